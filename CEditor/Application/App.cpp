@@ -28,20 +28,36 @@ namespace CronoEngine
 	App::App( int width, int height, std::string title, bool useAsSurface /*= false*/ )
 		:Application(width, height, title, useAsSurface)
 	{
-		
+		// The editor only redraws when something changes.
+		SetIdleMode( true );
+
+		ActionMap& actions = GetActions();
+		m_QuitAction = actions.AddAction( "Quit" );
+		actions.BindKey( m_QuitAction, VK_ESCAPE );
+		m_ToggleVSyncAction = actions.AddAction( "ToggleVSync" );
+		actions.BindKey( m_ToggleVSyncAction, 'V' );
+		m_FullscreenAction = actions.AddAction( "Fullscreen" );
+		actions.BindKey( m_FullscreenAction, VK_F11 );
 	}
 
 	void App::HandleInput( float deltaTime )
 	{
-		if (CRenderer->GetWindow()->kbd.KeyIsPressed( VK_ESCAPE ))
+		// Edges, so holding a key toggles once instead of every frame.
+		const InputSnapshot& input = GetInput();
+		const ActionMap& actions = GetActions();
+		if (actions.WasPressed( m_QuitAction, input ))
+		{
+			m_Platform->RequestQuit( 0 );
+		}
+		if (CRenderer == nullptr)
 		{
-			PostQuitMessage( 0 );
+			return;
 		}
-		if (CRenderer->GetWindow()->kbd.KeyIsPressed( 'V' ))
+		if (actions.WasPressed( m_ToggleVSyncAction, input ))
 		{
 			CRenderer->Gfx().ToggleVSync();
 		}
-		if (CRenderer->GetWindow()->kbd.KeyIsPressed( VK_F11 ))
+		if (actions.WasPressed( m_FullscreenAction, input ))
 		{
 			CRenderer->GetWindow()->SetFullscreen();
 		}
@@ -49,15 +65,41 @@ namespace CronoEngine
 
 	void App::Update( float deltaTimeF )
 	{	
+		// No ImGui context without a window.
+		if (m_Platform->IsHeadless())
+		{
+			return;
+		}
 		ImGuiIO& io = ImGui::GetIO(); (void)io;
 		ImGui::Begin( "FPS" );
 		ImGui::Text( "Application average %.3f ms/frame (%.1f FPS)", 1000.0f / io.Framerate, io.Framerate );
+		const auto& pacing = GetFramePacingStats();
+		ImGui::Text( "Frame time p50 %.3f ms, p99 %.3f ms, missed %llu", pacing.P50FrameTime * 1000.0,
+			pacing.P99FrameTime * 1000.0, static_cast<unsigned long long>(pacing.MissedDeadlines) );
+		ImGui::Text( "Idle frames skipped %llu", static_cast<unsigned long long>(GetSkippedFrames()) );
+		ImGui::End();
+		// Timings are from the previous frame, this one is still running.
+		const TaskGraph& graph = GetFrameGraph();
+		ImGui::Begin( "Frame Graph" );
+		ImGui::Text( "Critical path %.3f ms", graph.GetCriticalPathDuration() * 1000.0 );
+		for (TaskGraph::TaskId task = 0; task < graph.GetTaskCount(); ++task)
+		{
+			const auto& timing = graph.GetTiming( task );
+			ImGui::Text( "%c %-12s start %.3f ms, took %.3f ms", timing.Critical ? '*' : ' ',
+				graph.GetTaskName( task ).c_str(), timing.Start * 1000.0, timing.Duration * 1000.0 );
+		}
 		ImGui::End();
 		ImGui::Begin( "FPS1" );
 		ImGui::Text( "Application average %.3f ms/frame (%.1f FPS)", 1000.0f / io.Framerate, io.Framerate );
 		ImGui::End();
 	}
 
+	bool App::IsAnimating()
+	{
+		// Keep the text cursor blinking while a text field has focus.
+		return !m_Platform->IsHeadless() && ImGui::GetIO().WantTextInput;
+	}
+
 	void App::ShutDown()
 	{
 
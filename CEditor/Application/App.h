@@ -30,6 +30,11 @@ namespace CronoEngine
 	protected:
 		void HandleInput( float deltaTime ) override;
 		void Update( float deltaTime ) override;
+		bool IsAnimating() override;
 		void ShutDown() override;
+	private:
+		ActionMap::ActionId m_QuitAction;
+		ActionMap::ActionId m_ToggleVSyncAction;
+		ActionMap::ActionId m_FullscreenAction;
 	};
 }
\ No newline at end of file
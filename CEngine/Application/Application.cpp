@@ -18,18 +18,20 @@
 *	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
 ******************************************************************************************/
 #include "Application.h"
-#include "../Scene/Entity/Component/TransformComponent.h"
-#include "Graphics/Renderer.h"
+#include "Platform/HeadlessPlatform.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include "Math/Math.h"
+#if defined(_WIN32)
+#include "Platform/Win32Platform.h"
+#endif
 
 namespace CronoEngine
 {
 
 	Application::Application(int width, int height, std::string title, bool hasBorder /*= false*/ )
 	{	
-		if (CRenderer != nullptr)
-		{
-			ParseCommandLineArguments();
-		}
 		Initialize(width, height, title, hasBorder);
 	}
 
@@ -39,34 +41,140 @@ namespace CronoEngine
 
 	int Application::Run()
 	{			
+		m_FrameGraph.Clear();
+		BuildFrameGraph( m_FrameGraph );
+		// The timer started before the window and device did, the first frame's delta starts here.
+		m_Timer.Mark();
+		m_Accumulator = 0.0;
+		m_FramePacer.Resume();
+		if (m_PlatformConfig.Pipelined)
+		{
+			return RunPipelined();
+		}
 		while (true)
 		{
 			// process all messages pending, but to not block for new messages
-			if (const auto ecode = Window::ProcessMessages())
+			if (const auto ecode = m_Platform->ProcessMessages())
 			{
 				// if return optional has value, means we're quitting so return exit code
-				CRenderer->Gfx().Shutdown();
+				m_Platform->Shutdown();
 				return *ecode;
 			}
+			if (WaitWhileIdle())
+			{
+				continue;
+			}
+			m_Jobs->ProcessMainThreadJobs();
 			// execute the game logic
-			const auto dt = 0.0f;//timer.Mark() * speed_factor;
-			HandleInput( dt );
-			CRenderer->Gfx().BeginFrame();
-			Update( dt );
-			CRenderer->Gfx().EndFrame();
+			RunFrame();
+			m_FramePacer.WaitForNextFrame();
+		}
+	}
+
+	int Application::RunPipelined()
+	{
+		// The render thread submits the newest packet the simulation published, while the
+		// simulation already runs the next frame. Packets it didn't get to in time are skipped.
+		std::exception_ptr renderError;
+		std::atomic<bool> renderFailed = false;
+		m_FramePackets.Reopen();
+		std::thread renderThread( [this, &renderError, &renderFailed]()
+		{
+			try
+			{
+				while (Graphics::FramePacket* packet = m_FramePackets.WaitRead())
+				{
+					m_Platform->SubmitFrame( *packet );
+				}
+			}
+			catch (...)
+			{
+				renderError = std::current_exception();
+				renderFailed.store( true, std::memory_order_release );
+			}
+		} );
+		const auto stopRenderThread = [this, &renderThread, &renderError]()
+		{
+			m_FramePackets.Close();
+			renderThread.join();
+			if (renderError)
+			{
+				std::rethrow_exception( renderError );
+			}
+		};
+
+		try
+		{
+			while (true)
+			{
+				if (const auto ecode = m_Platform->ProcessMessages())
+				{
+					stopRenderThread();
+					m_Platform->Shutdown();
+					return *ecode;
+				}
+				if (renderFailed.load( std::memory_order_acquire ))
+				{
+					// Rethrows the render thread's exception.
+					stopRenderThread();
+				}
+				if (WaitWhileIdle())
+				{
+					continue;
+				}
+				m_Jobs->ProcessMainThreadJobs();
+				m_WritePacket = &m_FramePackets.BeginWrite();
+				m_WritePacket->FrameIndex = m_FrameIndex++;
+				RunFrame();
+				m_WritePacket = nullptr;
+				m_FramePackets.Publish();
+
+				m_FramePacer.WaitForNextFrame();
+			}
+		}
+		catch (...)
+		{
+			// Don't leave the render thread running (std::thread would terminate), keep the first error.
+			if (renderThread.joinable())
+			{
+				m_FramePackets.Close();
+				renderThread.join();
+			}
+			throw;
 		}
 	}
 
 	bool Application::Initialize( int width, int height, std::string title, bool hasBorder )
 	{
-		// Check for DirectX Math library support.
-		if (!DirectX::XMVerifyCPUSupport())
+		m_PlatformConfig.Width = width;
+		m_PlatformConfig.Height = height;
+		m_PlatformConfig.Title = title;
+		m_PlatformConfig.HasBorder = hasBorder;
+		ParseCommandLineArguments();
+		m_FramePacer.SetTargetFrameRate( m_PlatformConfig.TargetFrameRate );
+
+		m_Jobs = std::make_unique<JobSystem>( m_PlatformConfig.WorkerThreads );
+		m_Project = new Project();
+		m_Project->ActiveScene->SetJobSystem( m_Jobs.get() );
+		// Check the CPU has the instruction sets the math library was built for.
+		if (!Math::VerifyCPUSupport())
 		{
-			MessageBoxA( NULL, "Failed to verify DirectX Math library support.", "Error", MB_OK | MB_ICONERROR );
+#if defined(_WIN32)
+			MessageBoxA( NULL, "Failed to verify Math library CPU support.", "Error", MB_OK | MB_ICONERROR );
+#endif
 			return false;
 		}
-		m_Project = new Project();
-		CRenderer = new Graphics::Renderer( width, height, title, hasBorder );
+#if defined(_WIN32)
+		if (!m_PlatformConfig.Headless)
+		{
+			auto platform = std::make_unique<Win32Platform>( m_PlatformConfig );
+			CRenderer = &platform->GetRenderer();
+			m_Platform = std::move( platform );
+			return true;
+		}
+#endif
+		m_Platform = std::make_unique<HeadlessPlatform>( m_PlatformConfig );
+		return true;
 	}
 
 	void Application::ShutDown()
@@ -74,41 +182,224 @@ namespace CronoEngine
 
 	}
 
-	void Application::ParseCommandLineArguments()
+	void Application::SetFixedTimeStep( float step )
+	{
+		assert( step > 0.0f && "Fixed time step must be positive." );
+		m_FixedTimeStep = step;
+	}
+
+	float Application::GetFixedTimeStep() const noexcept
+	{
+		return m_FixedTimeStep;
+	}
+
+	void Application::SetMaxSimulationSteps( uint32_t steps )
+	{
+		m_MaxSimulationSteps = std::max( 1u, steps );
+	}
+
+	float Application::GetInterpolationAlpha() const noexcept
+	{
+		return m_InterpolationAlpha;
+	}
+
+	const FramePacingStats& Application::GetFramePacingStats()
+	{
+		return m_FramePacer.GetStats();
+	}
+
+	void Application::SetIdleMode( bool enabled )
+	{
+		m_IdleMode = enabled;
+		m_RedrawFrames = IdleSettleFrames;
+	}
+
+	void Application::SetIdleWakeInterval( std::chrono::milliseconds interval )
+	{
+		m_IdleWakeInterval = interval;
+	}
+
+	void Application::RequestRedraw( uint32_t frames /*= 1*/ )
 	{
-		int argc;
-		wchar_t** argv = ::CommandLineToArgvW( ::GetCommandLineW(), &argc );
+		m_RedrawFrames = std::max( m_RedrawFrames, frames );
+	}
+
+	uint64_t Application::GetSkippedFrames() const noexcept
+	{
+		return m_SkippedFrames;
+	}
+
+	JobSystem& Application::GetJobSystem()
+	{
+		return *m_Jobs;
+	}
 
-		int32_t clientWidth = 1920;
-		int32_t clientHeight = 1080;
-		bool useWarp = false;
-		bool isDirty = false;
+	const TaskGraph& Application::GetFrameGraph() const noexcept
+	{
+		return m_FrameGraph;
+	}
 
-		for (size_t i = 0; i < argc; ++i)
+	void Application::BuildFrameGraph( TaskGraph& graph )
+	{
+		// Window and UI state belong to the main thread, the rest may run on any worker.
+		graph.AddTask( "Input", { "Input" }, { "Window", "Scene" },
+			[this]()
+		{
+			m_Input.Update( m_Platform->GetKeyboard(), m_Platform->GetMouse() );
+			HandleInput( m_FrameDeltaTime );
+		}, JobAffinity::MainThread );
+		graph.AddTask( "Simulation", {}, { "Scene" },
+			[this]() { StepSimulation( m_FrameDeltaTime ); } );
+		graph.AddTask( "BeginFrame", { "Window" }, { "UI" },
+			[this]() { m_Platform->BeginFrame(); }, JobAffinity::MainThread );
+		graph.AddTask( "Update", {}, { "Scene", "UI" },
+			[this]() { Update( m_FrameDeltaTime ); }, JobAffinity::MainThread );
+		// Merges streamed cells and drops far ones, observers are set by the game.
+		graph.AddTask( "Streaming", {}, { "Scene" }, [this]()
 		{
-			if (::wcscmp( argv[i], L"-w" ) == 0 || ::wcscmp( argv[i], L"--width" ) == 0)
+			if (WorldPartition* world = m_Project->GetWorld())
 			{
-				clientWidth = ::wcstol( argv[++i], nullptr, 10 );
-				isDirty = true;
+				world->Update();
 			}
-			if (::wcscmp( argv[i], L"-h" ) == 0 || ::wcscmp( argv[i], L"--height" ) == 0)
+		} );
+		graph.AddTask( "Transforms", { "Scene" }, { "Scene.WorldMatrices", "Scene.Spatial" },
+			[this]() { m_Project->ActiveScene->UpdateTransforms(); } );
+		graph.AddTask( "Culling", { "Scene", "Scene.WorldMatrices" }, { "Scene.Visibility" }, [this]()
+		{
+			m_ViewFrustums.resize( m_Views.size() );
+			std::transform( m_Views.begin(), m_Views.end(), m_ViewFrustums.begin(), Math::FrustumFromMatrix );
+			m_Visibility.resize( m_Views.size() );
+			m_Project->ActiveScene->Cull( m_ViewFrustums.data(), static_cast<uint32_t>(m_Views.size()), m_Visibility.data() );
+			if (m_OcclusionCulling && !m_Views.empty())
+			{
+				m_Project->ActiveScene->CullOcclusion( m_Views.front(), m_Occlusion, m_Visibility.front() );
+			}
+		} );
+		if (!m_PlatformConfig.Pipelined)
+		{
+			graph.AddTask( "EndFrame", { "UI" }, { "Window" },
+				[this]() { m_Platform->EndFrame(); }, JobAffinity::MainThread );
+			return;
+		}
+		// The draw list and the UI snapshot don't touch each other and build side by side.
+		graph.AddTask( "DrawList", { "Scene", "Scene.WorldMatrices", "Scene.Visibility" }, { "Packet.DrawItems" }, [this]()
+		{
+			m_WritePacket->InterpolationAlpha = m_InterpolationAlpha;
+			if (m_Views.empty())
 			{
-				clientHeight = ::wcstol( argv[++i], nullptr, 10 );
-				isDirty = true;
+				m_Project->ActiveScene->CollectDrawItems( m_WritePacket->DrawItems );
 			}
-			if (::wcscmp( argv[i], L"-warp" ) == 0 || ::wcscmp( argv[i], L"--warp" ) == 0)
+			else
 			{
-				useWarp = true;
-				isDirty = true;
+				m_Project->ActiveScene->CollectDrawItems( m_WritePacket->DrawItems, m_Visibility.front() );
 			}
+		} );
+		graph.AddTask( "BuildFrame", { "UI" }, { "Packet.UI" },
+			[this]() { m_Platform->BuildFrame( *m_WritePacket ); }, JobAffinity::MainThread );
+	}
+
+	const InputSnapshot& Application::GetInput() const noexcept
+	{
+		return m_Input.GetSnapshot();
+	}
+
+	ActionMap& Application::GetActions() noexcept
+	{
+		return m_Actions;
+	}
+
+	std::vector<Math::Float4x4>& Application::GetViews() noexcept
+	{
+		return m_Views;
+	}
+
+	const std::vector<VisibilityList>& Application::GetVisibility() const noexcept
+	{
+		return m_Visibility;
+	}
+
+	void Application::SetOcclusionCulling( bool enabled ) noexcept
+	{
+		m_OcclusionCulling = enabled;
+	}
+
+	OcclusionBuffer& Application::GetOcclusionBuffer() noexcept
+	{
+		return m_Occlusion;
+	}
+
+	float Application::GetFrameDeltaTime() const noexcept
+	{
+		return m_FrameDeltaTime;
+	}
+
+	void Application::FixedUpdate( float )
+	{
+	}
+
+	bool Application::IsAnimating()
+	{
+		return false;
+	}
+
+	bool Application::WaitWhileIdle()
+	{
+		if (!m_IdleMode)
+		{
+			return false;
+		}
+		const uint64_t sceneChangeCount = m_Project->ActiveScene->GetChangeCount();
+		if (m_Platform->HadEvents() || sceneChangeCount != m_LastSceneChangeCount || IsAnimating())
+		{
+			m_LastSceneChangeCount = sceneChangeCount;
+			RequestRedraw( IdleSettleFrames );
+		}
+		if (m_RedrawFrames > 0)
+		{
+			--m_RedrawFrames;
+			return false;
 		}
 
-		if (isDirty)
+		++m_SkippedFrames;
+		if (!m_Platform->WaitForEvents( m_IdleWakeInterval ))
 		{
-			CRenderer->Resize( clientWidth, clientHeight );
+			// Woke up on the timer, draw one frame so time based UI stays current.
+			RequestRedraw();
 		}
-		// Free memory allocated by CommandLineToArgvW
-		::LocalFree( argv );
+		// The editor is paused while idle, don't hand the blocked time to the simulation or the pacer.
+		m_Timer.Mark();
+		m_FramePacer.Resume();
+		// Go back and pump the messages that woke us up before drawing.
+		return true;
+	}
+
+	void Application::RunFrame()
+	{
+		m_FrameDeltaTime = static_cast<float>(m_Timer.Mark()) * m_SpeedFactor;
+		m_FrameGraph.Execute( *m_Jobs );
+	}
+
+	void Application::StepSimulation( double frameTime )
+	{
+		m_Accumulator += frameTime;
+		uint32_t steps = 0;
+		while (m_Accumulator >= m_FixedTimeStep && steps < m_MaxSimulationSteps)
+		{
+			FixedUpdate( m_FixedTimeStep );
+			m_Accumulator -= m_FixedTimeStep;
+			++steps;
+		}
+		// Too far behind, drop the whole steps we couldn't catch up on and keep the remainder.
+		if (m_Accumulator >= m_FixedTimeStep)
+		{
+			m_Accumulator = std::fmod( m_Accumulator, static_cast<double>(m_FixedTimeStep) );
+		}
+		m_InterpolationAlpha = static_cast<float>(m_Accumulator / m_FixedTimeStep);
+	}
+
+	void Application::ParseCommandLineArguments()
+	{
+		Platform::ParseCommandLine( Platform::GetCommandLineArgs(), m_PlatformConfig );
 	}
 
 }
@@ -19,8 +19,18 @@
 ******************************************************************************************/
 #pragma once
 #include "Common/CommonHeaders.h"
-#include "Windows/Window.h"
+#include "Common/CronoTimer.h"
+#include "Common/TripleBuffer.h"
+#include "FramePacer.h"
+#include "Graphics/FramePacket.h"
+#include "Input/ActionMap.h"
+#include "Jobs/JobSystem.h"
+#include "Jobs/TaskGraph.h"
+#include "Platform/Platform.h"
 #include "Project/Project.h"
+#if defined(_WIN32)
+#include "Graphics/Renderer.h"
+#endif
 
 namespace CronoEngine
 {
@@ -49,14 +59,123 @@ namespace CronoEngine
 		 * Destroy any resource that are used by the game.
 		 */
 		virtual void ShutDown();
+
+		/**
+		 * Length of one simulation step in seconds, FixedUpdate runs at this rate.
+		 */
+		void SetFixedTimeStep( float step );
+		float GetFixedTimeStep() const noexcept;
+		/**
+		 * Most FixedUpdate calls per frame. Time beyond that is dropped so a slow
+		 * frame can't make the next one slower (spiral of death).
+		 */
+		void SetMaxSimulationSteps( uint32_t steps );
+		/**
+		 * How far the simulation is between the last and the next fixed step, in [0, 1).
+		 * Use it in Update to blend the previous and current simulation state when rendering.
+		 */
+		float GetInterpolationAlpha() const noexcept;
+		/**
+		 * Frame time percentiles and missed deadlines of the frame limiter.
+		 */
+		const FramePacingStats& GetFramePacingStats();
+		/**
+		 * Idle mode stops rendering while nothing changes: no input, no scene change, nothing
+		 * animating and no redraw requested. The loop then blocks on the OS until input arrives,
+		 * waking up every idle wake interval to draw one frame.
+		 */
+		void SetIdleMode( bool enabled );
+		void SetIdleWakeInterval( std::chrono::milliseconds interval );
+		// Keep rendering for at least this many frames, e.g. while an animation plays.
+		void RequestRedraw( uint32_t frames = 1 );
+		// Number of idle waits, each one stands for a frame that wasn't rendered.
+		uint64_t GetSkippedFrames() const noexcept;
+		/**
+		 * Engine wide job scheduler, for Update, Scene systems and asset loading.
+		 */
+		JobSystem& GetJobSystem();
+		/**
+		 * The tasks of one frame, with the timings and critical path of the last frame.
+		 */
+		const TaskGraph& GetFrameGraph() const noexcept;
+		/**
+		 * Keyboard and mouse state of the current frame, taken right before HandleInput.
+		 */
+		const InputSnapshot& GetInput() const noexcept;
+		ActionMap& GetActions() noexcept;
+		/**
+		 * View * projection matrices (row vectors, D3D depth) the Culling task culls the active
+		 * scene for every frame, set them in Update. The first one is the camera the draw list
+		 * is built for, without any views everything is drawn.
+		 */
+		std::vector<Math::Float4x4>& GetViews() noexcept;
+		// One list per view, from the last Culling task.
+		const std::vector<VisibilityList>& GetVisibility() const noexcept;
+		// Also culls what the scene's occluders hide from the first view, off by default.
+		void SetOcclusionCulling( bool enabled ) noexcept;
+		// Resolution and metrics of the occlusion culling.
+		OcclusionBuffer& GetOcclusionBuffer() noexcept;
 	protected:
+		/**
+		 * Declares the frame's tasks, called once when Run starts. The default graph is
+		 * Input, Simulation, BeginFrame, Update, Streaming, Transforms, Culling, then EndFrame (or
+		 * DrawList and BuildFrame when pipelined). Override it to add tasks, call this first so they are
+		 * ordered after the engine's for the resources they share. Use GetFrameDeltaTime in tasks.
+		 */
+		virtual void BuildFrameGraph( TaskGraph& graph );
+		float GetFrameDeltaTime() const noexcept;
 		virtual void HandleInput( float deltaTime ) = 0;
+		/**
+		 * One simulation step, from the Simulation task on a job system worker, not the main thread:
+		 * touch the scene only, leave Window, ImGui and other main thread state to Update.
+		 */
+		virtual void FixedUpdate( float fixedTimeStep );
 		virtual void Update( float deltaTime ) = 0;
+		// Polled every frame in idle mode, return true to keep rendering.
+		virtual bool IsAnimating();
 	private:
+		bool WaitWhileIdle();
 		void ParseCommandLineArguments();
+		void StepSimulation( double frameTime );
+		void RunFrame();
+		int RunPipelined();
 	protected:
 		Project* m_Project;
+		float m_SpeedFactor = 1.0f;
+		PlatformConfig m_PlatformConfig;
+		std::unique_ptr<Platform> m_Platform;
+		FramePacer m_FramePacer;
+		std::unique_ptr<JobSystem> m_Jobs;
+#if defined(_WIN32)
+		// Null when running headless.
 		Graphics::Renderer* CRenderer = nullptr;
+#endif
+	private:
+		CronoTimer m_Timer;
+		double m_Accumulator = 0.0;
+		float m_FixedTimeStep = 1.0f / 60.0f;
+		uint32_t m_MaxSimulationSteps = 8;
+		float m_InterpolationAlpha = 0.0f;
+		uint64_t m_FrameIndex = 0;
+		TripleBuffer<Graphics::FramePacket> m_FramePackets;
+		TaskGraph m_FrameGraph;
+		InputSystem m_Input;
+		ActionMap m_Actions;
+		std::vector<Math::Float4x4> m_Views;
+		std::vector<Math::Frustum> m_ViewFrustums;
+		std::vector<VisibilityList> m_Visibility;
+		bool m_OcclusionCulling = false;
+		OcclusionBuffer m_Occlusion;
+		float m_FrameDeltaTime = 0.0f;
+		// Packet the pipelined frame graph fills, null in the serial loop.
+		Graphics::FramePacket* m_WritePacket = nullptr;
+		// ImGui needs a few frames after an input to settle hover and layout state.
+		static constexpr uint32_t IdleSettleFrames = 3;
+		bool m_IdleMode = false;
+		std::chrono::milliseconds m_IdleWakeInterval{ 500 };
+		uint32_t m_RedrawFrames = IdleSettleFrames;
+		uint64_t m_LastSceneChangeCount = 0;
+		uint64_t m_SkippedFrames = 0;
 	};
 }
 // To be defined in CLIENT
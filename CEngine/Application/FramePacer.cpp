@@ -0,0 +1,143 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "FramePacer.h"
+#include <cmath>
+#include <thread>
+
+#if defined(_WIN32)
+#include "Windows/WinInclude.h"
+#include <timeapi.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+namespace CronoEngine
+{
+	FramePacer::FramePacer()
+		: _Deadline( Clock::now() ), _LastFrameStart( Clock::now() )
+	{
+#if defined(_WIN32)
+		// Default scheduler granularity is ~15.6ms, far too coarse to sleep inside a frame.
+		::timeBeginPeriod( 1 );
+#endif
+	}
+
+	FramePacer::~FramePacer()
+	{
+#if defined(_WIN32)
+		::timeEndPeriod( 1 );
+#endif
+	}
+
+	void FramePacer::SetTargetFrameRate( double framesPerSecond )
+	{
+		_TargetFrameRate = std::max( 0.0, framesPerSecond );
+		_Period = _TargetFrameRate > 0.0
+			? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>( 1.0 / _TargetFrameRate ))
+			: Clock::duration::zero();
+		_Deadline = Clock::now() + _Period;
+	}
+
+	double FramePacer::GetTargetFrameRate() const noexcept
+	{
+		return _TargetFrameRate;
+	}
+
+	void FramePacer::WaitForNextFrame()
+	{
+		if (_TargetFrameRate > 0.0)
+		{
+			const auto now = Clock::now();
+			// Measured from the frame's own start, being late because an earlier frame overran is not a miss.
+			if (now - _LastFrameStart > _Period)
+			{
+				++_Stats.MissedDeadlines;
+			}
+			if (now > _Deadline)
+			{
+				// More than a whole frame behind, restart the schedule instead of rushing to catch up.
+				if (now - _Deadline > _Period)
+				{
+					_Deadline = now;
+				}
+			}
+			else
+			{
+				SleepUntil( _Deadline );
+			}
+			_Deadline += _Period;
+		}
+		RecordFrame( Clock::now() );
+	}
+
+	void FramePacer::Resume()
+	{
+		_LastFrameStart = Clock::now();
+		_Deadline = _LastFrameStart + _Period;
+	}
+
+	const FramePacingStats& FramePacer::GetStats()
+	{
+		if (_StatsDirty)
+		{
+			const size_t count = static_cast<size_t>(std::min<uint64_t>( _Stats.FrameCount, HistorySize ));
+			std::array<double, HistorySize> sorted = _History;
+			const auto percentile = [&]( double p )
+			{
+				const size_t index = std::min( count - 1, static_cast<size_t>(p * count) );
+				std::nth_element( sorted.begin(), sorted.begin() + index, sorted.begin() + count );
+				return sorted[index];
+			};
+			_Stats.P50FrameTime = percentile( 0.50 );
+			_Stats.P99FrameTime = percentile( 0.99 );
+			_StatsDirty = false;
+		}
+		return _Stats;
+	}
+
+	void FramePacer::SleepUntil( Clock::time_point deadline )
+	{
+		// Sleep in 1ms slices while the remaining time comfortably exceeds the observed sleep cost.
+		while (std::chrono::duration<double>( deadline - Clock::now() ).count() > _SleepEstimate)
+		{
+			const auto start = Clock::now();
+			std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+			const double observed = std::chrono::duration<double>( Clock::now() - start ).count();
+
+			const double delta = observed - _SleepMean;
+			_SleepMean += SleepSmoothing * delta;
+			_SleepVariance = (1.0 - SleepSmoothing) * (_SleepVariance + SleepSmoothing * delta * delta);
+			_SleepEstimate = _SleepMean + std::sqrt( _SleepVariance );
+		}
+		// Spin the rest, sleep can't hit the deadline this precisely.
+		while (Clock::now() < deadline)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	void FramePacer::RecordFrame( Clock::time_point frameStart )
+	{
+		_Stats.LastFrameTime = std::chrono::duration<double>( frameStart - _LastFrameStart ).count();
+		_History[_Stats.FrameCount % HistorySize] = _Stats.LastFrameTime;
+		++_Stats.FrameCount;
+		_LastFrameStart = frameStart;
+		_StatsDirty = true;
+	}
+}
@@ -0,0 +1,79 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+#include "Common/CommonHeaders.h"
+#include <array>
+
+namespace CronoEngine
+{
+	struct FramePacingStats
+	{
+		// Frame times in seconds over the last FramePacer::HistorySize frames.
+		double LastFrameTime = 0.0;
+		double P50FrameTime = 0.0;
+		double P99FrameTime = 0.0;
+		// Frames whose own work took longer than the target period.
+		uint64_t MissedDeadlines = 0;
+		uint64_t FrameCount = 0;
+	};
+
+	/**
+	 * Caps the frame rate without burning a core: the wait sleeps on the OS timer while it
+	 * is safely far from the deadline and spins for the last stretch, where sleep is too coarse.
+	 */
+	class FramePacer
+	{
+	public:
+		static constexpr size_t HistorySize = 256;
+	public:
+		FramePacer();
+		~FramePacer();
+		FramePacer( const FramePacer& ) = delete;
+		FramePacer& operator=( const FramePacer& ) = delete;
+
+		// 0 disables the limiter, the frame times are still recorded.
+		void SetTargetFrameRate( double framesPerSecond );
+		double GetTargetFrameRate() const noexcept;
+		// Call once per frame after presenting, blocks until the next frame should start.
+		void WaitForNextFrame();
+		// Call after the loop blocked on something else (idle mode), the next frame starts now
+		// instead of counting the wait as its frame time.
+		void Resume();
+		const FramePacingStats& GetStats();
+	private:
+		void SleepUntil( std::chrono::steady_clock::time_point deadline );
+		void RecordFrame( std::chrono::steady_clock::time_point frameStart );
+	private:
+		using Clock = std::chrono::steady_clock;
+		double _TargetFrameRate = 0.0;
+		Clock::duration _Period{};
+		Clock::time_point _Deadline;
+		Clock::time_point _LastFrameStart;
+		// Running estimate of how long a 1ms sleep really takes (mean + deviation), exponentially
+		// weighted so it follows the scheduler as the load changes.
+		static constexpr double SleepSmoothing = 1.0 / 32.0;
+		double _SleepEstimate = 0.002;
+		double _SleepMean = 0.002;
+		double _SleepVariance = 0.0;
+		std::array<double, HistorySize> _History{};
+		FramePacingStats _Stats;
+		bool _StatsDirty = false;
+	};
+}
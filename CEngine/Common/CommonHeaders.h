@@ -18,6 +18,7 @@
 *	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
 ******************************************************************************************/
 #pragma once
+#include <cstdint>
 #include <string>
 #include <optional>
 #include <memory>
@@ -28,9 +29,11 @@
 #include <cassert>
 #include <chrono>
 
+#if defined(_WIN32)
 // Windows Runtime Library. Needed for Microsoft::WRL::ComPtr<> template class.
 #include <wrl.h>
 using namespace Microsoft::WRL;
+#endif
 
 // My includes
 #include "Common/Helpers.h"
@@ -61,6 +61,7 @@ namespace CronoEngine
 		return oss.str();
 	}
 
+#if defined(_WIN32)
 	HrException::HrException( int line, const char* file, HRESULT hr ) noexcept
 		:
 		CronoException( line, file ),
@@ -116,10 +117,72 @@ namespace CronoEngine
 		LocalFree( pMsgBuf );
 		return errorString;
 	}
+#endif
 
 	const char* NoGfxException::GetType() const noexcept
 	{
 		return "No Graphics Exception";
 	}
 
+	FileException::FileException( int line, const char* file, std::string path, std::string reason ) noexcept
+		:
+		CronoException( line, file ),
+		path( std::move( path ) ),
+		reason( std::move( reason ) )
+	{
+	}
+
+	const char* FileException::what() const noexcept
+	{
+		std::ostringstream oss;
+		oss << GetType() << std::endl
+			<< "[Path] " << GetPath() << std::endl
+			<< "[Reason] " << GetReason() << std::endl
+			<< GetOriginString();
+		whatBuffer = oss.str();
+		return whatBuffer.c_str();
+	}
+
+	const char* FileException::GetType() const noexcept
+	{
+		return "Crono File Exception";
+	}
+
+	const std::string& FileException::GetPath() const noexcept
+	{
+		return path;
+	}
+
+	const std::string& FileException::GetReason() const noexcept
+	{
+		return reason;
+	}
+
+	RhiException::RhiException( int line, const char* file, std::string reason ) noexcept
+		:
+		CronoException( line, file ),
+		reason( std::move( reason ) )
+	{
+	}
+
+	const char* RhiException::what() const noexcept
+	{
+		std::ostringstream oss;
+		oss << GetType() << std::endl
+			<< "[Reason] " << GetReason() << std::endl
+			<< GetOriginString();
+		whatBuffer = oss.str();
+		return whatBuffer.c_str();
+	}
+
+	const char* RhiException::GetType() const noexcept
+	{
+		return "Crono RHI Exception";
+	}
+
+	const std::string& RhiException::GetReason() const noexcept
+	{
+		return reason;
+	}
+
 }
\ No newline at end of file
@@ -18,7 +18,9 @@
 *	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
 ******************************************************************************************/
 #pragma once
+#if defined(_WIN32)
 #include "Windows/WinInclude.h"
+#endif
 #include <exception>
 #include <string>
 
@@ -39,6 +41,7 @@ namespace CronoEngine
 	protected:
 		mutable std::string whatBuffer;	
 	};
+#if defined(_WIN32)
 	class HrException : public CronoException
 	{
 	public:
@@ -51,14 +54,42 @@ namespace CronoEngine
 	private:
 		HRESULT hr;
 	};
+#endif
 	class NoGfxException : public CronoException
 	{
 	public:
 		using CronoException::CronoException;
 		const char* GetType() const noexcept override;
 	};
+	class FileException : public CronoException
+	{
+	public:
+		FileException( int line, const char* file, std::string path, std::string reason ) noexcept;
+		const char* what() const noexcept override;
+		const char* GetType() const noexcept override;
+		const std::string& GetPath() const noexcept;
+		const std::string& GetReason() const noexcept;
+	private:
+		std::string path;
+		std::string reason;
+	};
+	// Misuse of the render hardware interface caught by a validating backend, or of a render graph or upload ring.
+	class RhiException : public CronoException
+	{
+	public:
+		RhiException( int line, const char* file, std::string reason ) noexcept;
+		const char* what() const noexcept override;
+		const char* GetType() const noexcept override;
+		const std::string& GetReason() const noexcept;
+	private:
+		std::string reason;
+	};
 }
 
+#if defined(_WIN32)
 #define CHWND_EXCEPT( hr ) CronoEngine::HrException( __LINE__,__FILE__,(hr) )
 #define CHWND_LAST_EXCEPT() CronoEngine::HrException( __LINE__,__FILE__,GetLastError() )
-#define CHWND_NOGFX_EXCEPT() CronoEngine::NoGfxException( __LINE__,__FILE__ )
\ No newline at end of file
+#endif
+#define CHWND_NOGFX_EXCEPT() CronoEngine::NoGfxException( __LINE__,__FILE__ )
+#define CHWND_FILE_EXCEPT( path, reason ) CronoEngine::FileException( __LINE__,__FILE__,(path),(reason) )
+#define CHWND_RHI_EXCEPT( reason ) CronoEngine::RhiException( __LINE__,__FILE__,(reason) )
\ No newline at end of file
@@ -0,0 +1,41 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "CronoTimer.h"
+
+namespace CronoEngine
+{
+	CronoTimer::CronoTimer() noexcept
+		:
+		last( std::chrono::steady_clock::now() )
+	{
+	}
+
+	double CronoTimer::Mark() noexcept
+	{
+		const auto old = last;
+		last = std::chrono::steady_clock::now();
+		return std::chrono::duration<double>( last - old ).count();
+	}
+
+	double CronoTimer::Peek() const noexcept
+	{
+		return std::chrono::duration<double>( std::chrono::steady_clock::now() - last ).count();
+	}
+}
@@ -0,0 +1,39 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+#include <chrono>
+
+namespace CronoEngine
+{
+	/**
+	 * High resolution steady clock timer.
+	 */
+	class CronoTimer
+	{
+	public:
+		CronoTimer() noexcept;
+		// Returns the seconds elapsed since the last Mark and restarts the interval.
+		double Mark() noexcept;
+		// Returns the seconds elapsed since the last Mark without restarting the interval.
+		double Peek() const noexcept;
+	private:
+		std::chrono::steady_clock::time_point last;
+	};
+}
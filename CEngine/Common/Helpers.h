@@ -18,9 +18,11 @@
 *	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
 ******************************************************************************************/
 #pragma once
-#include "Windows/WinInclude.h"
 #include "CronoException.h"
 
+#if defined(_WIN32)
+#include "Windows/WinInclude.h"
+
 // From DXSampleHelper.h 
 // Source: https://github.com/Microsoft/DirectX-Graphics-Samples
 inline void ThrowIfFailed( HRESULT hr )
@@ -29,4 +31,5 @@ inline void ThrowIfFailed( HRESULT hr )
 	{
 		throw CHWND_EXCEPT( hr );
 	}
-}
\ No newline at end of file
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,148 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "MappedFile.h"
+#include "CronoException.h"
+#if defined(_WIN32)
+#include "Windows/WinInclude.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace CronoEngine
+{
+#if defined(_WIN32)
+	MappedFile::MappedFile( const std::string& path )
+		:
+		path( path )
+	{
+		file = CreateFileA( path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			file = nullptr;
+			throw CHWND_FILE_EXCEPT( path, HrException::TranslateErrorCode( HRESULT_FROM_WIN32( GetLastError() ) ) );
+		}
+		LARGE_INTEGER fileSize{};
+		GetFileSizeEx( file, &fileSize );
+		size = static_cast<size_t>(fileSize.QuadPart);
+		if (size == 0)
+		{
+			return;
+		}
+		mapping = CreateFileMappingA( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+		if (mapping != nullptr)
+		{
+			data = static_cast<const std::byte*>(MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 ));
+		}
+		if (data == nullptr)
+		{
+			const std::string reason = HrException::TranslateErrorCode( HRESULT_FROM_WIN32( GetLastError() ) );
+			Close();
+			throw CHWND_FILE_EXCEPT( path, reason );
+		}
+	}
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	void MappedFile::Close() noexcept
+	{
+		if (data != nullptr)
+		{
+			UnmapViewOfFile( data );
+			data = nullptr;
+		}
+		if (mapping != nullptr)
+		{
+			CloseHandle( mapping );
+			mapping = nullptr;
+		}
+		if (file != nullptr)
+		{
+			CloseHandle( file );
+			file = nullptr;
+		}
+	}
+#else
+	MappedFile::MappedFile( const std::string& path )
+		:
+		path( path )
+	{
+		const int descriptor = open( path.c_str(), O_RDONLY );
+		if (descriptor < 0)
+		{
+			throw CHWND_FILE_EXCEPT( path, "Could not open the file." );
+		}
+		struct stat status {};
+		if (fstat( descriptor, &status ) != 0)
+		{
+			close( descriptor );
+			throw CHWND_FILE_EXCEPT( path, "Could not read the file size." );
+		}
+		size = static_cast<size_t>(status.st_size);
+		if (size > 0)
+		{
+			void* view = mmap( nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0 );
+			if (view == MAP_FAILED)
+			{
+				close( descriptor );
+				throw CHWND_FILE_EXCEPT( path, "Could not map the file." );
+			}
+			data = static_cast<const std::byte*>(view);
+		}
+		// The mapping keeps its own reference to the file.
+		close( descriptor );
+	}
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	void MappedFile::Close() noexcept
+	{
+		if (data != nullptr)
+		{
+			munmap( const_cast<std::byte*>(data), size );
+			data = nullptr;
+		}
+	}
+#endif
+
+	const std::byte* MappedFile::GetData() const noexcept
+	{
+		return data;
+	}
+
+	size_t MappedFile::GetSize() const noexcept
+	{
+		return size;
+	}
+
+	const std::string& MappedFile::GetPath() const noexcept
+	{
+		return path;
+	}
+}
@@ -0,0 +1,54 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+#include <cstddef>
+#include <string>
+
+namespace CronoEngine
+{
+	/**
+	 * Read only view of a whole file mapped into memory. Pages are loaded by the OS on first
+	 * touch, so opening is cheap whatever the size. Throws FileException when the file can't
+	 * be opened or mapped.
+	 */
+	class MappedFile
+	{
+	public:
+		explicit MappedFile( const std::string& path );
+		~MappedFile();
+		MappedFile( const MappedFile& ) = delete;
+		MappedFile& operator=( const MappedFile& ) = delete;
+
+		// Page aligned, null for an empty file.
+		const std::byte* GetData() const noexcept;
+		size_t GetSize() const noexcept;
+		const std::string& GetPath() const noexcept;
+	private:
+		void Close() noexcept;
+	private:
+		std::string path;
+		const std::byte* data = nullptr;
+		size_t size = 0;
+#if defined(_WIN32)
+		void* file = nullptr;
+		void* mapping = nullptr;
+#endif
+	};
+}
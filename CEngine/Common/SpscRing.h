@@ -0,0 +1,95 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+
+namespace CronoEngine
+{
+	/**
+	 * Fixed capacity lock-free single producer / single consumer queue. Never allocates;
+	 * a push into a full ring is dropped and counted, so the producer never waits on the consumer.
+	 * Capacity must be a power of two.
+	 */
+	template<typename T, uint32_t Capacity>
+	class SpscRing
+	{
+		static_assert( Capacity != 0 && (Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two." );
+	public:
+		SpscRing() = default;
+		SpscRing( const SpscRing& ) = delete;
+		SpscRing& operator=( const SpscRing& ) = delete;
+
+		// Producer side.
+		bool TryPush( const T& value ) noexcept
+		{
+			const uint32_t tail = writeIndex.load( std::memory_order_relaxed );
+			if (tail - cachedReadIndex == Capacity)
+			{
+				cachedReadIndex = readIndex.load( std::memory_order_acquire );
+				if (tail - cachedReadIndex == Capacity)
+				{
+					dropCount.fetch_add( 1, std::memory_order_relaxed );
+					return false;
+				}
+			}
+			slots[tail & (Capacity - 1)] = value;
+			writeIndex.store( tail + 1, std::memory_order_release );
+			return true;
+		}
+
+		// Consumer side.
+		std::optional<T> TryPop() noexcept
+		{
+			const uint32_t head = readIndex.load( std::memory_order_relaxed );
+			if (head == writeIndex.load( std::memory_order_acquire ))
+			{
+				return std::nullopt;
+			}
+			T value = slots[head & (Capacity - 1)];
+			readIndex.store( head + 1, std::memory_order_release );
+			return value;
+		}
+		bool IsEmpty() const noexcept
+		{
+			return readIndex.load( std::memory_order_relaxed ) == writeIndex.load( std::memory_order_acquire );
+		}
+		// Drops everything pushed so far.
+		void Clear() noexcept
+		{
+			readIndex.store( writeIndex.load( std::memory_order_acquire ), std::memory_order_release );
+		}
+
+		// Pushes that didn't fit, since construction. Safe from any thread.
+		uint64_t GetDropCount() const noexcept
+		{
+			return dropCount.load( std::memory_order_relaxed );
+		}
+	private:
+		std::array<T, Capacity> slots{};
+		// Producer and consumer indices on their own cache lines, they only grow and wrap on overflow.
+		alignas(64) std::atomic<uint32_t> writeIndex = 0;
+		uint32_t cachedReadIndex = 0;
+		alignas(64) std::atomic<uint32_t> readIndex = 0;
+		std::atomic<uint64_t> dropCount = 0;
+	};
+}
@@ -0,0 +1,110 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace CronoEngine
+{
+	/**
+	 * Lock-free single producer / single consumer mailbox over three slots.
+	 * The producer always has a slot to write into and never waits, the consumer
+	 * always gets the most recently published slot; slots it didn't pick up in time are overwritten.
+	 */
+	template<typename T>
+	class TripleBuffer
+	{
+	public:
+		TripleBuffer() = default;
+		TripleBuffer( const TripleBuffer& ) = delete;
+		TripleBuffer& operator=( const TripleBuffer& ) = delete;
+
+		// Producer side: the slot to fill, owned by the producer until Publish.
+		T& BeginWrite() noexcept
+		{
+			return slots[writeIndex];
+		}
+		void Publish() noexcept
+		{
+			uint32_t state = ready.load( std::memory_order_relaxed );
+			while (!ready.compare_exchange_weak( state, (state & ClosedBit) | FreshBit | writeIndex,
+				std::memory_order_acq_rel, std::memory_order_relaxed ))
+			{
+			}
+			writeIndex = state & IndexMask;
+			ready.notify_one();
+		}
+
+		// Consumer side: the latest published slot, or nullptr if nothing new was published.
+		// The slot stays valid until the next read.
+		T* TryRead() noexcept
+		{
+			uint32_t state = ready.load( std::memory_order_acquire );
+			return (state & FreshBit) ? Take( state ) : nullptr;
+		}
+		// Blocks until a new slot is published, returns nullptr once closed.
+		T* WaitRead() noexcept
+		{
+			while (true)
+			{
+				const uint32_t state = ready.load( std::memory_order_acquire );
+				if (state & FreshBit)
+				{
+					return Take( state );
+				}
+				if (state & ClosedBit)
+				{
+					return nullptr;
+				}
+				ready.wait( state, std::memory_order_acquire );
+			}
+		}
+
+		// Wakes the consumer and makes every following WaitRead without fresh data return nullptr.
+		void Close() noexcept
+		{
+			ready.fetch_or( ClosedBit, std::memory_order_acq_rel );
+			ready.notify_all();
+		}
+		void Reopen() noexcept
+		{
+			ready.fetch_and( ~ClosedBit, std::memory_order_acq_rel );
+		}
+	private:
+		T* Take( uint32_t state ) noexcept
+		{
+			while (!ready.compare_exchange_weak( state, (state & ClosedBit) | readIndex,
+				std::memory_order_acq_rel, std::memory_order_acquire ))
+			{
+			}
+			readIndex = state & IndexMask;
+			return &slots[readIndex];
+		}
+	private:
+		static constexpr uint32_t IndexMask = 0x3u;
+		static constexpr uint32_t FreshBit = 0x4u;
+		static constexpr uint32_t ClosedBit = 0x8u;
+		std::array<T, 3> slots{};
+		uint32_t writeIndex = 0;
+		uint32_t readIndex = 2;
+		std::atomic<uint32_t> ready = 1;
+	};
+}
@@ -20,48 +20,38 @@
 #pragma once
 #include "Windows/WinInclude.h"
 #include "DX12CommonIncludes.h"
+#include "DX12Device.h"
+#include "Graphics/FrameRenderer.h"
+#include <atomic>
 
 namespace CronoEngine::Graphics
 {
+	/**
+	 * The window's graphics: owns the DX12Device and the swap chain for the window, runs
+	 * ImGui's DX12 backend and hands frames to a FrameRenderer, which only sees the RHI.
+	 */
 	class DX12Core
 	{
 	public:
 		DX12Core( HWND hWnd, uint32_t width, uint32_t height );
 		~DX12Core();
 
-		void Init();
+		// useWarp picks the WARP software adapter over the hardware one.
+		void Init( bool useWarp = false );
 		void Shutdown();
 		void Resize( uint32_t width, uint32_t height );
 		void BeginFrame();
+		// RenderUI followed by SubmitFrame on the calling thread.
 		void EndFrame();
+		// Finishes the ImGui frame (and its platform windows) and returns the main viewport draw data.
+		ImDrawData* RenderUI();
+		// Records, executes and presents one frame. Safe to call from a render thread.
+		void SubmitFrame( ImDrawData* drawData );
 		void SetFullscreen();
 		void SetFullscreen( bool fullscreen );
 		void ToggleVSync();
-	private:
-		void EnableDebugLayer();
-		ComPtr<IDXGIAdapter4> GetAdapter( bool useWarp );
-		ComPtr<ID3D12Device14> CreateDevice( ComPtr<IDXGIAdapter4> adapter );
-		ComPtr<ID3D12CommandQueue> CreateCommandQueue( ComPtr<ID3D12Device14> device, D3D12_COMMAND_LIST_TYPE type );
-		bool CheckTearingSupport();
-		ComPtr<IDXGISwapChain4> CreateSwapChain( HWND hWnd, ComPtr<ID3D12CommandQueue> commandQueue,
-			uint32_t width, uint32_t height, uint32_t bufferCount );
-		ComPtr<ID3D12DescriptorHeap> CreateDescriptorHeap( ComPtr<ID3D12Device14> device,
-			D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t numDescriptors );
-		void UpdateRenderTargetViews( ComPtr<ID3D12Device14> device,
-			ComPtr<IDXGISwapChain4> swapChain, ComPtr<ID3D12DescriptorHeap> descriptorHeap );
-		ComPtr<ID3D12CommandAllocator> CreateCommandAllocator( ComPtr<ID3D12Device14> device,
-			D3D12_COMMAND_LIST_TYPE type );
-		ComPtr<ID3D12GraphicsCommandList> CreateCommandList( ComPtr<ID3D12Device14> device,
-			ComPtr<ID3D12CommandAllocator> commandAllocator, D3D12_COMMAND_LIST_TYPE type );
-		ComPtr<ID3D12Fence> CreateFence( ComPtr<ID3D12Device14> device );
-		HANDLE CreateEventHandle();
-		uint64_t Signal( ComPtr<ID3D12CommandQueue> commandQueue, ComPtr<ID3D12Fence> fence,
-			uint64_t& fenceValue );
-		void WaitForFenceValue( ComPtr<ID3D12Fence> fence, uint64_t fenceValue, HANDLE fenceEvent,
-			std::chrono::milliseconds duration = std::chrono::milliseconds::max() );
-		void Flush( ComPtr<ID3D12CommandQueue> commandQueue, ComPtr<ID3D12Fence> fence,
-			uint64_t& fenceValue, HANDLE fenceEvent );
-		
+		// Throws before Init.
+		RHI::Device& GetDevice();
 	private:
 		// Window handle.
 		HWND _HWnd;
@@ -70,43 +60,21 @@ namespace CronoEngine::Graphics
 		// Window rectangle (used to toggle fullscreen state).
 		RECT _WindowRect;
 		// The number of swap chain back buffers.
-#define NumFrames 3
+		static constexpr uint32_t NumFrames = 3;
 		// Use WARP adapter
 		bool _UseWarp = false;
 		// Set to true once the DX12 objects have been initialized.
 		bool _IsInitialized = false;
-		// DirectX 12 Objects
-		ComPtr<ID3D12Device14> _Device;
-		ComPtr<ID3D12CommandQueue> _CommandQueue;
-		ComPtr<IDXGISwapChain4> _SwapChain;
-		ComPtr<ID3D12Resource> _BackBuffers[NumFrames];
-		ComPtr<ID3D12GraphicsCommandList> _CommandList;
-		ComPtr<ID3D12CommandAllocator> _CommandAllocators[NumFrames];
-		ComPtr<ID3D12DescriptorHeap> _SRVDescriptorHeap;
-		ComPtr<ID3D12DescriptorHeap> _RTVDescriptorHeap;
-		UINT _RTVDescriptorSize;
-		UINT _CurrentBackBufferIndex;
-		// Synchronization objects
-		ComPtr<ID3D12Fence> _Fence;
-		uint64_t _FenceValue = 0;
-		uint64_t _FrameFenceValues[NumFrames] = {};
-		HANDLE _FenceEvent;
+		std::unique_ptr<DX12Device> _Device;
+		std::unique_ptr<RHI::SwapChain> _SwapChain;
+		std::unique_ptr<FrameRenderer> _Frames;
 		// By default, enable V-Sync.
-		// Can be toggled with the V key.
-		bool _VSync = true;
-		bool _TearingSupported = false;
+		// Can be toggled with the V key, on the main thread while a render thread reads it.
+		std::atomic<bool> _VSync = true;
 		// By default, use windowed mode.
 		// Can be toggled with the Alt+Enter or F11
 		bool _Fullscreen = false;
-
-		// IMGUI TEST
-		
-		void WaitForNextFrameResources();
-		bool g_SwapChainOccluded = false;
-		bool show_demo_window = true;
-		bool show_another_window;
-		ImVec4 clear_color = ImVec4( 0.45f, 0.55f, 0.60f, 1.00f );
-		HANDLE g_hSwapChainWaitableObject = nullptr;
+		// Held while a frame is submitted so Resize can't swap the back buffers underneath it.
+		std::mutex _FrameMutex;
 	};
 }
-
@@ -0,0 +1,1224 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "DX12Device.h"
+#include <array>
+#include <cstring>
+
+namespace CronoEngine::Graphics
+{
+	namespace
+	{
+		D3D12_COMMAND_LIST_TYPE GetListType( RHI::QueueType type ) noexcept
+		{
+			switch (type)
+			{
+			case RHI::QueueType::Compute: return D3D12_COMMAND_LIST_TYPE_COMPUTE;
+			case RHI::QueueType::Copy: return D3D12_COMMAND_LIST_TYPE_COPY;
+			default: return D3D12_COMMAND_LIST_TYPE_DIRECT;
+			}
+		}
+
+		// RHI::ResourceState uses the D3D12 bits.
+		D3D12_RESOURCE_STATES ToD3D12State( RHI::ResourceState state ) noexcept
+		{
+			return static_cast<D3D12_RESOURCE_STATES>(state);
+		}
+
+		void SetDebugName( ID3D12Object* object, const std::string& name )
+		{
+			if (!name.empty())
+			{
+				object->SetName( std::wstring( name.begin(), name.end() ).c_str() );
+			}
+		}
+
+		// Depth textures read by shaders are typeless, their views name the format.
+		DXGI_FORMAT GetResourceFormat( const RHI::TextureDesc& desc ) noexcept
+		{
+			if (RHI::HasFlags( desc.Usage, RHI::TextureUsage::ShaderResource ))
+			{
+				if (desc.Format == RHI::PixelFormat::D32_Float)
+				{
+					return DXGI_FORMAT_R32_TYPELESS;
+				}
+				if (desc.Format == RHI::PixelFormat::D24_UNorm_S8_UInt)
+				{
+					return DXGI_FORMAT_R24G8_TYPELESS;
+				}
+			}
+			return DX12Device::GetFormat( desc.Format );
+		}
+
+		DXGI_FORMAT GetShaderResourceFormat( RHI::PixelFormat format ) noexcept
+		{
+			if (format == RHI::PixelFormat::D32_Float)
+			{
+				return DXGI_FORMAT_R32_FLOAT;
+			}
+			if (format == RHI::PixelFormat::D24_UNorm_S8_UInt)
+			{
+				return DXGI_FORMAT_R24_UNORM_X8_TYPELESS;
+			}
+			return DX12Device::GetFormat( format );
+		}
+
+		D3D12_RESOURCE_DESC GetResourceDesc( const RHI::TextureDesc& desc ) noexcept
+		{
+			D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE;
+			if (RHI::HasFlags( desc.Usage, RHI::TextureUsage::RenderTarget ))
+			{
+				flags |= D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+			}
+			if (RHI::HasFlags( desc.Usage, RHI::TextureUsage::DepthStencil ))
+			{
+				flags |= D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+				if (!RHI::HasFlags( desc.Usage, RHI::TextureUsage::ShaderResource ))
+				{
+					flags |= D3D12_RESOURCE_FLAG_DENY_SHADER_RESOURCE;
+				}
+			}
+			if (RHI::HasFlags( desc.Usage, RHI::TextureUsage::UnorderedAccess ))
+			{
+				flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+			}
+			return CD3DX12_RESOURCE_DESC::Tex2D( GetResourceFormat( desc ), desc.Width, desc.Height,
+				1, desc.MipLevels, 1, 0, flags );
+		}
+	}
+
+	class DX12Buffer : public RHI::Buffer
+	{
+	public:
+		// Committed, or placed in heap from offset.
+		DX12Buffer( ID3D12Device14* device, const RHI::BufferDesc& desc, ID3D12Heap* heap = nullptr, uint64_t offset = 0 )
+			: Buffer( desc )
+		{
+			D3D12_HEAP_TYPE heapType = D3D12_HEAP_TYPE_DEFAULT;
+			D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_COMMON;
+			if (desc.Memory == RHI::MemoryType::Upload)
+			{
+				heapType = D3D12_HEAP_TYPE_UPLOAD;
+				state = D3D12_RESOURCE_STATE_GENERIC_READ;
+			}
+			else if (desc.Memory == RHI::MemoryType::Readback)
+			{
+				heapType = D3D12_HEAP_TYPE_READBACK;
+				state = D3D12_RESOURCE_STATE_COPY_DEST;
+			}
+			const D3D12_RESOURCE_FLAGS flags = RHI::HasFlags( desc.Usage, RHI::BufferUsage::UnorderedAccess ) ?
+				D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS : D3D12_RESOURCE_FLAG_NONE;
+			const CD3DX12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Buffer( desc.Size, flags );
+			if (heap != nullptr)
+			{
+				ThrowIfFailed( device->CreatePlacedResource( heap, offset, &resourceDesc, state, nullptr, IID_PPV_ARGS( &_Resource ) ) );
+			}
+			else
+			{
+				const CD3DX12_HEAP_PROPERTIES properties( heapType );
+				ThrowIfFailed( device->CreateCommittedResource( &properties, D3D12_HEAP_FLAG_NONE, &resourceDesc, state,
+					nullptr, IID_PPV_ARGS( &_Resource ) ) );
+			}
+			SetDebugName( _Resource.Get(), desc.DebugName );
+
+			if (desc.Memory != RHI::MemoryType::Default)
+			{
+				// Upload memory is never read by the CPU.
+				const D3D12_RANGE nothingRead = { 0, 0 };
+				ThrowIfFailed( _Resource->Map( 0, desc.Memory == RHI::MemoryType::Upload ? &nothingRead : nullptr, &_Mapped ) );
+			}
+		}
+
+		void* GetMappedData() noexcept override
+		{
+			return _Mapped;
+		}
+
+		ID3D12Resource* GetResource() const noexcept
+		{
+			return _Resource.Get();
+		}
+
+		D3D12_GPU_VIRTUAL_ADDRESS GetAddress() const noexcept
+		{
+			return _Resource->GetGPUVirtualAddress();
+		}
+	private:
+		ComPtr<ID3D12Resource> _Resource;
+		void* _Mapped = nullptr;
+	};
+
+	class DX12Texture : public RHI::Texture
+	{
+	public:
+		// Committed, or placed in heap from offset.
+		DX12Texture( DX12Device& device, const RHI::TextureDesc& desc, ID3D12Heap* heap = nullptr, uint64_t offset = 0 )
+			: Texture( desc ), _Device( device )
+		{
+			const D3D12_RESOURCE_DESC resourceDesc = GetResourceDesc( desc );
+			D3D12_CLEAR_VALUE clearValue = {};
+			clearValue.Format = DX12Device::GetFormat( desc.Format );
+			const bool hasClearValue = (resourceDesc.Flags &
+				(D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) != 0;
+			if (RHI::IsDepthFormat( desc.Format ))
+			{
+				clearValue.DepthStencil.Depth = desc.ClearValue[0];
+			}
+			else
+			{
+				std::copy( desc.ClearValue, desc.ClearValue + 4, clearValue.Color );
+			}
+			if (heap != nullptr)
+			{
+				ThrowIfFailed( device.GetD3D12Device()->CreatePlacedResource( heap, offset, &resourceDesc,
+					ToD3D12State( desc.InitialState ), hasClearValue ? &clearValue : nullptr, IID_PPV_ARGS( &_Resource ) ) );
+			}
+			else
+			{
+				const CD3DX12_HEAP_PROPERTIES properties( D3D12_HEAP_TYPE_DEFAULT );
+				ThrowIfFailed( device.GetD3D12Device()->CreateCommittedResource( &properties, D3D12_HEAP_FLAG_NONE, &resourceDesc,
+					ToD3D12State( desc.InitialState ), hasClearValue ? &clearValue : nullptr, IID_PPV_ARGS( &_Resource ) ) );
+			}
+			SetDebugName( _Resource.Get(), desc.DebugName );
+			CreateViews();
+		}
+
+		// Wraps a swap chain back buffer.
+		DX12Texture( DX12Device& device, const RHI::TextureDesc& desc, ComPtr<ID3D12Resource> resource )
+			: Texture( desc ), _Device( device ), _Resource( std::move( resource ) )
+		{
+			CreateViews();
+		}
+
+		~DX12Texture()
+		{
+			if (_RTV.ptr != 0)
+			{
+				_Device.FreeDescriptor( D3D12_DESCRIPTOR_HEAP_TYPE_RTV, _RTV );
+			}
+			if (_DSV.ptr != 0)
+			{
+				_Device.FreeDescriptor( D3D12_DESCRIPTOR_HEAP_TYPE_DSV, _DSV );
+			}
+			if (_ShaderResourceIndex != UINT32_MAX)
+			{
+				_Device.FreeShaderResources( { _ShaderResourceIndex, 1 } );
+			}
+		}
+
+		ID3D12Resource* GetResource() const noexcept
+		{
+			return _Resource.Get();
+		}
+
+		D3D12_CPU_DESCRIPTOR_HANDLE GetRTV() const noexcept
+		{
+			return _RTV;
+		}
+
+		D3D12_CPU_DESCRIPTOR_HANDLE GetDSV() const noexcept
+		{
+			return _DSV;
+		}
+	private:
+		void CreateViews()
+		{
+			if (RHI::HasFlags( _Desc.Usage, RHI::TextureUsage::RenderTarget ))
+			{
+				_RTV = _Device.AllocateDescriptor( D3D12_DESCRIPTOR_HEAP_TYPE_RTV );
+				_Device.GetD3D12Device()->CreateRenderTargetView( _Resource.Get(), nullptr, _RTV );
+			}
+			if (RHI::HasFlags( _Desc.Usage, RHI::TextureUsage::DepthStencil ))
+			{
+				D3D12_DEPTH_STENCIL_VIEW_DESC viewDesc = {};
+				viewDesc.Format = DX12Device::GetFormat( _Desc.Format );
+				viewDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
+				_DSV = _Device.AllocateDescriptor( D3D12_DESCRIPTOR_HEAP_TYPE_DSV );
+				_Device.GetD3D12Device()->CreateDepthStencilView( _Resource.Get(), &viewDesc, _DSV );
+			}
+			if (RHI::HasFlags( _Desc.Usage, RHI::TextureUsage::ShaderResource ))
+			{
+				_ShaderResourceIndex = _Device.CreateShaderResourceView( _Resource.Get(), _Desc );
+			}
+		}
+	private:
+		DX12Device& _Device;
+		ComPtr<ID3D12Resource> _Resource;
+		D3D12_CPU_DESCRIPTOR_HANDLE _RTV = {};
+		D3D12_CPU_DESCRIPTOR_HANDLE _DSV = {};
+	};
+
+	class DX12Heap : public RHI::Heap
+	{
+	public:
+		DX12Heap( ID3D12Device14* device, const RHI::HeapDesc& desc )
+			: Heap( desc )
+		{
+			D3D12_HEAP_TYPE type = D3D12_HEAP_TYPE_DEFAULT;
+			if (desc.Memory == RHI::MemoryType::Upload)
+			{
+				type = D3D12_HEAP_TYPE_UPLOAD;
+			}
+			else if (desc.Memory == RHI::MemoryType::Readback)
+			{
+				type = D3D12_HEAP_TYPE_READBACK;
+			}
+			// The tier 1 split, so heaps work on every adapter.
+			D3D12_HEAP_FLAGS flags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+			if (desc.Contents == RHI::HeapContents::Textures)
+			{
+				flags = D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+			}
+			else if (desc.Contents == RHI::HeapContents::RenderTargets)
+			{
+				flags = D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+			}
+			const CD3DX12_HEAP_DESC heapDesc( desc.Size, type, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT, flags );
+			ThrowIfFailed( device->CreateHeap( &heapDesc, IID_PPV_ARGS( &_Heap ) ) );
+			SetDebugName( _Heap.Get(), desc.DebugName );
+		}
+
+		ID3D12Heap* GetHeap() const noexcept
+		{
+			return _Heap.Get();
+		}
+	private:
+		ComPtr<ID3D12Heap> _Heap;
+	};
+
+	class DX12Pipeline : public RHI::Pipeline
+	{
+	public:
+		DX12Pipeline( ID3D12Device14* device, const RHI::PipelineDesc& desc )
+			: Pipeline( desc )
+		{
+			std::vector<D3D12_ROOT_PARAMETER> parameters( desc.ConstantBufferCount );
+			for (uint32_t i = 0; i < desc.ConstantBufferCount; ++i)
+			{
+				parameters[i].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
+				parameters[i].Descriptor.ShaderRegister = i;
+				parameters[i].Descriptor.RegisterSpace = 0;
+				parameters[i].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+			}
+			// The whole bindless heap as one table after the constant buffers.
+			const CD3DX12_DESCRIPTOR_RANGE bindless( D3D12_DESCRIPTOR_RANGE_TYPE_SRV,
+				RHI::PersistentDescriptors + RHI::FrameDescriptors, 0, 1 );
+			CD3DX12_STATIC_SAMPLER_DESC sampler( 0, D3D12_FILTER_MIN_MAG_MIP_LINEAR );
+			sampler.RegisterSpace = 1;
+			if (desc.BindlessTextures)
+			{
+				CD3DX12_ROOT_PARAMETER table;
+				table.InitAsDescriptorTable( 1, &bindless );
+				parameters.push_back( table );
+			}
+			D3D12_ROOT_SIGNATURE_DESC rootDesc = {};
+			rootDesc.NumParameters = static_cast<UINT>(parameters.size());
+			rootDesc.pParameters = parameters.data();
+			if (desc.BindlessTextures)
+			{
+				rootDesc.NumStaticSamplers = 1;
+				rootDesc.pStaticSamplers = &sampler;
+			}
+			rootDesc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
+			ComPtr<ID3DBlob> signature;
+			ComPtr<ID3DBlob> error;
+			ThrowIfFailed( D3D12SerializeRootSignature( &rootDesc, D3D_ROOT_SIGNATURE_VERSION_1, &signature, &error ) );
+			ThrowIfFailed( device->CreateRootSignature( 0, signature->GetBufferPointer(), signature->GetBufferSize(),
+				IID_PPV_ARGS( &_RootSignature ) ) );
+
+			std::vector<D3D12_INPUT_ELEMENT_DESC> elements;
+			for (const RHI::VertexAttribute& attribute : desc.InputLayout)
+			{
+				elements.push_back( { attribute.Semantic, attribute.SemanticIndex, DX12Device::GetFormat( attribute.Format ),
+					0, attribute.Offset, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 } );
+			}
+
+			D3D12_GRAPHICS_PIPELINE_STATE_DESC stateDesc = {};
+			stateDesc.pRootSignature = _RootSignature.Get();
+			stateDesc.VS = { desc.VertexShader.Data, desc.VertexShader.Size };
+			stateDesc.PS = { desc.PixelShader.Data, desc.PixelShader.Size };
+			stateDesc.InputLayout = { elements.data(), static_cast<UINT>(elements.size()) };
+			stateDesc.RasterizerState = CD3DX12_RASTERIZER_DESC( D3D12_DEFAULT );
+			stateDesc.RasterizerState.CullMode = desc.Cull == RHI::CullMode::None ? D3D12_CULL_MODE_NONE :
+				desc.Cull == RHI::CullMode::Front ? D3D12_CULL_MODE_FRONT : D3D12_CULL_MODE_BACK;
+			stateDesc.BlendState = CD3DX12_BLEND_DESC( D3D12_DEFAULT );
+			if (desc.AlphaBlend)
+			{
+				for (D3D12_RENDER_TARGET_BLEND_DESC& target : stateDesc.BlendState.RenderTarget)
+				{
+					target.BlendEnable = TRUE;
+					target.SrcBlend = D3D12_BLEND_SRC_ALPHA;
+					target.DestBlend = D3D12_BLEND_INV_SRC_ALPHA;
+					target.BlendOp = D3D12_BLEND_OP_ADD;
+					target.SrcBlendAlpha = D3D12_BLEND_ONE;
+					target.DestBlendAlpha = D3D12_BLEND_INV_SRC_ALPHA;
+					target.BlendOpAlpha = D3D12_BLEND_OP_ADD;
+				}
+			}
+			stateDesc.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC( D3D12_DEFAULT );
+			stateDesc.DepthStencilState.DepthEnable = desc.DepthTest ? TRUE : FALSE;
+			stateDesc.DepthStencilState.DepthWriteMask = desc.DepthWrite ? D3D12_DEPTH_WRITE_MASK_ALL : D3D12_DEPTH_WRITE_MASK_ZERO;
+			stateDesc.SampleMask = UINT_MAX;
+			switch (desc.Topology)
+			{
+			case RHI::PrimitiveTopology::LineList:
+				stateDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE;
+				_Topology = D3D_PRIMITIVE_TOPOLOGY_LINELIST;
+				break;
+			case RHI::PrimitiveTopology::PointList:
+				stateDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_POINT;
+				_Topology = D3D_PRIMITIVE_TOPOLOGY_POINTLIST;
+				break;
+			case RHI::PrimitiveTopology::TriangleStrip:
+				stateDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+				_Topology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP;
+				break;
+			default:
+				stateDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+				_Topology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+				break;
+			}
+			stateDesc.NumRenderTargets = desc.RenderTargetCount;
+			for (uint32_t i = 0; i < desc.RenderTargetCount; ++i)
+			{
+				stateDesc.RTVFormats[i] = DX12Device::GetFormat( desc.RenderTargetFormats[i] );
+			}
+			stateDesc.DSVFormat = DX12Device::GetFormat( desc.DepthFormat );
+			stateDesc.SampleDesc = { 1, 0 };
+			ThrowIfFailed( device->CreateGraphicsPipelineState( &stateDesc, IID_PPV_ARGS( &_State ) ) );
+			SetDebugName( _State.Get(), desc.DebugName );
+		}
+
+		ID3D12PipelineState* GetState() const noexcept
+		{
+			return _State.Get();
+		}
+
+		ID3D12RootSignature* GetRootSignature() const noexcept
+		{
+			return _RootSignature.Get();
+		}
+
+		D3D_PRIMITIVE_TOPOLOGY GetTopology() const noexcept
+		{
+			return _Topology;
+		}
+	private:
+		ComPtr<ID3D12RootSignature> _RootSignature;
+		ComPtr<ID3D12PipelineState> _State;
+		D3D_PRIMITIVE_TOPOLOGY _Topology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	};
+
+	class DX12Fence : public RHI::Fence
+	{
+	public:
+		DX12Fence( ID3D12Device14* device, uint64_t initialValue )
+		{
+			ThrowIfFailed( device->CreateFence( initialValue, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS( &_Fence ) ) );
+		}
+
+		uint64_t GetCompletedValue() const override
+		{
+			return _Fence->GetCompletedValue();
+		}
+
+		void Wait( uint64_t value ) override
+		{
+			if (_Fence->GetCompletedValue() < value)
+			{
+				// Without an event the call itself blocks, so any number of threads can wait.
+				ThrowIfFailed( _Fence->SetEventOnCompletion( value, nullptr ) );
+			}
+		}
+
+		ID3D12Fence* GetFence() const noexcept
+		{
+			return _Fence.Get();
+		}
+	private:
+		ComPtr<ID3D12Fence> _Fence;
+	};
+
+	class DX12CommandList : public RHI::CommandList
+	{
+	public:
+		using CommandList::Barrier;
+
+		DX12CommandList( DX12Device& device, RHI::QueueType type )
+			: _Device( device ), _Type( type )
+		{
+			const D3D12_COMMAND_LIST_TYPE listType = GetListType( type );
+			ThrowIfFailed( device.GetD3D12Device()->CreateCommandAllocator( listType, IID_PPV_ARGS( &_Allocator ) ) );
+			ThrowIfFailed( device.GetD3D12Device()->CreateCommandList( 0, listType, _Allocator.Get(), nullptr,
+				IID_PPV_ARGS( &_List ) ) );
+			ThrowIfFailed( _List->Close() );
+		}
+
+		RHI::QueueType GetType() const noexcept override
+		{
+			return _Type;
+		}
+
+		void Begin() override
+		{
+			ThrowIfFailed( _Allocator->Reset() );
+			ThrowIfFailed( _List->Reset( _Allocator.Get(), nullptr ) );
+			if (_Type != RHI::QueueType::Copy)
+			{
+				ID3D12DescriptorHeap* heaps[] = { _Device.GetShaderResourceHeap() };
+				_List->SetDescriptorHeaps( 1, heaps );
+			}
+			_Pipeline = nullptr;
+			_VertexBuffers = {};
+			_ConstantBuffers = {};
+			_BindingsDirty = false;
+		}
+
+		void End() override
+		{
+			ThrowIfFailed( _List->Close() );
+		}
+
+		void Barrier( const RHI::ResourceBarrier* barriers, uint32_t count ) override
+		{
+			_Barriers.clear();
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				const RHI::ResourceBarrier& barrier = barriers[i];
+				if (barrier.Type == RHI::BarrierType::Aliasing)
+				{
+					_Barriers.push_back( CD3DX12_RESOURCE_BARRIER::Aliasing( nullptr, GetResource( *barrier.Target ) ) );
+				}
+				else if (barrier.Type == RHI::BarrierType::UnorderedAccess)
+				{
+					_Barriers.push_back( CD3DX12_RESOURCE_BARRIER::UAV( GetResource( *barrier.Target ) ) );
+				}
+				else if (barrier.Before != barrier.After)
+				{
+					_Barriers.push_back( CD3DX12_RESOURCE_BARRIER::Transition( GetResource( *barrier.Target ),
+						ToD3D12State( barrier.Before ), ToD3D12State( barrier.After ) ) );
+				}
+			}
+			if (!_Barriers.empty())
+			{
+				_List->ResourceBarrier( static_cast<UINT>(_Barriers.size()), _Barriers.data() );
+			}
+		}
+
+		void ClearRenderTarget( RHI::Texture& target, const float color[4] ) override
+		{
+			_List->ClearRenderTargetView( static_cast<DX12Texture&>(target).GetRTV(), color, 0, nullptr );
+		}
+
+		void ClearDepth( RHI::Texture& target, float depth ) override
+		{
+			_List->ClearDepthStencilView( static_cast<DX12Texture&>(target).GetDSV(), D3D12_CLEAR_FLAG_DEPTH, depth, 0, 0, nullptr );
+		}
+
+		void SetRenderTargets( RHI::Texture* const* targets, uint32_t count, RHI::Texture* depth ) override
+		{
+			D3D12_CPU_DESCRIPTOR_HANDLE views[RHI::MaxRenderTargets] = {};
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				views[i] = static_cast<DX12Texture*>(targets[i])->GetRTV();
+			}
+			D3D12_CPU_DESCRIPTOR_HANDLE depthView = {};
+			if (depth != nullptr)
+			{
+				depthView = static_cast<DX12Texture*>(depth)->GetDSV();
+			}
+			_List->OMSetRenderTargets( count, views, FALSE, depth != nullptr ? &depthView : nullptr );
+		}
+
+		void SetViewport( const RHI::Viewport& viewport ) override
+		{
+			const D3D12_VIEWPORT view = { viewport.X, viewport.Y, viewport.Width, viewport.Height, viewport.MinDepth, viewport.MaxDepth };
+			_List->RSSetViewports( 1, &view );
+		}
+
+		void SetScissor( const RHI::ScissorRect& scissor ) override
+		{
+			const D3D12_RECT rect = { scissor.Left, scissor.Top, scissor.Right, scissor.Bottom };
+			_List->RSSetScissorRects( 1, &rect );
+		}
+
+		void SetPipeline( RHI::Pipeline& pipeline ) override
+		{
+			DX12Pipeline& dx12Pipeline = static_cast<DX12Pipeline&>(pipeline);
+			_List->SetPipelineState( dx12Pipeline.GetState() );
+			if (_Pipeline == nullptr || _Pipeline->GetRootSignature() != dx12Pipeline.GetRootSignature())
+			{
+				// A new root signature drops the root arguments, they go again before the next draw.
+				_List->SetGraphicsRootSignature( dx12Pipeline.GetRootSignature() );
+			}
+			_List->IASetPrimitiveTopology( dx12Pipeline.GetTopology() );
+			_Pipeline = &dx12Pipeline;
+			_BindingsDirty = true;
+		}
+
+		void SetVertexBuffer( uint32_t slot, RHI::Buffer& buffer, uint64_t offset ) override
+		{
+			DX12Buffer& dx12Buffer = static_cast<DX12Buffer&>(buffer);
+			// The stride comes from the pipeline, which may be set after this.
+			_VertexBuffers[slot] = { dx12Buffer.GetAddress() + offset, static_cast<UINT>(buffer.GetDesc().Size - offset), 0 };
+			_BindingsDirty = true;
+		}
+
+		void SetIndexBuffer( RHI::Buffer& buffer, uint64_t offset, RHI::IndexFormat format ) override
+		{
+			DX12Buffer& dx12Buffer = static_cast<DX12Buffer&>(buffer);
+			const D3D12_INDEX_BUFFER_VIEW view = { dx12Buffer.GetAddress() + offset, static_cast<UINT>(buffer.GetDesc().Size - offset),
+				format == RHI::IndexFormat::UInt16 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT };
+			_List->IASetIndexBuffer( &view );
+		}
+
+		void SetConstantBuffer( uint32_t slot, RHI::Buffer& buffer, uint64_t offset ) override
+		{
+			_ConstantBuffers[slot] = static_cast<DX12Buffer&>(buffer).GetAddress() + offset;
+			_BindingsDirty = true;
+		}
+
+		void Draw( uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance ) override
+		{
+			FlushBindings();
+			_List->DrawInstanced( vertexCount, instanceCount, firstVertex, firstInstance );
+		}
+
+		void DrawIndexed( uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex,
+			int32_t baseVertex, uint32_t firstInstance ) override
+		{
+			FlushBindings();
+			_List->DrawIndexedInstanced( indexCount, instanceCount, firstIndex, baseVertex, firstInstance );
+		}
+
+		void CopyBuffer( RHI::Buffer& destination, uint64_t destinationOffset,
+			RHI::Buffer& source, uint64_t sourceOffset, uint64_t size ) override
+		{
+			_List->CopyBufferRegion( static_cast<DX12Buffer&>(destination).GetResource(), destinationOffset,
+				static_cast<DX12Buffer&>(source).GetResource(), sourceOffset, size );
+		}
+
+		void CopyBufferToTexture( RHI::Texture& destination, RHI::Buffer& source, uint64_t sourceOffset, uint32_t rowPitch ) override
+		{
+			const RHI::TextureDesc& desc = destination.GetDesc();
+			D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = {};
+			footprint.Offset = sourceOffset;
+			footprint.Footprint = { DX12Device::GetFormat( desc.Format ), desc.Width, desc.Height, 1, rowPitch };
+			const CD3DX12_TEXTURE_COPY_LOCATION to( static_cast<DX12Texture&>(destination).GetResource(), 0 );
+			const CD3DX12_TEXTURE_COPY_LOCATION from( static_cast<DX12Buffer&>(source).GetResource(), footprint );
+			_List->CopyTextureRegion( &to, 0, 0, 0, &from, nullptr );
+		}
+
+		void DrawUI( ImDrawData* drawData ) override
+		{
+			// The font is in the bindless heap Begin set.
+			ImGui_ImplDX12_RenderDrawData( drawData, _List.Get() );
+			// ImGui leaves its own pipeline and root signature bound.
+			_Pipeline = nullptr;
+		}
+
+		void BeginEvent( const char* name ) override
+		{
+			// Metadata 0 is a wide string, which PIX and RenderDoc both show.
+			const std::wstring wideName( name, name + std::strlen( name ) );
+			_List->BeginEvent( 0, wideName.c_str(), static_cast<UINT>((wideName.size() + 1) * sizeof( wchar_t )) );
+		}
+
+		void EndEvent() override
+		{
+			_List->EndEvent();
+		}
+
+		ID3D12GraphicsCommandList* GetList() const noexcept
+		{
+			return _List.Get();
+		}
+	private:
+		static ID3D12Resource* GetResource( RHI::Resource& resource ) noexcept
+		{
+			if (DX12Buffer* buffer = dynamic_cast<DX12Buffer*>(&resource))
+			{
+				return buffer->GetResource();
+			}
+			return static_cast<DX12Texture&>(resource).GetResource();
+		}
+
+		void FlushBindings()
+		{
+			if (!_BindingsDirty || _Pipeline == nullptr)
+			{
+				return;
+			}
+			const RHI::PipelineDesc& desc = _Pipeline->GetDesc();
+			if (!desc.InputLayout.empty())
+			{
+				for (D3D12_VERTEX_BUFFER_VIEW& view : _VertexBuffers)
+				{
+					view.StrideInBytes = desc.VertexStride;
+				}
+				_List->IASetVertexBuffers( 0, RHI::MaxVertexBuffers, _VertexBuffers.data() );
+			}
+			for (uint32_t i = 0; i < desc.ConstantBufferCount; ++i)
+			{
+				_List->SetGraphicsRootConstantBufferView( i, _ConstantBuffers[i] );
+			}
+			if (desc.BindlessTextures)
+			{
+				_List->SetGraphicsRootDescriptorTable( desc.ConstantBufferCount, _Device.GetShaderResourceGPUHandle( 0 ) );
+			}
+			_BindingsDirty = false;
+		}
+	private:
+		DX12Device& _Device;
+		const RHI::QueueType _Type;
+		ComPtr<ID3D12CommandAllocator> _Allocator;
+		ComPtr<ID3D12GraphicsCommandList> _List;
+		std::vector<D3D12_RESOURCE_BARRIER> _Barriers;
+		DX12Pipeline* _Pipeline = nullptr;
+		// Root arguments and vertex buffers wait for the pipeline, set at the next draw.
+		std::array<D3D12_VERTEX_BUFFER_VIEW, RHI::MaxVertexBuffers> _VertexBuffers = {};
+		std::array<D3D12_GPU_VIRTUAL_ADDRESS, RHI::MaxConstantBuffers> _ConstantBuffers = {};
+		bool _BindingsDirty = false;
+	};
+
+	class DX12Queue : public RHI::Queue
+	{
+	public:
+		DX12Queue( ID3D12Device14* device, RHI::QueueType type )
+			: _Type( type )
+		{
+			D3D12_COMMAND_QUEUE_DESC desc = {};
+			desc.Type = GetListType( type );
+			desc.Priority = D3D12_COMMAND_QUEUE_PRIORITY_NORMAL;
+			desc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+			desc.NodeMask = 0;
+			ThrowIfFailed( device->CreateCommandQueue( &desc, IID_PPV_ARGS( &_Queue ) ) );
+			ThrowIfFailed( device->CreateFence( 0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS( &_IdleFence ) ) );
+		}
+
+		RHI::QueueType GetType() const noexcept override
+		{
+			return _Type;
+		}
+
+		void Submit( RHI::CommandList* const* lists, uint32_t count ) override
+		{
+			ID3D12CommandList* d3d12Lists[16];
+			for (uint32_t begin = 0; begin < count; begin += static_cast<uint32_t>(std::size( d3d12Lists )))
+			{
+				const uint32_t batch = std::min( count - begin, static_cast<uint32_t>(std::size( d3d12Lists )) );
+				for (uint32_t i = 0; i < batch; ++i)
+				{
+					d3d12Lists[i] = static_cast<DX12CommandList*>(lists[begin + i])->GetList();
+				}
+				_Queue->ExecuteCommandLists( batch, d3d12Lists );
+			}
+		}
+
+		void Signal( RHI::Fence& fence, uint64_t value ) override
+		{
+			ThrowIfFailed( _Queue->Signal( static_cast<DX12Fence&>(fence).GetFence(), value ) );
+		}
+
+		void Wait( RHI::Fence& fence, uint64_t value ) override
+		{
+			ThrowIfFailed( _Queue->Wait( static_cast<DX12Fence&>(fence).GetFence(), value ) );
+		}
+
+		void WaitIdle() override
+		{
+			std::lock_guard<std::mutex> lock( _IdleMutex );
+			const uint64_t value = ++_IdleValue;
+			ThrowIfFailed( _Queue->Signal( _IdleFence.Get(), value ) );
+			if (_IdleFence->GetCompletedValue() < value)
+			{
+				ThrowIfFailed( _IdleFence->SetEventOnCompletion( value, nullptr ) );
+			}
+		}
+
+		ID3D12CommandQueue* GetQueue() const noexcept
+		{
+			return _Queue.Get();
+		}
+	private:
+		const RHI::QueueType _Type;
+		ComPtr<ID3D12CommandQueue> _Queue;
+		ComPtr<ID3D12Fence> _IdleFence;
+		uint64_t _IdleValue = 0;
+		std::mutex _IdleMutex;
+	};
+
+	class DX12SwapChain : public RHI::SwapChain
+	{
+	public:
+		DX12SwapChain( DX12Device& device, const RHI::SwapChainDesc& desc )
+			: _Device( device ), _Desc( desc )
+		{
+			const HWND hWnd = static_cast<HWND>(desc.Window);
+			ComPtr<IDXGIFactory4> dxgiFactory4;
+			UINT createFactoryFlags = 0;
+#if defined(_DEBUG)
+			createFactoryFlags = DXGI_CREATE_FACTORY_DEBUG;
+#endif
+			ThrowIfFailed( CreateDXGIFactory2( createFactoryFlags, IID_PPV_ARGS( &dxgiFactory4 ) ) );
+			DXGI_SWAP_CHAIN_DESC1 swapChainDesc = {};
+			swapChainDesc.Width = desc.Width;
+			swapChainDesc.Height = desc.Height;
+			swapChainDesc.Format = DX12Device::GetFormat( desc.Format );
+			swapChainDesc.Stereo = FALSE;
+			swapChainDesc.SampleDesc = { 1, 0 };
+			swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+			swapChainDesc.BufferCount = desc.BufferCount;
+			swapChainDesc.Scaling = DXGI_SCALING_STRETCH;
+			swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
+			swapChainDesc.AlphaMode = DXGI_ALPHA_MODE_UNSPECIFIED;
+			// It is recommended to always allow tearing if tearing support is available.
+			swapChainDesc.Flags = device.IsTearingSupported() ? DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING : 0;
+			ComPtr<IDXGISwapChain1> swapChain1;
+			ThrowIfFailed( dxgiFactory4->CreateSwapChainForHwnd( device.GetD3D12Queue( RHI::QueueType::Graphics ),
+				hWnd, &swapChainDesc, nullptr, nullptr, &swapChain1 ) );
+
+			// Disable the Alt+Enter fullscreen toggle feature. Switching to fullscreen
+			// will be handled manually.
+			ThrowIfFailed( dxgiFactory4->MakeWindowAssociation( hWnd, DXGI_MWA_NO_ALT_ENTER ) );
+			ThrowIfFailed( swapChain1.As( &_SwapChain ) );
+			CreateBuffers();
+		}
+
+		const RHI::SwapChainDesc& GetDesc() const noexcept override
+		{
+			return _Desc;
+		}
+
+		uint32_t GetCurrentIndex() const override
+		{
+			return _SwapChain->GetCurrentBackBufferIndex();
+		}
+
+		RHI::Texture& GetBackBuffer( uint32_t index ) override
+		{
+			return *_Buffers[index];
+		}
+
+		void Present( bool vsync ) override
+		{
+			const UINT syncInterval = vsync ? 1 : 0;
+			const UINT presentFlags = _Device.IsTearingSupported() && !vsync ? DXGI_PRESENT_ALLOW_TEARING : 0;
+			ThrowIfFailed( _SwapChain->Present( syncInterval, presentFlags ) );
+		}
+
+		void Resize( uint32_t width, uint32_t height ) override
+		{
+			_Desc.Width = std::max( 1u, width );
+			_Desc.Height = std::max( 1u, height );
+			// Any references to the back buffers must be released
+			// before the swap chain can be resized.
+			_Buffers.clear();
+			DXGI_SWAP_CHAIN_DESC swapChainDesc = {};
+			ThrowIfFailed( _SwapChain->GetDesc( &swapChainDesc ) );
+			ThrowIfFailed( _SwapChain->ResizeBuffers( _Desc.BufferCount, _Desc.Width, _Desc.Height,
+				swapChainDesc.BufferDesc.Format, swapChainDesc.Flags ) );
+			CreateBuffers();
+		}
+	private:
+		void CreateBuffers()
+		{
+			for (uint32_t i = 0; i < _Desc.BufferCount; ++i)
+			{
+				ComPtr<ID3D12Resource> backBuffer;
+				ThrowIfFailed( _SwapChain->GetBuffer( i, IID_PPV_ARGS( &backBuffer ) ) );
+				RHI::TextureDesc desc;
+				desc.Width = _Desc.Width;
+				desc.Height = _Desc.Height;
+				desc.Format = _Desc.Format;
+				desc.Usage = RHI::TextureUsage::RenderTarget;
+				desc.InitialState = RHI::ResourceState::Present;
+				desc.DebugName = "Back Buffer " + std::to_string( i );
+				_Buffers.push_back( std::make_unique<DX12Texture>( _Device, desc, std::move( backBuffer ) ) );
+			}
+		}
+	private:
+		DX12Device& _Device;
+		RHI::SwapChainDesc _Desc;
+		ComPtr<IDXGISwapChain4> _SwapChain;
+		std::vector<std::unique_ptr<DX12Texture>> _Buffers;
+	};
+
+	DX12Device::DX12Device( bool useWarp )
+		: _Descriptors( { RHI::PersistentDescriptors, RHI::FrameDescriptors } )
+	{
+		_TearingSupported = CheckTearingSupport();
+		_Adapter = GetAdapter( useWarp );
+		_Device = CreateDevice( _Adapter );
+		for (size_t i = 0; i < std::size( _Queues ); ++i)
+		{
+			_Queues[i] = std::make_unique<DX12Queue>( _Device.Get(), static_cast<RHI::QueueType>(i) );
+		}
+		CreateDescriptorPool( _RTVs, D3D12_DESCRIPTOR_HEAP_TYPE_RTV, RenderTargetViews );
+		CreateDescriptorPool( _DSVs, D3D12_DESCRIPTOR_HEAP_TYPE_DSV, DepthStencilViews );
+
+		D3D12_DESCRIPTOR_HEAP_DESC desc = {};
+		desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+		desc.NumDescriptors = RHI::PersistentDescriptors + RHI::FrameDescriptors;
+		desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+		ThrowIfFailed( _Device->CreateDescriptorHeap( &desc, IID_PPV_ARGS( &_ShaderResourceHeap ) ) );
+		desc.NumDescriptors = RHI::PersistentDescriptors;
+		desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+		ThrowIfFailed( _Device->CreateDescriptorHeap( &desc, IID_PPV_ARGS( &_StagingHeap ) ) );
+		_ShaderResourceSize = _Device->GetDescriptorHandleIncrementSize( D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV );
+		ThrowIfFailed( _Device->CreateFence( 0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS( &_FrameFence ) ) );
+	}
+
+	DX12Device::~DX12Device()
+	{
+		// Make sure the queues have finished all commands before releasing anything.
+		WaitIdle();
+	}
+
+	const char* DX12Device::GetName() const noexcept
+	{
+		return "DX12";
+	}
+
+	RHI::Queue& DX12Device::GetQueue( RHI::QueueType type )
+	{
+		return *_Queues[static_cast<size_t>(type)];
+	}
+
+	std::unique_ptr<RHI::Buffer> DX12Device::CreateBuffer( const RHI::BufferDesc& desc )
+	{
+		return std::make_unique<DX12Buffer>( _Device.Get(), desc );
+	}
+
+	std::unique_ptr<RHI::Texture> DX12Device::CreateTexture( const RHI::TextureDesc& desc )
+	{
+		return std::make_unique<DX12Texture>( *this, desc );
+	}
+
+	std::unique_ptr<RHI::Pipeline> DX12Device::CreatePipeline( const RHI::PipelineDesc& desc )
+	{
+		return std::make_unique<DX12Pipeline>( _Device.Get(), desc );
+	}
+
+	std::unique_ptr<RHI::Fence> DX12Device::CreateFence( uint64_t initialValue )
+	{
+		return std::make_unique<DX12Fence>( _Device.Get(), initialValue );
+	}
+
+	std::unique_ptr<RHI::CommandList> DX12Device::CreateCommandList( RHI::QueueType type )
+	{
+		return std::make_unique<DX12CommandList>( *this, type );
+	}
+
+	std::unique_ptr<RHI::SwapChain> DX12Device::CreateSwapChain( const RHI::SwapChainDesc& desc )
+	{
+		return std::make_unique<DX12SwapChain>( *this, desc );
+	}
+
+	RHI::ResourceAllocationInfo DX12Device::GetTextureAllocationInfo( const RHI::TextureDesc& desc )
+	{
+		const D3D12_RESOURCE_DESC resourceDesc = GetResourceDesc( desc );
+		const D3D12_RESOURCE_ALLOCATION_INFO info = _Device->GetResourceAllocationInfo( 0, 1, &resourceDesc );
+		return { info.SizeInBytes, info.Alignment };
+	}
+
+	RHI::ResourceAllocationInfo DX12Device::GetBufferAllocationInfo( const RHI::BufferDesc& desc )
+	{
+		const D3D12_RESOURCE_FLAGS flags = RHI::HasFlags( desc.Usage, RHI::BufferUsage::UnorderedAccess ) ?
+			D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS : D3D12_RESOURCE_FLAG_NONE;
+		const CD3DX12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Buffer( desc.Size, flags );
+		const D3D12_RESOURCE_ALLOCATION_INFO info = _Device->GetResourceAllocationInfo( 0, 1, &resourceDesc );
+		return { info.SizeInBytes, info.Alignment };
+	}
+
+	std::unique_ptr<RHI::Heap> DX12Device::CreateHeap( const RHI::HeapDesc& desc )
+	{
+		return std::make_unique<DX12Heap>( _Device.Get(), desc );
+	}
+
+	std::unique_ptr<RHI::Texture> DX12Device::CreatePlacedTexture( const RHI::TextureDesc& desc, RHI::Heap& heap, uint64_t offset )
+	{
+		return std::make_unique<DX12Texture>( *this, desc, static_cast<DX12Heap&>(heap).GetHeap(), offset );
+	}
+
+	std::unique_ptr<RHI::Buffer> DX12Device::CreatePlacedBuffer( const RHI::BufferDesc& desc, RHI::Heap& heap, uint64_t offset )
+	{
+		return std::make_unique<DX12Buffer>( _Device.Get(), desc, static_cast<DX12Heap&>(heap).GetHeap(), offset );
+	}
+
+	RHI::MemoryBudget DX12Device::GetMemoryBudget()
+	{
+		DXGI_QUERY_VIDEO_MEMORY_INFO local = {};
+		DXGI_QUERY_VIDEO_MEMORY_INFO nonLocal = {};
+		ThrowIfFailed( _Adapter->QueryVideoMemoryInfo( 0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &local ) );
+		ThrowIfFailed( _Adapter->QueryVideoMemoryInfo( 0, DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL, &nonLocal ) );
+		return { local.Budget, local.CurrentUsage, nonLocal.Budget, nonLocal.CurrentUsage };
+	}
+
+	void DX12Device::BeginFrame()
+	{
+		ThrowIfFailed( GetD3D12Queue( RHI::QueueType::Graphics )->Signal( _FrameFence.Get(), _Descriptors.GetFrame() ) );
+		_Descriptors.BeginFrame( _FrameFence->GetCompletedValue() );
+	}
+
+	uint32_t DX12Device::AllocateFrameTable( RHI::Texture* const* textures, uint32_t count )
+	{
+		const RHI::DescriptorRange range = _Descriptors.AllocateFrame( count );
+		const CD3DX12_CPU_DESCRIPTOR_HANDLE staging( _StagingHeap->GetCPUDescriptorHandleForHeapStart() );
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			_Device->CopyDescriptorsSimple( 1, GetShaderResourceCPUHandle( range.Index + i ),
+				CD3DX12_CPU_DESCRIPTOR_HANDLE( staging, textures[i]->GetShaderResourceIndex(), _ShaderResourceSize ),
+				D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV );
+		}
+		return range.Index;
+	}
+
+	RHI::DescriptorAllocatorStats DX12Device::GetDescriptorStats() const
+	{
+		return _Descriptors.GetStats();
+	}
+
+	void DX12Device::WaitIdle()
+	{
+		for (const std::unique_ptr<RHI::Queue>& queue : _Queues)
+		{
+			queue->WaitIdle();
+		}
+	}
+
+	ID3D12Device14* DX12Device::GetD3D12Device() const noexcept
+	{
+		return _Device.Get();
+	}
+
+	ID3D12CommandQueue* DX12Device::GetD3D12Queue( RHI::QueueType type ) const
+	{
+		return static_cast<DX12Queue&>(*_Queues[static_cast<size_t>(type)]).GetQueue();
+	}
+
+	bool DX12Device::IsTearingSupported() const noexcept
+	{
+		return _TearingSupported;
+	}
+
+	D3D12_CPU_DESCRIPTOR_HANDLE DX12Device::AllocateDescriptor( D3D12_DESCRIPTOR_HEAP_TYPE type )
+	{
+		DescriptorPool& pool = GetDescriptorPool( type );
+		std::lock_guard<std::mutex> lock( pool.Mutex );
+		if (pool.Free.empty())
+		{
+			throw CHWND_NOGFX_EXCEPT();
+		}
+		const uint32_t slot = pool.Free.back();
+		pool.Free.pop_back();
+		return CD3DX12_CPU_DESCRIPTOR_HANDLE( pool.Heap->GetCPUDescriptorHandleForHeapStart(), slot, pool.Size );
+	}
+
+	void DX12Device::FreeDescriptor( D3D12_DESCRIPTOR_HEAP_TYPE type, D3D12_CPU_DESCRIPTOR_HANDLE descriptor )
+	{
+		DescriptorPool& pool = GetDescriptorPool( type );
+		std::lock_guard<std::mutex> lock( pool.Mutex );
+		const SIZE_T start = pool.Heap->GetCPUDescriptorHandleForHeapStart().ptr;
+		pool.Free.push_back( static_cast<uint32_t>((descriptor.ptr - start) / pool.Size) );
+	}
+
+	ID3D12DescriptorHeap* DX12Device::GetShaderResourceHeap() const noexcept
+	{
+		return _ShaderResourceHeap.Get();
+	}
+
+	RHI::DescriptorRange DX12Device::AllocateShaderResources( uint32_t count )
+	{
+		return _Descriptors.Allocate( count );
+	}
+
+	void DX12Device::FreeShaderResources( RHI::DescriptorRange range )
+	{
+		_Descriptors.Free( range );
+	}
+
+	D3D12_CPU_DESCRIPTOR_HANDLE DX12Device::GetShaderResourceCPUHandle( uint32_t index ) const noexcept
+	{
+		return CD3DX12_CPU_DESCRIPTOR_HANDLE( _ShaderResourceHeap->GetCPUDescriptorHandleForHeapStart(), index, _ShaderResourceSize );
+	}
+
+	D3D12_GPU_DESCRIPTOR_HANDLE DX12Device::GetShaderResourceGPUHandle( uint32_t index ) const noexcept
+	{
+		return CD3DX12_GPU_DESCRIPTOR_HANDLE( _ShaderResourceHeap->GetGPUDescriptorHandleForHeapStart(), index, _ShaderResourceSize );
+	}
+
+	uint32_t DX12Device::CreateShaderResourceView( ID3D12Resource* resource, const RHI::TextureDesc& desc )
+	{
+		const uint32_t index = _Descriptors.Allocate().Index;
+		D3D12_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+		viewDesc.Format = GetShaderResourceFormat( desc.Format );
+		viewDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+		viewDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+		viewDesc.Texture2D.MipLevels = desc.MipLevels;
+		const CD3DX12_CPU_DESCRIPTOR_HANDLE staging( _StagingHeap->GetCPUDescriptorHandleForHeapStart(), index, _ShaderResourceSize );
+		_Device->CreateShaderResourceView( resource, &viewDesc, staging );
+		_Device->CopyDescriptorsSimple( 1, GetShaderResourceCPUHandle( index ), staging, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV );
+		return index;
+	}
+
+	DXGI_FORMAT DX12Device::GetFormat( RHI::PixelFormat format ) noexcept
+	{
+		switch (format)
+		{
+		case RHI::PixelFormat::R8G8B8A8_UNorm: return DXGI_FORMAT_R8G8B8A8_UNORM;
+		case RHI::PixelFormat::B8G8R8A8_UNorm: return DXGI_FORMAT_B8G8R8A8_UNORM;
+		case RHI::PixelFormat::R16G16B16A16_Float: return DXGI_FORMAT_R16G16B16A16_FLOAT;
+		case RHI::PixelFormat::R32G32B32A32_Float: return DXGI_FORMAT_R32G32B32A32_FLOAT;
+		case RHI::PixelFormat::R32G32B32_Float: return DXGI_FORMAT_R32G32B32_FLOAT;
+		case RHI::PixelFormat::R32G32_Float: return DXGI_FORMAT_R32G32_FLOAT;
+		case RHI::PixelFormat::R32_Float: return DXGI_FORMAT_R32_FLOAT;
+		case RHI::PixelFormat::R32_UInt: return DXGI_FORMAT_R32_UINT;
+		case RHI::PixelFormat::R16_UInt: return DXGI_FORMAT_R16_UINT;
+		case RHI::PixelFormat::D32_Float: return DXGI_FORMAT_D32_FLOAT;
+		case RHI::PixelFormat::D24_UNorm_S8_UInt: return DXGI_FORMAT_D24_UNORM_S8_UINT;
+		default: return DXGI_FORMAT_UNKNOWN;
+		}
+	}
+
+	ComPtr<IDXGIAdapter4> DX12Device::GetAdapter( bool useWarp )
+	{
+		ComPtr<IDXGIFactory4> dxgiFactory;
+		UINT createFactoryFlags = 0;
+#if defined(_DEBUG)
+		createFactoryFlags = DXGI_CREATE_FACTORY_DEBUG;
+#endif
+		ThrowIfFailed( CreateDXGIFactory2( createFactoryFlags, IID_PPV_ARGS( &dxgiFactory ) ) );
+		ComPtr<IDXGIAdapter1> dxgiAdapter1;
+		ComPtr<IDXGIAdapter4> dxgiAdapter4;
+
+		if (useWarp)
+		{
+			ThrowIfFailed( dxgiFactory->EnumWarpAdapter( IID_PPV_ARGS( &dxgiAdapter1 ) ) );
+			ThrowIfFailed( dxgiAdapter1.As( &dxgiAdapter4 ) );
+		}
+		else
+		{
+			SIZE_T maxDedicatedVideoMemory = 0;
+			for (UINT i = 0; dxgiFactory->EnumAdapters1( i, &dxgiAdapter1 ) != DXGI_ERROR_NOT_FOUND; ++i)
+			{
+				DXGI_ADAPTER_DESC1 dxgiAdapterDesc1;
+				dxgiAdapter1->GetDesc1( &dxgiAdapterDesc1 );
+
+				// Check to see if the adapter can create a D3D12 device without actually
+				// creating it. The adapter with the largest dedicated video memory
+				// is favored.
+				if ((dxgiAdapterDesc1.Flags & DXGI_ADAPTER_FLAG_SOFTWARE) == 0 &&
+					SUCCEEDED( D3D12CreateDevice( dxgiAdapter1.Get(),
+						D3D_FEATURE_LEVEL_11_0, __uuidof(ID3D12Device), nullptr ) ) &&
+					dxgiAdapterDesc1.DedicatedVideoMemory > maxDedicatedVideoMemory)
+				{
+					maxDedicatedVideoMemory = dxgiAdapterDesc1.DedicatedVideoMemory;
+					ThrowIfFailed( dxgiAdapter1.As( &dxgiAdapter4 ) );
+				}
+			}
+		}
+
+		return dxgiAdapter4;
+	}
+
+	ComPtr<ID3D12Device14> DX12Device::CreateDevice( ComPtr<IDXGIAdapter4> adapter )
+	{
+		ComPtr<ID3D12Device14> d3d12Device14;
+		ThrowIfFailed( D3D12CreateDevice( adapter.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS( &d3d12Device14 ) ) );
+		// Enable debug messages in debug mode.
+#if defined(_DEBUG)
+		ComPtr<ID3D12InfoQueue> pInfoQueue;
+		if (SUCCEEDED( d3d12Device14.As( &pInfoQueue ) ))
+		{
+			pInfoQueue->SetBreakOnSeverity( D3D12_MESSAGE_SEVERITY_CORRUPTION, TRUE );
+			pInfoQueue->SetBreakOnSeverity( D3D12_MESSAGE_SEVERITY_ERROR, TRUE );
+			pInfoQueue->SetBreakOnSeverity( D3D12_MESSAGE_SEVERITY_WARNING, TRUE );
+
+			// Suppress messages based on their severity level
+			D3D12_MESSAGE_SEVERITY Severities[] =
+			{
+				D3D12_MESSAGE_SEVERITY_INFO
+			};
+
+			// Suppress individual messages by their ID
+			D3D12_MESSAGE_ID DenyIds[] = {
+				D3D12_MESSAGE_ID_CLEARRENDERTARGETVIEW_MISMATCHINGCLEARVALUE,   // I'm really not sure how to avoid this message.
+				D3D12_MESSAGE_ID_MAP_INVALID_NULLRANGE,                         // This warning occurs when using capture frame while graphics debugging.
+				D3D12_MESSAGE_ID_UNMAP_INVALID_NULLRANGE,                       // This warning occurs when using capture frame while graphics debugging.
+			};
+
+			D3D12_INFO_QUEUE_FILTER NewFilter = {};
+			NewFilter.DenyList.NumSeverities = _countof( Severities );
+			NewFilter.DenyList.pSeverityList = Severities;
+			NewFilter.DenyList.NumIDs = _countof( DenyIds );
+			NewFilter.DenyList.pIDList = DenyIds;
+
+			ThrowIfFailed( pInfoQueue->PushStorageFilter( &NewFilter ) );
+		}
+#endif
+
+		return d3d12Device14;
+	}
+
+	bool DX12Device::CheckTearingSupport()
+	{
+		BOOL allowTearing = FALSE;
+
+		// Rather than create the DXGI 1.5 factory interface directly, we create the
+		// DXGI 1.4 interface and query for the 1.5 interface. This is to enable the
+		// graphics debugging tools which will not support the 1.5 factory interface
+		// until a future update.
+		ComPtr<IDXGIFactory4> factory4;
+		if (SUCCEEDED( CreateDXGIFactory1( IID_PPV_ARGS( &factory4 ) ) ))
+		{
+			ComPtr<IDXGIFactory5> factory5;
+			if (SUCCEEDED( factory4.As( &factory5 ) ))
+			{
+				if (FAILED( factory5->CheckFeatureSupport(
+					DXGI_FEATURE_PRESENT_ALLOW_TEARING,
+					&allowTearing, sizeof( allowTearing ) ) ))
+				{
+					allowTearing = FALSE;
+				}
+			}
+		}
+
+		return allowTearing == TRUE;
+	}
+
+	void DX12Device::CreateDescriptorPool( DescriptorPool& pool, D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t count )
+	{
+		D3D12_DESCRIPTOR_HEAP_DESC desc = {};
+		desc.NumDescriptors = count;
+		desc.Type = type;
+		ThrowIfFailed( _Device->CreateDescriptorHeap( &desc, IID_PPV_ARGS( &pool.Heap ) ) );
+		pool.Size = _Device->GetDescriptorHandleIncrementSize( type );
+		// Handed out from the front of the heap first.
+		for (uint32_t i = count; i-- > 0;)
+		{
+			pool.Free.push_back( i );
+		}
+	}
+
+	DX12Device::DescriptorPool& DX12Device::GetDescriptorPool( D3D12_DESCRIPTOR_HEAP_TYPE type )
+	{
+		return type == D3D12_DESCRIPTOR_HEAP_TYPE_DSV ? _DSVs : _RTVs;
+	}
+}
@@ -0,0 +1,113 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+#include "Windows/WinInclude.h"
+#include "DX12CommonIncludes.h"
+#include "Graphics/RHI/RHI.h"
+
+namespace CronoEngine::Graphics
+{
+	/**
+	 * RHI backend over D3D12. Resources are committed unless placed in a heap, pipelines get a root signature of
+	 * PipelineDesc::ConstantBufferCount root constant buffer views, and render target and
+	 * depth stencil views come from CPU descriptor heaps with a free list. Shader resource
+	 * views live in one shader visible heap laid out by a DescriptorAllocator, set on every
+	 * graphics and compute list, with a CPU copy frame tables are copied from. Each command list
+	 * owns one allocator, which Begin resets, so a list must not be recorded again before its
+	 * last submission is done (FrameRenderer keeps one per back buffer for that).
+	 */
+	class DX12Device : public RHI::Device
+	{
+	public:
+		DX12Device( bool useWarp );
+		~DX12Device();
+		DX12Device( const DX12Device& ) = delete;
+		DX12Device& operator=( const DX12Device& ) = delete;
+
+		const char* GetName() const noexcept override;
+		RHI::Queue& GetQueue( RHI::QueueType type ) override;
+		std::unique_ptr<RHI::Buffer> CreateBuffer( const RHI::BufferDesc& desc ) override;
+		std::unique_ptr<RHI::Texture> CreateTexture( const RHI::TextureDesc& desc ) override;
+		std::unique_ptr<RHI::Pipeline> CreatePipeline( const RHI::PipelineDesc& desc ) override;
+		std::unique_ptr<RHI::Fence> CreateFence( uint64_t initialValue = 0 ) override;
+		std::unique_ptr<RHI::CommandList> CreateCommandList( RHI::QueueType type ) override;
+		std::unique_ptr<RHI::SwapChain> CreateSwapChain( const RHI::SwapChainDesc& desc ) override;
+		RHI::ResourceAllocationInfo GetTextureAllocationInfo( const RHI::TextureDesc& desc ) override;
+		RHI::ResourceAllocationInfo GetBufferAllocationInfo( const RHI::BufferDesc& desc ) override;
+		std::unique_ptr<RHI::Heap> CreateHeap( const RHI::HeapDesc& desc ) override;
+		std::unique_ptr<RHI::Texture> CreatePlacedTexture( const RHI::TextureDesc& desc, RHI::Heap& heap, uint64_t offset ) override;
+		std::unique_ptr<RHI::Buffer> CreatePlacedBuffer( const RHI::BufferDesc& desc, RHI::Heap& heap, uint64_t offset ) override;
+		// From DXGI, for the adapter's first node.
+		RHI::MemoryBudget GetMemoryBudget() override;
+		void BeginFrame() override;
+		uint32_t AllocateFrameTable( RHI::Texture* const* textures, uint32_t count ) override;
+		RHI::DescriptorAllocatorStats GetDescriptorStats() const override;
+		void WaitIdle() override;
+
+		ID3D12Device14* GetD3D12Device() const noexcept;
+		ID3D12CommandQueue* GetD3D12Queue( RHI::QueueType type ) const;
+		bool IsTearingSupported() const noexcept;
+		// Render target and depth stencil views.
+		D3D12_CPU_DESCRIPTOR_HANDLE AllocateDescriptor( D3D12_DESCRIPTOR_HEAP_TYPE type );
+		void FreeDescriptor( D3D12_DESCRIPTOR_HEAP_TYPE type, D3D12_CPU_DESCRIPTOR_HANDLE descriptor );
+		// Bindless slots. Views made outside the RHI (the ImGui font) are written straight to the shader visible heap.
+		ID3D12DescriptorHeap* GetShaderResourceHeap() const noexcept;
+		RHI::DescriptorRange AllocateShaderResources( uint32_t count );
+		void FreeShaderResources( RHI::DescriptorRange range );
+		D3D12_CPU_DESCRIPTOR_HANDLE GetShaderResourceCPUHandle( uint32_t index ) const noexcept;
+		D3D12_GPU_DESCRIPTOR_HANDLE GetShaderResourceGPUHandle( uint32_t index ) const noexcept;
+		// Persistent slot with a view of the whole texture, in both heaps.
+		uint32_t CreateShaderResourceView( ID3D12Resource* resource, const RHI::TextureDesc& desc );
+
+		static DXGI_FORMAT GetFormat( RHI::PixelFormat format ) noexcept;
+	private:
+		// Non shader visible heap, slots handed out and taken back under the mutex.
+		struct DescriptorPool
+		{
+			ComPtr<ID3D12DescriptorHeap> Heap;
+			UINT Size = 0;
+			std::vector<uint32_t> Free;
+			std::mutex Mutex;
+		};
+
+		ComPtr<IDXGIAdapter4> GetAdapter( bool useWarp );
+		ComPtr<ID3D12Device14> CreateDevice( ComPtr<IDXGIAdapter4> adapter );
+		bool CheckTearingSupport();
+		void CreateDescriptorPool( DescriptorPool& pool, D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t count );
+		DescriptorPool& GetDescriptorPool( D3D12_DESCRIPTOR_HEAP_TYPE type );
+	private:
+		static constexpr uint32_t RenderTargetViews = 256;
+		static constexpr uint32_t DepthStencilViews = 64;
+
+		ComPtr<IDXGIAdapter4> _Adapter;
+		ComPtr<ID3D12Device14> _Device;
+		std::unique_ptr<RHI::Queue> _Queues[static_cast<size_t>(RHI::QueueType::Count)];
+		DescriptorPool _RTVs;
+		DescriptorPool _DSVs;
+		ComPtr<ID3D12DescriptorHeap> _ShaderResourceHeap;
+		// Not shader visible, same slots, the source of frame table copies.
+		ComPtr<ID3D12DescriptorHeap> _StagingHeap;
+		UINT _ShaderResourceSize = 0;
+		RHI::DescriptorAllocator _Descriptors;
+		// Signaled on the graphics queue with the number of each frame BeginFrame ends.
+		ComPtr<ID3D12Fence> _FrameFence;
+		bool _TearingSupported = false;
+	};
+}
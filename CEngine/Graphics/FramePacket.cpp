@@ -0,0 +1,62 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "FramePacket.h"
+
+namespace CronoEngine::Graphics
+{
+	ImGuiDrawSnapshot::~ImGuiDrawSnapshot()
+	{
+		Clear();
+	}
+
+	void ImGuiDrawSnapshot::Capture( const ImDrawData* drawData )
+	{
+		Clear();
+		if (drawData == nullptr || !drawData->Valid)
+		{
+			return;
+		}
+		// Shallow copy for the frame parameters, then replace the lists owned by the ImGui context with clones.
+		_DrawData = *drawData;
+		for (int i = 0; i < _DrawData.CmdLists.Size; ++i)
+		{
+			_DrawData.CmdLists[i] = drawData->CmdLists[i]->CloneOutput();
+		}
+		_Valid = true;
+	}
+
+	void ImGuiDrawSnapshot::Clear()
+	{
+		if (_Valid)
+		{
+			for (ImDrawList* list : _DrawData.CmdLists)
+			{
+				IM_DELETE( list );
+			}
+		}
+		_DrawData.Clear();
+		_Valid = false;
+	}
+
+	ImDrawData* ImGuiDrawSnapshot::Get()
+	{
+		return _Valid ? &_DrawData : nullptr;
+	}
+}
@@ -0,0 +1,70 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+#include "Common/CommonHeaders.h"
+#include "imgui/imgui.h"
+
+namespace CronoEngine::Graphics
+{
+	/**
+	 * One drawable entity as seen by the simulation when the packet was built.
+	 */
+	struct DrawItem
+	{
+		uint32_t Entity;
+		float Position[3];
+		float Rotation[4]; // quaternion
+		float Scale[3];
+		float World[4][4] = {}; // row major, from the scene's TransformSystem
+	};
+
+	/**
+	 * Deep copy of the ImGui draw data, so the render thread can submit it while
+	 * the simulation thread already builds the next ImGui frame.
+	 */
+	class ImGuiDrawSnapshot
+	{
+	public:
+		ImGuiDrawSnapshot() = default;
+		~ImGuiDrawSnapshot();
+		ImGuiDrawSnapshot( const ImGuiDrawSnapshot& ) = delete;
+		ImGuiDrawSnapshot& operator=( const ImGuiDrawSnapshot& ) = delete;
+
+		void Capture( const ImDrawData* drawData );
+		void Clear();
+		// Null when nothing was captured.
+		ImDrawData* Get();
+	private:
+		ImDrawData _DrawData;
+		bool _Valid = false;
+	};
+
+	/**
+	 * Everything the render thread needs for one frame. Built by the simulation thread,
+	 * then treated as immutable once published.
+	 */
+	struct FramePacket
+	{
+		uint64_t FrameIndex = 0;
+		float InterpolationAlpha = 0.0f;
+		std::vector<DrawItem> DrawItems;
+		ImGuiDrawSnapshot UI;
+	};
+}
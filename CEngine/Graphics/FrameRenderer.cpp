@@ -0,0 +1,113 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "FrameRenderer.h"
+
+namespace CronoEngine::Graphics
+{
+	FrameRenderer::FrameRenderer( RHI::Device& device, RHI::SwapChain& swapChain )
+		: _Device( device ), _SwapChain( swapChain ), _Fence( device.CreateFence( 0 ) ),
+		_Uploads( device, *_Fence, UploadRingSize ), _Graph( device, swapChain.GetDesc().BufferCount )
+	{
+		_Frames.resize( swapChain.GetDesc().BufferCount );
+		for (Frame& frame : _Frames)
+		{
+			frame.Commands = device.CreateCommandList( RHI::QueueType::Graphics );
+		}
+	}
+
+	FrameRenderer::~FrameRenderer()
+	{
+		_Fence->Wait( _FenceValue );
+	}
+
+	void FrameRenderer::Render( ImDrawData* drawData, bool vsync )
+	{
+		const uint32_t index = _SwapChain.GetCurrentIndex();
+		Frame& frame = _Frames[index];
+		// The list and back buffer may still be in use by the frame before last.
+		_Fence->Wait( frame.FenceValue );
+		_Device.BeginFrame();
+
+		RHI::Texture& backBuffer = _SwapChain.GetBackBuffer( index );
+		_Graph.Reset();
+		const RenderGraphTexture target = _Graph.ImportTexture( backBuffer, RHI::ResourceState::Present, RHI::ResourceState::Present );
+		_Graph.AddPass( "UI",
+			[&]( RenderGraphBuilder& builder )
+			{
+				builder.Write( target, RHI::ResourceState::RenderTarget );
+			},
+			[&]( RenderGraphContext& context )
+			{
+				RHI::CommandList& commands = context.GetCommands();
+				RHI::Texture& texture = context.GetTexture( target );
+				const RHI::TextureDesc& desc = texture.GetDesc();
+				commands.ClearRenderTarget( texture, _ClearColor );
+				RHI::Texture* targets[] = { &texture };
+				commands.SetRenderTargets( targets, 1, nullptr );
+				commands.SetViewport( { 0.0f, 0.0f, static_cast<float>(desc.Width), static_cast<float>(desc.Height) } );
+				commands.SetScissor( { 0, 0, static_cast<int32_t>(desc.Width), static_cast<int32_t>(desc.Height) } );
+				if (drawData != nullptr)
+				{
+					commands.DrawUI( drawData );
+				}
+			} );
+		_Graph.Compile();
+
+		RHI::CommandList& commands = *frame.Commands;
+		commands.Begin();
+		commands.BeginEvent( "Frame" );
+		_Graph.Execute( commands );
+		commands.EndEvent();
+		commands.End();
+
+		RHI::Queue& queue = _Device.GetQueue( RHI::QueueType::Graphics );
+		RHI::CommandList* lists[] = { &commands };
+		queue.Submit( lists, 1 );
+		_SwapChain.Present( vsync );
+		frame.FenceValue = ++_FenceValue;
+		queue.Signal( *_Fence, frame.FenceValue );
+		_Uploads.EndFrame( frame.FenceValue );
+	}
+
+	void FrameRenderer::Resize( uint32_t width, uint32_t height )
+	{
+		// No back buffer may be referenced by a list in flight while the swap chain resizes.
+		_Fence->Wait( _FenceValue );
+		_SwapChain.Resize( width, height );
+	}
+
+	void FrameRenderer::SetClearColor( float r, float g, float b, float a ) noexcept
+	{
+		_ClearColor[0] = r;
+		_ClearColor[1] = g;
+		_ClearColor[2] = b;
+		_ClearColor[3] = a;
+	}
+
+	uint64_t FrameRenderer::GetFrameCount() const noexcept
+	{
+		return _FenceValue;
+	}
+
+	UploadRing& FrameRenderer::GetUploads() noexcept
+	{
+		return _Uploads;
+	}
+}
@@ -0,0 +1,70 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+#include "Common/CommonHeaders.h"
+#include "RHI/RHI.h"
+#include "RenderGraph.h"
+#include "UploadRing.h"
+
+namespace CronoEngine::Graphics
+{
+	/**
+	 * Records, submits and presents a frame through any RHI device. The frame is a render graph
+	 * over the imported swap chain back buffer, which the UI pass clears and draws over. Each
+	 * back buffer has its own command list and fence value, so recording a frame only waits for
+	 * the GPU to finish the frame that last used the same back buffer. Per frame constants and
+	 * geometry come from an upload ring tied to the same fence.
+	 */
+	class FrameRenderer
+	{
+	public:
+		FrameRenderer( RHI::Device& device, RHI::SwapChain& swapChain );
+		// Waits for the frames still in flight.
+		~FrameRenderer();
+		FrameRenderer( const FrameRenderer& ) = delete;
+		FrameRenderer& operator=( const FrameRenderer& ) = delete;
+
+		void Render( ImDrawData* drawData, bool vsync );
+		// Waits for the GPU to go idle, then resizes the swap chain.
+		void Resize( uint32_t width, uint32_t height );
+		void SetClearColor( float r, float g, float b, float a ) noexcept;
+		uint64_t GetFrameCount() const noexcept;
+		// For the passes of the frame being rendered, valid until the GPU is done with it.
+		UploadRing& GetUploads() noexcept;
+	private:
+		static constexpr uint64_t UploadRingSize = 8 * 1024 * 1024;
+
+		struct Frame
+		{
+			std::unique_ptr<RHI::CommandList> Commands;
+			// Signaled when the GPU is done with the frame that last used this back buffer.
+			uint64_t FenceValue = 0;
+		};
+
+		RHI::Device& _Device;
+		RHI::SwapChain& _SwapChain;
+		std::unique_ptr<RHI::Fence> _Fence;
+		uint64_t _FenceValue = 0;
+		UploadRing _Uploads;
+		std::vector<Frame> _Frames;
+		RenderGraph _Graph;
+		float _ClearColor[4] = { 0.4f, 0.6f, 0.9f, 1.0f };
+	};
+}
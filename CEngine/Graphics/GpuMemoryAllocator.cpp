@@ -0,0 +1,402 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "GpuMemoryAllocator.h"
+#include <sstream>
+#include <iomanip>
+
+namespace CronoEngine::Graphics
+{
+	namespace
+	{
+		// Cells in the heap map of Describe.
+		constexpr uint32_t MapCells = 64;
+
+		const char* GetMemoryName( RHI::MemoryType memory ) noexcept
+		{
+			switch (memory)
+			{
+			case RHI::MemoryType::Upload: return "Upload";
+			case RHI::MemoryType::Readback: return "Readback";
+			default: return "Default";
+			}
+		}
+
+		const char* GetContentsName( RHI::HeapContents contents ) noexcept
+		{
+			switch (contents)
+			{
+			case RHI::HeapContents::Textures: return "Textures";
+			case RHI::HeapContents::RenderTargets: return "RenderTargets";
+			default: return "Buffers";
+			}
+		}
+
+		double ToMegabytes( uint64_t bytes ) noexcept
+		{
+			return static_cast<double>(bytes) / (1024.0 * 1024.0);
+		}
+
+		double GetFragmentation( uint64_t freeBytes, uint64_t largestFreeBlock ) noexcept
+		{
+			return freeBytes > 0 ? 1.0 - static_cast<double>(largestFreeBlock) / static_cast<double>(freeBytes) : 0.0;
+		}
+	}
+
+	GpuMemoryAllocator::GpuMemoryAllocator( RHI::Device& device, const GpuMemoryAllocatorDesc& desc )
+		: _Device( device ), _Desc( desc )
+	{
+		if (desc.HeapSize < Granularity || desc.HeapSize % Granularity != 0)
+		{
+			throw CHWND_RHI_EXCEPT( "GPU memory heaps must be a multiple of 64 KB" );
+		}
+	}
+
+	GpuMemoryAllocator::~GpuMemoryAllocator()
+	{
+		// Resources must go before their memory, a leak here is a bug in the caller.
+		assert( GetStats().Allocations == 0 && "GpuMemoryAllocator destroyed with live allocations" );
+	}
+
+	GpuAllocation GpuMemoryAllocator::Allocate( RHI::MemoryType memory, RHI::HeapContents contents, const RHI::ResourceAllocationInfo& info )
+	{
+		const uint32_t pool = GetPoolIndex( memory, contents );
+		const uint64_t alignment = std::max( info.Alignment, Granularity );
+		std::lock_guard<std::mutex> lock( _Mutex );
+		GpuAllocation allocation = TryAllocate( pool, info.Size, alignment, UINT32_MAX );
+		if (!allocation.IsValid())
+		{
+			allocation = CreateHeap( pool, info.Size, alignment );
+		}
+		return allocation;
+	}
+
+	void GpuMemoryAllocator::Free( const GpuAllocation& allocation )
+	{
+		std::lock_guard<std::mutex> lock( _Mutex );
+		FreeLocked( allocation );
+	}
+
+	std::unique_ptr<RHI::Buffer> GpuMemoryAllocator::CreateBuffer( const RHI::BufferDesc& desc, GpuAllocation& allocation )
+	{
+		allocation = Allocate( desc.Memory, RHI::HeapContents::Buffers, _Device.GetBufferAllocationInfo( desc ) );
+		try
+		{
+			return _Device.CreatePlacedBuffer( desc, *allocation.Heap, allocation.Offset );
+		}
+		catch (...)
+		{
+			Free( allocation );
+			allocation = {};
+			throw;
+		}
+	}
+
+	std::unique_ptr<RHI::Texture> GpuMemoryAllocator::CreateTexture( const RHI::TextureDesc& desc, GpuAllocation& allocation )
+	{
+		allocation = Allocate( RHI::MemoryType::Default, RHI::GetHeapContents( desc.Usage ), _Device.GetTextureAllocationInfo( desc ) );
+		try
+		{
+			return _Device.CreatePlacedTexture( desc, *allocation.Heap, allocation.Offset );
+		}
+		catch (...)
+		{
+			Free( allocation );
+			allocation = {};
+			throw;
+		}
+	}
+
+	std::vector<GpuDefragmentMove> GpuMemoryAllocator::BeginDefragmentation( uint64_t maxBytes )
+	{
+		std::lock_guard<std::mutex> lock( _Mutex );
+		std::vector<GpuDefragmentMove> moves;
+		uint64_t moved = 0;
+		for (uint32_t pool = 0; pool < PoolCount && moved < maxBytes; ++pool)
+		{
+			// The emptiest heap that is not empty already, when there is somewhere to move to.
+			const std::vector<std::unique_ptr<PoolHeap>>& heaps = _Pools[pool].Heaps;
+			uint32_t source = UINT32_MAX;
+			uint32_t targets = 0;
+			uint64_t sourceUsed = UINT64_MAX;
+			for (uint32_t i = 0; i < heaps.size(); ++i)
+			{
+				if (heaps[i] == nullptr || heaps[i]->Dedicated)
+				{
+					continue;
+				}
+				++targets;
+				const uint64_t used = heaps[i]->Allocator.GetStats().UsedBytes;
+				if (used > 0 && used < sourceUsed)
+				{
+					source = i;
+					sourceUsed = used;
+				}
+			}
+			if (source == UINT32_MAX || targets < 2)
+			{
+				continue;
+			}
+			std::vector<TlsfAllocator::BlockInfo> blocks;
+			heaps[source]->Allocator.ForEachBlock( [&]( const TlsfAllocator::BlockInfo& block )
+				{
+					if (!block.Free)
+					{
+						blocks.push_back( block );
+					}
+				} );
+			for (const TlsfAllocator::BlockInfo& block : blocks)
+			{
+				if (moved + block.Size > maxBytes)
+				{
+					break;
+				}
+				const GpuAllocation to = TryAllocate( pool, block.Size, block.Alignment, source );
+				if (!to.IsValid())
+				{
+					break;
+				}
+				const GpuAllocation from = { heaps[source]->Heap.get(), block.Offset, block.Size, pool, source, block.Block };
+				moves.push_back( { from, to } );
+				moved += block.Size;
+			}
+		}
+		return moves;
+	}
+
+	void GpuMemoryAllocator::EndDefragmentation( const std::vector<GpuDefragmentMove>& moves )
+	{
+		std::lock_guard<std::mutex> lock( _Mutex );
+		for (const GpuDefragmentMove& move : moves)
+		{
+			FreeLocked( move.Dropped ? move.To : move.From );
+		}
+	}
+
+	GpuMemoryStats GpuMemoryAllocator::GetStats() const
+	{
+		std::lock_guard<std::mutex> lock( _Mutex );
+		GpuMemoryStats stats;
+		for (uint32_t pool = 0; pool < PoolCount; ++pool)
+		{
+			const GpuMemoryPoolStats poolStats = GetPoolStats( pool );
+			if (poolStats.Heaps == 0)
+			{
+				continue;
+			}
+			stats.HeapBytes += poolStats.HeapBytes;
+			stats.UsedBytes += poolStats.UsedBytes;
+			stats.Allocations += poolStats.Allocations;
+			stats.Pools.push_back( poolStats );
+		}
+		return stats;
+	}
+
+	RHI::MemoryBudget GpuMemoryAllocator::GetBudget() const
+	{
+		return _Device.GetMemoryBudget();
+	}
+
+	bool GpuMemoryAllocator::IsOverBudget() const
+	{
+		const RHI::MemoryBudget budget = GetBudget();
+		uint64_t local = 0;
+		uint64_t nonLocal = 0;
+		for (const GpuMemoryPoolStats& pool : GetStats().Pools)
+		{
+			(pool.Memory == RHI::MemoryType::Default ? local : nonLocal) += pool.HeapBytes;
+		}
+		return local > budget.LocalBudget || nonLocal > budget.NonLocalBudget;
+	}
+
+	std::string GpuMemoryAllocator::Describe() const
+	{
+		std::lock_guard<std::mutex> lock( _Mutex );
+		std::ostringstream oss;
+		oss << std::fixed << std::setprecision( 1 );
+		for (uint32_t pool = 0; pool < PoolCount; ++pool)
+		{
+			const GpuMemoryPoolStats stats = GetPoolStats( pool );
+			if (stats.Heaps == 0)
+			{
+				continue;
+			}
+			oss << GetMemoryName( stats.Memory ) << "/" << GetContentsName( stats.Contents ) << ": " << stats.Heaps << " heaps ("
+				<< stats.DedicatedHeaps << " dedicated), " << ToMegabytes( stats.UsedBytes ) << " of " << ToMegabytes( stats.HeapBytes )
+				<< " MB used by " << stats.Allocations << " allocations, fragmentation " << stats.Fragmentation * 100.0 << "%\n";
+			const std::vector<std::unique_ptr<PoolHeap>>& heaps = _Pools[pool].Heaps;
+			for (uint32_t i = 0; i < heaps.size(); ++i)
+			{
+				if (heaps[i] == nullptr)
+				{
+					continue;
+				}
+				const TlsfAllocator::Stats heapStats = heaps[i]->Allocator.GetStats();
+				// '#' full, '.' free, '+' partly used.
+				uint64_t cellUsed[MapCells] = {};
+				const double cellSize = static_cast<double>(heapStats.Size) / MapCells;
+				heaps[i]->Allocator.ForEachBlock( [&]( const TlsfAllocator::BlockInfo& block )
+					{
+						if (block.Free)
+						{
+							return;
+						}
+						const uint32_t first = static_cast<uint32_t>(block.Offset / cellSize);
+						const uint32_t last = std::min( MapCells - 1, static_cast<uint32_t>((block.Offset + block.Size - 1) / cellSize) );
+						for (uint32_t cell = first; cell <= last; ++cell)
+						{
+							const uint64_t begin = std::max( block.Offset, static_cast<uint64_t>(cell * cellSize) );
+							const uint64_t end = std::min( block.Offset + block.Size, static_cast<uint64_t>((cell + 1) * cellSize) );
+							cellUsed[cell] += end > begin ? end - begin : 0;
+						}
+					} );
+				std::string map( MapCells, '+' );
+				for (uint32_t cell = 0; cell < MapCells; ++cell)
+				{
+					if (cellUsed[cell] == 0)
+					{
+						map[cell] = '.';
+					}
+					else if (cellUsed[cell] >= static_cast<uint64_t>(cellSize))
+					{
+						map[cell] = '#';
+					}
+				}
+				oss << "  Heap " << i << (heaps[i]->Dedicated ? " (dedicated)" : "") << ": " << ToMegabytes( heapStats.UsedBytes )
+					<< " of " << ToMegabytes( heapStats.Size ) << " MB, " << heapStats.Allocations << " allocations, "
+					<< heapStats.FreeBlocks << " free blocks, largest " << ToMegabytes( heapStats.LargestFreeBlock ) << " MB, fragmentation "
+					<< GetFragmentation( heapStats.FreeBytes, heapStats.LargestFreeBlock ) * 100.0 << "% [" << map << "]\n";
+			}
+		}
+		return oss.str();
+	}
+
+	uint32_t GpuMemoryAllocator::GetPoolIndex( RHI::MemoryType memory, RHI::HeapContents contents ) noexcept
+	{
+		return static_cast<uint32_t>(memory) * 3 + static_cast<uint32_t>(contents);
+	}
+
+	GpuAllocation GpuMemoryAllocator::TryAllocate( uint32_t pool, uint64_t size, uint64_t alignment, uint32_t exclude )
+	{
+		std::vector<std::unique_ptr<PoolHeap>>& heaps = _Pools[pool].Heaps;
+		for (uint32_t i = 0; i < heaps.size(); ++i)
+		{
+			if (i == exclude || heaps[i] == nullptr || heaps[i]->Dedicated)
+			{
+				continue;
+			}
+			const TlsfAllocator::Allocation allocation = heaps[i]->Allocator.Allocate( size, alignment );
+			if (allocation.IsValid())
+			{
+				return { heaps[i]->Heap.get(), allocation.Offset, allocation.Size, pool, i, allocation.Block };
+			}
+		}
+		return {};
+	}
+
+	GpuAllocation GpuMemoryAllocator::CreateHeap( uint32_t pool, uint64_t size, uint64_t alignment )
+	{
+		// Alignment is a multiple of Granularity, so is the aligned size.
+		const uint64_t alignedSize = (size + alignment - 1) / alignment * alignment;
+		const bool dedicated = alignedSize > _Desc.HeapSize;
+		RHI::HeapDesc desc;
+		desc.Size = dedicated ? alignedSize : _Desc.HeapSize;
+		desc.Memory = static_cast<RHI::MemoryType>(pool / 3);
+		desc.Contents = static_cast<RHI::HeapContents>(pool % 3);
+		std::vector<std::unique_ptr<PoolHeap>>& heaps = _Pools[pool].Heaps;
+		uint32_t index = 0;
+		while (index < heaps.size() && heaps[index] != nullptr)
+		{
+			++index;
+		}
+		if (index == heaps.size())
+		{
+			heaps.emplace_back();
+		}
+		desc.DebugName = std::string( "GPU Memory " ) + GetMemoryName( desc.Memory ) + "/" + GetContentsName( desc.Contents ) +
+			" " + std::to_string( index );
+		heaps[index] = std::make_unique<PoolHeap>( PoolHeap{ _Device.CreateHeap( desc ), TlsfAllocator( desc.Size, Granularity ), dedicated } );
+		const TlsfAllocator::Allocation allocation = heaps[index]->Allocator.Allocate( size, alignment );
+		if (!allocation.IsValid())
+		{
+			heaps[index].reset();
+			throw CHWND_RHI_EXCEPT( "GPU memory allocation of " + std::to_string( size ) + " bytes aligned to " +
+				std::to_string( alignment ) + " does not fit a new heap of " + std::to_string( desc.Size ) );
+		}
+		return { heaps[index]->Heap.get(), allocation.Offset, allocation.Size, pool, index, allocation.Block };
+	}
+
+	void GpuMemoryAllocator::FreeLocked( const GpuAllocation& allocation )
+	{
+		if (allocation.Pool >= PoolCount || allocation.HeapIndex >= _Pools[allocation.Pool].Heaps.size() ||
+			_Pools[allocation.Pool].Heaps[allocation.HeapIndex] == nullptr ||
+			_Pools[allocation.Pool].Heaps[allocation.HeapIndex]->Heap.get() != allocation.Heap)
+		{
+			throw CHWND_RHI_EXCEPT( "Free of a GPU allocation this allocator does not hold" );
+		}
+		std::vector<std::unique_ptr<PoolHeap>>& heaps = _Pools[allocation.Pool].Heaps;
+		PoolHeap& heap = *heaps[allocation.HeapIndex];
+		heap.Allocator.Free( allocation.Block );
+		if (!heap.Allocator.IsEmpty())
+		{
+			return;
+		}
+		uint32_t emptyHeaps = 0;
+		for (const std::unique_ptr<PoolHeap>& other : heaps)
+		{
+			if (other != nullptr && !other->Dedicated && other->Allocator.IsEmpty())
+			{
+				++emptyHeaps;
+			}
+		}
+		if (heap.Dedicated || emptyHeaps > _Desc.EmptyHeapsKept)
+		{
+			heaps[allocation.HeapIndex].reset();
+		}
+	}
+
+	GpuMemoryPoolStats GpuMemoryAllocator::GetPoolStats( uint32_t pool ) const
+	{
+		GpuMemoryPoolStats stats;
+		stats.Memory = static_cast<RHI::MemoryType>(pool / 3);
+		stats.Contents = static_cast<RHI::HeapContents>(pool % 3);
+		uint64_t freeBytes = 0;
+		double weightedFragmentation = 0.0;
+		for (const std::unique_ptr<PoolHeap>& heap : _Pools[pool].Heaps)
+		{
+			if (heap == nullptr)
+			{
+				continue;
+			}
+			const TlsfAllocator::Stats heapStats = heap->Allocator.GetStats();
+			++stats.Heaps;
+			stats.DedicatedHeaps += heap->Dedicated ? 1 : 0;
+			stats.HeapBytes += heapStats.Size;
+			stats.UsedBytes += heapStats.UsedBytes;
+			stats.Allocations += heapStats.Allocations;
+			stats.FreeBlocks += heapStats.FreeBlocks;
+			stats.LargestFreeBlock = std::max( stats.LargestFreeBlock, heapStats.LargestFreeBlock );
+			freeBytes += heapStats.FreeBytes;
+			weightedFragmentation += GetFragmentation( heapStats.FreeBytes, heapStats.LargestFreeBlock ) * heapStats.FreeBytes;
+		}
+		// Each heap's fragmentation, weighted by its free bytes.
+		stats.Fragmentation = freeBytes > 0 ? weightedFragmentation / freeBytes : 0.0;
+		return stats;
+	}
+}
@@ -0,0 +1,156 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+#include "Common/CommonHeaders.h"
+#include "RHI/RHI.h"
+#include "TlsfAllocator.h"
+
+namespace CronoEngine::Graphics
+{
+	struct GpuMemoryAllocatorDesc
+	{
+		// What pools grow by. Anything larger gets a dedicated heap of its own size.
+		uint64_t HeapSize = 64ull * 1024 * 1024;
+		// Empty heaps a pool keeps instead of releasing, so it does not thrash at a heap boundary.
+		uint32_t EmptyHeapsKept = 1;
+	};
+
+	// Place in a pool heap, copied around by value.
+	struct GpuAllocation
+	{
+		RHI::Heap* Heap = nullptr;
+		uint64_t Offset = 0;
+		uint64_t Size = 0;
+		// Where the allocator finds it again.
+		uint32_t Pool = 0;
+		uint32_t HeapIndex = 0;
+		uint32_t Block = TlsfAllocator::InvalidBlock;
+
+		bool IsValid() const noexcept
+		{
+			return Heap != nullptr;
+		}
+	};
+
+	// An allocation to move, To is already reserved.
+	struct GpuDefragmentMove
+	{
+		GpuAllocation From;
+		GpuAllocation To;
+		// Set by the caller to leave the resource at From, EndDefragmentation then frees To instead.
+		bool Dropped = false;
+	};
+
+	struct GpuMemoryPoolStats
+	{
+		RHI::MemoryType Memory = RHI::MemoryType::Default;
+		RHI::HeapContents Contents = RHI::HeapContents::Buffers;
+		uint32_t Heaps = 0;
+		uint32_t DedicatedHeaps = 0;
+		uint64_t HeapBytes = 0;
+		uint64_t UsedBytes = 0;
+		uint32_t Allocations = 0;
+		uint32_t FreeBlocks = 0;
+		uint64_t LargestFreeBlock = 0;
+		// 1 - largest free block / free bytes, 0 while the free space of each heap is one block.
+		double Fragmentation = 0.0;
+	};
+
+	struct GpuMemoryStats
+	{
+		// Pools that have heaps.
+		std::vector<GpuMemoryPoolStats> Pools;
+		uint64_t HeapBytes = 0;
+		uint64_t UsedBytes = 0;
+		uint32_t Allocations = 0;
+	};
+
+	/**
+	 * Places buffers and textures in large heaps instead of giving each its own committed
+	 * allocation. There is a pool per memory type and heap contents, each a list of heaps
+	 * that a TlsfAllocator splits up; allocations go to the first heap with room, so the
+	 * later heaps drain and defragmentation can empty them. Every call may come from any
+	 * thread.
+	 *
+	 * Free releases the range right away: the resource in it must be destroyed and the GPU
+	 * done with it, the same as for the heap memory of any placed resource.
+	 */
+	class GpuMemoryAllocator
+	{
+	public:
+		GpuMemoryAllocator( RHI::Device& device, const GpuMemoryAllocatorDesc& desc = {} );
+		~GpuMemoryAllocator();
+		GpuMemoryAllocator( const GpuMemoryAllocator& ) = delete;
+		GpuMemoryAllocator& operator=( const GpuMemoryAllocator& ) = delete;
+
+		GpuAllocation Allocate( RHI::MemoryType memory, RHI::HeapContents contents, const RHI::ResourceAllocationInfo& info );
+		void Free( const GpuAllocation& allocation );
+		// Allocate and create the resource in one go. Free allocation after destroying the resource.
+		std::unique_ptr<RHI::Buffer> CreateBuffer( const RHI::BufferDesc& desc, GpuAllocation& allocation );
+		std::unique_ptr<RHI::Texture> CreateTexture( const RHI::TextureDesc& desc, GpuAllocation& allocation );
+
+		/**
+		 * Up to maxBytes of allocations to move out of the emptiest heap of each pool into its
+		 * other heaps. For each move the caller creates the resource at To and copies it there
+		 * once the GPU is done with From, or sets Dropped to keep it where it is, then hands the
+		 * moves to EndDefragmentation, which frees the From ranges of the moves made, the To
+		 * ranges of the dropped ones and the heaps left empty.
+		 */
+		std::vector<GpuDefragmentMove> BeginDefragmentation( uint64_t maxBytes );
+		void EndDefragmentation( const std::vector<GpuDefragmentMove>& moves );
+
+		GpuMemoryStats GetStats() const;
+		RHI::MemoryBudget GetBudget() const;
+		// Heap bytes of Default pools past the local budget, or Upload and Readback ones past the non local one.
+		bool IsOverBudget() const;
+		// Per pool and heap: usage, free blocks, fragmentation and a map of the heap, one line each.
+		std::string Describe() const;
+	private:
+		struct PoolHeap
+		{
+			std::unique_ptr<RHI::Heap> Heap;
+			TlsfAllocator Allocator;
+			// Made for one allocation larger than HeapSize, released once it is free.
+			bool Dedicated;
+		};
+
+		struct Pool
+		{
+			// Released heaps leave an empty slot, so HeapIndex stays valid.
+			std::vector<std::unique_ptr<PoolHeap>> Heaps;
+		};
+
+		static constexpr uint32_t PoolCount = 9;
+		// Placement alignment of buffers and most textures on D3D12.
+		static constexpr uint64_t Granularity = 64 * 1024;
+
+		static uint32_t GetPoolIndex( RHI::MemoryType memory, RHI::HeapContents contents ) noexcept;
+		// With _Mutex held. An invalid allocation when no heap but exclude has room.
+		GpuAllocation TryAllocate( uint32_t pool, uint64_t size, uint64_t alignment, uint32_t exclude );
+		GpuAllocation CreateHeap( uint32_t pool, uint64_t size, uint64_t alignment );
+		void FreeLocked( const GpuAllocation& allocation );
+		GpuMemoryPoolStats GetPoolStats( uint32_t pool ) const;
+	private:
+		RHI::Device& _Device;
+		const GpuMemoryAllocatorDesc _Desc;
+		mutable std::mutex _Mutex;
+		Pool _Pools[PoolCount];
+	};
+}
@@ -0,0 +1,297 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "DescriptorAllocator.h"
+#include <bit>
+
+namespace CronoEngine::Graphics::RHI
+{
+	DescriptorAllocator::DescriptorAllocator( const DescriptorAllocatorDesc& desc )
+		: _Desc( desc ), _Slabs( (desc.PersistentCount + SlabSize - 1) / SlabSize, Slab{ {}, 0, SizeClasses, NoSlab, NoSlab } ),
+		_Allocated( desc.PersistentCount, 0 )
+	{
+		static_assert(SlabSize == sizeof( Slab::FreeMask ) * 8, "A free bit per slot of a slab");
+		std::fill( std::begin( _PartialSlabs ), std::end( _PartialSlabs ), NoSlab );
+		if (static_cast<uint64_t>(desc.PersistentCount) + desc.FrameCount > UINT32_MAX)
+		{
+			throw CHWND_RHI_EXCEPT( "Descriptor heap of more than 2^32 - 1 slots" );
+		}
+		if (desc.PersistentCount > 0)
+		{
+			_FreeRanges.emplace( 0, desc.PersistentCount );
+		}
+		_Stats.PersistentCapacity = desc.PersistentCount;
+		_Stats.FrameCapacity = desc.FrameCount;
+	}
+
+	DescriptorRange DescriptorAllocator::Allocate( uint32_t count )
+	{
+		if (count == 0)
+		{
+			throw CHWND_RHI_EXCEPT( "Allocation of 0 descriptors" );
+		}
+		std::lock_guard<std::mutex> lock( _Mutex );
+		const uint32_t sizeClass = GetSizeClass( count );
+		const uint32_t index = sizeClass < SizeClasses ? AllocateBlock( sizeClass ) : AllocateRange( count );
+		if (index == UINT32_MAX)
+		{
+			throw CHWND_RHI_EXCEPT( "Out of persistent descriptors: " + std::to_string( count ) + " wanted, " +
+				std::to_string( _Stats.PersistentUsed ) + " of " + std::to_string( _Desc.PersistentCount ) +
+				" in use and " + std::to_string( _Stats.PendingFrees ) + " waiting on the GPU" );
+		}
+		_Allocated[index] = count;
+		++_Stats.Allocations;
+		_Stats.PersistentUsed += count;
+		_Stats.PersistentPeak = std::max( _Stats.PersistentPeak, _Stats.PersistentUsed );
+		return { index, count };
+	}
+
+	void DescriptorAllocator::Free( DescriptorRange range )
+	{
+		std::lock_guard<std::mutex> lock( _Mutex );
+		if (!range.IsValid() || range.Index >= _Desc.PersistentCount || range.Count == 0 || _Allocated[range.Index] != range.Count)
+		{
+			throw CHWND_RHI_EXCEPT( "Free of " + std::to_string( range.Count ) + " descriptors at " + std::to_string( range.Index ) +
+				", which is not an allocated range" );
+		}
+		_Allocated[range.Index] = 0;
+		_PendingFrees.push_back( { _Frame, range } );
+		++_Stats.Frees;
+		_Stats.PendingFrees += range.Count;
+	}
+
+	DescriptorRange DescriptorAllocator::AllocateFrame( uint32_t count )
+	{
+		if (count == 0 || count > _Desc.FrameCount)
+		{
+			throw CHWND_RHI_EXCEPT( "Frame allocation of " + std::to_string( count ) + " descriptors from a ring of " +
+				std::to_string( _Desc.FrameCount ) );
+		}
+		std::lock_guard<std::mutex> lock( _Mutex );
+		uint64_t start = _RingHead;
+		// Ranges do not wrap, the end of the ring is skipped when it is too short.
+		const uint64_t offset = start % _Desc.FrameCount;
+		if (offset + count > _Desc.FrameCount)
+		{
+			start += _Desc.FrameCount - offset;
+		}
+		if (start + count - _RingTail > _Desc.FrameCount)
+		{
+			throw CHWND_RHI_EXCEPT( "Descriptor ring full: " + std::to_string( count ) + " wanted, " +
+				std::to_string( _RingHead - _RingTail ) + " of " + std::to_string( _Desc.FrameCount ) +
+				" held by this frame and " + std::to_string( _InFlight.size() ) + " in flight" );
+		}
+		_RingHead = start + count;
+		++_Stats.FrameAllocations;
+		_Stats.FramePeak = std::max( _Stats.FramePeak, static_cast<uint32_t>(_RingHead - _RingTail) );
+		return { _Desc.PersistentCount + static_cast<uint32_t>(start % _Desc.FrameCount), count };
+	}
+
+	void DescriptorAllocator::BeginFrame( uint64_t completedFrame )
+	{
+		std::lock_guard<std::mutex> lock( _Mutex );
+		_InFlight.push_back( { _Frame, _RingHead } );
+		while (!_InFlight.empty() && _InFlight.front().Frame <= completedFrame)
+		{
+			_RingTail = _InFlight.front().Head;
+			_InFlight.pop_front();
+		}
+		while (!_PendingFrees.empty() && _PendingFrees.front().Frame <= completedFrame)
+		{
+			Release( _PendingFrees.front().Range );
+			_PendingFrees.pop_front();
+		}
+		_FrameStart = _RingHead;
+		++_Frame;
+	}
+
+	uint64_t DescriptorAllocator::GetFrame() const noexcept
+	{
+		return _Frame;
+	}
+
+	DescriptorAllocatorStats DescriptorAllocator::GetStats() const
+	{
+		std::lock_guard<std::mutex> lock( _Mutex );
+		DescriptorAllocatorStats stats = _Stats;
+		stats.FrameUsed = static_cast<uint32_t>(_RingHead - _FrameStart);
+		stats.FrameInFlight = static_cast<uint32_t>(_RingHead - _RingTail);
+		stats.FramesInFlight = static_cast<uint32_t>(_InFlight.size());
+		return stats;
+	}
+
+	uint32_t DescriptorAllocator::GetSizeClass( uint32_t count ) noexcept
+	{
+		uint32_t sizeClass = 0;
+		while (sizeClass < SizeClasses && (1u << sizeClass) < count)
+		{
+			++sizeClass;
+		}
+		return sizeClass;
+	}
+
+	uint32_t DescriptorAllocator::AllocateRange( uint32_t count, uint32_t alignment )
+	{
+		for (auto it = _FreeRanges.begin(); it != _FreeRanges.end(); ++it)
+		{
+			const uint64_t begin = it->first;
+			const uint64_t end = begin + it->second;
+			const uint64_t index = (begin + alignment - 1) / alignment * alignment;
+			if (index + count > end)
+			{
+				continue;
+			}
+			_FreeRanges.erase( it );
+			if (index > begin)
+			{
+				_FreeRanges.emplace( static_cast<uint32_t>(begin), static_cast<uint32_t>(index - begin) );
+			}
+			if (index + count < end)
+			{
+				_FreeRanges.emplace( static_cast<uint32_t>(index + count), static_cast<uint32_t>(end - index - count) );
+			}
+			_Stats.PersistentReserved += count;
+			return static_cast<uint32_t>(index);
+		}
+		return UINT32_MAX;
+	}
+
+	void DescriptorAllocator::FreeRange( uint32_t index, uint32_t count )
+	{
+		_Stats.PersistentReserved -= count;
+		auto next = _FreeRanges.lower_bound( index );
+		if (next != _FreeRanges.end() && index + count == next->first)
+		{
+			count += next->second;
+			next = _FreeRanges.erase( next );
+		}
+		if (next != _FreeRanges.begin())
+		{
+			auto prev = std::prev( next );
+			if (prev->first + prev->second == index)
+			{
+				prev->second += count;
+				return;
+			}
+		}
+		_FreeRanges.emplace_hint( next, index, count );
+	}
+
+	uint32_t DescriptorAllocator::AllocateBlock( uint32_t sizeClass )
+	{
+		uint32_t slab = _PartialSlabs[sizeClass];
+		if (slab == NoSlab)
+		{
+			// A whole slab, or just the block once the free list has no room for one.
+			const uint32_t start = AllocateRange( SlabSize, SlabSize );
+			if (start == UINT32_MAX)
+			{
+				return AllocateRange( 1u << sizeClass );
+			}
+			slab = start / SlabSize;
+			const uint32_t blocks = SlabSize >> sizeClass;
+			Slab& fresh = _Slabs[slab];
+			for (uint32_t word = 0; word < std::size( fresh.FreeMask ); ++word)
+			{
+				const uint32_t bits = std::min( 64u, blocks - std::min( blocks, word * 64 ) );
+				fresh.FreeMask[word] = bits == 64 ? ~0ull : (1ull << bits) - 1;
+			}
+			fresh.FreeCount = blocks;
+			fresh.SizeClass = sizeClass;
+			LinkSlab( slab );
+		}
+
+		// Lowest free block first, so blocks go out in index order.
+		Slab& partial = _Slabs[slab];
+		uint32_t word = 0;
+		while (partial.FreeMask[word] == 0)
+		{
+			++word;
+		}
+		const uint32_t block = word * 64 + static_cast<uint32_t>(std::countr_zero( partial.FreeMask[word] ));
+		partial.FreeMask[word] &= partial.FreeMask[word] - 1;
+		if (--partial.FreeCount == 0)
+		{
+			UnlinkSlab( slab );
+		}
+		return slab * SlabSize + (block << sizeClass);
+	}
+
+	void DescriptorAllocator::Release( DescriptorRange range )
+	{
+		const uint32_t sizeClass = GetSizeClass( range.Count );
+		Slab* slab = sizeClass < SizeClasses ? &_Slabs[range.Index / SlabSize] : nullptr;
+		if (slab != nullptr && slab->SizeClass == sizeClass)
+		{
+			const uint32_t window = range.Index / SlabSize;
+			const uint32_t block = (range.Index % SlabSize) >> sizeClass;
+			slab->FreeMask[block / 64] |= 1ull << (block % 64);
+			if (slab->FreeCount++ == 0)
+			{
+				LinkSlab( window );
+			}
+			// Wholly free, back to the free list unless it is the last slab its class has room in.
+			const bool onlyPartial = _PartialSlabs[sizeClass] == window && slab->Next == NoSlab;
+			if (slab->FreeCount == SlabSize >> sizeClass && !onlyPartial)
+			{
+				UnlinkSlab( window );
+				slab->SizeClass = SizeClasses;
+				FreeRange( window * SlabSize, SlabSize );
+			}
+		}
+		else
+		{
+			// A large range, or a block that had to come without a slab.
+			FreeRange( range.Index, sizeClass < SizeClasses ? 1u << sizeClass : range.Count );
+		}
+		_Stats.PersistentUsed -= range.Count;
+		_Stats.PendingFrees -= range.Count;
+	}
+
+	void DescriptorAllocator::LinkSlab( uint32_t slab ) noexcept
+	{
+		Slab& linked = _Slabs[slab];
+		uint32_t& head = _PartialSlabs[linked.SizeClass];
+		linked.Previous = NoSlab;
+		linked.Next = head;
+		if (head != NoSlab)
+		{
+			_Slabs[head].Previous = slab;
+		}
+		head = slab;
+	}
+
+	void DescriptorAllocator::UnlinkSlab( uint32_t slab ) noexcept
+	{
+		Slab& unlinked = _Slabs[slab];
+		if (unlinked.Previous != NoSlab)
+		{
+			_Slabs[unlinked.Previous].Next = unlinked.Next;
+		}
+		else
+		{
+			_PartialSlabs[unlinked.SizeClass] = unlinked.Next;
+		}
+		if (unlinked.Next != NoSlab)
+		{
+			_Slabs[unlinked.Next].Previous = unlinked.Previous;
+		}
+		unlinked.Previous = unlinked.Next = NoSlab;
+	}
+}
@@ -0,0 +1,155 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+#include "Common/CommonHeaders.h"
+#include <atomic>
+#include <deque>
+#include <map>
+
+namespace CronoEngine::Graphics::RHI
+{
+	struct DescriptorAllocatorDesc
+	{
+		// Slots [0, PersistentCount) stay until freed, the FrameCount after them are the frame ring.
+		uint32_t PersistentCount = 0;
+		uint32_t FrameCount = 0;
+	};
+
+	// Consecutive slots of a descriptor heap.
+	struct DescriptorRange
+	{
+		uint32_t Index = UINT32_MAX;
+		uint32_t Count = 0;
+
+		bool IsValid() const noexcept
+		{
+			return Index != UINT32_MAX;
+		}
+	};
+
+	struct DescriptorAllocatorStats
+	{
+		uint32_t PersistentCapacity = 0;
+		// Slots in live ranges, and slots taken from the free list (by slabs and large ranges).
+		uint32_t PersistentUsed = 0;
+		uint32_t PersistentReserved = 0;
+		uint32_t PersistentPeak = 0;
+		// Freed, waiting for their frame to be done on the GPU.
+		uint32_t PendingFrees = 0;
+		uint64_t Allocations = 0;
+		uint64_t Frees = 0;
+		uint32_t FrameCapacity = 0;
+		// Ring slots of the current frame and of every frame still in flight, holes at the wrap included.
+		uint32_t FrameUsed = 0;
+		uint32_t FrameInFlight = 0;
+		uint32_t FramePeak = 0;
+		uint64_t FrameAllocations = 0;
+		uint32_t FramesInFlight = 0;
+	};
+
+	/**
+	 * Hands out the slots of one shader visible descriptor heap, so any texture can be bound
+	 * by index. The persistent region is for views that live as long as their resource: up
+	 * to 32 slots come from power of two size classes, carved from slabs aligned to their size,
+	 * bigger ranges first fit from a free list that merges neighbours. A slab that is wholly
+	 * free again goes back to that list, but for one per size class kept against churn, so a
+	 * burst of small ranges doesn't fragment the region for good. The frame region is a ring
+	 * that frames allocate from in order and that is taken back a whole frame at a time.
+	 *
+	 * The GPU may still read slots after they are freed, so frees and frame slots are only
+	 * reused once BeginFrame is told their frame is done. Frame numbers start at 1, so a
+	 * fence created at 0 and signaled with each frame's number works as is. Exhaustion of
+	 * either region throws an RhiException. Every call may come from any thread.
+	 */
+	class DescriptorAllocator
+	{
+	public:
+		DescriptorAllocator( const DescriptorAllocatorDesc& desc );
+		DescriptorAllocator( const DescriptorAllocator& ) = delete;
+		DescriptorAllocator& operator=( const DescriptorAllocator& ) = delete;
+
+		DescriptorRange Allocate( uint32_t count = 1 );
+		void Free( DescriptorRange range );
+		// Valid until the current frame is done.
+		DescriptorRange AllocateFrame( uint32_t count );
+		// Ends the current frame and takes back what frames up to completedFrame held.
+		void BeginFrame( uint64_t completedFrame );
+		uint64_t GetFrame() const noexcept;
+		DescriptorAllocatorStats GetStats() const;
+	private:
+		struct PendingFree
+		{
+			uint64_t Frame;
+			DescriptorRange Range;
+		};
+
+		// One per SlabSize window of the persistent region.
+		struct Slab
+		{
+			// Bit per block, set while free. SlabSize / 64 words.
+			uint64_t FreeMask[4];
+			uint32_t FreeCount;
+			// SizeClasses while the window is no slab.
+			uint32_t SizeClass;
+			// Slabs of the same size class with free blocks, linked by window.
+			uint32_t Previous;
+			uint32_t Next;
+		};
+
+		struct FrameEnd
+		{
+			uint64_t Frame;
+			// Ring position the frame's slots run up to.
+			uint64_t Head;
+		};
+
+		// Size class index for count, SizeClasses for large ranges.
+		static uint32_t GetSizeClass( uint32_t count ) noexcept;
+		// First fit starting at a multiple of alignment, UINT32_MAX when nothing fits.
+		uint32_t AllocateRange( uint32_t count, uint32_t alignment = 1 );
+		void FreeRange( uint32_t index, uint32_t count );
+		uint32_t AllocateBlock( uint32_t sizeClass );
+		void Release( DescriptorRange range );
+		void LinkSlab( uint32_t slab ) noexcept;
+		void UnlinkSlab( uint32_t slab ) noexcept;
+	private:
+		static constexpr uint32_t SizeClasses = 6;
+		static constexpr uint32_t SlabSize = 256;
+		static constexpr uint32_t NoSlab = UINT32_MAX;
+
+		const DescriptorAllocatorDesc _Desc;
+		mutable std::mutex _Mutex;
+		std::atomic<uint64_t> _Frame = 1;
+		// Free persistent slots that no size class holds, by index.
+		std::map<uint32_t, uint32_t> _FreeRanges;
+		std::vector<Slab> _Slabs;
+		// First slab with free blocks of 1, 2, 4 ... 32 slots.
+		uint32_t _PartialSlabs[SizeClasses];
+		// One per persistent slot, the count of the range starting there while allocated, else 0.
+		// Catches double and stray frees, and frees with another count.
+		std::vector<uint32_t> _Allocated;
+		std::deque<PendingFree> _PendingFrees;
+		uint64_t _RingHead = 0;
+		uint64_t _RingTail = 0;
+		uint64_t _FrameStart = 0;
+		std::deque<FrameEnd> _InFlight;
+		DescriptorAllocatorStats _Stats;
+	};
+}
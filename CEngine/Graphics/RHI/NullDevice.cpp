@@ -0,0 +1,1555 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "NullDevice.h"
+#include "imgui/imgui.h"
+#include <atomic>
+#include <cstring>
+#include <sstream>
+
+namespace CronoEngine::Graphics::RHI
+{
+	class NullHeap;
+
+	// Holds a device id for the life of the object.
+	class NullObject
+	{
+	public:
+		NullObject( NullDevice& device )
+			: _Device( device ), _Id( device.Register( this ) )
+		{
+		}
+		virtual ~NullObject()
+		{
+			_Device.Unregister( _Id );
+		}
+		NullObject( const NullObject& ) = delete;
+		NullObject& operator=( const NullObject& ) = delete;
+
+		NullDevice& GetDevice() const noexcept
+		{
+			return _Device;
+		}
+		uint32_t GetId() const noexcept
+		{
+			return _Id;
+		}
+	protected:
+		NullDevice& _Device;
+		const uint32_t _Id;
+	};
+
+	class NullResource : public NullObject
+	{
+	public:
+		NullResource( NullDevice& device, ResourceState state, const std::string& debugName )
+			: NullObject( device ), State( state ), _DebugName( debugName )
+		{
+		}
+		// "#4 (Scene Color)".
+		std::string GetLabel() const
+		{
+			std::string label = "#" + std::to_string( _Id );
+			if (!_DebugName.empty())
+			{
+				label += " (" + _DebugName + ")";
+			}
+			return label;
+		}
+		bool Overlaps( const NullResource& other ) const noexcept
+		{
+			return PlacedIn != nullptr && PlacedIn == other.PlacedIn &&
+				Offset < other.Offset + other.Size && other.Offset < Offset + Size;
+		}
+	public:
+		// As left by the last submitted list, only touched by queues.
+		ResourceState State;
+		// Placed resources only. Active while it holds its memory, queues hand that around.
+		NullHeap* PlacedIn = nullptr;
+		uint64_t Offset = 0;
+		uint64_t Size = 0;
+		bool Active = true;
+	private:
+		const std::string& _DebugName;
+	};
+
+	class NullBuffer : public Buffer, public NullResource
+	{
+	public:
+		NullBuffer( NullDevice& device, const BufferDesc& desc )
+			: Buffer( desc ), NullResource( device, GetInitialState( desc.Memory ), _Desc.DebugName )
+		{
+			if (desc.Memory != MemoryType::Default)
+			{
+				_Memory.resize( desc.Size );
+			}
+		}
+		NullBuffer( NullDevice& device, const BufferDesc& desc, NullHeap& heap, uint64_t offset, uint64_t size );
+		~NullBuffer();
+		void* GetMappedData() noexcept override
+		{
+			return _Desc.Memory != MemoryType::Default ? _Memory.data() : nullptr;
+		}
+		// Default buffers get theirs on the first copy, so copies through them can be read back.
+		uint8_t* GetMemory()
+		{
+			_Memory.resize( _Desc.Size );
+			return _Memory.data();
+		}
+	private:
+		static ResourceState GetInitialState( MemoryType memory ) noexcept
+		{
+			switch (memory)
+			{
+			case MemoryType::Upload: return ResourceState::GenericRead;
+			case MemoryType::Readback: return ResourceState::CopyDest;
+			default: return ResourceState::Common;
+			}
+		}
+	private:
+		std::vector<uint8_t> _Memory;
+	};
+
+	class NullHeap : public Heap, public NullObject
+	{
+	public:
+		NullHeap( NullDevice& device, const HeapDesc& desc )
+			: Heap( desc ), NullObject( device )
+		{
+			std::lock_guard<std::mutex> lock( _Device._Mutex );
+			GetUsage() += desc.Size;
+		}
+		~NullHeap()
+		{
+			assert( _Placed.empty() && "heap destroyed before the resources placed in it" );
+			std::lock_guard<std::mutex> lock( _Device._Mutex );
+			GetUsage() -= _Desc.Size;
+		}
+
+		// A new resource holds its memory unless something placed before overlaps it.
+		void Place( NullResource& resource )
+		{
+			std::lock_guard<std::mutex> lock( _Device._Mutex );
+			resource.Active = std::none_of( _Placed.begin(), _Placed.end(),
+				[&]( const NullResource* placed ) { return placed->Overlaps( resource ); } );
+			_Placed.push_back( &resource );
+		}
+
+		void Remove( NullResource& resource )
+		{
+			std::lock_guard<std::mutex> lock( _Device._Mutex );
+			_Placed.erase( std::find( _Placed.begin(), _Placed.end(), &resource ) );
+		}
+
+		// With the device mutex held.
+		void Activate( NullResource& resource )
+		{
+			for (NullResource* placed : _Placed)
+			{
+				if (placed->Overlaps( resource ))
+				{
+					placed->Active = false;
+				}
+			}
+			resource.Active = true;
+		}
+	private:
+		uint64_t& GetUsage() noexcept
+		{
+			return _Desc.Memory == MemoryType::Default ? _Device._LocalHeapBytes : _Device._NonLocalHeapBytes;
+		}
+	private:
+		std::vector<NullResource*> _Placed;
+	};
+
+	NullBuffer::NullBuffer( NullDevice& device, const BufferDesc& desc, NullHeap& heap, uint64_t offset, uint64_t size )
+		: NullBuffer( device, desc )
+	{
+		PlacedIn = &heap;
+		Offset = offset;
+		Size = size;
+		heap.Place( *this );
+	}
+
+	NullBuffer::~NullBuffer()
+	{
+		if (PlacedIn != nullptr)
+		{
+			PlacedIn->Remove( *this );
+		}
+	}
+
+	class NullTexture : public Texture, public NullResource
+	{
+	public:
+		NullTexture( NullDevice& device, const TextureDesc& desc )
+			: Texture( desc ), NullResource( device, desc.InitialState, _Desc.DebugName )
+		{
+			AllocateView();
+		}
+		NullTexture( NullDevice& device, const TextureDesc& desc, NullHeap& heap, uint64_t offset, uint64_t size )
+			: Texture( desc ), NullResource( device, desc.InitialState, _Desc.DebugName )
+		{
+			PlacedIn = &heap;
+			Offset = offset;
+			Size = size;
+			heap.Place( *this );
+			AllocateView();
+		}
+		~NullTexture()
+		{
+			if (PlacedIn != nullptr)
+			{
+				PlacedIn->Remove( *this );
+			}
+			if (_ShaderResourceIndex != UINT32_MAX)
+			{
+				_Device._Descriptors.Free( { _ShaderResourceIndex, 1 } );
+			}
+		}
+	private:
+		void AllocateView()
+		{
+			if (HasFlags( _Desc.Usage, TextureUsage::ShaderResource ))
+			{
+				_ShaderResourceIndex = _Device._Descriptors.Allocate().Index;
+			}
+		}
+	};
+
+	class NullPipeline : public Pipeline, public NullObject
+	{
+	public:
+		NullPipeline( NullDevice& device, const PipelineDesc& desc )
+			: Pipeline( desc ), NullObject( device )
+		{
+		}
+	};
+
+	class NullFence : public Fence
+	{
+	public:
+		NullFence( NullDevice& device, uint64_t value )
+			: Value( value ), _Device( device )
+		{
+		}
+		uint64_t GetCompletedValue() const override
+		{
+			return Value.load( std::memory_order_acquire );
+		}
+		void Wait( uint64_t value ) override
+		{
+			const uint64_t completed = GetCompletedValue();
+			if (completed < value)
+			{
+				// Submitted work is done already, so nothing is left that could signal it.
+				_Device.Report( "Fence::Wait( " + std::to_string( value ) + " ) would never return, the fence is at " +
+					std::to_string( completed ) + " and nothing submitted signals more" );
+			}
+		}
+	public:
+		std::atomic<uint64_t> Value;
+	private:
+		NullDevice& _Device;
+	};
+
+	class NullCommandList : public CommandList
+	{
+	public:
+		using CommandList::Barrier;
+
+		NullCommandList( NullDevice& device, QueueType type )
+			: _Device( device ), _Type( type )
+		{
+		}
+
+		QueueType GetType() const noexcept override
+		{
+			return _Type;
+		}
+
+		void Begin() override
+		{
+			if (_Recording)
+			{
+				Fail( "Begin", "the list is already recording" );
+			}
+			_Recording = true;
+			_Closed = false;
+			_Commands.clear();
+			_Uses.clear();
+			_UseIndex.clear();
+			_Activations.clear();
+			_Bound = {};
+			_EventDepth = 0;
+		}
+
+		void End() override
+		{
+			if (!_Recording)
+			{
+				Fail( "End", "the list is not recording" );
+			}
+			if (_EventDepth != 0)
+			{
+				Fail( "End", std::to_string( _EventDepth ) + " BeginEvent calls are not closed" );
+			}
+			_Recording = false;
+			_Closed = true;
+		}
+
+		void Barrier( const ResourceBarrier* barriers, uint32_t count ) override
+		{
+			CheckRecording( "Barrier" );
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				const ResourceBarrier& barrier = barriers[i];
+				RecordedCommand& command = Record( CommandType::Barrier );
+				command.Arguments[0] = static_cast<uint64_t>(barrier.Before);
+				command.Arguments[1] = static_cast<uint64_t>(barrier.After);
+				command.Arguments[2] = static_cast<uint64_t>(barrier.Type);
+				if (barrier.Target == nullptr)
+				{
+					Fail( "Barrier", "null target" );
+					continue;
+				}
+				NullResource* resource = Find( *barrier.Target, "Barrier" );
+				if (resource == nullptr)
+				{
+					continue;
+				}
+				command.Objects[0] = resource->GetId();
+				if (barrier.Type == BarrierType::Aliasing)
+				{
+					if (resource->PlacedIn == nullptr)
+					{
+						Fail( "Barrier", resource->GetLabel() + " is not placed in a heap, there is nothing to alias" );
+						continue;
+					}
+					_Activations.push_back( resource );
+					continue;
+				}
+				if (barrier.Type == BarrierType::UnorderedAccess)
+				{
+					Require( *resource, ResourceState::UnorderedAccess, "Barrier" );
+					continue;
+				}
+				if (barrier.Before == barrier.After)
+				{
+					Fail( "Barrier", resource->GetLabel() + " goes from " + GetStateName( barrier.Before ) + " to itself" );
+				}
+				if (const NullBuffer* buffer = dynamic_cast<const NullBuffer*>(resource);
+					buffer != nullptr && buffer->GetDesc().Memory != MemoryType::Default)
+				{
+					Fail( "Barrier", resource->GetLabel() + " is an Upload or Readback buffer, those never change state" );
+				}
+				Transition( *resource, barrier.Before, barrier.After, "Barrier" );
+			}
+		}
+
+		void ClearRenderTarget( Texture& target, const float color[4] ) override
+		{
+			CheckGraphics( "ClearRenderTarget" );
+			RecordedCommand& command = Record( CommandType::ClearRenderTarget );
+			std::copy( color, color + 4, command.Values );
+			if (NullResource* resource = FindTexture( target, TextureUsage::RenderTarget, "ClearRenderTarget" ))
+			{
+				command.Objects[0] = resource->GetId();
+				Require( *resource, ResourceState::RenderTarget, "ClearRenderTarget" );
+			}
+		}
+
+		void ClearDepth( Texture& target, float depth ) override
+		{
+			CheckGraphics( "ClearDepth" );
+			RecordedCommand& command = Record( CommandType::ClearDepth );
+			command.Values[0] = depth;
+			if (NullResource* resource = FindTexture( target, TextureUsage::DepthStencil, "ClearDepth" ))
+			{
+				command.Objects[0] = resource->GetId();
+				Require( *resource, ResourceState::DepthWrite, "ClearDepth" );
+			}
+		}
+
+		void SetRenderTargets( Texture* const* targets, uint32_t count, Texture* depth ) override
+		{
+			CheckGraphics( "SetRenderTargets" );
+			RecordedCommand& command = Record( CommandType::SetRenderTargets );
+			if (count > MaxRenderTargets)
+			{
+				Fail( "SetRenderTargets", std::to_string( count ) + " targets, at most " + std::to_string( MaxRenderTargets ) );
+				count = MaxRenderTargets;
+			}
+			command.Arguments[0] = count;
+			_Bound.TargetCount = count;
+			_Bound.DepthFormat = PixelFormat::Unknown;
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				_Bound.TargetFormats[i] = PixelFormat::Unknown;
+				if (targets[i] == nullptr)
+				{
+					continue;
+				}
+				if (NullResource* resource = FindTexture( *targets[i], TextureUsage::RenderTarget, "SetRenderTargets" ))
+				{
+					command.Objects[i] = resource->GetId();
+					_Bound.TargetFormats[i] = targets[i]->GetDesc().Format;
+					Require( *resource, ResourceState::RenderTarget, "SetRenderTargets" );
+				}
+			}
+			if (depth != nullptr)
+			{
+				if (NullResource* resource = FindTexture( *depth, TextureUsage::DepthStencil, "SetRenderTargets" ))
+				{
+					command.Objects[MaxRenderTargets] = resource->GetId();
+					_Bound.DepthFormat = depth->GetDesc().Format;
+					Require( *resource, ResourceState::DepthWrite, "SetRenderTargets" );
+				}
+			}
+		}
+
+		void SetViewport( const Viewport& viewport ) override
+		{
+			CheckGraphics( "SetViewport" );
+			RecordedCommand& command = Record( CommandType::SetViewport );
+			const float values[6] = { viewport.X, viewport.Y, viewport.Width, viewport.Height, viewport.MinDepth, viewport.MaxDepth };
+			std::copy( values, values + 6, command.Values );
+			if (viewport.Width <= 0.0f || viewport.Height <= 0.0f)
+			{
+				Fail( "SetViewport", "empty viewport" );
+			}
+			_Bound.HasViewport = true;
+		}
+
+		void SetScissor( const ScissorRect& scissor ) override
+		{
+			CheckGraphics( "SetScissor" );
+			RecordedCommand& command = Record( CommandType::SetScissor );
+			const float values[4] = { static_cast<float>(scissor.Left), static_cast<float>(scissor.Top),
+				static_cast<float>(scissor.Right), static_cast<float>(scissor.Bottom) };
+			std::copy( values, values + 4, command.Values );
+			if (scissor.Right < scissor.Left || scissor.Bottom < scissor.Top)
+			{
+				Fail( "SetScissor", "inverted rectangle" );
+			}
+		}
+
+		void SetPipeline( Pipeline& pipeline ) override
+		{
+			CheckGraphics( "SetPipeline" );
+			RecordedCommand& command = Record( CommandType::SetPipeline );
+			NullPipeline* nullPipeline = dynamic_cast<NullPipeline*>(&pipeline);
+			if (nullPipeline == nullptr || &nullPipeline->GetDevice() != &_Device)
+			{
+				Fail( "SetPipeline", "pipeline not made by this device" );
+				return;
+			}
+			command.Objects[0] = nullPipeline->GetId();
+			// Copied so a draw never looks at a pipeline that may be gone by then.
+			const PipelineDesc& desc = pipeline.GetDesc();
+			_Bound.HasPipeline = true;
+			_Bound.PipelineId = nullPipeline->GetId();
+			std::copy( desc.RenderTargetFormats, desc.RenderTargetFormats + MaxRenderTargets, _Bound.PipelineTargetFormats );
+			_Bound.PipelineTargetCount = desc.RenderTargetCount;
+			_Bound.PipelineDepthFormat = desc.DepthFormat;
+			_Bound.VertexStride = desc.InputLayout.empty() ? 0 : desc.VertexStride;
+			_Bound.ConstantBufferMask = (1u << desc.ConstantBufferCount) - 1;
+			_Bound.Topology = desc.Topology;
+		}
+
+		void SetVertexBuffer( uint32_t slot, Buffer& buffer, uint64_t offset ) override
+		{
+			CheckGraphics( "SetVertexBuffer" );
+			RecordedCommand& command = Record( CommandType::SetVertexBuffer );
+			command.Arguments[0] = slot;
+			command.Arguments[1] = offset;
+			if (slot >= MaxVertexBuffers)
+			{
+				Fail( "SetVertexBuffer", "slot " + std::to_string( slot ) + " past MaxVertexBuffers" );
+				return;
+			}
+			if (NullResource* resource = FindBuffer( buffer, BufferUsage::Vertex, offset, "SetVertexBuffer" ))
+			{
+				command.Objects[0] = resource->GetId();
+				_Bound.VertexBufferSizes[slot] = buffer.GetDesc().Size - offset;
+				Require( *resource, ResourceState::VertexBuffer, "SetVertexBuffer" );
+			}
+		}
+
+		void SetIndexBuffer( Buffer& buffer, uint64_t offset, IndexFormat format ) override
+		{
+			CheckGraphics( "SetIndexBuffer" );
+			RecordedCommand& command = Record( CommandType::SetIndexBuffer );
+			command.Arguments[0] = offset;
+			command.Arguments[1] = static_cast<uint64_t>(format);
+			const uint32_t indexSize = format == IndexFormat::UInt16 ? 2 : 4;
+			if (offset % indexSize != 0)
+			{
+				Fail( "SetIndexBuffer", "offset " + std::to_string( offset ) + " is not a multiple of the index size" );
+			}
+			if (NullResource* resource = FindBuffer( buffer, BufferUsage::Index, offset, "SetIndexBuffer" ))
+			{
+				command.Objects[0] = resource->GetId();
+				_Bound.IndexBufferSize = buffer.GetDesc().Size - offset;
+				_Bound.IndexSize = indexSize;
+				Require( *resource, ResourceState::IndexBuffer, "SetIndexBuffer" );
+			}
+		}
+
+		void SetConstantBuffer( uint32_t slot, Buffer& buffer, uint64_t offset ) override
+		{
+			CheckGraphics( "SetConstantBuffer" );
+			RecordedCommand& command = Record( CommandType::SetConstantBuffer );
+			command.Arguments[0] = slot;
+			command.Arguments[1] = offset;
+			if (slot >= MaxConstantBuffers)
+			{
+				Fail( "SetConstantBuffer", "slot " + std::to_string( slot ) + " past MaxConstantBuffers" );
+				return;
+			}
+			if (offset % ConstantBufferAlignment != 0)
+			{
+				Fail( "SetConstantBuffer", "offset " + std::to_string( offset ) + " is not a multiple of " +
+					std::to_string( ConstantBufferAlignment ) );
+			}
+			if (NullResource* resource = FindBuffer( buffer, BufferUsage::Constant, offset, "SetConstantBuffer" ))
+			{
+				command.Objects[0] = resource->GetId();
+				_Bound.BoundConstantBuffers |= 1u << slot;
+				Require( *resource, ResourceState::ConstantBuffer, "SetConstantBuffer" );
+			}
+		}
+
+		void Draw( uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance ) override
+		{
+			CheckGraphics( "Draw" );
+			RecordedCommand& command = Record( CommandType::Draw );
+			command.Objects[0] = _Bound.PipelineId;
+			command.Arguments[0] = vertexCount;
+			command.Arguments[1] = instanceCount;
+			command.Arguments[2] = firstVertex;
+			command.Arguments[3] = firstInstance;
+			command.Arguments[4] = GetPrimitiveCount( vertexCount ) * instanceCount;
+			CheckDrawState( "Draw" );
+			const uint64_t end = (static_cast<uint64_t>(firstVertex) + vertexCount) * _Bound.VertexStride;
+			if (_Bound.HasPipeline && _Bound.VertexStride != 0 && end > _Bound.VertexBufferSizes[0])
+			{
+				Fail( "Draw", "vertices up to " + std::to_string( firstVertex + vertexCount ) +
+					" are past the end of vertex buffer slot 0" );
+			}
+		}
+
+		// The first instance is not recorded, only instance data would tell it apart.
+		void DrawIndexed( uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex,
+			int32_t baseVertex, uint32_t ) override
+		{
+			CheckGraphics( "DrawIndexed" );
+			RecordedCommand& command = Record( CommandType::DrawIndexed );
+			command.Objects[0] = _Bound.PipelineId;
+			command.Arguments[0] = indexCount;
+			command.Arguments[1] = instanceCount;
+			command.Arguments[2] = firstIndex;
+			command.Arguments[3] = static_cast<uint64_t>(static_cast<int64_t>(baseVertex));
+			command.Arguments[4] = GetPrimitiveCount( indexCount ) * instanceCount;
+			CheckDrawState( "DrawIndexed" );
+			if (_Bound.IndexSize == 0)
+			{
+				Fail( "DrawIndexed", "no index buffer" );
+			}
+			else if ((static_cast<uint64_t>(firstIndex) + indexCount) * _Bound.IndexSize > _Bound.IndexBufferSize)
+			{
+				Fail( "DrawIndexed", "indices up to " + std::to_string( firstIndex + indexCount ) + " are past the end of the index buffer" );
+			}
+		}
+
+		void CopyBuffer( Buffer& destination, uint64_t destinationOffset,
+			Buffer& source, uint64_t sourceOffset, uint64_t size ) override
+		{
+			CheckRecording( "CopyBuffer" );
+			RecordedCommand& command = Record( CommandType::CopyBuffer );
+			command.Arguments[0] = destinationOffset;
+			command.Arguments[1] = sourceOffset;
+			command.Arguments[2] = size;
+			NullResource* to = FindBuffer( destination, BufferUsage::None, 0, "CopyBuffer" );
+			NullResource* from = FindBuffer( source, BufferUsage::None, 0, "CopyBuffer" );
+			if (to == nullptr || from == nullptr)
+			{
+				return;
+			}
+			command.Objects[0] = to->GetId();
+			command.Objects[1] = from->GetId();
+			if (to == from)
+			{
+				Fail( "CopyBuffer", "source and destination are both " + to->GetLabel() );
+			}
+			if (destinationOffset + size > destination.GetDesc().Size || sourceOffset + size > source.GetDesc().Size)
+			{
+				Fail( "CopyBuffer", std::to_string( size ) + " bytes from " + from->GetLabel() + " +" + std::to_string( sourceOffset ) +
+					" to " + to->GetLabel() + " +" + std::to_string( destinationOffset ) + " run past the end" );
+			}
+			Require( *to, ResourceState::CopyDest, "CopyBuffer" );
+			Require( *from, ResourceState::CopySource, "CopyBuffer" );
+		}
+
+		void CopyBufferToTexture( Texture& destination, Buffer& source, uint64_t sourceOffset, uint32_t rowPitch ) override
+		{
+			CheckRecording( "CopyBufferToTexture" );
+			RecordedCommand& command = Record( CommandType::CopyBufferToTexture );
+			command.Arguments[0] = sourceOffset;
+			command.Arguments[1] = rowPitch;
+			NullResource* to = FindTexture( destination, TextureUsage::None, "CopyBufferToTexture" );
+			NullResource* from = FindBuffer( source, BufferUsage::None, 0, "CopyBufferToTexture" );
+			if (to == nullptr || from == nullptr)
+			{
+				return;
+			}
+			command.Objects[0] = to->GetId();
+			command.Objects[1] = from->GetId();
+			const TextureDesc& desc = destination.GetDesc();
+			const uint64_t rowBytes = static_cast<uint64_t>(desc.Width) * GetFormatSize( desc.Format );
+			// D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT.
+			if (rowPitch % TextureRowAlignment != 0 || rowPitch < rowBytes || sourceOffset % 512 != 0)
+			{
+				Fail( "CopyBufferToTexture", "row pitch " + std::to_string( rowPitch ) + " or offset " +
+					std::to_string( sourceOffset ) + " is misaligned or too small for " + to->GetLabel() );
+			}
+			if (sourceOffset + static_cast<uint64_t>(rowPitch) * (desc.Height - 1) + rowBytes > source.GetDesc().Size)
+			{
+				Fail( "CopyBufferToTexture", "rows run past the end of " + from->GetLabel() );
+			}
+			Require( *to, ResourceState::CopyDest, "CopyBufferToTexture" );
+			Require( *from, ResourceState::CopySource, "CopyBufferToTexture" );
+		}
+
+		void DrawUI( ImDrawData* drawData ) override
+		{
+			CheckGraphics( "DrawUI" );
+			RecordedCommand& command = Record( CommandType::DrawUI );
+			if (drawData != nullptr)
+			{
+				command.Arguments[0] = static_cast<uint64_t>(drawData->CmdListsCount);
+				command.Arguments[1] = static_cast<uint64_t>(drawData->TotalVtxCount);
+				command.Arguments[2] = static_cast<uint64_t>(drawData->TotalIdxCount);
+				command.Arguments[4] = static_cast<uint64_t>(drawData->TotalIdxCount / 3);
+			}
+			if (_Bound.TargetCount == 0)
+			{
+				Fail( "DrawUI", "no render target" );
+			}
+		}
+
+		void BeginEvent( const char* name ) override
+		{
+			CheckRecording( "BeginEvent" );
+			Record( CommandType::BeginEvent ).Name = _Device.Intern( name != nullptr ? name : "" );
+			++_EventDepth;
+		}
+
+		void EndEvent() override
+		{
+			CheckRecording( "EndEvent" );
+			Record( CommandType::EndEvent );
+			if (_EventDepth == 0)
+			{
+				Fail( "EndEvent", "no BeginEvent to close" );
+				return;
+			}
+			--_EventDepth;
+		}
+	public:
+		struct Use
+		{
+			NullResource* Resource;
+			uint32_t Id;
+			// What it must be in when the list starts, exactly when Exact, at least otherwise.
+			ResourceState Initial;
+			ResourceState Current;
+			bool Exact;
+			// Placed and used before the list makes it take over its memory.
+			bool NeedsActive = false;
+		};
+
+		bool IsClosed() const noexcept
+		{
+			return _Closed;
+		}
+		const std::vector<RecordedCommand>& GetCommands() const noexcept
+		{
+			return _Commands;
+		}
+		const std::vector<Use>& GetUses() const noexcept
+		{
+			return _Uses;
+		}
+	private:
+		// Copied from the bound pipeline, targets and buffers for the draw checks.
+		struct BoundState
+		{
+			bool HasPipeline = false;
+			bool HasViewport = false;
+			uint32_t PipelineId = 0;
+			PixelFormat PipelineTargetFormats[MaxRenderTargets] = {};
+			uint32_t PipelineTargetCount = 0;
+			PixelFormat PipelineDepthFormat = PixelFormat::Unknown;
+			uint32_t VertexStride = 0;
+			uint32_t ConstantBufferMask = 0;
+			PrimitiveTopology Topology = PrimitiveTopology::TriangleList;
+			PixelFormat TargetFormats[MaxRenderTargets] = {};
+			uint32_t TargetCount = 0;
+			PixelFormat DepthFormat = PixelFormat::Unknown;
+			uint64_t VertexBufferSizes[MaxVertexBuffers] = {};
+			uint64_t IndexBufferSize = 0;
+			uint32_t IndexSize = 0;
+			uint32_t BoundConstantBuffers = 0;
+		};
+
+		void Fail( const char* call, const std::string& message )
+		{
+			_Device.Report( std::string( call ) + ": " + message );
+		}
+
+		RecordedCommand& Record( CommandType type )
+		{
+			RecordedCommand& command = _Commands.emplace_back();
+			command.Type = type;
+			return command;
+		}
+
+		void CheckRecording( const char* call )
+		{
+			if (!_Recording)
+			{
+				Fail( call, "the list is not recording, call Begin first" );
+			}
+		}
+
+		void CheckGraphics( const char* call )
+		{
+			CheckRecording( call );
+			if (_Type != QueueType::Graphics)
+			{
+				Fail( call, "only graphics lists can do this" );
+			}
+		}
+
+		NullResource* Find( Resource& resource, const char* call )
+		{
+			NullResource* found = dynamic_cast<NullResource*>(&resource);
+			if (found == nullptr || &found->GetDevice() != &_Device)
+			{
+				Fail( call, "resource not made by this device" );
+				return nullptr;
+			}
+			return found;
+		}
+
+		NullResource* FindTexture( Texture& texture, TextureUsage usage, const char* call )
+		{
+			NullResource* resource = Find( texture, call );
+			if (resource != nullptr && !HasFlags( texture.GetDesc().Usage, usage ))
+			{
+				Fail( call, resource->GetLabel() + " was not created for this usage" );
+			}
+			return resource;
+		}
+
+		NullResource* FindBuffer( Buffer& buffer, BufferUsage usage, uint64_t offset, const char* call )
+		{
+			NullResource* resource = Find( buffer, call );
+			if (resource == nullptr)
+			{
+				return nullptr;
+			}
+			if (!HasFlags( buffer.GetDesc().Usage, usage ))
+			{
+				Fail( call, resource->GetLabel() + " was not created for this usage" );
+			}
+			if (offset != 0 && offset >= buffer.GetDesc().Size)
+			{
+				Fail( call, "offset " + std::to_string( offset ) + " is past the end of " + resource->GetLabel() );
+			}
+			return resource;
+		}
+
+		Use& Track( NullResource& resource, ResourceState initial, bool exact, const char* call )
+		{
+			const auto [it, inserted] = _UseIndex.try_emplace( resource.GetId(), static_cast<uint32_t>(_Uses.size()) );
+			if (inserted)
+			{
+				_Uses.push_back( { &resource, resource.GetId(), initial, initial, exact } );
+			}
+			Use& use = _Uses[it->second];
+			if (resource.PlacedIn != nullptr)
+			{
+				CheckMemory( resource, use, call );
+			}
+			return use;
+		}
+
+		// A placed resource must hold its memory, from an Aliasing barrier earlier in the list or when the list starts.
+		void CheckMemory( NullResource& resource, Use& use, const char* call )
+		{
+			for (auto it = _Activations.rbegin(); it != _Activations.rend(); ++it)
+			{
+				if (*it == &resource)
+				{
+					return;
+				}
+				if ((*it)->Overlaps( resource ))
+				{
+					Fail( call, resource.GetLabel() + " is used after " + (*it)->GetLabel() + " took over its memory" );
+					return;
+				}
+			}
+			use.NeedsActive = true;
+		}
+
+		// The resource must be in (at least) state for what comes next.
+		void Require( NullResource& resource, ResourceState state, const char* call )
+		{
+			Use& use = Track( resource, state, false, call );
+			if (!use.Exact)
+			{
+				// Only read so far: it must start in every state it is read in.
+				use.Initial = use.Initial | state;
+				use.Current = use.Initial;
+			}
+			else if (!HasFlags( use.Current, state ))
+			{
+				Fail( call, resource.GetLabel() + " must be in " + GetStateName( state ) + " but the list left it in " +
+					GetStateName( use.Current ) );
+			}
+		}
+
+		void Transition( NullResource& resource, ResourceState before, ResourceState after, const char* call )
+		{
+			Use& use = Track( resource, before, true, call );
+			if (!use.Exact && HasFlags( before, use.Initial ))
+			{
+				// Only read so far, now the whole state is known.
+				use.Initial = before;
+				use.Current = before;
+				use.Exact = true;
+			}
+			if (use.Current != before)
+			{
+				Fail( call, resource.GetLabel() + " is in " + GetStateName( use.Current ) + ", not " + GetStateName( before ) );
+			}
+			use.Current = after;
+		}
+
+		void CheckDrawState( const char* call )
+		{
+			if (!_Bound.HasPipeline)
+			{
+				Fail( call, "no pipeline" );
+				return;
+			}
+			if (!_Bound.HasViewport)
+			{
+				Fail( call, "no viewport" );
+			}
+			if (_Bound.TargetCount != _Bound.PipelineTargetCount ||
+				!std::equal( _Bound.TargetFormats, _Bound.TargetFormats + _Bound.TargetCount, _Bound.PipelineTargetFormats ) ||
+				_Bound.DepthFormat != _Bound.PipelineDepthFormat)
+			{
+				Fail( call, "the bound render targets do not match the pipeline's formats" );
+			}
+			if ((_Bound.BoundConstantBuffers & _Bound.ConstantBufferMask) != _Bound.ConstantBufferMask)
+			{
+				Fail( call, "a constant buffer the pipeline uses is not bound" );
+			}
+			if (_Bound.VertexStride != 0 && _Bound.VertexBufferSizes[0] == 0)
+			{
+				Fail( call, "no vertex buffer in slot 0" );
+			}
+		}
+
+		uint64_t GetPrimitiveCount( uint32_t vertexCount ) const noexcept
+		{
+			switch (_Bound.Topology)
+			{
+			case PrimitiveTopology::TriangleList: return vertexCount / 3;
+			case PrimitiveTopology::TriangleStrip: return vertexCount > 2 ? vertexCount - 2 : 0;
+			case PrimitiveTopology::LineList: return vertexCount / 2;
+			default: return vertexCount;
+			}
+		}
+	private:
+		NullDevice& _Device;
+		const QueueType _Type;
+		bool _Recording = false;
+		bool _Closed = false;
+		std::vector<RecordedCommand> _Commands;
+		std::vector<Use> _Uses;
+		std::unordered_map<uint32_t, uint32_t> _UseIndex;
+		// Placed resources given their memory by Aliasing barriers, in order.
+		std::vector<NullResource*> _Activations;
+		BoundState _Bound;
+		uint32_t _EventDepth = 0;
+	};
+
+	class NullQueue : public Queue
+	{
+	public:
+		NullQueue( NullDevice& device, QueueType type )
+			: _Device( device ), _Type( type )
+		{
+		}
+
+		QueueType GetType() const noexcept override
+		{
+			return _Type;
+		}
+
+		void Submit( CommandList* const* lists, uint32_t count ) override
+		{
+			std::lock_guard<std::mutex> lock( _Device._Mutex );
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				NullCommandList* list = dynamic_cast<NullCommandList*>(lists[i]);
+				if (list == nullptr)
+				{
+					_Device.ReportLocked( "Submit: command list not made by a NullDevice" );
+					continue;
+				}
+				if (!list->IsClosed())
+				{
+					_Device.ReportLocked( "Submit: the list was not closed with End" );
+					continue;
+				}
+				if (list->GetType() != _Type)
+				{
+					_Device.ReportLocked( "Submit: list and queue types differ" );
+					continue;
+				}
+				Execute( *list );
+			}
+		}
+
+		void Signal( Fence& fence, uint64_t value ) override
+		{
+			NullFence* nullFence = dynamic_cast<NullFence*>(&fence);
+			if (nullFence == nullptr)
+			{
+				_Device.Report( "Signal: fence not made by a NullDevice" );
+				return;
+			}
+			const uint64_t previous = nullFence->Value.load( std::memory_order_relaxed );
+			if (value < previous)
+			{
+				_Device.Report( "Signal: fence values must not go down, " + std::to_string( previous ) + " -> " + std::to_string( value ) );
+			}
+			// Everything submitted before is done already.
+			nullFence->Value.store( value, std::memory_order_release );
+		}
+
+		void Wait( Fence& fence, uint64_t value ) override
+		{
+			NullFence* nullFence = dynamic_cast<NullFence*>(&fence);
+			if (nullFence == nullptr)
+			{
+				_Device.Report( "Wait: fence not made by a NullDevice" );
+				return;
+			}
+			// Work completes at Submit, so the value has to be signalled already.
+			const uint64_t completed = nullFence->GetCompletedValue();
+			if (completed < value)
+			{
+				_Device.Report( "Wait: the queue would wait for " + std::to_string( value ) + " forever, the fence is at " +
+					std::to_string( completed ) + " and nothing submitted signals more" );
+			}
+		}
+
+		void WaitIdle() override
+		{
+		}
+	private:
+		// With the device mutex held.
+		void Execute( const NullCommandList& list )
+		{
+			const std::vector<RecordedCommand>& commands = list.GetCommands();
+			for (const RecordedCommand& command : commands)
+			{
+				for (uint32_t id : command.Objects)
+				{
+					if (id != 0 && _Device._Alive.find( id ) == _Device._Alive.end())
+					{
+						_Device.ReportLocked( "Submit: #" + std::to_string( id ) + " was destroyed after the list recorded it" );
+						return;
+					}
+				}
+			}
+			for (const NullCommandList::Use& use : list.GetUses())
+			{
+				NullResource& resource = *use.Resource;
+				const bool matches = use.Exact ? resource.State == use.Initial : HasFlags( resource.State, use.Initial );
+				if (!matches)
+				{
+					_Device.ReportLocked( "Submit: the list expects " + resource.GetLabel() + " in " + GetStateName( use.Initial ) +
+						" but it is in " + GetStateName( resource.State ) );
+				}
+				if (use.NeedsActive && !resource.Active)
+				{
+					_Device.ReportLocked( "Submit: the list uses " + resource.GetLabel() +
+						" while another placed resource holds its memory, it needs an Aliasing barrier first" );
+				}
+				resource.State = use.Current;
+			}
+
+			NullDeviceStats& stats = _Device._Stats;
+			++stats.SubmittedLists;
+			stats.Commands += commands.size();
+			for (const RecordedCommand& command : commands)
+			{
+				switch (command.Type)
+				{
+				case CommandType::Barrier:
+					++stats.Barriers;
+					if (command.Arguments[2] == static_cast<uint64_t>(BarrierType::Aliasing))
+					{
+						++stats.AliasingBarriers;
+						Activate( command.Objects[0] );
+					}
+					break;
+				case CommandType::ClearRenderTarget:
+				case CommandType::ClearDepth:
+					++stats.Clears;
+					break;
+				case CommandType::Draw:
+				case CommandType::DrawIndexed:
+					++stats.Draws;
+					stats.Primitives += command.Arguments[4];
+					break;
+				case CommandType::DrawUI:
+					++stats.UIDraws;
+					stats.Primitives += command.Arguments[4];
+					break;
+				case CommandType::CopyBuffer:
+					++stats.Copies;
+					stats.CopiedBytes += command.Arguments[2];
+					CopyBufferMemory( command );
+					break;
+				case CommandType::CopyBufferToTexture:
+					++stats.Copies;
+					break;
+				case CommandType::BeginEvent:
+				case CommandType::EndEvent:
+					break;
+				default:
+					++stats.StateChanges;
+					break;
+				}
+			}
+			if (_Device._Desc.RecordSubmissions)
+			{
+				_Device._Submissions.push_back( { _Type, _Device._NextSubmission, commands } );
+			}
+			++_Device._NextSubmission;
+		}
+
+		void Activate( uint32_t id )
+		{
+			NullResource* resource = dynamic_cast<NullResource*>(_Device._Alive[id]);
+			if (resource != nullptr && resource->PlacedIn != nullptr)
+			{
+				resource->PlacedIn->Activate( *resource );
+			}
+		}
+
+		void CopyBufferMemory( const RecordedCommand& command )
+		{
+			NullBuffer* to = dynamic_cast<NullBuffer*>(_Device._Alive[command.Objects[0]]);
+			NullBuffer* from = dynamic_cast<NullBuffer*>(_Device._Alive[command.Objects[1]]);
+			const uint64_t size = command.Arguments[2];
+			if (to != nullptr && from != nullptr &&
+				command.Arguments[0] + size <= to->GetDesc().Size && command.Arguments[1] + size <= from->GetDesc().Size)
+			{
+				std::memmove( to->GetMemory() + command.Arguments[0], from->GetMemory() + command.Arguments[1], size );
+			}
+		}
+	private:
+		NullDevice& _Device;
+		const QueueType _Type;
+	};
+
+	class NullSwapChain : public SwapChain
+	{
+	public:
+		NullSwapChain( NullDevice& device, const SwapChainDesc& desc )
+			: _Device( device ), _Desc( desc )
+		{
+			CreateBuffers();
+		}
+
+		const SwapChainDesc& GetDesc() const noexcept override
+		{
+			return _Desc;
+		}
+
+		uint32_t GetCurrentIndex() const override
+		{
+			return _Current;
+		}
+
+		Texture& GetBackBuffer( uint32_t index ) override
+		{
+			if (index >= _Buffers.size())
+			{
+				// There is no texture to return, so this throws even without ThrowOnError.
+				const std::string message = "GetBackBuffer: index " + std::to_string( index ) + " of " +
+					std::to_string( _Buffers.size() ) + " back buffers";
+				_Device.Report( message );
+				throw CHWND_RHI_EXCEPT( message );
+			}
+			return *_Buffers[index];
+		}
+
+		// Frames aren't shown, so there is no interval to wait for.
+		void Present( bool ) override
+		{
+			std::lock_guard<std::mutex> lock( _Device._Mutex );
+			NullTexture& buffer = *_Buffers[_Current];
+			if (buffer.State != ResourceState::Present)
+			{
+				_Device.ReportLocked( "Present: back buffer " + buffer.GetLabel() + " is in " + GetStateName( buffer.State ) );
+			}
+			++_Device._Stats.Presents;
+			_Current = (_Current + 1) % _Desc.BufferCount;
+		}
+
+		void Resize( uint32_t width, uint32_t height ) override
+		{
+			_Desc.Width = std::max( 1u, width );
+			_Desc.Height = std::max( 1u, height );
+			CreateBuffers();
+		}
+	private:
+		void CreateBuffers()
+		{
+			_Buffers.clear();
+			for (uint32_t i = 0; i < _Desc.BufferCount; ++i)
+			{
+				TextureDesc desc;
+				desc.Width = _Desc.Width;
+				desc.Height = _Desc.Height;
+				desc.Format = _Desc.Format;
+				desc.Usage = TextureUsage::RenderTarget;
+				desc.InitialState = ResourceState::Present;
+				desc.DebugName = "Back Buffer " + std::to_string( i );
+				_Buffers.push_back( std::make_unique<NullTexture>( _Device, desc ) );
+			}
+			_Current = 0;
+		}
+	private:
+		NullDevice& _Device;
+		SwapChainDesc _Desc;
+		std::vector<std::unique_ptr<NullTexture>> _Buffers;
+		uint32_t _Current = 0;
+	};
+
+	NullDevice::NullDevice( const NullDeviceDesc& desc )
+		: _Desc( desc ), _Descriptors( { PersistentDescriptors, FrameDescriptors } )
+	{
+		for (size_t i = 0; i < static_cast<size_t>(QueueType::Count); ++i)
+		{
+			_Queues[i] = std::make_unique<NullQueue>( *this, static_cast<QueueType>(i) );
+		}
+	}
+
+	NullDevice::~NullDevice()
+	{
+		// Objects must go before their device, a leak here is a bug in the caller.
+		assert( _Alive.empty() && "NullDevice destroyed before the objects it made" );
+	}
+
+	const char* NullDevice::GetName() const noexcept
+	{
+		return "Null";
+	}
+
+	Queue& NullDevice::GetQueue( QueueType type )
+	{
+		return *_Queues[static_cast<size_t>(type)];
+	}
+
+	std::unique_ptr<Buffer> NullDevice::CreateBuffer( const BufferDesc& desc )
+	{
+		if (desc.Size == 0)
+		{
+			Report( "CreateBuffer: empty buffer" );
+		}
+		return std::make_unique<NullBuffer>( *this, desc );
+	}
+
+	std::unique_ptr<Texture> NullDevice::CreateTexture( const TextureDesc& desc )
+	{
+		CheckTextureDesc( desc, "CreateTexture" );
+		return std::make_unique<NullTexture>( *this, desc );
+	}
+
+	std::unique_ptr<Pipeline> NullDevice::CreatePipeline( const PipelineDesc& desc )
+	{
+		if (desc.VertexShader.Data == nullptr || desc.VertexShader.Size == 0)
+		{
+			Report( "CreatePipeline: no vertex shader" );
+		}
+		if (desc.RenderTargetCount > MaxRenderTargets || desc.ConstantBufferCount > MaxConstantBuffers)
+		{
+			Report( "CreatePipeline: too many render targets or constant buffers" );
+		}
+		if (!desc.InputLayout.empty() && desc.VertexStride == 0)
+		{
+			Report( "CreatePipeline: input layout without a vertex stride" );
+		}
+		for (const VertexAttribute& attribute : desc.InputLayout)
+		{
+			if (attribute.Semantic == nullptr || attribute.Offset + GetFormatSize( attribute.Format ) > desc.VertexStride)
+			{
+				Report( "CreatePipeline: vertex attribute without a semantic or past the vertex stride" );
+			}
+		}
+		return std::make_unique<NullPipeline>( *this, desc );
+	}
+
+	std::unique_ptr<Fence> NullDevice::CreateFence( uint64_t initialValue )
+	{
+		return std::make_unique<NullFence>( *this, initialValue );
+	}
+
+	std::unique_ptr<CommandList> NullDevice::CreateCommandList( QueueType type )
+	{
+		return std::make_unique<NullCommandList>( *this, type );
+	}
+
+	std::unique_ptr<SwapChain> NullDevice::CreateSwapChain( const SwapChainDesc& desc )
+	{
+		if (desc.BufferCount < 2)
+		{
+			Report( "CreateSwapChain: at least two buffers" );
+		}
+		return std::make_unique<NullSwapChain>( *this, desc );
+	}
+
+	ResourceAllocationInfo NullDevice::GetTextureAllocationInfo( const TextureDesc& desc )
+	{
+		// D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT.
+		constexpr uint64_t page = 64 * 1024;
+		uint64_t size = 0;
+		for (uint32_t mip = 0; mip < desc.MipLevels; ++mip)
+		{
+			size += static_cast<uint64_t>(std::max( 1u, desc.Width >> mip )) * std::max( 1u, desc.Height >> mip ) *
+				GetFormatSize( desc.Format );
+		}
+		return { std::max( page, (size + page - 1) / page * page ), page };
+	}
+
+	ResourceAllocationInfo NullDevice::GetBufferAllocationInfo( const BufferDesc& desc )
+	{
+		constexpr uint64_t page = 64 * 1024;
+		return { std::max( page, (desc.Size + page - 1) / page * page ), page };
+	}
+
+	std::unique_ptr<Heap> NullDevice::CreateHeap( const HeapDesc& desc )
+	{
+		if (desc.Size == 0)
+		{
+			Report( "CreateHeap: empty heap" );
+		}
+		if (desc.Memory != MemoryType::Default && desc.Contents != HeapContents::Buffers)
+		{
+			Report( "CreateHeap: Upload and Readback heaps only hold buffers" );
+		}
+		return std::make_unique<NullHeap>( *this, desc );
+	}
+
+	std::unique_ptr<Texture> NullDevice::CreatePlacedTexture( const TextureDesc& desc, Heap& heap, uint64_t offset )
+	{
+		NullHeap* nullHeap = dynamic_cast<NullHeap*>(&heap);
+		if (nullHeap == nullptr || &nullHeap->GetDevice() != this)
+		{
+			Report( "CreatePlacedTexture: heap not made by this device" );
+			return CreateTexture( desc );
+		}
+		CheckTextureDesc( desc, "CreatePlacedTexture" );
+		const ResourceAllocationInfo info = GetTextureAllocationInfo( desc );
+		const HeapDesc& heapDesc = heap.GetDesc();
+		if (heapDesc.Memory != MemoryType::Default || heapDesc.Contents != GetHeapContents( desc.Usage ))
+		{
+			Report( "CreatePlacedTexture: heap #" + std::to_string( nullHeap->GetId() ) + " can not hold this kind of texture" );
+		}
+		if (offset % info.Alignment != 0 || offset + info.Size > heapDesc.Size)
+		{
+			Report( "CreatePlacedTexture: " + std::to_string( info.Size ) + " bytes at " + std::to_string( offset ) +
+				" are misaligned or past the end of heap #" + std::to_string( nullHeap->GetId() ) );
+		}
+		return std::make_unique<NullTexture>( *this, desc, *nullHeap, offset, info.Size );
+	}
+
+	std::unique_ptr<Buffer> NullDevice::CreatePlacedBuffer( const BufferDesc& desc, Heap& heap, uint64_t offset )
+	{
+		NullHeap* nullHeap = dynamic_cast<NullHeap*>(&heap);
+		if (nullHeap == nullptr || &nullHeap->GetDevice() != this)
+		{
+			Report( "CreatePlacedBuffer: heap not made by this device" );
+			return CreateBuffer( desc );
+		}
+		if (desc.Size == 0)
+		{
+			Report( "CreatePlacedBuffer: empty buffer" );
+		}
+		const ResourceAllocationInfo info = GetBufferAllocationInfo( desc );
+		const HeapDesc& heapDesc = heap.GetDesc();
+		if (heapDesc.Memory != desc.Memory || heapDesc.Contents != HeapContents::Buffers)
+		{
+			Report( "CreatePlacedBuffer: heap #" + std::to_string( nullHeap->GetId() ) + " can not hold this kind of buffer" );
+		}
+		if (offset % info.Alignment != 0 || offset + info.Size > heapDesc.Size)
+		{
+			Report( "CreatePlacedBuffer: " + std::to_string( info.Size ) + " bytes at " + std::to_string( offset ) +
+				" are misaligned or past the end of heap #" + std::to_string( nullHeap->GetId() ) );
+		}
+		return std::make_unique<NullBuffer>( *this, desc, *nullHeap, offset, info.Size );
+	}
+
+	MemoryBudget NullDevice::GetMemoryBudget()
+	{
+		std::lock_guard<std::mutex> lock( _Mutex );
+		return { _Desc.LocalMemoryBudget, _LocalHeapBytes, _Desc.NonLocalMemoryBudget, _NonLocalHeapBytes };
+	}
+
+	void NullDevice::BeginFrame()
+	{
+		_Descriptors.BeginFrame( _Descriptors.GetFrame() );
+	}
+
+	uint32_t NullDevice::AllocateFrameTable( Texture* const* textures, uint32_t count )
+	{
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const NullTexture* texture = dynamic_cast<const NullTexture*>(textures[i]);
+			if (texture == nullptr || &texture->GetDevice() != this)
+			{
+				Report( "AllocateFrameTable: texture " + std::to_string( i ) + " not made by this device" );
+			}
+			else if (texture->GetShaderResourceIndex() == UINT32_MAX)
+			{
+				Report( "AllocateFrameTable: " + texture->GetLabel() + " was not created for shader resource usage" );
+			}
+		}
+		return _Descriptors.AllocateFrame( count ).Index;
+	}
+
+	DescriptorAllocatorStats NullDevice::GetDescriptorStats() const
+	{
+		return _Descriptors.GetStats();
+	}
+
+	void NullDevice::WaitIdle()
+	{
+	}
+
+	NullDeviceStats NullDevice::GetStats() const
+	{
+		std::lock_guard<std::mutex> lock( _Mutex );
+		return _Stats;
+	}
+
+	void NullDevice::ResetStats()
+	{
+		std::lock_guard<std::mutex> lock( _Mutex );
+		_Stats = {};
+	}
+
+	std::vector<std::string> NullDevice::GetErrors() const
+	{
+		std::lock_guard<std::mutex> lock( _Mutex );
+		return _Errors;
+	}
+
+	void NullDevice::ClearErrors()
+	{
+		std::lock_guard<std::mutex> lock( _Mutex );
+		_Errors.clear();
+	}
+
+	std::vector<NullSubmission> NullDevice::GetSubmissions() const
+	{
+		std::lock_guard<std::mutex> lock( _Mutex );
+		return _Submissions;
+	}
+
+	void NullDevice::ClearSubmissions()
+	{
+		std::lock_guard<std::mutex> lock( _Mutex );
+		_Submissions.clear();
+	}
+
+	uint32_t NullDevice::GetId( const Resource& resource ) noexcept
+	{
+		const NullObject* object = dynamic_cast<const NullObject*>(&resource);
+		return object != nullptr ? object->GetId() : 0;
+	}
+
+	uint32_t NullDevice::GetId( const Pipeline& pipeline ) noexcept
+	{
+		const NullObject* object = dynamic_cast<const NullObject*>(&pipeline);
+		return object != nullptr ? object->GetId() : 0;
+	}
+
+	std::string NullDevice::Describe( const RecordedCommand& command )
+	{
+		std::ostringstream oss;
+		const uint64_t* arguments = command.Arguments;
+		const float* values = command.Values;
+		auto object = [&]( uint32_t index )
+		{
+			return "#" + std::to_string( command.Objects[index] );
+		};
+		switch (command.Type)
+		{
+		case CommandType::Barrier:
+			oss << "Barrier " << object( 0 );
+			if (arguments[2] == static_cast<uint64_t>(BarrierType::Aliasing))
+			{
+				oss << " aliasing";
+			}
+			else if (arguments[2] == static_cast<uint64_t>(BarrierType::UnorderedAccess))
+			{
+				oss << " unordered access";
+			}
+			else
+			{
+				oss << " " << GetStateName( static_cast<ResourceState>(arguments[0]) )
+					<< " -> " << GetStateName( static_cast<ResourceState>(arguments[1]) );
+			}
+			break;
+		case CommandType::ClearRenderTarget:
+			oss << "ClearRenderTarget " << object( 0 ) << " (" << values[0] << ", " << values[1] << ", "
+				<< values[2] << ", " << values[3] << ")";
+			break;
+		case CommandType::ClearDepth:
+			oss << "ClearDepth " << object( 0 ) << " " << values[0];
+			break;
+		case CommandType::SetRenderTargets:
+			oss << "SetRenderTargets";
+			for (uint32_t i = 0; i < arguments[0]; ++i)
+			{
+				oss << " " << object( i );
+			}
+			if (command.Objects[MaxRenderTargets] != 0)
+			{
+				oss << " depth " << object( MaxRenderTargets );
+			}
+			break;
+		case CommandType::SetViewport:
+			oss << "SetViewport " << values[0] << " " << values[1] << " " << values[2] << "x" << values[3];
+			break;
+		case CommandType::SetScissor:
+			oss << "SetScissor " << values[0] << " " << values[1] << " " << values[2] << " " << values[3];
+			break;
+		case CommandType::SetPipeline:
+			oss << "SetPipeline " << object( 0 );
+			break;
+		case CommandType::SetVertexBuffer:
+			oss << "SetVertexBuffer " << arguments[0] << " " << object( 0 ) << " +" << arguments[1];
+			break;
+		case CommandType::SetIndexBuffer:
+			oss << "SetIndexBuffer " << object( 0 ) << " +" << arguments[0]
+				<< (arguments[1] == static_cast<uint64_t>(IndexFormat::UInt16) ? " UInt16" : " UInt32");
+			break;
+		case CommandType::SetConstantBuffer:
+			oss << "SetConstantBuffer " << arguments[0] << " " << object( 0 ) << " +" << arguments[1];
+			break;
+		case CommandType::Draw:
+			oss << "Draw " << arguments[0] << " vertices x" << arguments[1] << " from " << arguments[2];
+			break;
+		case CommandType::DrawIndexed:
+			oss << "DrawIndexed " << arguments[0] << " indices x" << arguments[1] << " from " << arguments[2]
+				<< " base " << static_cast<int64_t>(arguments[3]);
+			break;
+		case CommandType::CopyBuffer:
+			oss << "CopyBuffer " << object( 0 ) << " +" << arguments[0] << " <- " << object( 1 ) << " +"
+				<< arguments[1] << " " << arguments[2] << " bytes";
+			break;
+		case CommandType::CopyBufferToTexture:
+			oss << "CopyBufferToTexture " << object( 0 ) << " <- " << object( 1 ) << " +" << arguments[0]
+				<< " pitch " << arguments[1];
+			break;
+		case CommandType::DrawUI:
+			oss << "DrawUI " << arguments[0] << " lists " << arguments[2] << " indices";
+			break;
+		case CommandType::BeginEvent:
+			oss << "BeginEvent " << (command.Name != nullptr ? command.Name : "");
+			break;
+		case CommandType::EndEvent:
+			oss << "EndEvent";
+			break;
+		}
+		return oss.str();
+	}
+
+	uint32_t NullDevice::Register( NullObject* object )
+	{
+		std::lock_guard<std::mutex> lock( _Mutex );
+		const uint32_t id = _NextId++;
+		_Alive.emplace( id, object );
+		return id;
+	}
+
+	void NullDevice::Unregister( uint32_t id )
+	{
+		std::lock_guard<std::mutex> lock( _Mutex );
+		_Alive.erase( id );
+	}
+
+	const char* NullDevice::Intern( const char* name )
+	{
+		std::lock_guard<std::mutex> lock( _Mutex );
+		return _Names.emplace( name ).first->c_str();
+	}
+
+	void NullDevice::Report( std::string message )
+	{
+		std::lock_guard<std::mutex> lock( _Mutex );
+		ReportLocked( std::move( message ) );
+	}
+
+	void NullDevice::CheckTextureDesc( const TextureDesc& desc, const char* call )
+	{
+		if (desc.Width == 0 || desc.Height == 0 || desc.MipLevels == 0 || desc.Format == PixelFormat::Unknown)
+		{
+			Report( std::string( call ) + ": empty size or unknown format" );
+		}
+		if (HasFlags( desc.Usage, TextureUsage::DepthStencil ) != IsDepthFormat( desc.Format ))
+		{
+			Report( std::string( call ) + ": depth stencil usage needs a depth format and the other way around" );
+		}
+	}
+
+	void NullDevice::ReportLocked( std::string message )
+	{
+		++_Stats.ValidationErrors;
+		_Errors.push_back( message );
+		if (_Desc.ThrowOnError)
+		{
+			throw CHWND_RHI_EXCEPT( std::move( message ) );
+		}
+	}
+}
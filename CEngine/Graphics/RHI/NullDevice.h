@@ -0,0 +1,190 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+#include "RHI.h"
+#include <unordered_map>
+#include <unordered_set>
+
+namespace CronoEngine::Graphics::RHI
+{
+	class NullObject;
+
+	enum class CommandType : uint8_t
+	{
+		Barrier,
+		ClearRenderTarget,
+		ClearDepth,
+		SetRenderTargets,
+		SetViewport,
+		SetScissor,
+		SetPipeline,
+		SetVertexBuffer,
+		SetIndexBuffer,
+		SetConstantBuffer,
+		Draw,
+		DrawIndexed,
+		CopyBuffer,
+		CopyBufferToTexture,
+		DrawUI,
+		BeginEvent,
+		EndEvent
+	};
+
+	/**
+	 * One recorded call. Objects are NullDevice ids (0 for none), what Arguments and Values
+	 * hold depends on the type, Describe spells it out.
+	 */
+	struct RecordedCommand
+	{
+		CommandType Type;
+		// SetRenderTargets keeps the depth target in the last one.
+		uint32_t Objects[MaxRenderTargets + 1] = {};
+		uint64_t Arguments[5] = {};
+		float Values[6] = {};
+		// BeginEvent only, owned by the device.
+		const char* Name = nullptr;
+	};
+
+	// Lists submitted to a NullDevice queue, kept when NullDeviceDesc::RecordSubmissions is set.
+	struct NullSubmission
+	{
+		QueueType Queue;
+		uint64_t Index;
+		std::vector<RecordedCommand> Commands;
+	};
+
+	struct NullDeviceDesc
+	{
+		// Throw an RhiException on the first misuse, otherwise only collect the message.
+		bool ThrowOnError = true;
+		// Copy every submitted list into GetSubmissions (render tests); off for benchmarks.
+		bool RecordSubmissions = false;
+		// What GetMemoryBudget reports, usage is the size of the live heaps.
+		uint64_t LocalMemoryBudget = 4ull * 1024 * 1024 * 1024;
+		uint64_t NonLocalMemoryBudget = 8ull * 1024 * 1024 * 1024;
+	};
+
+	// Totals over everything submitted.
+	struct NullDeviceStats
+	{
+		uint64_t SubmittedLists = 0;
+		uint64_t Commands = 0;
+		uint64_t Barriers = 0;
+		uint64_t AliasingBarriers = 0;
+		uint64_t Clears = 0;
+		uint64_t Draws = 0;
+		uint64_t Primitives = 0;
+		uint64_t StateChanges = 0;
+		uint64_t Copies = 0;
+		uint64_t CopiedBytes = 0;
+		uint64_t UIDraws = 0;
+		uint64_t Presents = 0;
+		uint64_t ValidationErrors = 0;
+	};
+
+	/**
+	 * Device without a GPU. Work "runs" the moment it is submitted: fences signal right away
+	 * and copies between mapped buffers really happen, so readback works in tests. Everything
+	 * else is checked against what D3D12's debug layer would complain about (list states,
+	 * resource usage flags and states, bound pipeline and targets, ranges, alignment, objects
+	 * destroyed while still referenced, placed textures used while another one holds their
+	 * memory) and counted, so the CPU side of rendering can be tested and timed anywhere.
+	 *
+	 * States are tracked the way the GPU sees them: while recording a list only knows the
+	 * state it left each resource in; the state a resource must be in when the list starts is
+	 * checked against the real one at Submit.
+	 */
+	class NullDevice : public Device
+	{
+	public:
+		NullDevice( const NullDeviceDesc& desc = {} );
+		~NullDevice();
+		NullDevice( const NullDevice& ) = delete;
+		NullDevice& operator=( const NullDevice& ) = delete;
+
+		const char* GetName() const noexcept override;
+		Queue& GetQueue( QueueType type ) override;
+		std::unique_ptr<Buffer> CreateBuffer( const BufferDesc& desc ) override;
+		std::unique_ptr<Texture> CreateTexture( const TextureDesc& desc ) override;
+		std::unique_ptr<Pipeline> CreatePipeline( const PipelineDesc& desc ) override;
+		std::unique_ptr<Fence> CreateFence( uint64_t initialValue = 0 ) override;
+		std::unique_ptr<CommandList> CreateCommandList( QueueType type ) override;
+		std::unique_ptr<SwapChain> CreateSwapChain( const SwapChainDesc& desc ) override;
+		// Every texture counted as mips of Width x Height x format size, in 64 KB pages.
+		ResourceAllocationInfo GetTextureAllocationInfo( const TextureDesc& desc ) override;
+		// Size in 64 KB pages.
+		ResourceAllocationInfo GetBufferAllocationInfo( const BufferDesc& desc ) override;
+		std::unique_ptr<Heap> CreateHeap( const HeapDesc& desc ) override;
+		std::unique_ptr<Texture> CreatePlacedTexture( const TextureDesc& desc, Heap& heap, uint64_t offset ) override;
+		std::unique_ptr<Buffer> CreatePlacedBuffer( const BufferDesc& desc, Heap& heap, uint64_t offset ) override;
+		MemoryBudget GetMemoryBudget() override;
+		// Submitted work is already done, so this frees what the frames before it held.
+		void BeginFrame() override;
+		uint32_t AllocateFrameTable( Texture* const* textures, uint32_t count ) override;
+		DescriptorAllocatorStats GetDescriptorStats() const override;
+		void WaitIdle() override;
+
+		NullDeviceStats GetStats() const;
+		void ResetStats();
+		std::vector<std::string> GetErrors() const;
+		void ClearErrors();
+		std::vector<NullSubmission> GetSubmissions() const;
+		void ClearSubmissions();
+		// Id of an object made by this device (0 for anything else), as found in RecordedCommand::Objects.
+		static uint32_t GetId( const Resource& resource ) noexcept;
+		static uint32_t GetId( const Pipeline& pipeline ) noexcept;
+		// One line, "Barrier #3 RenderTarget -> Present".
+		static std::string Describe( const RecordedCommand& command );
+	private:
+		friend class NullCommandList;
+		friend class NullQueue;
+		friend class NullSwapChain;
+		friend class NullFence;
+		friend class NullObject;
+		friend class NullHeap;
+		friend class NullTexture;
+
+		uint32_t Register( NullObject* object );
+		void Unregister( uint32_t id );
+		// Copy of name that lives as long as the device.
+		const char* Intern( const char* name );
+		void Report( std::string message );
+		// With _Mutex held.
+		void ReportLocked( std::string message );
+		void CheckTextureDesc( const TextureDesc& desc, const char* call );
+	private:
+		NullDeviceDesc _Desc;
+		mutable std::mutex _Mutex;
+		uint32_t _NextId = 1;
+		// Objects not yet destroyed by id.
+		std::unordered_map<uint32_t, NullObject*> _Alive;
+		std::unordered_set<std::string> _Names;
+		uint64_t _NextSubmission = 0;
+		NullDeviceStats _Stats;
+		// Bytes of live heaps, for GetMemoryBudget.
+		uint64_t _LocalHeapBytes = 0;
+		uint64_t _NonLocalHeapBytes = 0;
+		std::vector<std::string> _Errors;
+		std::vector<NullSubmission> _Submissions;
+		std::unique_ptr<Queue> _Queues[static_cast<size_t>(QueueType::Count)];
+		// Same layout as the DX12 heap, so indices match between backends.
+		DescriptorAllocator _Descriptors;
+	};
+}
@@ -0,0 +1,109 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "RHI.h"
+
+namespace CronoEngine::Graphics::RHI
+{
+	uint32_t GetFormatSize( PixelFormat format ) noexcept
+	{
+		switch (format)
+		{
+		case PixelFormat::R8G8B8A8_UNorm:
+		case PixelFormat::B8G8R8A8_UNorm:
+		case PixelFormat::R32_Float:
+		case PixelFormat::R32_UInt:
+		case PixelFormat::D32_Float:
+		case PixelFormat::D24_UNorm_S8_UInt:
+			return 4;
+		case PixelFormat::R16G16B16A16_Float:
+		case PixelFormat::R32G32_Float:
+			return 8;
+		case PixelFormat::R32G32B32_Float:
+			return 12;
+		case PixelFormat::R32G32B32A32_Float:
+			return 16;
+		case PixelFormat::R16_UInt:
+			return 2;
+		default:
+			return 0;
+		}
+	}
+
+	bool IsDepthFormat( PixelFormat format ) noexcept
+	{
+		return format == PixelFormat::D32_Float || format == PixelFormat::D24_UNorm_S8_UInt;
+	}
+
+	HeapContents GetHeapContents( TextureUsage usage ) noexcept
+	{
+		return (usage & (TextureUsage::RenderTarget | TextureUsage::DepthStencil)) != TextureUsage::None ?
+			HeapContents::RenderTargets : HeapContents::Textures;
+	}
+
+	bool IsReadOnlyState( ResourceState state ) noexcept
+	{
+		constexpr ResourceState writes = ResourceState::RenderTarget | ResourceState::UnorderedAccess |
+			ResourceState::DepthWrite | ResourceState::CopyDest;
+		return state != ResourceState::Common && (state & writes) == ResourceState::Common;
+	}
+
+	std::string GetStateName( ResourceState state )
+	{
+		if (state == ResourceState::Common)
+		{
+			return "Common";
+		}
+		if (state == ResourceState::GenericRead)
+		{
+			return "GenericRead";
+		}
+		static constexpr struct
+		{
+			ResourceState State;
+			const char* Name;
+		} names[] = {
+			{ ResourceState::ShaderResource, "ShaderResource" },
+			{ ResourceState::VertexBuffer, "VertexBuffer" },
+			{ ResourceState::IndexBuffer, "IndexBuffer" },
+			{ ResourceState::RenderTarget, "RenderTarget" },
+			{ ResourceState::UnorderedAccess, "UnorderedAccess" },
+			{ ResourceState::DepthWrite, "DepthWrite" },
+			{ ResourceState::DepthRead, "DepthRead" },
+			{ ResourceState::NonPixelShaderResource, "NonPixelShaderResource" },
+			{ ResourceState::PixelShaderResource, "PixelShaderResource" },
+			{ ResourceState::IndirectArgument, "IndirectArgument" },
+			{ ResourceState::CopyDest, "CopyDest" },
+			{ ResourceState::CopySource, "CopySource" },
+		};
+		std::string name;
+		uint32_t left = static_cast<uint32_t>(state);
+		for (const auto& entry : names)
+		{
+			const uint32_t bits = static_cast<uint32_t>(entry.State);
+			if ((left & bits) == bits)
+			{
+				left &= ~bits;
+				name += name.empty() ? "" : "|";
+				name += entry.Name;
+			}
+		}
+		return name;
+	}
+}
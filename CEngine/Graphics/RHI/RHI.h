@@ -0,0 +1,481 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+#include "Common/CommonHeaders.h"
+#include "DescriptorAllocator.h"
+
+struct ImDrawData;
+
+/**
+ * Render hardware interface: what the renderer needs from a graphics API, without naming one.
+ * DX12Device drives a D3D12 device, NullDevice checks the calls and records them so rendering
+ * code can run (and be timed) on machines without a GPU.
+ *
+ * Objects are created by the Device and must be destroyed before it. Command lists are recorded
+ * by one thread at a time, queues and devices may be used from any thread. Resource states
+ * follow D3D12: every transition is an explicit Barrier and the before state must be the
+ * state the resource is really in when the list runs.
+ */
+namespace CronoEngine::Graphics::RHI
+{
+	static constexpr uint32_t MaxRenderTargets = 8;
+	static constexpr uint32_t MaxVertexBuffers = 4;
+	static constexpr uint32_t MaxConstantBuffers = 8;
+	// Alignment of constant buffer offsets and texture upload rows.
+	static constexpr uint32_t ConstantBufferAlignment = 256;
+	static constexpr uint32_t TextureRowAlignment = 256;
+	// Shader resource slots: one per texture that has a view, then the ring for frame tables.
+	static constexpr uint32_t PersistentDescriptors = 65536;
+	static constexpr uint32_t FrameDescriptors = 16384;
+
+#define CRONO_RHI_FLAGS( Type ) \
+	constexpr Type operator|( Type a, Type b ) noexcept { return static_cast<Type>(static_cast<uint32_t>(a) | static_cast<uint32_t>(b)); } \
+	constexpr Type operator&( Type a, Type b ) noexcept { return static_cast<Type>(static_cast<uint32_t>(a) & static_cast<uint32_t>(b)); } \
+	constexpr bool HasFlags( Type value, Type flags ) noexcept { return (value & flags) == flags; }
+
+	enum class QueueType : uint8_t
+	{
+		Graphics,
+		Compute,
+		Copy,
+		Count
+	};
+
+	enum class PixelFormat : uint8_t
+	{
+		Unknown,
+		R8G8B8A8_UNorm,
+		B8G8R8A8_UNorm,
+		R16G16B16A16_Float,
+		R32G32B32A32_Float,
+		R32G32B32_Float,
+		R32G32_Float,
+		R32_Float,
+		R32_UInt,
+		R16_UInt,
+		D32_Float,
+		D24_UNorm_S8_UInt
+	};
+
+	enum class IndexFormat : uint8_t
+	{
+		UInt16,
+		UInt32
+	};
+
+	enum class MemoryType : uint8_t
+	{
+		// GPU only.
+		Default,
+		// CPU writes, GPU reads. Stays mapped and in the GenericRead state.
+		Upload,
+		// GPU writes, CPU reads. Stays mapped and in the CopyDest state.
+		Readback
+	};
+
+	enum class BufferUsage : uint32_t
+	{
+		None = 0,
+		Vertex = 1 << 0,
+		Index = 1 << 1,
+		Constant = 1 << 2,
+		ShaderResource = 1 << 3,
+		UnorderedAccess = 1 << 4,
+		Indirect = 1 << 5
+	};
+	CRONO_RHI_FLAGS( BufferUsage )
+
+	enum class TextureUsage : uint32_t
+	{
+		None = 0,
+		ShaderResource = 1 << 0,
+		RenderTarget = 1 << 1,
+		DepthStencil = 1 << 2,
+		UnorderedAccess = 1 << 3
+	};
+	CRONO_RHI_FLAGS( TextureUsage )
+
+	// Same bits as D3D12_RESOURCE_STATES for the states used here.
+	enum class ResourceState : uint32_t
+	{
+		Common = 0,
+		// Swap chain back buffers when handed back for presenting.
+		Present = 0,
+		VertexBuffer = 0x1,
+		ConstantBuffer = 0x1,
+		IndexBuffer = 0x2,
+		RenderTarget = 0x4,
+		UnorderedAccess = 0x8,
+		DepthWrite = 0x10,
+		DepthRead = 0x20,
+		NonPixelShaderResource = 0x40,
+		PixelShaderResource = 0x80,
+		IndirectArgument = 0x200,
+		CopyDest = 0x400,
+		CopySource = 0x800,
+		ShaderResource = NonPixelShaderResource | PixelShaderResource,
+		// What Upload buffers are always in.
+		GenericRead = VertexBuffer | IndexBuffer | ShaderResource | IndirectArgument | CopySource
+	};
+	CRONO_RHI_FLAGS( ResourceState )
+
+	// What a heap may hold, D3D12 resource heap tier 1 keeps these apart.
+	enum class HeapContents : uint8_t
+	{
+		Buffers,
+		// Textures without render target or depth stencil usage.
+		Textures,
+		// Render targets and depth stencils.
+		RenderTargets
+	};
+
+	// Bytes per pixel, 0 for Unknown.
+	uint32_t GetFormatSize( PixelFormat format ) noexcept;
+	bool IsDepthFormat( PixelFormat format ) noexcept;
+	// The heap a texture with usage may be placed in.
+	HeapContents GetHeapContents( TextureUsage usage ) noexcept;
+	// Only read bits, so other read states may be combined with it.
+	bool IsReadOnlyState( ResourceState state ) noexcept;
+	// "RenderTarget", "CopySource|CopyDest", ...
+	std::string GetStateName( ResourceState state );
+
+	struct BufferDesc
+	{
+		uint64_t Size = 0;
+		BufferUsage Usage = BufferUsage::None;
+		MemoryType Memory = MemoryType::Default;
+		std::string DebugName;
+	};
+
+	struct TextureDesc
+	{
+		uint32_t Width = 1;
+		uint32_t Height = 1;
+		uint16_t MipLevels = 1;
+		PixelFormat Format = PixelFormat::R8G8B8A8_UNorm;
+		TextureUsage Usage = TextureUsage::ShaderResource;
+		ResourceState InitialState = ResourceState::Common;
+		// Clear color for render targets, depth in [0] for depth stencils.
+		float ClearValue[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		std::string DebugName;
+	};
+
+	struct HeapDesc
+	{
+		uint64_t Size = 0;
+		MemoryType Memory = MemoryType::Default;
+		HeapContents Contents = HeapContents::RenderTargets;
+		std::string DebugName;
+	};
+
+	// Bytes and alignment a resource takes when placed in a heap.
+	struct ResourceAllocationInfo
+	{
+		uint64_t Size = 0;
+		uint64_t Alignment = 0;
+	};
+
+	// What the OS lets the process use before it starts paging, and what it uses now.
+	struct MemoryBudget
+	{
+		// Video memory, where Default heaps live on discrete GPUs.
+		uint64_t LocalBudget = 0;
+		uint64_t LocalUsage = 0;
+		// System memory the GPU reads, Upload and Readback heaps.
+		uint64_t NonLocalBudget = 0;
+		uint64_t NonLocalUsage = 0;
+	};
+
+	struct ShaderBytecode
+	{
+		const void* Data = nullptr;
+		size_t Size = 0;
+	};
+
+	struct VertexAttribute
+	{
+		// Points at a string that outlives the CreatePipeline call.
+		const char* Semantic = nullptr;
+		uint32_t SemanticIndex = 0;
+		PixelFormat Format = PixelFormat::R32G32B32_Float;
+		uint32_t Offset = 0;
+	};
+
+	enum class CullMode : uint8_t
+	{
+		None,
+		Front,
+		Back
+	};
+
+	enum class PrimitiveTopology : uint8_t
+	{
+		TriangleList,
+		TriangleStrip,
+		LineList,
+		PointList
+	};
+
+	struct PipelineDesc
+	{
+		ShaderBytecode VertexShader;
+		ShaderBytecode PixelShader;
+		// Read from vertex buffer slot 0.
+		std::vector<VertexAttribute> InputLayout;
+		uint32_t VertexStride = 0;
+		PixelFormat RenderTargetFormats[MaxRenderTargets] = {};
+		uint32_t RenderTargetCount = 0;
+		PixelFormat DepthFormat = PixelFormat::Unknown;
+		bool DepthTest = false;
+		bool DepthWrite = false;
+		bool AlphaBlend = false;
+		CullMode Cull = CullMode::Back;
+		PrimitiveTopology Topology = PrimitiveTopology::TriangleList;
+		// Constant buffers b0 .. b(ConstantBufferCount - 1), bound with SetConstantBuffer.
+		uint32_t ConstantBufferCount = 0;
+		// Every bindless slot as Texture2D Textures[] : register(t0, space1), with a linear wrap
+		// SamplerState at register(s0, space1). Indices come from GetShaderResourceIndex and AllocateFrameTable.
+		bool BindlessTextures = false;
+		std::string DebugName;
+	};
+
+	struct Viewport
+	{
+		float X = 0.0f;
+		float Y = 0.0f;
+		float Width = 0.0f;
+		float Height = 0.0f;
+		float MinDepth = 0.0f;
+		float MaxDepth = 1.0f;
+	};
+
+	struct ScissorRect
+	{
+		int32_t Left = 0;
+		int32_t Top = 0;
+		int32_t Right = 0;
+		int32_t Bottom = 0;
+	};
+
+	struct SwapChainDesc
+	{
+		// HWND on Windows, ignored by the null backend.
+		void* Window = nullptr;
+		uint32_t Width = 1;
+		uint32_t Height = 1;
+		uint32_t BufferCount = 3;
+		PixelFormat Format = PixelFormat::R8G8B8A8_UNorm;
+	};
+
+	class Resource
+	{
+	public:
+		virtual ~Resource() = default;
+		Resource( const Resource& ) = delete;
+		Resource& operator=( const Resource& ) = delete;
+	protected:
+		Resource() = default;
+	};
+
+	class Buffer : public Resource
+	{
+	public:
+		const BufferDesc& GetDesc() const noexcept { return _Desc; }
+		// Upload and Readback buffers only, valid for the life of the buffer.
+		virtual void* GetMappedData() noexcept = 0;
+	protected:
+		Buffer( const BufferDesc& desc ) : _Desc( desc ) {}
+		BufferDesc _Desc;
+	};
+
+	class Texture : public Resource
+	{
+	public:
+		const TextureDesc& GetDesc() const noexcept { return _Desc; }
+		// Slot of its view in the bindless table, UINT32_MAX without ShaderResource usage.
+		uint32_t GetShaderResourceIndex() const noexcept { return _ShaderResourceIndex; }
+	protected:
+		Texture( const TextureDesc& desc ) : _Desc( desc ) {}
+		TextureDesc _Desc;
+		uint32_t _ShaderResourceIndex = UINT32_MAX;
+	};
+
+	class Heap
+	{
+	public:
+		virtual ~Heap() = default;
+		Heap( const Heap& ) = delete;
+		Heap& operator=( const Heap& ) = delete;
+		const HeapDesc& GetDesc() const noexcept { return _Desc; }
+	protected:
+		Heap( const HeapDesc& desc ) : _Desc( desc ) {}
+		HeapDesc _Desc;
+	};
+
+	enum class BarrierType : uint8_t
+	{
+		Transition,
+		// Target takes over heap memory other placed resources used, Before and After are ignored.
+		Aliasing,
+		// Unordered access writes to Target finish before what comes next reads or writes it.
+		UnorderedAccess
+	};
+
+	struct ResourceBarrier
+	{
+		Resource* Target = nullptr;
+		ResourceState Before = ResourceState::Common;
+		ResourceState After = ResourceState::Common;
+		BarrierType Type = BarrierType::Transition;
+	};
+
+	class Pipeline
+	{
+	public:
+		virtual ~Pipeline() = default;
+		Pipeline( const Pipeline& ) = delete;
+		Pipeline& operator=( const Pipeline& ) = delete;
+		const PipelineDesc& GetDesc() const noexcept { return _Desc; }
+	protected:
+		Pipeline( const PipelineDesc& desc ) : _Desc( desc ) {}
+		PipelineDesc _Desc;
+	};
+
+	class Fence
+	{
+	public:
+		virtual ~Fence() = default;
+		virtual uint64_t GetCompletedValue() const = 0;
+		// Blocks the calling thread until the fence reaches value.
+		virtual void Wait( uint64_t value ) = 0;
+	};
+
+	class CommandList
+	{
+	public:
+		virtual ~CommandList() = default;
+		virtual QueueType GetType() const noexcept = 0;
+
+		// Starts recording over whatever was recorded before. The last submission must be done.
+		virtual void Begin() = 0;
+		// Closes the list so it can be submitted.
+		virtual void End() = 0;
+
+		virtual void Barrier( const ResourceBarrier* barriers, uint32_t count ) = 0;
+		void Barrier( Resource& target, ResourceState before, ResourceState after )
+		{
+			const ResourceBarrier barrier{ &target, before, after };
+			Barrier( &barrier, 1 );
+		}
+		virtual void ClearRenderTarget( Texture& target, const float color[4] ) = 0;
+		virtual void ClearDepth( Texture& target, float depth ) = 0;
+		virtual void SetRenderTargets( Texture* const* targets, uint32_t count, Texture* depth ) = 0;
+		virtual void SetViewport( const Viewport& viewport ) = 0;
+		virtual void SetScissor( const ScissorRect& scissor ) = 0;
+		virtual void SetPipeline( Pipeline& pipeline ) = 0;
+		virtual void SetVertexBuffer( uint32_t slot, Buffer& buffer, uint64_t offset ) = 0;
+		virtual void SetIndexBuffer( Buffer& buffer, uint64_t offset, IndexFormat format ) = 0;
+		// offset must be a multiple of ConstantBufferAlignment.
+		virtual void SetConstantBuffer( uint32_t slot, Buffer& buffer, uint64_t offset ) = 0;
+		virtual void Draw( uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance ) = 0;
+		virtual void DrawIndexed( uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex,
+			int32_t baseVertex, uint32_t firstInstance ) = 0;
+		virtual void CopyBuffer( Buffer& destination, uint64_t destinationOffset,
+			Buffer& source, uint64_t sourceOffset, uint64_t size ) = 0;
+		// Fills mip 0 from rows of rowPitch bytes (a multiple of TextureRowAlignment) starting at sourceOffset.
+		virtual void CopyBufferToTexture( Texture& destination, Buffer& source, uint64_t sourceOffset, uint32_t rowPitch ) = 0;
+		// Dear ImGui draw lists into the bound render target.
+		virtual void DrawUI( ImDrawData* drawData ) = 0;
+		// Debugger and capture tool markers, they must pair up within the list.
+		virtual void BeginEvent( const char* name ) = 0;
+		virtual void EndEvent() = 0;
+	};
+
+	class Queue
+	{
+	public:
+		virtual ~Queue() = default;
+		virtual QueueType GetType() const noexcept = 0;
+		// Runs the closed lists in order after everything submitted before.
+		virtual void Submit( CommandList* const* lists, uint32_t count ) = 0;
+		// Sets the fence to value once the work submitted so far is done.
+		virtual void Signal( Fence& fence, uint64_t value ) = 0;
+		// Holds later work on this queue until the fence reaches value, the CPU does not wait.
+		virtual void Wait( Fence& fence, uint64_t value ) = 0;
+		// Blocks until everything submitted so far is done.
+		virtual void WaitIdle() = 0;
+	};
+
+	class SwapChain
+	{
+	public:
+		virtual ~SwapChain() = default;
+		virtual const SwapChainDesc& GetDesc() const noexcept = 0;
+		// Back buffer the next frame renders to.
+		virtual uint32_t GetCurrentIndex() const = 0;
+		// In the Present state outside of the frame that renders to it.
+		virtual Texture& GetBackBuffer( uint32_t index ) = 0;
+		virtual void Present( bool vsync ) = 0;
+		// No back buffer may still be in use by the GPU.
+		virtual void Resize( uint32_t width, uint32_t height ) = 0;
+	};
+
+	class Device
+	{
+	public:
+		virtual ~Device() = default;
+		// "DX12", "Null".
+		virtual const char* GetName() const noexcept = 0;
+		virtual Queue& GetQueue( QueueType type ) = 0;
+		virtual std::unique_ptr<Buffer> CreateBuffer( const BufferDesc& desc ) = 0;
+		virtual std::unique_ptr<Texture> CreateTexture( const TextureDesc& desc ) = 0;
+		virtual std::unique_ptr<Pipeline> CreatePipeline( const PipelineDesc& desc ) = 0;
+		virtual std::unique_ptr<Fence> CreateFence( uint64_t initialValue = 0 ) = 0;
+		virtual std::unique_ptr<CommandList> CreateCommandList( QueueType type ) = 0;
+		virtual std::unique_ptr<SwapChain> CreateSwapChain( const SwapChainDesc& desc ) = 0;
+		virtual ResourceAllocationInfo GetTextureAllocationInfo( const TextureDesc& desc ) = 0;
+		virtual ResourceAllocationInfo GetBufferAllocationInfo( const BufferDesc& desc ) = 0;
+		virtual std::unique_ptr<Heap> CreateHeap( const HeapDesc& desc ) = 0;
+		/**
+		 * Texture in heap memory from offset, a multiple of its allocation alignment. Placed
+		 * textures with overlapping ranges alias: only the last one named by an Aliasing barrier
+		 * may be used, and its content is undefined until cleared or fully written. The heap must
+		 * outlive it.
+		 */
+		virtual std::unique_ptr<Texture> CreatePlacedTexture( const TextureDesc& desc, Heap& heap, uint64_t offset ) = 0;
+		// Buffer in a Buffers heap of the same memory type, from offset as for CreatePlacedTexture.
+		virtual std::unique_ptr<Buffer> CreatePlacedBuffer( const BufferDesc& desc, Heap& heap, uint64_t offset ) = 0;
+		virtual MemoryBudget GetMemoryBudget() = 0;
+		/**
+		 * Once per frame, before recording it. Slots of destroyed textures and frame tables are
+		 * reused when the graphics queue is done with everything submitted before the call
+		 * that ended their frame.
+		 */
+		virtual void BeginFrame() = 0;
+		/**
+		 * Copies the views of count textures with ShaderResource usage to consecutive bindless
+		 * slots that stay valid for this frame, and returns the first one.
+		 */
+		virtual uint32_t AllocateFrameTable( Texture* const* textures, uint32_t count ) = 0;
+		virtual DescriptorAllocatorStats GetDescriptorStats() const = 0;
+		// Every queue idle.
+		virtual void WaitIdle() = 0;
+	};
+}
@@ -0,0 +1,616 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "RenderGraph.h"
+#include <sstream>
+
+namespace CronoEngine::Graphics
+{
+	namespace
+	{
+		// Heaps grow in steps of this, so a frame a little bigger than the last does not recreate them.
+		constexpr uint64_t HeapGranularity = 4 * 1024 * 1024;
+
+		uint64_t AlignUp( uint64_t value, uint64_t alignment ) noexcept
+		{
+			return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+		}
+
+		bool IsSameTexture( const RHI::TextureDesc& a, const RHI::TextureDesc& b ) noexcept
+		{
+			return a.Width == b.Width && a.Height == b.Height && a.MipLevels == b.MipLevels && a.Format == b.Format &&
+				a.Usage == b.Usage && std::equal( a.ClearValue, a.ClearValue + 4, b.ClearValue );
+		}
+	}
+
+	RenderGraphBuilder::RenderGraphBuilder( RenderGraph& graph, uint32_t pass ) noexcept
+		: _Graph( graph ), _Pass( pass )
+	{
+	}
+
+	RenderGraphTexture RenderGraphBuilder::CreateTexture( const RHI::TextureDesc& desc )
+	{
+		RenderGraph::TextureEntry& entry = _Graph._Textures.emplace_back();
+		entry.Desc = desc;
+		entry.Contents = RHI::GetHeapContents( desc.Usage );
+		return { static_cast<uint32_t>(_Graph._Textures.size() - 1) };
+	}
+
+	void RenderGraphBuilder::Read( RenderGraphTexture texture, RHI::ResourceState state )
+	{
+		_Graph.AddAccess( _Pass, texture, state, false );
+	}
+
+	void RenderGraphBuilder::Write( RenderGraphTexture texture, RHI::ResourceState state )
+	{
+		_Graph.AddAccess( _Pass, texture, state, true );
+	}
+
+	void RenderGraphBuilder::SetSideEffects() noexcept
+	{
+		_Graph._Passes[_Pass].SideEffects = true;
+	}
+
+	RenderGraphContext::RenderGraphContext( RenderGraph& graph, RHI::CommandList& commands ) noexcept
+		: _Graph( graph ), _Commands( commands )
+	{
+	}
+
+	RHI::CommandList& RenderGraphContext::GetCommands() const noexcept
+	{
+		return _Commands;
+	}
+
+	RHI::Texture& RenderGraphContext::GetTexture( RenderGraphTexture texture ) const
+	{
+		const RenderGraph::TextureEntry& entry = _Graph.GetEntry( texture );
+		if (entry.Imported != nullptr)
+		{
+			return *entry.Imported;
+		}
+		if (entry.Placed == UINT32_MAX)
+		{
+			throw CHWND_RHI_EXCEPT( "RenderGraph: texture " + std::to_string( texture.Index ) + " is not used by a pass that was kept" );
+		}
+		return *_Graph._Placed[entry.Placed].Texture;
+	}
+
+	RenderGraph::RenderGraph( RHI::Device& device, uint32_t framesInFlight )
+		: _Device( device ), _FramesInFlight( framesInFlight )
+	{
+	}
+
+	RenderGraph::~RenderGraph() = default;
+
+	void RenderGraph::Reset()
+	{
+		_Passes.clear();
+		_Accesses.clear();
+		_Textures.clear();
+		_Barriers.clear();
+		_FinalBarrier = 0;
+		_Compiled = false;
+	}
+
+	RenderGraphTexture RenderGraph::ImportTexture( RHI::Texture& texture, RHI::ResourceState state, RHI::ResourceState finalState )
+	{
+		TextureEntry& entry = _Textures.emplace_back();
+		entry.Desc = texture.GetDesc();
+		entry.Imported = &texture;
+		entry.State = state;
+		entry.FinalState = finalState;
+		_Compiled = false;
+		return { static_cast<uint32_t>(_Textures.size() - 1) };
+	}
+
+	void RenderGraph::AddPass( std::string name, const SetupCallback& setup, ExecuteCallback execute )
+	{
+		Pass& pass = _Passes.emplace_back();
+		pass.Name = std::move( name );
+		pass.Execute = std::move( execute );
+		pass.FirstAccess = static_cast<uint32_t>(_Accesses.size());
+		RenderGraphBuilder builder( *this, static_cast<uint32_t>(_Passes.size() - 1) );
+		setup( builder );
+		_Compiled = false;
+	}
+
+	void RenderGraph::Compile()
+	{
+		_Stats = {};
+		_Stats.Passes = static_cast<uint32_t>(_Passes.size());
+		_Stats.Textures = static_cast<uint32_t>(_Textures.size());
+		for (TextureEntry& entry : _Textures)
+		{
+			entry.FirstPass = UINT32_MAX;
+			entry.LastPass = 0;
+			entry.Current = entry.State;
+			entry.Touched = false;
+			entry.UnorderedWrite = false;
+			entry.LastAccess = UINT32_MAX;
+			entry.Placed = UINT32_MAX;
+		}
+		Cull();
+		PlaceTransients();
+		PlanBarriers();
+		_Compiled = true;
+	}
+
+	void RenderGraph::Execute( RHI::CommandList& commands )
+	{
+		if (!_Compiled)
+		{
+			Compile();
+		}
+		// Everything retired framesInFlight frames ago is done with on the GPU.
+		ReleaseRetired();
+		PrepareHeaps();
+		_Stats.AliasingBarriers = 0;
+		_Stats.ExecutedTransitions = 0;
+
+		RenderGraphContext context( *this, commands );
+		for (const Pass& pass : _Passes)
+		{
+			if (pass.Culled)
+			{
+				continue;
+			}
+			RecordBarriers( commands, pass.FirstBarrier, pass.BarrierCount );
+			commands.BeginEvent( pass.Name.c_str() );
+			if (pass.Execute)
+			{
+				pass.Execute( context );
+			}
+			commands.EndEvent();
+		}
+		RecordBarriers( commands, _FinalBarrier, static_cast<uint32_t>(_Barriers.size()) - _FinalBarrier );
+
+		// Placed textures nothing used for a while go, the rest wait for the next frame.
+		for (size_t i = 0; i < _Placed.size();)
+		{
+			if (_Placed[i].LastUsedFrame + _FramesInFlight < _Frame)
+			{
+				_Retired.push_back( { _Frame, nullptr, {} } );
+				_Retired.back().Textures.push_back( std::move( _Placed[i].Texture ) );
+				_Placed[i] = std::move( _Placed.back() );
+				_Placed.pop_back();
+			}
+			else
+			{
+				++i;
+			}
+		}
+		++_Frame;
+	}
+
+	const RenderGraphStats& RenderGraph::GetStats() const noexcept
+	{
+		return _Stats;
+	}
+
+	bool RenderGraph::IsCulled( uint32_t pass ) const
+	{
+		if (pass >= _Passes.size())
+		{
+			throw CHWND_RHI_EXCEPT( "RenderGraph: no pass " + std::to_string( pass ) );
+		}
+		return _Passes[pass].Culled;
+	}
+
+	uint64_t RenderGraph::GetHeapOffset( RenderGraphTexture texture ) const
+	{
+		return GetEntry( texture ).Offset;
+	}
+
+	std::string RenderGraph::Describe() const
+	{
+		std::ostringstream oss;
+		auto name = [this]( uint32_t texture )
+		{
+			const std::string& debugName = _Textures[texture].Desc.DebugName;
+			return debugName.empty() ? "Texture " + std::to_string( texture ) : debugName;
+		};
+		auto barriers = [&]( uint32_t first, uint32_t count )
+		{
+			for (uint32_t i = first; i < first + count; ++i)
+			{
+				const Barrier& barrier = _Barriers[i];
+				oss << "  Barrier " << name( barrier.Texture );
+				if (barrier.Type == RHI::BarrierType::UnorderedAccess)
+				{
+					oss << " unordered access\n";
+					continue;
+				}
+				oss << " " << (barrier.FirstUse ? "?" : RHI::GetStateName( barrier.Before )) << " -> "
+					<< RHI::GetStateName( barrier.After ) << "\n";
+			}
+		};
+		for (const Pass& pass : _Passes)
+		{
+			oss << "Pass " << pass.Name << (pass.Culled ? " culled\n" : "\n");
+			if (!pass.Culled)
+			{
+				barriers( pass.FirstBarrier, pass.BarrierCount );
+			}
+		}
+		oss << "End\n";
+		barriers( _FinalBarrier, static_cast<uint32_t>(_Barriers.size()) - _FinalBarrier );
+		for (uint32_t i = 0; i < _Textures.size(); ++i)
+		{
+			const TextureEntry& entry = _Textures[i];
+			if (IsTransient( entry ) && entry.FirstPass != UINT32_MAX)
+			{
+				oss << name( i ) << " " << (entry.Contents == RHI::HeapContents::RenderTargets ? "RenderTargets" : "Textures")
+					<< " +" << entry.Offset << " " << entry.Size << " bytes, passes " << entry.FirstPass << "-" << entry.LastPass << "\n";
+			}
+		}
+		return oss.str();
+	}
+
+	RenderGraph::TextureEntry& RenderGraph::GetEntry( RenderGraphTexture texture )
+	{
+		if (texture.Index >= _Textures.size())
+		{
+			throw CHWND_RHI_EXCEPT( "RenderGraph: texture " + std::to_string( texture.Index ) + " does not exist" );
+		}
+		return _Textures[texture.Index];
+	}
+
+	const RenderGraph::TextureEntry& RenderGraph::GetEntry( RenderGraphTexture texture ) const
+	{
+		if (texture.Index >= _Textures.size())
+		{
+			throw CHWND_RHI_EXCEPT( "RenderGraph: texture " + std::to_string( texture.Index ) + " does not exist" );
+		}
+		return _Textures[texture.Index];
+	}
+
+	void RenderGraph::AddAccess( uint32_t pass, RenderGraphTexture texture, RHI::ResourceState state, bool writes )
+	{
+		GetEntry( texture );
+		Pass& owner = _Passes[pass];
+		// One access per texture and pass, so a pass sees the texture in a single state.
+		for (uint32_t i = owner.FirstAccess; i < owner.FirstAccess + owner.AccessCount; ++i)
+		{
+			Access& access = _Accesses[i];
+			if (access.Texture != texture.Index)
+			{
+				continue;
+			}
+			if (!writes && !access.Writes && RHI::IsReadOnlyState( state ) && RHI::IsReadOnlyState( access.State ))
+			{
+				access.State = access.State | state;
+			}
+			else if (access.State != state)
+			{
+				throw CHWND_RHI_EXCEPT( "RenderGraph: pass " + owner.Name + " uses texture " + std::to_string( texture.Index ) +
+					" as " + RHI::GetStateName( access.State ) + " and as " + RHI::GetStateName( state ) );
+			}
+			access.Reads = access.Reads || !writes;
+			access.Writes = access.Writes || writes;
+			return;
+		}
+		_Accesses.push_back( { texture.Index, state, !writes, writes } );
+		++owner.AccessCount;
+	}
+
+	void RenderGraph::Cull()
+	{
+		// Walking back from the end: a pass is kept when a kept pass after it (or the world
+		// outside the graph, for imported textures) reads something it writes.
+		_Needed.assign( _Textures.size(), 0 );
+		for (size_t i = 0; i < _Textures.size(); ++i)
+		{
+			_Needed[i] = _Textures[i].Imported != nullptr;
+		}
+		for (size_t i = _Passes.size(); i-- > 0;)
+		{
+			Pass& pass = _Passes[i];
+			const Access* accesses = _Accesses.data() + pass.FirstAccess;
+			bool kept = pass.SideEffects;
+			for (uint32_t a = 0; a < pass.AccessCount && !kept; ++a)
+			{
+				kept = accesses[a].Writes && _Needed[accesses[a].Texture];
+			}
+			pass.Culled = !kept;
+			if (!kept)
+			{
+				++_Stats.CulledPasses;
+				continue;
+			}
+			for (uint32_t a = 0; a < pass.AccessCount; ++a)
+			{
+				// A write without a read replaces what came before, a read needs it.
+				_Needed[accesses[a].Texture] = accesses[a].Reads;
+			}
+		}
+
+		_NextAccess.assign( _Accesses.size(), UINT32_MAX );
+		for (uint32_t i = 0; i < _Passes.size(); ++i)
+		{
+			const Pass& pass = _Passes[i];
+			if (pass.Culled)
+			{
+				continue;
+			}
+			for (uint32_t a = pass.FirstAccess; a < pass.FirstAccess + pass.AccessCount; ++a)
+			{
+				TextureEntry& entry = _Textures[_Accesses[a].Texture];
+				entry.FirstPass = std::min( entry.FirstPass, i );
+				entry.LastPass = i;
+				if (entry.LastAccess != UINT32_MAX)
+				{
+					_NextAccess[entry.LastAccess] = a;
+				}
+				entry.LastAccess = a;
+			}
+		}
+	}
+
+	void RenderGraph::PlaceTransients()
+	{
+		_Order.clear();
+		for (uint32_t i = 0; i < _Textures.size(); ++i)
+		{
+			TextureEntry& entry = _Textures[i];
+			if (IsTransient( entry ) && entry.FirstPass != UINT32_MAX)
+			{
+				const RHI::ResourceAllocationInfo info = _Device.GetTextureAllocationInfo( entry.Desc );
+				entry.Size = info.Size;
+				entry.Alignment = info.Alignment;
+				_Order.push_back( i );
+				_Stats.UnaliasedMemory += info.Size;
+			}
+		}
+		_Stats.TransientTextures = static_cast<uint32_t>(_Order.size());
+
+		// Biggest first, each at the lowest offset clear of everything placed before it that
+		// is alive at the same time. Transients with disjoint lifetimes end up sharing memory.
+		std::sort( _Order.begin(), _Order.end(), [this]( uint32_t a, uint32_t b )
+		{
+			const TextureEntry& first = _Textures[a];
+			const TextureEntry& second = _Textures[b];
+			return first.Size != second.Size ? first.Size > second.Size : first.FirstPass < second.FirstPass;
+		} );
+		for (TransientHeap& heap : _Heaps)
+		{
+			heap.Required = 0;
+		}
+		std::vector<const TextureEntry*> overlapping;
+		for (size_t i = 0; i < _Order.size(); ++i)
+		{
+			TextureEntry& entry = _Textures[_Order[i]];
+			overlapping.clear();
+			for (size_t j = 0; j < i; ++j)
+			{
+				const TextureEntry& placed = _Textures[_Order[j]];
+				if (placed.Contents == entry.Contents && placed.FirstPass <= entry.LastPass && entry.FirstPass <= placed.LastPass)
+				{
+					overlapping.push_back( &placed );
+				}
+			}
+			std::sort( overlapping.begin(), overlapping.end(),
+				[]( const TextureEntry* a, const TextureEntry* b ) { return a->Offset < b->Offset; } );
+			uint64_t offset = 0;
+			for (const TextureEntry* placed : overlapping)
+			{
+				if (offset + entry.Size <= placed->Offset)
+				{
+					break;
+				}
+				offset = std::max( offset, AlignUp( placed->Offset + placed->Size, entry.Alignment ) );
+			}
+			entry.Offset = offset;
+			uint64_t& required = _Heaps[static_cast<size_t>(entry.Contents)].Required;
+			required = std::max( required, offset + entry.Size );
+		}
+		for (const TransientHeap& heap : _Heaps)
+		{
+			_Stats.TransientMemory += heap.Required;
+		}
+	}
+
+	void RenderGraph::PlanBarriers()
+	{
+		_Barriers.clear();
+		for (uint32_t i = 0; i < _Passes.size(); ++i)
+		{
+			Pass& pass = _Passes[i];
+			pass.FirstBarrier = static_cast<uint32_t>(_Barriers.size());
+			pass.BarrierCount = 0;
+			if (pass.Culled)
+			{
+				continue;
+			}
+			for (uint32_t a = pass.FirstAccess; a < pass.FirstAccess + pass.AccessCount; ++a)
+			{
+				const Access& access = _Accesses[a];
+				TextureEntry& entry = _Textures[access.Texture];
+				const bool readOnly = !access.Writes && RHI::IsReadOnlyState( access.State );
+				RHI::ResourceState state = access.State;
+				if (readOnly)
+				{
+					// Later passes that only read it too get their states in the same transition.
+					for (uint32_t next = _NextAccess[a]; next != UINT32_MAX; next = _NextAccess[next])
+					{
+						const Access& found = _Accesses[next];
+						if (found.Writes || !RHI::IsReadOnlyState( found.State ))
+						{
+							break;
+						}
+						state = state | found.State;
+					}
+				}
+
+				if (IsTransient( entry ) && !entry.Touched)
+				{
+					_Barriers.push_back( { access.Texture, RHI::ResourceState::Common, state, RHI::BarrierType::Transition, true } );
+					++_Stats.Transitions;
+				}
+				else if (entry.Current == state || (readOnly && RHI::IsReadOnlyState( entry.Current ) && RHI::HasFlags( entry.Current, state )))
+				{
+					if (entry.UnorderedWrite && access.State == RHI::ResourceState::UnorderedAccess)
+					{
+						_Barriers.push_back( { access.Texture, state, state, RHI::BarrierType::UnorderedAccess, false } );
+						++_Stats.UnorderedAccessBarriers;
+					}
+					state = entry.Current;
+				}
+				else
+				{
+					_Barriers.push_back( { access.Texture, entry.Current, state, RHI::BarrierType::Transition, false } );
+					++_Stats.Transitions;
+				}
+				entry.Current = state;
+				entry.Touched = true;
+				entry.UnorderedWrite = access.Writes && state == RHI::ResourceState::UnorderedAccess;
+			}
+			pass.BarrierCount = static_cast<uint32_t>(_Barriers.size()) - pass.FirstBarrier;
+			_Stats.BarrierBatches += pass.BarrierCount != 0;
+		}
+
+		_FinalBarrier = static_cast<uint32_t>(_Barriers.size());
+		for (uint32_t i = 0; i < _Textures.size(); ++i)
+		{
+			const TextureEntry& entry = _Textures[i];
+			if (entry.Imported != nullptr && entry.Current != entry.FinalState)
+			{
+				_Barriers.push_back( { i, entry.Current, entry.FinalState, RHI::BarrierType::Transition, false } );
+				++_Stats.Transitions;
+			}
+		}
+		_Stats.BarrierBatches += _Barriers.size() != _FinalBarrier;
+	}
+
+	void RenderGraph::PrepareHeaps()
+	{
+		for (size_t contents = 0; contents < std::size( _Heaps ); ++contents)
+		{
+			TransientHeap& heap = _Heaps[contents];
+			if (heap.Required == 0 || (heap.Heap != nullptr && heap.Heap->GetDesc().Size >= heap.Required))
+			{
+				continue;
+			}
+			// Too small: it goes with everything placed in it, frames in flight may still use them.
+			Retired& retired = _Retired.emplace_back();
+			retired.Frame = _Frame;
+			retired.Heap = std::move( heap.Heap );
+			for (size_t i = 0; i < _Placed.size();)
+			{
+				if (static_cast<size_t>(_Placed[i].Contents) == contents)
+				{
+					retired.Textures.push_back( std::move( _Placed[i].Texture ) );
+					_Placed[i] = std::move( _Placed.back() );
+					_Placed.pop_back();
+				}
+				else
+				{
+					++i;
+				}
+			}
+			RHI::HeapDesc desc;
+			desc.Size = AlignUp( heap.Required, HeapGranularity );
+			desc.Contents = static_cast<RHI::HeapContents>(contents);
+			desc.DebugName = "Render Graph Transients";
+			heap.Heap = _Device.CreateHeap( desc );
+		}
+
+		for (uint32_t index : _Order)
+		{
+			TextureEntry& entry = _Textures[index];
+			entry.Placed = FindPlacedTexture( entry );
+			_Placed[entry.Placed].LastUsedFrame = _Frame;
+		}
+	}
+
+	uint32_t RenderGraph::FindPlacedTexture( const TextureEntry& entry )
+	{
+		// Transients alike at the same offset never live at the same time, so they can share one.
+		for (uint32_t i = 0; i < _Placed.size(); ++i)
+		{
+			const PlacedTexture& placed = _Placed[i];
+			if (placed.Contents == entry.Contents && placed.Offset == entry.Offset &&
+				IsSameTexture( placed.Texture->GetDesc(), entry.Desc ))
+			{
+				return i;
+			}
+		}
+		RHI::Heap& heap = *_Heaps[static_cast<size_t>(entry.Contents)].Heap;
+		// Inactive until its first use hands it the memory with an Aliasing barrier.
+		_Placed.push_back( { _Device.CreatePlacedTexture( entry.Desc, heap, entry.Offset ), entry.Contents,
+			entry.Offset, entry.Size, entry.Desc.InitialState, false, _Frame } );
+		return static_cast<uint32_t>(_Placed.size() - 1);
+	}
+
+	void RenderGraph::RecordBarriers( RHI::CommandList& commands, uint32_t first, uint32_t count )
+	{
+		_Batch.clear();
+		for (uint32_t i = first; i < first + count; ++i)
+		{
+			const Barrier& barrier = _Barriers[i];
+			const TextureEntry& entry = _Textures[barrier.Texture];
+			if (entry.Imported != nullptr)
+			{
+				_Batch.push_back( { entry.Imported, barrier.Before, barrier.After, barrier.Type } );
+				_Stats.ExecutedTransitions += barrier.Type == RHI::BarrierType::Transition;
+				continue;
+			}
+			PlacedTexture& placed = _Placed[entry.Placed];
+			if (barrier.FirstUse && !placed.Active)
+			{
+				for (PlacedTexture& other : _Placed)
+				{
+					if (other.Contents == placed.Contents && other.Offset < placed.Offset + placed.Size &&
+						placed.Offset < other.Offset + other.Size)
+					{
+						other.Active = false;
+					}
+				}
+				placed.Active = true;
+				_Batch.push_back( { placed.Texture.get(), barrier.Before, barrier.After, RHI::BarrierType::Aliasing } );
+				++_Stats.AliasingBarriers;
+			}
+			if (barrier.Type == RHI::BarrierType::UnorderedAccess)
+			{
+				_Batch.push_back( { placed.Texture.get(), barrier.Before, barrier.After, barrier.Type } );
+			}
+			else if (placed.State != barrier.After)
+			{
+				_Batch.push_back( { placed.Texture.get(), placed.State, barrier.After, RHI::BarrierType::Transition } );
+				placed.State = barrier.After;
+				++_Stats.ExecutedTransitions;
+			}
+		}
+		if (!_Batch.empty())
+		{
+			commands.Barrier( _Batch.data(), static_cast<uint32_t>(_Batch.size()) );
+		}
+	}
+
+	void RenderGraph::ReleaseRetired()
+	{
+		const auto done = std::find_if( _Retired.begin(), _Retired.end(),
+			[this]( const Retired& retired ) { return retired.Frame + _FramesInFlight > _Frame; } );
+		_Retired.erase( _Retired.begin(), done );
+	}
+
+	bool RenderGraph::IsTransient( const TextureEntry& entry ) noexcept
+	{
+		return entry.Imported == nullptr;
+	}
+}
@@ -0,0 +1,265 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+#include "Common/CommonHeaders.h"
+#include "RHI/RHI.h"
+#include <functional>
+
+namespace CronoEngine::Graphics
+{
+	class RenderGraph;
+
+	// A texture the graph knows about, valid until the graph is reset.
+	struct RenderGraphTexture
+	{
+		static constexpr uint32_t Invalid = UINT32_MAX;
+		uint32_t Index = Invalid;
+
+		bool IsValid() const noexcept
+		{
+			return Index != Invalid;
+		}
+	};
+
+	// Declares what a pass touches, handed to the setup callback of RenderGraph::AddPass.
+	class RenderGraphBuilder
+	{
+	public:
+		/**
+		 * Transient texture: it only exists from the first to the last pass that uses it and
+		 * its memory is shared with transients that are never alive at the same time. Its
+		 * content is undefined when the first pass writing it starts, so that pass must clear
+		 * it or write all of it.
+		 */
+		RenderGraphTexture CreateTexture( const RHI::TextureDesc& desc );
+		// The pass needs what earlier passes wrote, in state.
+		void Read( RenderGraphTexture texture, RHI::ResourceState state = RHI::ResourceState::PixelShaderResource );
+		// The pass writes in state. Without a Read too, earlier content is not needed.
+		void Write( RenderGraphTexture texture, RHI::ResourceState state = RHI::ResourceState::RenderTarget );
+		// Never culled, even when nothing uses what it writes (readback, captures).
+		void SetSideEffects() noexcept;
+	private:
+		friend class RenderGraph;
+		RenderGraphBuilder( RenderGraph& graph, uint32_t pass ) noexcept;
+	private:
+		RenderGraph& _Graph;
+		const uint32_t _Pass;
+	};
+
+	// What a pass records with, handed to the execute callback of RenderGraph::AddPass.
+	class RenderGraphContext
+	{
+	public:
+		RHI::CommandList& GetCommands() const noexcept;
+		RHI::Texture& GetTexture( RenderGraphTexture texture ) const;
+	private:
+		friend class RenderGraph;
+		RenderGraphContext( RenderGraph& graph, RHI::CommandList& commands ) noexcept;
+	private:
+		RenderGraph& _Graph;
+		RHI::CommandList& _Commands;
+	};
+
+	// What Compile decided, and what the last Execute added to it.
+	struct RenderGraphStats
+	{
+		uint32_t Passes = 0;
+		uint32_t CulledPasses = 0;
+		uint32_t Textures = 0;
+		// Transients used by a pass that was kept.
+		uint32_t TransientTextures = 0;
+		uint32_t Transitions = 0;
+		uint32_t UnorderedAccessBarriers = 0;
+		// Barrier calls, one per pass that needs any plus one for the final states.
+		uint32_t BarrierBatches = 0;
+		// Aliased heap bytes against what the transients would take on their own.
+		uint64_t TransientMemory = 0;
+		uint64_t UnaliasedMemory = 0;
+		// Execute only. The first use of a transient depends on the placed texture it got, which
+		// may already hold its memory or be in the state the pass wants.
+		uint32_t AliasingBarriers = 0;
+		uint32_t ExecutedTransitions = 0;
+	};
+
+	/**
+	 * Frame as a list of passes that declare the textures they read and write. Compile culls
+	 * passes nothing needs, places the transients so ones that are never alive together share
+	 * memory, and works out the fewest transitions between passes: consecutive reads are
+	 * merged into one combined read state, and each pass gets a single batched Barrier call.
+	 * Execute then records the passes into a command list, placing transients in heaps the
+	 * graph keeps from frame to frame.
+	 *
+	 * Passes run in the order they are added. Rebuild the graph every frame with Reset and
+	 * AddPass; heaps and placed textures stay alive until framesInFlight more frames have been
+	 * executed after they stop being needed, so the GPU is done with them when they go.
+	 */
+	class RenderGraph
+	{
+	public:
+		using SetupCallback = std::function<void( RenderGraphBuilder& )>;
+		using ExecuteCallback = std::function<void( RenderGraphContext& )>;
+
+		RenderGraph( RHI::Device& device, uint32_t framesInFlight );
+		~RenderGraph();
+		RenderGraph( const RenderGraph& ) = delete;
+		RenderGraph& operator=( const RenderGraph& ) = delete;
+
+		// Drops the passes and textures, keeps the heaps and placed textures for the next frame.
+		void Reset();
+		/**
+		 * Texture made outside the graph, in state when the graph starts and returned in
+		 * finalState. What passes write to it is kept, so they are never culled for it.
+		 */
+		RenderGraphTexture ImportTexture( RHI::Texture& texture, RHI::ResourceState state, RHI::ResourceState finalState );
+		// setup runs right away; execute runs in Execute, unless the pass is culled.
+		void AddPass( std::string name, const SetupCallback& setup, ExecuteCallback execute );
+		void Compile();
+		// Records the passes kept by Compile into commands, which must be recording.
+		void Execute( RHI::CommandList& commands );
+
+		const RenderGraphStats& GetStats() const noexcept;
+		bool IsCulled( uint32_t pass ) const;
+		// Transient's offset in its heap, after Compile.
+		uint64_t GetHeapOffset( RenderGraphTexture texture ) const;
+		// Passes, barriers and transient placement, one line each.
+		std::string Describe() const;
+	private:
+		friend class RenderGraphBuilder;
+		friend class RenderGraphContext;
+
+		struct Access
+		{
+			uint32_t Texture;
+			RHI::ResourceState State;
+			bool Reads;
+			bool Writes;
+		};
+
+		struct Pass
+		{
+			std::string Name;
+			ExecuteCallback Execute;
+			// Range in _Accesses.
+			uint32_t FirstAccess = 0;
+			uint32_t AccessCount = 0;
+			bool SideEffects = false;
+			bool Culled = false;
+			// Range in _Barriers, placed in front of the pass.
+			uint32_t FirstBarrier = 0;
+			uint32_t BarrierCount = 0;
+		};
+
+		struct Barrier
+		{
+			uint32_t Texture;
+			RHI::ResourceState Before;
+			RHI::ResourceState After;
+			RHI::BarrierType Type;
+			// First use of a transient this frame: Execute works out the real before state and aliasing.
+			bool FirstUse;
+		};
+
+		struct TextureEntry
+		{
+			RHI::TextureDesc Desc;
+			// Imported only.
+			RHI::Texture* Imported = nullptr;
+			RHI::ResourceState State = RHI::ResourceState::Common;
+			RHI::ResourceState FinalState = RHI::ResourceState::Common;
+			// Kept passes using it, in pass order.
+			uint32_t FirstPass = UINT32_MAX;
+			uint32_t LastPass = 0;
+			RHI::HeapContents Contents = RHI::HeapContents::RenderTargets;
+			uint64_t Size = 0;
+			uint64_t Alignment = 0;
+			uint64_t Offset = 0;
+			// While planning barriers: the state the last planned pass left it in.
+			RHI::ResourceState Current = RHI::ResourceState::Common;
+			bool Touched = false;
+			bool UnorderedWrite = false;
+			uint32_t LastAccess = UINT32_MAX;
+			// Index in _Placed while executing.
+			uint32_t Placed = UINT32_MAX;
+		};
+
+		// Placed texture kept from frame to frame.
+		struct PlacedTexture
+		{
+			std::unique_ptr<RHI::Texture> Texture;
+			RHI::HeapContents Contents;
+			uint64_t Offset;
+			uint64_t Size;
+			RHI::ResourceState State;
+			// Holds its memory, the last Aliasing barrier named it.
+			bool Active;
+			uint64_t LastUsedFrame;
+		};
+
+		struct TransientHeap
+		{
+			std::unique_ptr<RHI::Heap> Heap;
+			// What Compile needs this frame.
+			uint64_t Required = 0;
+		};
+
+		// Objects the GPU may still use, released once frame is framesInFlight behind.
+		struct Retired
+		{
+			uint64_t Frame;
+			// Declared first so it goes after the textures placed in it.
+			std::unique_ptr<RHI::Heap> Heap;
+			std::vector<std::unique_ptr<RHI::Texture>> Textures;
+		};
+
+		TextureEntry& GetEntry( RenderGraphTexture texture );
+		const TextureEntry& GetEntry( RenderGraphTexture texture ) const;
+		void AddAccess( uint32_t pass, RenderGraphTexture texture, RHI::ResourceState state, bool writes );
+		void Cull();
+		void PlaceTransients();
+		void PlanBarriers();
+		void PrepareHeaps();
+		uint32_t FindPlacedTexture( const TextureEntry& entry );
+		void RecordBarriers( RHI::CommandList& commands, uint32_t first, uint32_t count );
+		void ReleaseRetired();
+		static bool IsTransient( const TextureEntry& entry ) noexcept;
+	private:
+		RHI::Device& _Device;
+		const uint32_t _FramesInFlight;
+		uint64_t _Frame = 0;
+		bool _Compiled = false;
+		std::vector<Pass> _Passes;
+		std::vector<Access> _Accesses;
+		std::vector<TextureEntry> _Textures;
+		// Transitions into the final states of imported textures trail the last pass.
+		std::vector<Barrier> _Barriers;
+		uint32_t _FinalBarrier = 0;
+		RenderGraphStats _Stats;
+		// By HeapContents, Buffers unused.
+		TransientHeap _Heaps[3];
+		std::vector<PlacedTexture> _Placed;
+		std::vector<Retired> _Retired;
+		// Scratch, kept so frames do not allocate.
+		std::vector<uint32_t> _Order;
+		std::vector<RHI::ResourceBarrier> _Batch;
+		std::vector<uint8_t> _Needed;
+		// Per access, the next access to the same texture by a kept pass.
+		std::vector<uint32_t> _NextAccess;
+	};
+}
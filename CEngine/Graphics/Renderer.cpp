@@ -23,11 +23,11 @@
 namespace CronoEngine::Graphics
 {
 	
-	Renderer::Renderer( int32_t width, int32_t height, std::string title, bool hasBorder )
+	Renderer::Renderer( int32_t width, int32_t height, std::string title, bool hasBorder, bool useWarp )
 		: _Width(width), _Height(height)
 	{		
 		CWindow = CreateCWindow( width, height, title.c_str(), hasBorder );	
-		CWindow->Gfx().Init();
+		CWindow->Gfx().Init( useWarp );
 	}
 
 	Renderer::~Renderer()
@@ -27,7 +27,7 @@ namespace CronoEngine::Graphics
 	class Renderer
 	{
 	public:
-		Renderer(int32_t width, int32_t height, std::string title, bool hasBorder);
+		Renderer(int32_t width, int32_t height, std::string title, bool hasBorder, bool useWarp = false);
 		~Renderer();
 
 		DX12Core& Gfx();
@@ -0,0 +1,301 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "TlsfAllocator.h"
+#include <bit>
+
+namespace CronoEngine::Graphics
+{
+	namespace
+	{
+		uint64_t AlignUp( uint64_t value, uint64_t alignment ) noexcept
+		{
+			return (value + alignment - 1) & ~(alignment - 1);
+		}
+	}
+
+	TlsfAllocator::TlsfAllocator( uint64_t size, uint64_t granularity )
+		: _Size( size / granularity * granularity ), _Granularity( granularity )
+	{
+		if (!std::has_single_bit( granularity ))
+		{
+			throw CHWND_RHI_EXCEPT( "TLSF granularity " + std::to_string( granularity ) + " is not a power of two" );
+		}
+		for (auto& lists : _FreeLists)
+		{
+			std::fill( std::begin( lists ), std::end( lists ), InvalidBlock );
+		}
+		if (_Size > 0)
+		{
+			_First = NewBlock();
+			_Blocks[_First].Size = _Size;
+			InsertFree( _First );
+		}
+	}
+
+	TlsfAllocator::Allocation TlsfAllocator::Allocate( uint64_t size, uint64_t alignment )
+	{
+		alignment = std::max( alignment, _Granularity );
+		size = AlignUp( std::max<uint64_t>( size, 1 ), _Granularity );
+		if (!std::has_single_bit( alignment ) || size > _Size)
+		{
+			return {};
+		}
+		// Offsets are multiples of the granularity already, worst case padding is the rest.
+		const uint64_t search = size + alignment - _Granularity;
+		uint32_t block = search <= _Size ? FindFree( search ) : InvalidBlock;
+		if (block == InvalidBlock)
+		{
+			block = FindFit( size, alignment );
+			if (block == InvalidBlock)
+			{
+				return {};
+			}
+		}
+		RemoveFree( block );
+		const uint64_t padding = AlignUp( _Blocks[block].Offset, alignment ) - _Blocks[block].Offset;
+		if (padding > 0)
+		{
+			// The padding stays free; the block before it is in use, free neighbours are always merged.
+			const uint32_t front = block;
+			block = Split( front, padding );
+			InsertFree( front );
+		}
+		if (_Blocks[block].Size - size >= _Granularity)
+		{
+			InsertFree( Split( block, size ) );
+		}
+		Block& entry = _Blocks[block];
+		entry.State = BlockState::Allocated;
+		entry.Alignment = alignment;
+		_UsedBytes += entry.Size;
+		++_Allocations;
+		return { entry.Offset, entry.Size, block };
+	}
+
+	void TlsfAllocator::Free( uint32_t block )
+	{
+		if (block >= _Blocks.size() || _Blocks[block].State != BlockState::Allocated)
+		{
+			throw CHWND_RHI_EXCEPT( "TLSF free of block " + std::to_string( block ) + ", which is not allocated" );
+		}
+		Block& entry = _Blocks[block];
+		entry.State = BlockState::Free;
+		entry.Alignment = 0;
+		_UsedBytes -= entry.Size;
+		--_Allocations;
+		const uint32_t next = entry.NextPhysical;
+		if (next != InvalidBlock && _Blocks[next].State == BlockState::Free)
+		{
+			RemoveFree( next );
+			Merge( block, next );
+		}
+		const uint32_t prev = _Blocks[block].PrevPhysical;
+		if (prev != InvalidBlock && _Blocks[prev].State == BlockState::Free)
+		{
+			RemoveFree( prev );
+			Merge( prev, block );
+			block = prev;
+		}
+		InsertFree( block );
+	}
+
+	bool TlsfAllocator::IsEmpty() const noexcept
+	{
+		return _Allocations == 0;
+	}
+
+	TlsfAllocator::Stats TlsfAllocator::GetStats() const noexcept
+	{
+		Stats stats;
+		stats.Size = _Size;
+		stats.UsedBytes = _UsedBytes;
+		stats.FreeBytes = _Size - _UsedBytes;
+		stats.Allocations = _Allocations;
+		stats.FreeBlocks = _FreeBlocks;
+		if (_FirstLevelMap != 0)
+		{
+			// The largest block is in the highest class that has any.
+			const uint32_t firstLevel = 63 - std::countl_zero( _FirstLevelMap );
+			const uint32_t secondLevel = 31 - std::countl_zero( _SecondLevelMaps[firstLevel] );
+			for (uint32_t block = _FreeLists[firstLevel][secondLevel]; block != InvalidBlock; block = _Blocks[block].NextFree)
+			{
+				stats.LargestFreeBlock = std::max( stats.LargestFreeBlock, _Blocks[block].Size );
+			}
+		}
+		return stats;
+	}
+
+	void TlsfAllocator::GetSizeClass( uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel ) noexcept
+	{
+		firstLevel = 63 - std::countl_zero( size );
+		const uint64_t steps = firstLevel >= SecondLevelLog ? size >> (firstLevel - SecondLevelLog) : size << (SecondLevelLog - firstLevel);
+		secondLevel = static_cast<uint32_t>(steps) & (SecondLevelCount - 1);
+	}
+
+	uint32_t TlsfAllocator::FindFree( uint64_t size ) const noexcept
+	{
+		uint32_t firstLevel;
+		uint32_t secondLevel;
+		GetSizeClass( size, firstLevel, secondLevel );
+		// Up to the next class, so any block found is large enough.
+		if (firstLevel >= SecondLevelLog)
+		{
+			size += (1ull << (firstLevel - SecondLevelLog)) - 1;
+			GetSizeClass( size, firstLevel, secondLevel );
+		}
+		uint32_t secondLevelMap = _SecondLevelMaps[firstLevel] & (~0u << secondLevel);
+		if (secondLevelMap == 0)
+		{
+			const uint64_t firstLevelMap = firstLevel + 1 < FirstLevelCount ? _FirstLevelMap & (~0ull << (firstLevel + 1)) : 0;
+			if (firstLevelMap == 0)
+			{
+				return InvalidBlock;
+			}
+			firstLevel = std::countr_zero( firstLevelMap );
+			secondLevelMap = _SecondLevelMaps[firstLevel];
+		}
+		return _FreeLists[firstLevel][std::countr_zero( secondLevelMap )];
+	}
+
+	uint32_t TlsfAllocator::FindFit( uint64_t size, uint64_t alignment ) const noexcept
+	{
+		uint32_t firstLevel;
+		uint32_t secondLevel;
+		GetSizeClass( size, firstLevel, secondLevel );
+		uint32_t secondLevelMap = _SecondLevelMaps[firstLevel] & (~0u << secondLevel);
+		// Only reached when FindFree found nothing, so just the classes it rounded past are left, checked block by block.
+		while (true)
+		{
+			while (secondLevelMap != 0)
+			{
+				const uint32_t list = std::countr_zero( secondLevelMap );
+				secondLevelMap &= secondLevelMap - 1;
+				for (uint32_t block = _FreeLists[firstLevel][list]; block != InvalidBlock; block = _Blocks[block].NextFree)
+				{
+					const Block& entry = _Blocks[block];
+					if (AlignUp( entry.Offset, alignment ) + size <= entry.Offset + entry.Size)
+					{
+						return block;
+					}
+				}
+			}
+			const uint64_t firstLevelMap = firstLevel + 1 < FirstLevelCount ? _FirstLevelMap & (~0ull << (firstLevel + 1)) : 0;
+			if (firstLevelMap == 0)
+			{
+				return InvalidBlock;
+			}
+			firstLevel = std::countr_zero( firstLevelMap );
+			secondLevelMap = _SecondLevelMaps[firstLevel];
+		}
+	}
+
+	void TlsfAllocator::InsertFree( uint32_t block ) noexcept
+	{
+		uint32_t firstLevel;
+		uint32_t secondLevel;
+		GetSizeClass( _Blocks[block].Size, firstLevel, secondLevel );
+		Block& entry = _Blocks[block];
+		entry.State = BlockState::Free;
+		entry.PrevFree = InvalidBlock;
+		entry.NextFree = _FreeLists[firstLevel][secondLevel];
+		if (entry.NextFree != InvalidBlock)
+		{
+			_Blocks[entry.NextFree].PrevFree = block;
+		}
+		_FreeLists[firstLevel][secondLevel] = block;
+		_FirstLevelMap |= 1ull << firstLevel;
+		_SecondLevelMaps[firstLevel] |= 1u << secondLevel;
+		++_FreeBlocks;
+	}
+
+	void TlsfAllocator::RemoveFree( uint32_t block ) noexcept
+	{
+		uint32_t firstLevel;
+		uint32_t secondLevel;
+		GetSizeClass( _Blocks[block].Size, firstLevel, secondLevel );
+		const Block& entry = _Blocks[block];
+		if (entry.PrevFree != InvalidBlock)
+		{
+			_Blocks[entry.PrevFree].NextFree = entry.NextFree;
+		}
+		else
+		{
+			_FreeLists[firstLevel][secondLevel] = entry.NextFree;
+		}
+		if (entry.NextFree != InvalidBlock)
+		{
+			_Blocks[entry.NextFree].PrevFree = entry.PrevFree;
+		}
+		if (_FreeLists[firstLevel][secondLevel] == InvalidBlock)
+		{
+			_SecondLevelMaps[firstLevel] &= ~(1u << secondLevel);
+			if (_SecondLevelMaps[firstLevel] == 0)
+			{
+				_FirstLevelMap &= ~(1ull << firstLevel);
+			}
+		}
+		--_FreeBlocks;
+	}
+
+	uint32_t TlsfAllocator::Split( uint32_t block, uint64_t size )
+	{
+		// May grow _Blocks, so no references across it.
+		const uint32_t rest = NewBlock();
+		Block& entry = _Blocks[block];
+		Block& restEntry = _Blocks[rest];
+		restEntry.Offset = entry.Offset + size;
+		restEntry.Size = entry.Size - size;
+		restEntry.PrevPhysical = block;
+		restEntry.NextPhysical = entry.NextPhysical;
+		if (entry.NextPhysical != InvalidBlock)
+		{
+			_Blocks[entry.NextPhysical].PrevPhysical = rest;
+		}
+		entry.NextPhysical = rest;
+		entry.Size = size;
+		return rest;
+	}
+
+	void TlsfAllocator::Merge( uint32_t block, uint32_t next ) noexcept
+	{
+		Block& entry = _Blocks[block];
+		Block& nextEntry = _Blocks[next];
+		entry.Size += nextEntry.Size;
+		entry.NextPhysical = nextEntry.NextPhysical;
+		if (nextEntry.NextPhysical != InvalidBlock)
+		{
+			_Blocks[nextEntry.NextPhysical].PrevPhysical = block;
+		}
+		nextEntry = Block();
+		_UnusedBlocks.push_back( next );
+	}
+
+	uint32_t TlsfAllocator::NewBlock()
+	{
+		if (!_UnusedBlocks.empty())
+		{
+			const uint32_t block = _UnusedBlocks.back();
+			_UnusedBlocks.pop_back();
+			return block;
+		}
+		_Blocks.emplace_back();
+		return static_cast<uint32_t>(_Blocks.size() - 1);
+	}
+}
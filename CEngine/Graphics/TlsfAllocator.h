@@ -0,0 +1,140 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+#include "Common/CommonHeaders.h"
+
+namespace CronoEngine::Graphics
+{
+	/**
+	 * Two level segregated fit allocator over a range of offsets, without memory of its own:
+	 * free blocks sit in lists by size class (the power of two, then 16 steps inside it),
+	 * found through two bitmaps, so Allocate and Free take the same few steps whatever the
+	 * number of blocks. Only when no class that surely fits has a block does Allocate scan the
+	 * smaller ones, which may still hold it, e.g. a heap sized for exactly one allocation.
+	 * Neighbouring free blocks are merged on Free. Every offset and size is a multiple of the
+	 * granularity, a power of two.
+	 */
+	class TlsfAllocator
+	{
+	public:
+		static constexpr uint32_t InvalidBlock = UINT32_MAX;
+
+		struct Allocation
+		{
+			uint64_t Offset = 0;
+			// Can be up to one granularity step larger than asked, when the rest is too small to keep.
+			uint64_t Size = 0;
+			uint32_t Block = InvalidBlock;
+
+			bool IsValid() const noexcept
+			{
+				return Block != InvalidBlock;
+			}
+		};
+
+		struct BlockInfo
+		{
+			uint32_t Block;
+			uint64_t Offset;
+			uint64_t Size;
+			// As asked by Allocate, 0 for free blocks.
+			uint64_t Alignment;
+			bool Free;
+		};
+
+		struct Stats
+		{
+			uint64_t Size = 0;
+			uint64_t UsedBytes = 0;
+			uint64_t FreeBytes = 0;
+			uint64_t LargestFreeBlock = 0;
+			uint32_t Allocations = 0;
+			uint32_t FreeBlocks = 0;
+		};
+
+		TlsfAllocator( uint64_t size, uint64_t granularity );
+
+		// Invalid when no free block can hold size bytes at a multiple of alignment (a power of two).
+		Allocation Allocate( uint64_t size, uint64_t alignment );
+		void Free( uint32_t block );
+		bool IsEmpty() const noexcept;
+		Stats GetStats() const noexcept;
+		// Every block, free or not, in offset order.
+		template<typename Visitor>
+		void ForEachBlock( Visitor&& visitor ) const
+		{
+			for (uint32_t block = _First; block != InvalidBlock; block = _Blocks[block].NextPhysical)
+			{
+				const Block& entry = _Blocks[block];
+				visitor( BlockInfo{ block, entry.Offset, entry.Size, entry.Alignment, entry.State == BlockState::Free } );
+			}
+		}
+	private:
+		enum class BlockState : uint8_t
+		{
+			// In _UnusedBlocks, waiting to be reused.
+			Unused,
+			Free,
+			Allocated
+		};
+
+		struct Block
+		{
+			uint64_t Offset = 0;
+			uint64_t Size = 0;
+			uint64_t Alignment = 0;
+			uint32_t PrevPhysical = InvalidBlock;
+			uint32_t NextPhysical = InvalidBlock;
+			// Free list of its size class, free blocks only.
+			uint32_t PrevFree = InvalidBlock;
+			uint32_t NextFree = InvalidBlock;
+			BlockState State = BlockState::Unused;
+		};
+
+		static constexpr uint32_t SecondLevelLog = 4;
+		static constexpr uint32_t SecondLevelCount = 1u << SecondLevelLog;
+		static constexpr uint32_t FirstLevelCount = 64;
+
+		static void GetSizeClass( uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel ) noexcept;
+		// A free block of at least size bytes, from the first class whose blocks are all large enough.
+		uint32_t FindFree( uint64_t size ) const noexcept;
+		// The first free block from size's class up that holds size bytes at alignment, walking the lists.
+		uint32_t FindFit( uint64_t size, uint64_t alignment ) const noexcept;
+		void InsertFree( uint32_t block ) noexcept;
+		void RemoveFree( uint32_t block ) noexcept;
+		// Cuts block after size bytes and returns the second part.
+		uint32_t Split( uint32_t block, uint64_t size );
+		// Joins next into block and drops it.
+		void Merge( uint32_t block, uint32_t next ) noexcept;
+		uint32_t NewBlock();
+	private:
+		const uint64_t _Size;
+		const uint64_t _Granularity;
+		std::vector<Block> _Blocks;
+		std::vector<uint32_t> _UnusedBlocks;
+		uint32_t _First = InvalidBlock;
+		uint64_t _FirstLevelMap = 0;
+		uint32_t _SecondLevelMaps[FirstLevelCount] = {};
+		uint32_t _FreeLists[FirstLevelCount][SecondLevelCount];
+		uint64_t _UsedBytes = 0;
+		uint32_t _Allocations = 0;
+		uint32_t _FreeBlocks = 0;
+	};
+}
@@ -0,0 +1,149 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "UploadRing.h"
+
+namespace CronoEngine::Graphics
+{
+	RingAllocator::RingAllocator( uint64_t capacity ) noexcept
+		: _Capacity( capacity )
+	{
+	}
+
+	uint64_t RingAllocator::Allocate( uint64_t size, uint64_t alignment ) noexcept
+	{
+		if (size == 0 || size > _Capacity)
+		{
+			return Full;
+		}
+		uint64_t start = (_Head + alignment - 1) & ~(alignment - 1);
+		const uint64_t offset = start % _Capacity;
+		if (offset + size > _Capacity)
+		{
+			start += _Capacity - offset;
+		}
+		if (start + size - _Tail > _Capacity)
+		{
+			return Full;
+		}
+		_Head = start + size;
+		return start % _Capacity;
+	}
+
+	void RingAllocator::Close( uint64_t fenceValue )
+	{
+		// Nothing allocated since the last Close, nothing to wait for.
+		const uint64_t closedHead = _Closed.empty() ? _Tail : _Closed.back().Head;
+		if (_Head != closedHead)
+		{
+			_Closed.push_back( { fenceValue, _Head } );
+		}
+	}
+
+	void RingAllocator::Release( uint64_t completedValue ) noexcept
+	{
+		while (!_Closed.empty() && _Closed.front().FenceValue <= completedValue)
+		{
+			_Tail = _Closed.front().Head;
+			_Closed.pop_front();
+		}
+	}
+
+	std::optional<uint64_t> RingAllocator::GetOldestValue() const noexcept
+	{
+		if (_Closed.empty())
+		{
+			return std::nullopt;
+		}
+		return _Closed.front().FenceValue;
+	}
+
+	uint64_t RingAllocator::GetCapacity() const noexcept
+	{
+		return _Capacity;
+	}
+
+	uint64_t RingAllocator::GetUsed() const noexcept
+	{
+		return _Head - _Tail;
+	}
+
+	UploadRing::UploadRing( RHI::Device& device, RHI::Fence& fence, uint64_t size )
+		: _Fence( fence ),
+		_Ring( (size + RHI::ConstantBufferAlignment - 1) / RHI::ConstantBufferAlignment * RHI::ConstantBufferAlignment )
+	{
+		RHI::BufferDesc desc;
+		desc.Size = _Ring.GetCapacity();
+		desc.Usage = RHI::BufferUsage::Constant | RHI::BufferUsage::Vertex | RHI::BufferUsage::Index;
+		desc.Memory = RHI::MemoryType::Upload;
+		desc.DebugName = "Upload Ring";
+		_Buffer = device.CreateBuffer( desc );
+		_Data = static_cast<uint8_t*>(_Buffer->GetMappedData());
+		_Stats.Capacity = desc.Size;
+	}
+
+	UploadAllocation UploadRing::Allocate( uint64_t size, uint64_t alignment )
+	{
+		if (size == 0)
+		{
+			return { nullptr, _Buffer.get(), 0, 0 };
+		}
+		uint64_t offset = _Ring.Allocate( size, alignment );
+		if (offset == RingAllocator::Full)
+		{
+			// Frames the GPU already finished, then the oldest one still running.
+			_Ring.Release( _Fence.GetCompletedValue() );
+			offset = _Ring.Allocate( size, alignment );
+			while (offset == RingAllocator::Full)
+			{
+				const std::optional<uint64_t> oldest = _Ring.GetOldestValue();
+				if (!oldest || size > _Ring.GetCapacity())
+				{
+					throw CHWND_RHI_EXCEPT( "Upload ring of " + std::to_string( _Ring.GetCapacity() ) + " bytes can not fit " +
+						std::to_string( size ) + " more bytes in one frame" );
+				}
+				const auto start = std::chrono::steady_clock::now();
+				_Fence.Wait( *oldest );
+				_Stats.StallSeconds += std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+				++_Stats.Stalls;
+				_Ring.Release( *oldest );
+				offset = _Ring.Allocate( size, alignment );
+			}
+		}
+		++_Stats.Allocations;
+		_Stats.AllocatedBytes += size;
+		_Stats.PeakUsed = std::max( _Stats.PeakUsed, _Ring.GetUsed() );
+		return { _Data + offset, _Buffer.get(), offset, size };
+	}
+
+	void UploadRing::EndFrame( uint64_t fenceValue )
+	{
+		_Ring.Close( fenceValue );
+	}
+
+	RHI::Buffer& UploadRing::GetBuffer() const noexcept
+	{
+		return *_Buffer;
+	}
+
+	UploadRingStats UploadRing::GetStats() const noexcept
+	{
+		return _Stats;
+	}
+}
@@ -0,0 +1,126 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+#include "Common/CommonHeaders.h"
+#include "RHI/RHI.h"
+#include <cstring>
+#include <deque>
+#include <type_traits>
+
+namespace CronoEngine::Graphics
+{
+	/**
+	 * Bytes handed out in order and taken back in order, without memory or a GPU of its own.
+	 * Close tags what was allocated since the last Close with a fence value and Release frees
+	 * what the values up to a completed one held, so the caller decides what the values are.
+	 * An allocation never wraps: one that does not fit before the end starts over at 0.
+	 */
+	class RingAllocator
+	{
+	public:
+		static constexpr uint64_t Full = UINT64_MAX;
+
+		explicit RingAllocator( uint64_t capacity ) noexcept;
+
+		// Offset of size bytes at a multiple of alignment, Full while closed values hold the space.
+		// alignment is a power of two that divides the capacity.
+		uint64_t Allocate( uint64_t size, uint64_t alignment ) noexcept;
+		void Close( uint64_t fenceValue );
+		void Release( uint64_t completedValue ) noexcept;
+		// Oldest closed value still holding space.
+		std::optional<uint64_t> GetOldestValue() const noexcept;
+		uint64_t GetCapacity() const noexcept;
+		// From the oldest live allocation to the last one, padding included.
+		uint64_t GetUsed() const noexcept;
+	private:
+		struct Closed
+		{
+			uint64_t FenceValue;
+			// Position the value's allocations run up to.
+			uint64_t Head;
+		};
+
+		const uint64_t _Capacity;
+		// Positions only grow, the offset is the position modulo the capacity.
+		uint64_t _Head = 0;
+		uint64_t _Tail = 0;
+		std::deque<Closed> _Closed;
+	};
+
+	struct UploadAllocation
+	{
+		// Write only, upload memory is write combined and slow to read.
+		void* Data = nullptr;
+		RHI::Buffer* Buffer = nullptr;
+		uint64_t Offset = 0;
+		uint64_t Size = 0;
+	};
+
+	struct UploadRingStats
+	{
+		uint64_t Capacity = 0;
+		uint64_t Allocations = 0;
+		uint64_t AllocatedBytes = 0;
+		uint64_t PeakUsed = 0;
+		// Allocations that had to wait for the GPU, and for how long in total.
+		uint64_t Stalls = 0;
+		double StallSeconds = 0.0;
+	};
+
+	/**
+	 * Per frame data the GPU reads straight from one persistently mapped Upload buffer, such
+	 * as per draw constants and dynamic geometry. Allocating is a pointer bump and the memory
+	 * stays valid until the GPU is done with the frame it was allocated in; EndFrame gives the
+	 * ring the fence value that frame signals. When the frames in flight fill the ring,
+	 * Allocate waits on the fence for the oldest of them. Used by one thread at a time, like
+	 * the command list it feeds.
+	 */
+	class UploadRing
+	{
+	public:
+		// size is rounded up to a multiple of ConstantBufferAlignment.
+		UploadRing( RHI::Device& device, RHI::Fence& fence, uint64_t size );
+		UploadRing( const UploadRing& ) = delete;
+		UploadRing& operator=( const UploadRing& ) = delete;
+
+		// Throws when size is larger than the ring or the current frame alone fills it. Size 0 gives an empty allocation, Data null.
+		UploadAllocation Allocate( uint64_t size, uint64_t alignment = RHI::ConstantBufferAlignment );
+		// Copy of value, aligned for SetConstantBuffer.
+		template<typename T>
+		UploadAllocation Upload( const T& value )
+		{
+			static_assert(std::is_trivially_copyable_v<T>, "Uploads are copied bytewise");
+			UploadAllocation allocation = Allocate( sizeof( T ) );
+			std::memcpy( allocation.Data, &value, sizeof( T ) );
+			return allocation;
+		}
+		// Everything allocated since the last call is done once the fence reaches fenceValue.
+		void EndFrame( uint64_t fenceValue );
+
+		RHI::Buffer& GetBuffer() const noexcept;
+		UploadRingStats GetStats() const noexcept;
+	private:
+		RHI::Fence& _Fence;
+		RingAllocator _Ring;
+		std::unique_ptr<RHI::Buffer> _Buffer;
+		uint8_t* _Data = nullptr;
+		UploadRingStats _Stats;
+	};
+}
@@ -0,0 +1,91 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "ActionMap.h"
+
+namespace CronoEngine
+{
+	ActionMap::ActionId ActionMap::AddAction( const std::string& name )
+	{
+		if (const auto existing = FindAction( name ))
+		{
+			return *existing;
+		}
+		_Actions.push_back( { name } );
+		return static_cast<ActionId>(_Actions.size() - 1);
+	}
+
+	std::optional<ActionMap::ActionId> ActionMap::FindAction( const std::string& name ) const
+	{
+		for (size_t i = 0; i < _Actions.size(); ++i)
+		{
+			if (_Actions[i].Name == name)
+			{
+				return static_cast<ActionId>(i);
+			}
+		}
+		return std::nullopt;
+	}
+
+	const std::string& ActionMap::GetActionName( ActionId action ) const
+	{
+		return _Actions[action].Name;
+	}
+
+	void ActionMap::BindKey( ActionId action, unsigned char key )
+	{
+		_Actions[action].Keys[key >> 6] |= uint64_t( 1 ) << (key & 63);
+	}
+
+	void ActionMap::BindButton( ActionId action, uint32_t button )
+	{
+		_Actions[action].Buttons |= button;
+	}
+
+	void ActionMap::ClearBindings( ActionId action )
+	{
+		_Actions[action].Keys = {};
+		_Actions[action].Buttons = 0;
+	}
+
+	bool ActionMap::IsDown( ActionId action, const InputSnapshot& input ) const noexcept
+	{
+		return Intersects( _Actions[action], input.Keys, input.Buttons );
+	}
+
+	bool ActionMap::WasPressed( ActionId action, const InputSnapshot& input ) const noexcept
+	{
+		return Intersects( _Actions[action], input.PressedKeys, input.PressedButtons );
+	}
+
+	bool ActionMap::WasReleased( ActionId action, const InputSnapshot& input ) const noexcept
+	{
+		return Intersects( _Actions[action], input.ReleasedKeys, input.ReleasedButtons );
+	}
+
+	bool ActionMap::Intersects( const Action& action, const InputSnapshot::KeyMask& keys, uint32_t buttons ) noexcept
+	{
+		uint64_t hits = action.Buttons & buttons;
+		for (size_t i = 0; i < keys.size(); ++i)
+		{
+			hits |= action.Keys[i] & keys[i];
+		}
+		return hits != 0;
+	}
+}
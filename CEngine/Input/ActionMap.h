@@ -0,0 +1,61 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+#include "InputSystem.h"
+
+namespace CronoEngine
+{
+	/**
+	 * Named actions bound to any number of keys and mouse buttons. Every action keeps its
+	 * bindings as masks, so a query is a handful of ANDs against the frame's InputSnapshot.
+	 */
+	class ActionMap
+	{
+	public:
+		using ActionId = uint32_t;
+	public:
+		ActionMap() = default;
+
+		// Returns the existing id if the action was added before.
+		ActionId AddAction( const std::string& name );
+		std::optional<ActionId> FindAction( const std::string& name ) const;
+		const std::string& GetActionName( ActionId action ) const;
+		void BindKey( ActionId action, unsigned char key );
+		void BindButton( ActionId action, uint32_t button );
+		void ClearBindings( ActionId action );
+
+		// Any bound key or button is held.
+		bool IsDown( ActionId action, const InputSnapshot& input ) const noexcept;
+		// A bound key or button went down / up this frame.
+		bool WasPressed( ActionId action, const InputSnapshot& input ) const noexcept;
+		bool WasReleased( ActionId action, const InputSnapshot& input ) const noexcept;
+	private:
+		struct Action
+		{
+			std::string Name;
+			InputSnapshot::KeyMask Keys{};
+			uint32_t Buttons = 0;
+		};
+
+		static bool Intersects( const Action& action, const InputSnapshot::KeyMask& keys, uint32_t buttons ) noexcept;
+	private:
+		std::vector<Action> _Actions;
+	};
+}
@@ -0,0 +1,65 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "InputSystem.h"
+
+namespace CronoEngine
+{
+	void InputSystem::Update( Keyboard& keyboard, Mouse& mouse ) noexcept
+	{
+		InputSnapshot& s = _Snapshot;
+		s.PreviousKeys = s.Keys;
+		s.Keys = keyboard.GetKeyStates();
+		s.PressedKeys = keyboard.ReadPressedKeys();
+		s.ReleasedKeys = keyboard.ReadReleasedKeys();
+
+		s.PreviousButtons = s.Buttons;
+		s.Buttons = mouse.GetButtonStates();
+		s.PressedButtons = mouse.ReadPressedButtons();
+		s.ReleasedButtons = mouse.ReadReleasedButtons();
+
+		const int32_t previousX = s.MouseX;
+		const int32_t previousY = s.MouseY;
+		s.MouseX = mouse.GetPosX();
+		s.MouseY = mouse.GetPosY();
+		const auto raw = mouse.ReadRawDelta();
+		if (mouse.RawEnabled())
+		{
+			s.MouseDeltaX = raw ? raw->x : 0;
+			s.MouseDeltaY = raw ? raw->y : 0;
+		}
+		else if (_HasPosition)
+		{
+			s.MouseDeltaX = s.MouseX - previousX;
+			s.MouseDeltaY = s.MouseY - previousY;
+		}
+		else
+		{
+			s.MouseDeltaX = 0;
+			s.MouseDeltaY = 0;
+		}
+		_HasPosition = true;
+		s.Wheel = static_cast<float>(mouse.ReadWheelDelta()) / 120.0f;
+	}
+
+	const InputSnapshot& InputSystem::GetSnapshot() const noexcept
+	{
+		return _Snapshot;
+	}
+}
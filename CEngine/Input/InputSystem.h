@@ -0,0 +1,101 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+#include "Common/CommonHeaders.h"
+#include "Windows/Keyboard.h"
+#include "Windows/Mouse.h"
+
+namespace CronoEngine
+{
+	/**
+	 * Input state of one frame. Queries are plain bit tests, so check as often as you like.
+	 * Pressed/Released are edges: true for exactly the one frame the transition happened in.
+	 */
+	struct InputSnapshot
+	{
+		using KeyMask = Keyboard::KeyMask;
+
+		KeyMask Keys{};
+		KeyMask PreviousKeys{};
+		KeyMask PressedKeys{};
+		KeyMask ReleasedKeys{};
+		// Mouse::LeftButton / Mouse::RightButton bits.
+		uint32_t Buttons = 0;
+		uint32_t PreviousButtons = 0;
+		uint32_t PressedButtons = 0;
+		uint32_t ReleasedButtons = 0;
+		int32_t MouseX = 0;
+		int32_t MouseY = 0;
+		// Raw deltas summed over the frame while raw input is on, else the cursor movement.
+		int32_t MouseDeltaX = 0;
+		int32_t MouseDeltaY = 0;
+		// Wheel notches, fractional for high resolution wheels.
+		float Wheel = 0.0f;
+
+		static bool Test( const KeyMask& mask, unsigned char key ) noexcept
+		{
+			return (mask[key >> 6] >> (key & 63)) & 1u;
+		}
+		bool KeyIsDown( unsigned char key ) const noexcept
+		{
+			return Test( Keys, key );
+		}
+		bool KeyWasPressed( unsigned char key ) const noexcept
+		{
+			return Test( PressedKeys, key );
+		}
+		bool KeyWasReleased( unsigned char key ) const noexcept
+		{
+			return Test( ReleasedKeys, key );
+		}
+		bool ButtonIsDown( uint32_t button ) const noexcept
+		{
+			return (Buttons & button) != 0;
+		}
+		bool ButtonWasPressed( uint32_t button ) const noexcept
+		{
+			return (PressedButtons & button) != 0;
+		}
+		bool ButtonWasReleased( uint32_t button ) const noexcept
+		{
+			return (ReleasedButtons & button) != 0;
+		}
+	};
+
+	/**
+	 * Builds the InputSnapshot once per frame from the keyboard and mouse. It drains their
+	 * edge latches, raw delta and wheel, so it should be the only reader of those; the event
+	 * queues (ReadKey, Read, ReadChar) are left alone.
+	 */
+	class InputSystem
+	{
+	public:
+		InputSystem() = default;
+		InputSystem( const InputSystem& ) = delete;
+		InputSystem& operator=( const InputSystem& ) = delete;
+
+		void Update( Keyboard& keyboard, Mouse& mouse ) noexcept;
+		const InputSnapshot& GetSnapshot() const noexcept;
+	private:
+		InputSnapshot _Snapshot;
+		// Until the first Update there is no previous cursor position to take a delta from.
+		bool _HasPosition = false;
+	};
+}
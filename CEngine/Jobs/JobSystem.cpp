@@ -0,0 +1,299 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "JobSystem.h"
+
+namespace CronoEngine
+{
+	namespace
+	{
+		// Which deque the current thread owns, if it belongs to this job system.
+		thread_local const JobSystem* t_Owner = nullptr;
+		thread_local uint32_t t_ThreadIndex = 0;
+		// Cheap per thread xorshift for picking steal victims.
+		thread_local uint32_t t_StealSeed = 0x9E3779B9u;
+
+		uint32_t NextRandom()
+		{
+			t_StealSeed ^= t_StealSeed << 13;
+			t_StealSeed ^= t_StealSeed >> 17;
+			t_StealSeed ^= t_StealSeed << 5;
+			return t_StealSeed;
+		}
+	}
+
+	JobSystem::JobSystem( uint32_t workerCount /*= 0*/ )
+		: _MainThreadId( std::this_thread::get_id() )
+	{
+		if (workerCount == 0)
+		{
+			workerCount = std::max( 1u, std::thread::hardware_concurrency() ) - 1;
+		}
+		// Deque 0 belongs to the main thread.
+		for (uint32_t i = 0; i <= workerCount; ++i)
+		{
+			_Queues.push_back( std::make_unique<WorkStealingQueue<Job*>>( QueueCapacity ) );
+		}
+		t_Owner = this;
+		t_ThreadIndex = 0;
+		for (uint32_t i = 1; i <= workerCount; ++i)
+		{
+			_Workers.emplace_back( &JobSystem::WorkerLoop, this, i );
+		}
+	}
+
+	JobSystem::~JobSystem()
+	{
+		_Running.store( false, std::memory_order_release );
+		_WorkSignal.fetch_add( 1, std::memory_order_release );
+		_WorkSignal.notify_all();
+		for (auto& worker : _Workers)
+		{
+			worker.join();
+		}
+		// Jobs that never got to run.
+		for (auto& queue : _Queues)
+		{
+			while (Job* job = queue->Pop())
+			{
+				delete job;
+			}
+		}
+		for (Job* job : _SharedJobs)
+		{
+			delete job;
+		}
+		for (Job* job : _MainThreadJobs)
+		{
+			delete job;
+		}
+		if (t_Owner == this)
+		{
+			t_Owner = nullptr;
+		}
+	}
+
+	void JobSystem::Run( std::function<void()> function, JobCounter* counter /*= nullptr*/, JobAffinity affinity /*= JobAffinity::Any*/ )
+	{
+		if (counter != nullptr)
+		{
+			counter->pending.fetch_add( 1, std::memory_order_relaxed );
+		}
+		Schedule( new Job{ std::move( function ), counter, affinity } );
+	}
+
+	void JobSystem::RunAfter( JobCounter& dependency, std::function<void()> function, JobCounter* counter /*= nullptr*/,
+		JobAffinity affinity /*= JobAffinity::Any*/ )
+	{
+		if (counter != nullptr)
+		{
+			counter->pending.fetch_add( 1, std::memory_order_relaxed );
+		}
+		Job* job = new Job{ std::move( function ), counter, affinity };
+		{
+			std::lock_guard<std::mutex> lock( dependency.continuationMutex );
+			if (!dependency.IsDone())
+			{
+				dependency.continuations.push_back( job );
+				return;
+			}
+		}
+		Schedule( job );
+	}
+
+	void JobSystem::Wait( JobCounter& counter )
+	{
+		const bool isMain = IsMainThread();
+		// Threads without a deque of their own only take shared and stolen jobs.
+		const uint32_t threadIndex = t_Owner == this ? t_ThreadIndex : UINT32_MAX;
+		while (!counter.IsDone())
+		{
+			if (isMain)
+			{
+				ProcessMainThreadJobs();
+			}
+			if (Job* job = FindJob( threadIndex ))
+			{
+				Execute( job );
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+		// Let the thread that finished the last job release the counter.
+		std::lock_guard<std::mutex> lock( counter.continuationMutex );
+	}
+
+	void JobSystem::ProcessMainThreadJobs()
+	{
+		assert( IsMainThread() && "Main thread jobs must run on the main thread." );
+		while (true)
+		{
+			Job* job = nullptr;
+			{
+				std::lock_guard<std::mutex> lock( _MainThreadMutex );
+				if (_MainThreadJobs.empty())
+				{
+					return;
+				}
+				job = _MainThreadJobs.front();
+				_MainThreadJobs.pop_front();
+			}
+			Execute( job );
+		}
+	}
+
+	uint32_t JobSystem::GetThreadCount() const noexcept
+	{
+		return static_cast<uint32_t>(_Queues.size());
+	}
+
+	bool JobSystem::IsMainThread() const noexcept
+	{
+		return std::this_thread::get_id() == _MainThreadId;
+	}
+
+	void JobSystem::Schedule( Job* job )
+	{
+		if (job->Affinity == JobAffinity::MainThread)
+		{
+			std::lock_guard<std::mutex> lock( _MainThreadMutex );
+			_MainThreadJobs.push_back( job );
+			return;
+		}
+		if (t_Owner != this || !_Queues[t_ThreadIndex]->Push( job ))
+		{
+			// Not one of our threads, or its deque is full.
+			std::lock_guard<std::mutex> lock( _SharedMutex );
+			_SharedJobs.push_back( job );
+			_SharedCount.fetch_add( 1, std::memory_order_release );
+		}
+		_WorkSignal.fetch_add( 1, std::memory_order_release );
+		_WorkSignal.notify_one();
+	}
+
+	void JobSystem::Execute( Job* job )
+	{
+		job->Function();
+		JobCounter* counter = job->Counter;
+		delete job;
+		if (counter != nullptr)
+		{
+			Finish( counter );
+		}
+	}
+
+	void JobSystem::Finish( JobCounter* counter )
+	{
+		// Lock-free unless this could be the last job.
+		uint32_t pending = counter->pending.load( std::memory_order_relaxed );
+		while (pending > 1)
+		{
+			if (counter->pending.compare_exchange_weak( pending, pending - 1, std::memory_order_acq_rel ))
+			{
+				return;
+			}
+		}
+		// The last decrement happens under the lock, Wait takes it too before returning
+		// so the counter can't be destroyed while we still touch it.
+		std::vector<Job*> ready;
+		{
+			std::lock_guard<std::mutex> lock( counter->continuationMutex );
+			if (counter->pending.fetch_sub( 1, std::memory_order_acq_rel ) != 1)
+			{
+				return;
+			}
+			ready.swap( counter->continuations );
+		}
+		for (Job* job : ready)
+		{
+			Schedule( job );
+		}
+	}
+
+	Job* JobSystem::FindJob( uint32_t threadIndex )
+	{
+		const uint32_t queueCount = static_cast<uint32_t>(_Queues.size());
+		if (threadIndex < queueCount)
+		{
+			if (Job* job = _Queues[threadIndex]->Pop())
+			{
+				return job;
+			}
+		}
+		if (_SharedCount.load( std::memory_order_acquire ) > 0)
+		{
+			std::lock_guard<std::mutex> lock( _SharedMutex );
+			if (!_SharedJobs.empty())
+			{
+				Job* job = _SharedJobs.front();
+				_SharedJobs.pop_front();
+				_SharedCount.fetch_sub( 1, std::memory_order_relaxed );
+				return job;
+			}
+		}
+		// Start at a random victim so thieves spread out instead of piling onto the same deque.
+		const uint32_t start = NextRandom() % queueCount;
+		for (uint32_t i = 0; i < queueCount; ++i)
+		{
+			const uint32_t victim = (start + i) % queueCount;
+			if (victim == threadIndex)
+			{
+				continue;
+			}
+			if (Job* job = _Queues[victim]->Steal())
+			{
+				return job;
+			}
+		}
+		return nullptr;
+	}
+
+	void JobSystem::WorkerLoop( uint32_t threadIndex )
+	{
+		t_Owner = this;
+		t_ThreadIndex = threadIndex;
+		t_StealSeed ^= threadIndex * 0x85EBCA6Bu;
+		constexpr uint32_t spinsBeforeSleep = 64;
+		uint32_t idleSpins = 0;
+		while (true)
+		{
+			// Read the signal before looking for work so a submit in between can't be missed.
+			const uint32_t signal = _WorkSignal.load( std::memory_order_acquire );
+			if (!_Running.load( std::memory_order_acquire ))
+			{
+				return;
+			}
+			if (Job* job = FindJob( threadIndex ))
+			{
+				Execute( job );
+				idleSpins = 0;
+				continue;
+			}
+			if (++idleSpins < spinsBeforeSleep)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+			_WorkSignal.wait( signal, std::memory_order_acquire );
+			idleSpins = 0;
+		}
+	}
+}
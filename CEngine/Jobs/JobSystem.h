@@ -0,0 +1,131 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+#include "Common/CommonHeaders.h"
+#include "WorkStealingQueue.h"
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <thread>
+
+namespace CronoEngine
+{
+	class JobSystem;
+	struct Job;
+
+	enum class JobAffinity
+	{
+		// Any worker, the main thread included while it waits.
+		Any,
+		// Only the thread that created the JobSystem (the window thread), e.g. for Win32 or ImGui calls.
+		MainThread,
+	};
+
+	/**
+	 * Counts the unfinished jobs of a group. Jobs queued with RunAfter start once it drops to zero.
+	 * Don't add new jobs to a counter while others still wait on it to finish, and only
+	 * destroy it after JobSystem::Wait returned for it.
+	 */
+	class JobCounter
+	{
+		friend class JobSystem;
+	public:
+		JobCounter() = default;
+		JobCounter( const JobCounter& ) = delete;
+		JobCounter& operator=( const JobCounter& ) = delete;
+		bool IsDone() const noexcept
+		{
+			return pending.load( std::memory_order_acquire ) == 0;
+		}
+	private:
+		std::atomic<uint32_t> pending = 0;
+		std::mutex continuationMutex;
+		std::vector<Job*> continuations;
+	};
+
+	struct Job
+	{
+		std::function<void()> Function;
+		JobCounter* Counter = nullptr;
+		JobAffinity Affinity = JobAffinity::Any;
+	};
+
+	/**
+	 * Work-stealing job scheduler. Every worker owns a Chase-Lev deque and steals from the
+	 * others when it runs dry; the main thread owns one too and helps while it waits.
+	 * Jobs must not throw.
+	 */
+	class JobSystem
+	{
+	public:
+		// 0 workers uses one per hardware thread, minus the main thread.
+		explicit JobSystem( uint32_t workerCount = 0 );
+		~JobSystem();
+		JobSystem( const JobSystem& ) = delete;
+		JobSystem& operator=( const JobSystem& ) = delete;
+
+		void Run( std::function<void()> function, JobCounter* counter = nullptr, JobAffinity affinity = JobAffinity::Any );
+		// Queues the job once dependency has no unfinished jobs left.
+		void RunAfter( JobCounter& dependency, std::function<void()> function, JobCounter* counter = nullptr,
+			JobAffinity affinity = JobAffinity::Any );
+		// Runs other jobs until the counter reaches zero instead of blocking.
+		void Wait( JobCounter& counter );
+		// Runs the jobs queued with JobAffinity::MainThread. Main thread only.
+		void ProcessMainThreadJobs();
+
+		// Calls function( begin, end ) over [0, count) in chunks of at most grainSize and waits for all of them.
+		template<typename F>
+		void ParallelFor( uint32_t count, uint32_t grainSize, F&& function )
+		{
+			grainSize = std::max( 1u, grainSize );
+			JobCounter counter;
+			for (uint32_t begin = 0; begin < count; begin += grainSize)
+			{
+				const uint32_t end = std::min( count, begin + grainSize );
+				Run( [&function, begin, end]() { function( begin, end ); }, &counter );
+			}
+			Wait( counter );
+		}
+
+		// Workers plus the main thread.
+		uint32_t GetThreadCount() const noexcept;
+		bool IsMainThread() const noexcept;
+	private:
+		void Schedule( Job* job );
+		void Execute( Job* job );
+		void Finish( JobCounter* counter );
+		Job* FindJob( uint32_t threadIndex );
+		void WorkerLoop( uint32_t threadIndex );
+	private:
+		static constexpr size_t QueueCapacity = 4096;
+		std::thread::id _MainThreadId;
+		std::vector<std::unique_ptr<WorkStealingQueue<Job*>>> _Queues;
+		std::vector<std::thread> _Workers;
+		// Jobs queued from threads without a deque of their own (e.g. the render thread).
+		std::mutex _SharedMutex;
+		std::deque<Job*> _SharedJobs;
+		std::atomic<uint32_t> _SharedCount = 0;
+		std::mutex _MainThreadMutex;
+		std::deque<Job*> _MainThreadJobs;
+		// Bumped on every submit, sleeping workers wait for it to change.
+		std::atomic<uint32_t> _WorkSignal = 0;
+		std::atomic<bool> _Running = true;
+	};
+}
@@ -0,0 +1,293 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "TaskGraph.h"
+#include <unordered_map>
+
+namespace CronoEngine
+{
+	TaskGraph::TaskId TaskGraph::AddTask( std::string name, std::vector<std::string> reads, std::vector<std::string> writes,
+		std::function<void()> function, JobAffinity affinity /*= JobAffinity::Any*/ )
+	{
+		Task task;
+		task.Name = std::move( name );
+		task.Reads = std::move( reads );
+		task.Writes = std::move( writes );
+		task.Function = std::move( function );
+		task.Affinity = affinity;
+		_Tasks.push_back( std::move( task ) );
+		_Timings.emplace_back();
+		_Compiled = false;
+		return static_cast<TaskId>(_Tasks.size() - 1);
+	}
+
+	void TaskGraph::Clear()
+	{
+		_Tasks.clear();
+		_Timings.clear();
+		_CriticalPath.clear();
+		_CriticalPathDuration = 0.0;
+		_Compiled = false;
+	}
+
+	void TaskGraph::Execute( JobSystem& jobs )
+	{
+		assert( jobs.IsMainThread() && "TaskGraph::Execute must run on the main thread." );
+		if (!_Compiled)
+		{
+			Compile();
+		}
+		for (size_t i = 0; i < _Tasks.size(); ++i)
+		{
+			_Remaining[i].store( static_cast<uint32_t>(_Tasks[i].Dependencies.size()), std::memory_order_relaxed );
+			_Tasks[i].Timing = {};
+		}
+		_Error = nullptr;
+		_Failed.store( false, std::memory_order_relaxed );
+		_ExecuteStart = Clock::now();
+
+		JobCounter counter;
+		for (TaskId task = 0; task < _Tasks.size(); ++task)
+		{
+			if (_Tasks[task].Dependencies.empty())
+			{
+				Launch( jobs, counter, task );
+			}
+		}
+		jobs.Wait( counter );
+
+		FindCriticalPath();
+		if (_Error)
+		{
+			std::rethrow_exception( _Error );
+		}
+	}
+
+	size_t TaskGraph::GetTaskCount() const noexcept
+	{
+		return _Tasks.size();
+	}
+
+	const std::string& TaskGraph::GetTaskName( TaskId task ) const
+	{
+		return _Tasks[task].Name;
+	}
+
+	const std::vector<TaskGraph::TaskId>& TaskGraph::GetDependencies( TaskId task ) const
+	{
+		return _Tasks[task].Dependencies;
+	}
+
+	const TaskGraph::TaskTiming& TaskGraph::GetTiming( TaskId task ) const
+	{
+		return _Timings[task];
+	}
+
+	const std::vector<TaskGraph::TaskId>& TaskGraph::GetCriticalPath() const noexcept
+	{
+		return _CriticalPath;
+	}
+
+	double TaskGraph::GetCriticalPathDuration() const noexcept
+	{
+		return _CriticalPathDuration;
+	}
+
+	void TaskGraph::Dump( std::ostream& stream ) const
+	{
+		stream << "digraph TaskGraph\n{\n\tnode [shape=box];\n";
+		for (TaskId task = 0; task < _Tasks.size(); ++task)
+		{
+			const Task& node = _Tasks[task];
+			stream << "\tt" << task << " [label=\"" << node.Name;
+			if (node.Affinity == JobAffinity::MainThread)
+			{
+				stream << " (main)";
+			}
+			stream << "\\nstart " << _Timings[task].Start * 1000.0 << " ms, took " << _Timings[task].Duration * 1000.0 << " ms";
+			if (!node.Reads.empty())
+			{
+				stream << "\\nreads";
+				for (const auto& resource : node.Reads)
+				{
+					stream << ' ' << resource;
+				}
+			}
+			if (!node.Writes.empty())
+			{
+				stream << "\\nwrites";
+				for (const auto& resource : node.Writes)
+				{
+					stream << ' ' << resource;
+				}
+			}
+			stream << '"';
+			if (_Timings[task].Critical)
+			{
+				stream << ", color=red";
+			}
+			stream << "];\n";
+		}
+		for (TaskId task = 0; task < _Tasks.size(); ++task)
+		{
+			for (TaskId dependency : _Tasks[task].Dependencies)
+			{
+				stream << "\tt" << dependency << " -> t" << task;
+				if (_Timings[task].Critical && _Timings[dependency].Critical)
+				{
+					stream << " [color=red]";
+				}
+				stream << ";\n";
+			}
+		}
+		stream << "}\n";
+	}
+
+	void TaskGraph::Compile()
+	{
+		struct ResourceState
+		{
+			std::optional<TaskId> Writer;
+			std::vector<TaskId> Readers;
+		};
+		std::unordered_map<std::string, ResourceState> resources;
+		for (TaskId task = 0; task < _Tasks.size(); ++task)
+		{
+			Task& node = _Tasks[task];
+			node.Dependencies.clear();
+			node.Dependents.clear();
+			for (const auto& resource : node.Reads)
+			{
+				ResourceState& state = resources[resource];
+				if (state.Writer)
+				{
+					node.Dependencies.push_back( *state.Writer );
+				}
+				state.Readers.push_back( task );
+			}
+			for (const auto& resource : node.Writes)
+			{
+				ResourceState& state = resources[resource];
+				if (state.Writer)
+				{
+					node.Dependencies.push_back( *state.Writer );
+				}
+				for (TaskId reader : state.Readers)
+				{
+					if (reader != task)
+					{
+						node.Dependencies.push_back( reader );
+					}
+				}
+				state.Writer = task;
+				state.Readers.clear();
+			}
+			std::sort( node.Dependencies.begin(), node.Dependencies.end() );
+			node.Dependencies.erase( std::unique( node.Dependencies.begin(), node.Dependencies.end() ), node.Dependencies.end() );
+			// Dependencies always point at earlier tasks, so the task order is a valid run order.
+			for (TaskId dependency : node.Dependencies)
+			{
+				_Tasks[dependency].Dependents.push_back( task );
+			}
+		}
+		_Remaining = std::make_unique<std::atomic<uint32_t>[]>( _Tasks.size() );
+		_Compiled = true;
+	}
+
+	void TaskGraph::Launch( JobSystem& jobs, JobCounter& counter, TaskId task )
+	{
+		jobs.Run( [this, &jobs, &counter, task]() { RunTask( jobs, counter, task ); }, &counter, _Tasks[task].Affinity );
+	}
+
+	void TaskGraph::RunTask( JobSystem& jobs, JobCounter& counter, TaskId task )
+	{
+		Task& node = _Tasks[task];
+		const auto start = Clock::now();
+		if (!_Failed.load( std::memory_order_acquire ))
+		{
+			try
+			{
+				node.Function();
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock( _ErrorMutex );
+				if (!_Error)
+				{
+					_Error = std::current_exception();
+				}
+				_Failed.store( true, std::memory_order_release );
+			}
+		}
+		const auto end = Clock::now();
+		node.Timing.Start = std::chrono::duration<double>( start - _ExecuteStart ).count();
+		node.Timing.Duration = std::chrono::duration<double>( end - start ).count();
+		// Queued before this job finishes, so the counter can't reach zero in between.
+		for (TaskId dependent : node.Dependents)
+		{
+			if (_Remaining[dependent].fetch_sub( 1, std::memory_order_acq_rel ) == 1)
+			{
+				Launch( jobs, counter, dependent );
+			}
+		}
+	}
+
+	void TaskGraph::FindCriticalPath()
+	{
+		_CriticalPath.clear();
+		_CriticalPathDuration = 0.0;
+		// Published once every task is done, the tasks of the next Execute read them while it runs.
+		for (TaskId task = 0; task < _Tasks.size(); ++task)
+		{
+			_Timings[task] = _Tasks[task].Timing;
+		}
+		if (_Tasks.empty())
+		{
+			return;
+		}
+		// Longest chain by duration, in task order since that is a topological order.
+		std::vector<double> finish( _Tasks.size(), 0.0 );
+		std::vector<std::optional<TaskId>> previous( _Tasks.size() );
+		TaskId last = 0;
+		for (TaskId task = 0; task < _Tasks.size(); ++task)
+		{
+			double start = 0.0;
+			for (TaskId dependency : _Tasks[task].Dependencies)
+			{
+				if (finish[dependency] > start)
+				{
+					start = finish[dependency];
+					previous[task] = dependency;
+				}
+			}
+			finish[task] = start + _Tasks[task].Timing.Duration;
+			if (finish[task] > finish[last])
+			{
+				last = task;
+			}
+		}
+		_CriticalPathDuration = finish[last];
+		for (std::optional<TaskId> task = last; task; task = previous[*task])
+		{
+			_Timings[*task].Critical = true;
+			_CriticalPath.push_back( *task );
+		}
+		std::reverse( _CriticalPath.begin(), _CriticalPath.end() );
+	}
+}
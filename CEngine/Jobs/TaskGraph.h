@@ -0,0 +1,102 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+#include "Common/CommonHeaders.h"
+#include "JobSystem.h"
+#include <exception>
+#include <functional>
+#include <ostream>
+
+namespace CronoEngine
+{
+	/**
+	 * Declarative list of tasks that run once per Execute. Every task names the resources it
+	 * reads and writes; a task waits for the last earlier writer of everything it touches and,
+	 * when it writes, for the earlier readers too. Tasks without a conflict run concurrently
+	 * on the job system, so declaration order only matters between tasks that share a resource.
+	 */
+	class TaskGraph
+	{
+	public:
+		using TaskId = uint32_t;
+
+		struct TaskTiming
+		{
+			// Seconds since the start of the last Execute.
+			double Start = 0.0;
+			double Duration = 0.0;
+			bool Critical = false;
+		};
+	public:
+		TaskGraph() = default;
+		TaskGraph( const TaskGraph& ) = delete;
+		TaskGraph& operator=( const TaskGraph& ) = delete;
+
+		TaskId AddTask( std::string name, std::vector<std::string> reads, std::vector<std::string> writes,
+			std::function<void()> function, JobAffinity affinity = JobAffinity::Any );
+		void Clear();
+
+		// Runs every task once and waits for all of them, from the main thread. If a task throws,
+		// the tasks after it are skipped and the first exception is rethrown here.
+		void Execute( JobSystem& jobs );
+
+		size_t GetTaskCount() const noexcept;
+		const std::string& GetTaskName( TaskId task ) const;
+		const std::vector<TaskId>& GetDependencies( TaskId task ) const;
+		// Timings of the last finished Execute, so tasks of the running one may read them.
+		const TaskTiming& GetTiming( TaskId task ) const;
+		// The chain of dependent tasks that took the longest in the last Execute, in run order.
+		const std::vector<TaskId>& GetCriticalPath() const noexcept;
+		double GetCriticalPathDuration() const noexcept;
+		// Writes the graph in Graphviz dot format, with the last timings and the critical path in red.
+		void Dump( std::ostream& stream ) const;
+	private:
+		struct Task
+		{
+			std::string Name;
+			std::vector<std::string> Reads;
+			std::vector<std::string> Writes;
+			std::function<void()> Function;
+			JobAffinity Affinity = JobAffinity::Any;
+			std::vector<TaskId> Dependencies;
+			std::vector<TaskId> Dependents;
+			// Of the running Execute, copied to _Timings once it finishes.
+			TaskTiming Timing;
+		};
+
+		void Compile();
+		void Launch( JobSystem& jobs, JobCounter& counter, TaskId task );
+		void RunTask( JobSystem& jobs, JobCounter& counter, TaskId task );
+		void FindCriticalPath();
+	private:
+		using Clock = std::chrono::steady_clock;
+		std::vector<Task> _Tasks;
+		bool _Compiled = false;
+		// Unfinished dependencies of each task during Execute.
+		std::unique_ptr<std::atomic<uint32_t>[]> _Remaining;
+		Clock::time_point _ExecuteStart;
+		std::mutex _ErrorMutex;
+		std::exception_ptr _Error;
+		std::atomic<bool> _Failed = false;
+		std::vector<TaskTiming> _Timings;
+		std::vector<TaskId> _CriticalPath;
+		double _CriticalPathDuration = 0.0;
+	};
+}
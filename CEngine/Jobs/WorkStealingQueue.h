@@ -0,0 +1,115 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+namespace CronoEngine
+{
+	/**
+	 * Chase-Lev work-stealing deque of pointers (Le, Pop, Cohen, Zappa Nardelli, PPoPP 2013).
+	 * The owning thread pushes and pops at the bottom (LIFO, cache warm), any other thread
+	 * steals from the top (FIFO). Fixed capacity, Push fails when full.
+	 */
+	template<typename T>
+	class WorkStealingQueue
+	{
+		static_assert(std::is_pointer_v<T>, "WorkStealingQueue stores pointers.");
+	public:
+		explicit WorkStealingQueue( size_t capacity )
+			:
+			mask( static_cast<int64_t>(capacity) - 1 ),
+			buffer( std::make_unique<std::atomic<T>[]>( capacity ) )
+		{
+			assert( capacity > 1 && (capacity & (capacity - 1)) == 0 && "Capacity must be a power of two." );
+		}
+		WorkStealingQueue( const WorkStealingQueue& ) = delete;
+		WorkStealingQueue& operator=( const WorkStealingQueue& ) = delete;
+
+		// Owner only.
+		bool Push( T item ) noexcept
+		{
+			const int64_t b = bottom.load( std::memory_order_relaxed );
+			const int64_t t = top.load( std::memory_order_acquire );
+			if (b - t > mask)
+			{
+				return false;
+			}
+			buffer[b & mask].store( item, std::memory_order_relaxed );
+			// Publishes the item to thieves that acquire bottom.
+			bottom.store( b + 1, std::memory_order_release );
+			return true;
+		}
+		// Owner only, nullptr when empty.
+		T Pop() noexcept
+		{
+			const int64_t b = bottom.load( std::memory_order_relaxed ) - 1;
+			bottom.store( b, std::memory_order_relaxed );
+			std::atomic_thread_fence( std::memory_order_seq_cst );
+			int64_t t = top.load( std::memory_order_relaxed );
+			if (t > b)
+			{
+				bottom.store( b + 1, std::memory_order_relaxed );
+				return nullptr;
+			}
+			T item = buffer[b & mask].load( std::memory_order_relaxed );
+			if (t == b)
+			{
+				// Last item, race the thieves for it.
+				if (!top.compare_exchange_strong( t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed ))
+				{
+					item = nullptr;
+				}
+				bottom.store( b + 1, std::memory_order_relaxed );
+			}
+			return item;
+		}
+		// Any thread, nullptr when empty or when another thread won the race.
+		T Steal() noexcept
+		{
+			int64_t t = top.load( std::memory_order_acquire );
+			std::atomic_thread_fence( std::memory_order_seq_cst );
+			const int64_t b = bottom.load( std::memory_order_acquire );
+			if (t >= b)
+			{
+				return nullptr;
+			}
+			T item = buffer[t & mask].load( std::memory_order_relaxed );
+			if (!top.compare_exchange_strong( t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed ))
+			{
+				return nullptr;
+			}
+			return item;
+		}
+		bool IsEmpty() const noexcept
+		{
+			return bottom.load( std::memory_order_relaxed ) <= top.load( std::memory_order_relaxed );
+		}
+	private:
+		// Owner and thieves hammer different ends, keep them on separate cache lines.
+		alignas(64) std::atomic<int64_t> top = 0;
+		alignas(64) std::atomic<int64_t> bottom = 0;
+		int64_t mask;
+		std::unique_ptr<std::atomic<T>[]> buffer;
+	};
+}
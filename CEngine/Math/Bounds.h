@@ -0,0 +1,189 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+#include "Matrix.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace CronoEngine
+{
+	namespace Math
+	{
+		// Axis aligned box, Min <= Max on every axis.
+		struct Aabb
+		{
+			Float3 Min;
+			Float3 Max;
+		};
+
+		struct Ray
+		{
+			Float3 Origin;
+			// Doesn't need to be normalized, distances are in multiples of it.
+			Float3 Direction;
+			float MaxDistance = FLT_MAX;
+		};
+
+		// Planes (a, b, c, d) facing inwards: a point p is inside when a*x + b*y + c*z + d >= 0 for all six.
+		struct Frustum
+		{
+			Float4 Planes[6];
+		};
+
+		enum class Containment
+		{
+			Disjoint,
+			Intersects,
+			Contains,
+		};
+
+		inline Aabb AabbFromCenterExtents( const Float3& center, const Float3& extents ) noexcept
+		{
+			return { { center.x - extents.x, center.y - extents.y, center.z - extents.z },
+				{ center.x + extents.x, center.y + extents.y, center.z + extents.z } };
+		}
+
+		inline Aabb AabbUnion( const Aabb& a, const Aabb& b ) noexcept
+		{
+			return { { std::min( a.Min.x, b.Min.x ), std::min( a.Min.y, b.Min.y ), std::min( a.Min.z, b.Min.z ) },
+				{ std::max( a.Max.x, b.Max.x ), std::max( a.Max.y, b.Max.y ), std::max( a.Max.z, b.Max.z ) } };
+		}
+
+		// Half of it really, which is all the SAH needs.
+		inline float AabbSurfaceArea( const Aabb& box ) noexcept
+		{
+			const float x = box.Max.x - box.Min.x;
+			const float y = box.Max.y - box.Min.y;
+			const float z = box.Max.z - box.Min.z;
+			return x * y + y * z + z * x;
+		}
+
+		inline bool AabbOverlaps( const Aabb& a, const Aabb& b ) noexcept
+		{
+			return a.Min.x <= b.Max.x && a.Max.x >= b.Min.x &&
+				a.Min.y <= b.Max.y && a.Max.y >= b.Min.y &&
+				a.Min.z <= b.Max.z && a.Max.z >= b.Min.z;
+		}
+
+		inline bool AabbContains( const Aabb& outer, const Aabb& inner ) noexcept
+		{
+			return outer.Min.x <= inner.Min.x && outer.Min.y <= inner.Min.y && outer.Min.z <= inner.Min.z &&
+				outer.Max.x >= inner.Max.x && outer.Max.y >= inner.Max.y && outer.Max.z >= inner.Max.z;
+		}
+
+		inline bool AabbEqual( const Aabb& a, const Aabb& b ) noexcept
+		{
+			return a.Min.x == b.Min.x && a.Min.y == b.Min.y && a.Min.z == b.Min.z &&
+				a.Max.x == b.Max.x && a.Max.y == b.Max.y && a.Max.z == b.Max.z;
+		}
+
+		// Bounds of the box after m (row vectors), from its transformed center and the absolute 3x3 part.
+		inline Aabb AabbTransform( const Aabb& box, const Matrix& m ) noexcept
+		{
+			const Vector min = LoadFloat3( &box.Min );
+			const Vector max = LoadFloat3( &box.Max );
+			const Vector half = VectorReplicate( 0.5f );
+			const Vector center = Vector3Transform( VectorMultiply( VectorAdd( min, max ), half ), m );
+			const Vector extents = VectorMultiply( VectorSubtract( max, min ), half );
+			Vector newExtents = VectorMultiply( VectorSplatX( extents ), VectorAbs( m.r[0] ) );
+			newExtents = VectorMultiplyAdd( VectorSplatY( extents ), VectorAbs( m.r[1] ), newExtents );
+			newExtents = VectorMultiplyAdd( VectorSplatZ( extents ), VectorAbs( m.r[2] ), newExtents );
+			Aabb result;
+			StoreFloat3( &result.Min, VectorSubtract( center, newExtents ) );
+			StoreFloat3( &result.Max, VectorAdd( center, newExtents ) );
+			return result;
+		}
+
+		/**
+		 * The planes of a view * projection matrix (row vectors, D3D depth from 0 to 1), normalized.
+		 * Order: left, right, bottom, top, near, far.
+		 */
+		inline Frustum FrustumFromMatrix( const Float4x4& viewProjection ) noexcept
+		{
+			const auto& m = viewProjection.m;
+			auto column = [&m]( int j ) { return Float4( m[0][j], m[1][j], m[2][j], m[3][j] ); };
+			const Float4 x = column( 0 );
+			const Float4 y = column( 1 );
+			const Float4 z = column( 2 );
+			const Float4 w = column( 3 );
+			Frustum frustum;
+			frustum.Planes[0] = { w.x + x.x, w.y + x.y, w.z + x.z, w.w + x.w };
+			frustum.Planes[1] = { w.x - x.x, w.y - x.y, w.z - x.z, w.w - x.w };
+			frustum.Planes[2] = { w.x + y.x, w.y + y.y, w.z + y.z, w.w + y.w };
+			frustum.Planes[3] = { w.x - y.x, w.y - y.y, w.z - y.z, w.w - y.w };
+			frustum.Planes[4] = z;
+			frustum.Planes[5] = { w.x - z.x, w.y - z.y, w.z - z.z, w.w - z.w };
+			for (Float4& plane : frustum.Planes)
+			{
+				const float length = std::sqrt( plane.x * plane.x + plane.y * plane.y + plane.z * plane.z );
+				const float scale = length > 0.0f ? 1.0f / length : 0.0f;
+				plane = { plane.x * scale, plane.y * scale, plane.z * scale, plane.w * scale };
+			}
+			return frustum;
+		}
+
+		inline Containment FrustumContainsAabb( const Frustum& frustum, const Aabb& box ) noexcept
+		{
+			const float cx = (box.Min.x + box.Max.x) * 0.5f;
+			const float cy = (box.Min.y + box.Max.y) * 0.5f;
+			const float cz = (box.Min.z + box.Max.z) * 0.5f;
+			const float ex = (box.Max.x - box.Min.x) * 0.5f;
+			const float ey = (box.Max.y - box.Min.y) * 0.5f;
+			const float ez = (box.Max.z - box.Min.z) * 0.5f;
+			Containment result = Containment::Contains;
+			for (const Float4& plane : frustum.Planes)
+			{
+				const float distance = plane.x * cx + plane.y * cy + plane.z * cz + plane.w;
+				const float radius = std::abs( plane.x ) * ex + std::abs( plane.y ) * ey + std::abs( plane.z ) * ez;
+				if (distance < -radius)
+				{
+					return Containment::Disjoint;
+				}
+				if (distance < radius)
+				{
+					result = Containment::Intersects;
+				}
+			}
+			return result;
+		}
+
+		// 1 / direction per axis, what RayIntersectsAabb takes so it is done once per ray.
+		inline Float3 RayInverseDirection( const Ray& ray ) noexcept
+		{
+			return { 1.0f / ray.Direction.x, 1.0f / ray.Direction.y, 1.0f / ray.Direction.z };
+		}
+
+		// Slab test, distance is where the ray enters the box (0 when it starts inside).
+		inline bool RayIntersectsAabb( const Ray& ray, const Float3& inverseDirection, const Aabb& box, float& distance ) noexcept
+		{
+			const float x0 = (box.Min.x - ray.Origin.x) * inverseDirection.x;
+			const float x1 = (box.Max.x - ray.Origin.x) * inverseDirection.x;
+			const float y0 = (box.Min.y - ray.Origin.y) * inverseDirection.y;
+			const float y1 = (box.Max.y - ray.Origin.y) * inverseDirection.y;
+			const float z0 = (box.Min.z - ray.Origin.z) * inverseDirection.z;
+			const float z1 = (box.Max.z - ray.Origin.z) * inverseDirection.z;
+			const float enter = std::max( { std::min( x0, x1 ), std::min( y0, y1 ), std::min( z0, z1 ), 0.0f } );
+			const float exit = std::min( { std::max( x0, x1 ), std::max( y0, y1 ), std::max( z0, z1 ), ray.MaxDistance } );
+			distance = enter;
+			return enter <= exit;
+		}
+	}
+}
@@ -0,0 +1,110 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "Math.h"
+#if defined(CRONO_MATH_SSE2)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace CronoEngine
+{
+	namespace Math
+	{
+#if defined(CRONO_MATH_SSE2)
+		namespace
+		{
+			void CpuId( int registers[4], int leaf ) noexcept
+			{
+#if defined(_MSC_VER)
+				__cpuidex( registers, leaf, 0 );
+#else
+				unsigned int a, b, c, d;
+				__cpuid_count( leaf, 0, a, b, c, d );
+				registers[0] = static_cast<int>(a);
+				registers[1] = static_cast<int>(b);
+				registers[2] = static_cast<int>(c);
+				registers[3] = static_cast<int>(d);
+#endif
+			}
+
+			// The OS saves the AVX registers on context switches (XCR0 bits 1 and 2).
+			bool OSSavesAVXState() noexcept
+			{
+#if defined(_MSC_VER)
+				return (_xgetbv( 0 ) & 0x6) == 0x6;
+#else
+				unsigned int eax, edx;
+				__asm__( "xgetbv" : "=a"(eax), "=d"(edx) : "c"(0) );
+				return (eax & 0x6) == 0x6;
+#endif
+			}
+		}
+#endif
+
+		bool VerifyCPUSupport() noexcept
+		{
+#if defined(CRONO_MATH_SSE2)
+			int registers[4] = {};
+			CpuId( registers, 0 );
+			const int maxLeaf = registers[0];
+			if (maxLeaf < 1)
+			{
+				return false;
+			}
+			CpuId( registers, 1 );
+			const bool sse2 = (registers[3] & (1 << 26)) != 0;
+			const bool sse41 = (registers[2] & (1 << 19)) != 0;
+			const bool fma = (registers[2] & (1 << 12)) != 0;
+			const bool osxsave = (registers[2] & (1 << 27)) != 0;
+			const bool avx = (registers[2] & (1 << 28)) != 0 && osxsave && OSSavesAVXState();
+			bool avx2 = false;
+			if (maxLeaf >= 7)
+			{
+				CpuId( registers, 7 );
+				avx2 = (registers[1] & (1 << 5)) != 0;
+			}
+			if (!sse2)
+			{
+				return false;
+			}
+#if defined(CRONO_MATH_SSE4)
+			if (!sse41)
+			{
+				return false;
+			}
+#endif
+#if defined(CRONO_MATH_AVX2)
+			if (!avx || !avx2 || !fma)
+			{
+				return false;
+			}
+#endif
+			(void)sse41;
+			(void)fma;
+			(void)avx;
+			(void)avx2;
+#endif
+			return true;
+		}
+	}
+}
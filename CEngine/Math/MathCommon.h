@@ -0,0 +1,126 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+// Instruction sets, picked from the compiler flags. Define CRONO_MATH_NO_INTRINSICS to force the scalar path.
+#if !defined(CRONO_MATH_NO_INTRINSICS)
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CRONO_MATH_SSE2 1
+#endif
+// MSVC has no SSE4 switch, /arch:AVX implies it.
+#if defined(CRONO_MATH_SSE2) && (defined(__SSE4_1__) || defined(__AVX__))
+#define CRONO_MATH_SSE4 1
+#endif
+// AVX2 builds also get FMA, like DirectXMath.
+#if defined(CRONO_MATH_SSE4) && defined(__AVX2__)
+#define CRONO_MATH_AVX2 1
+#endif
+#endif
+
+#if defined(CRONO_MATH_AVX2)
+#include <immintrin.h>
+#elif defined(CRONO_MATH_SSE4)
+#include <smmintrin.h>
+#elif defined(CRONO_MATH_SSE2)
+#include <emmintrin.h>
+#endif
+
+namespace CronoEngine
+{
+	namespace Math
+	{
+		constexpr float Pi = 3.141592654f;
+		constexpr float TwoPi = 6.283185307f;
+		constexpr float OneOverPi = 0.318309886f;
+		constexpr float OneOverTwoPi = 0.159154943f;
+		constexpr float PiOverTwo = 1.570796327f;
+		constexpr float PiOverFour = 0.785398163f;
+
+		constexpr float ConvertToRadians( float degrees ) noexcept
+		{
+			return degrees * (Pi / 180.0f);
+		}
+		constexpr float ConvertToDegrees( float radians ) noexcept
+		{
+			return radians * (180.0f / Pi);
+		}
+
+		// Storage types: plain structs for members and buffers. Load them into a Vector/Matrix
+		// to do math, the A variants are 16 byte aligned and load faster.
+		struct Float2
+		{
+			float x = 0.0f;
+			float y = 0.0f;
+
+			Float2() = default;
+			constexpr Float2( float x, float y ) noexcept : x( x ), y( y ) {}
+		};
+
+		struct Float3
+		{
+			float x = 0.0f;
+			float y = 0.0f;
+			float z = 0.0f;
+
+			Float3() = default;
+			constexpr Float3( float x, float y, float z ) noexcept : x( x ), y( y ), z( z ) {}
+		};
+
+		struct alignas(16) Float3A : public Float3
+		{
+			using Float3::Float3;
+			Float3A() = default;
+			constexpr Float3A( const Float3& other ) noexcept : Float3( other ) {}
+		};
+
+		struct Float4
+		{
+			float x = 0.0f;
+			float y = 0.0f;
+			float z = 0.0f;
+			float w = 0.0f;
+
+			Float4() = default;
+			constexpr Float4( float x, float y, float z, float w ) noexcept : x( x ), y( y ), z( z ), w( w ) {}
+		};
+
+		struct alignas(16) Float4A : public Float4
+		{
+			using Float4::Float4;
+			Float4A() = default;
+			constexpr Float4A( const Float4& other ) noexcept : Float4( other ) {}
+		};
+
+		// Row major, row vectors (v * M), same layout as DirectXMath's XMFLOAT4X4.
+		struct Float4x4
+		{
+			float m[4][4] = {};
+		};
+
+		struct alignas(16) Float4x4A : public Float4x4
+		{
+		};
+
+		// Checks the running CPU supports the instruction sets this build was compiled for.
+		bool VerifyCPUSupport() noexcept;
+	}
+}
@@ -0,0 +1,184 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+#include "Quaternion.h"
+
+namespace CronoEngine
+{
+	namespace Math
+	{
+		/**
+		 * 4x4 matrix as four row Vectors. Row vectors times matrix (v * M), so transforms
+		 * compose left to right: scale * rotation * translation.
+		 */
+		struct Matrix
+		{
+			Vector r[4];
+		};
+
+		inline Matrix MatrixIdentity() noexcept
+		{
+			return { { VectorSet( 1.0f, 0.0f, 0.0f, 0.0f ), VectorSet( 0.0f, 1.0f, 0.0f, 0.0f ),
+				VectorSet( 0.0f, 0.0f, 1.0f, 0.0f ), VectorSet( 0.0f, 0.0f, 0.0f, 1.0f ) } };
+		}
+
+		inline Matrix LoadFloat4x4( const Float4x4* source ) noexcept
+		{
+			Matrix m;
+			for (int i = 0; i < 4; ++i)
+			{
+				m.r[i] = VectorLoad4( source->m[i] );
+			}
+			return m;
+		}
+
+		inline Matrix LoadFloat4x4A( const Float4x4A* source ) noexcept
+		{
+			Matrix m;
+			for (int i = 0; i < 4; ++i)
+			{
+				m.r[i] = VectorLoad4A( source->m[i] );
+			}
+			return m;
+		}
+
+		inline void StoreFloat4x4( Float4x4* destination, const Matrix& m ) noexcept
+		{
+			for (int i = 0; i < 4; ++i)
+			{
+				VectorStore4( destination->m[i], m.r[i] );
+			}
+		}
+
+		inline void StoreFloat4x4A( Float4x4A* destination, const Matrix& m ) noexcept
+		{
+			for (int i = 0; i < 4; ++i)
+			{
+				VectorStore4A( destination->m[i], m.r[i] );
+			}
+		}
+
+		inline Matrix MatrixMultiply( const Matrix& a, const Matrix& b ) noexcept
+		{
+			Matrix result;
+			for (int i = 0; i < 4; ++i)
+			{
+				const Vector x = VectorMultiply( VectorSplatX( a.r[i] ), b.r[0] );
+				const Vector y = VectorMultiply( VectorSplatY( a.r[i] ), b.r[1] );
+				const Vector z = VectorMultiply( VectorSplatZ( a.r[i] ), b.r[2] );
+				const Vector w = VectorMultiply( VectorSplatW( a.r[i] ), b.r[3] );
+				result.r[i] = VectorAdd( VectorAdd( x, z ), VectorAdd( y, w ) );
+			}
+			return result;
+		}
+
+		inline Matrix MatrixTranspose( const Matrix& m ) noexcept
+		{
+			const Vector t0 = VectorPermute<0, 1, 4, 5>( m.r[0], m.r[1] );
+			const Vector t1 = VectorPermute<2, 3, 6, 7>( m.r[0], m.r[1] );
+			const Vector t2 = VectorPermute<0, 1, 4, 5>( m.r[2], m.r[3] );
+			const Vector t3 = VectorPermute<2, 3, 6, 7>( m.r[2], m.r[3] );
+			return { { VectorPermute<0, 2, 4, 6>( t0, t2 ), VectorPermute<1, 3, 5, 7>( t0, t2 ),
+				VectorPermute<0, 2, 4, 6>( t1, t3 ), VectorPermute<1, 3, 5, 7>( t1, t3 ) } };
+		}
+
+		inline Matrix MatrixScaling( float x, float y, float z ) noexcept
+		{
+			return { { VectorSet( x, 0.0f, 0.0f, 0.0f ), VectorSet( 0.0f, y, 0.0f, 0.0f ),
+				VectorSet( 0.0f, 0.0f, z, 0.0f ), VectorSet( 0.0f, 0.0f, 0.0f, 1.0f ) } };
+		}
+
+		inline Matrix MatrixScalingFromVector( Vector scale ) noexcept
+		{
+			const Vector zero = VectorZero();
+			return { { VectorPermute<0, 4, 4, 4>( scale, zero ), VectorPermute<4, 1, 4, 4>( scale, zero ),
+				VectorPermute<4, 4, 2, 4>( scale, zero ), VectorSet( 0.0f, 0.0f, 0.0f, 1.0f ) } };
+		}
+
+		inline Matrix MatrixTranslation( float x, float y, float z ) noexcept
+		{
+			Matrix m = MatrixIdentity();
+			m.r[3] = VectorSet( x, y, z, 1.0f );
+			return m;
+		}
+
+		inline Matrix MatrixTranslationFromVector( Vector translation ) noexcept
+		{
+			Matrix m = MatrixIdentity();
+			m.r[3] = VectorPermute<0, 1, 2, 7>( translation, VectorSet( 0.0f, 0.0f, 0.0f, 1.0f ) );
+			return m;
+		}
+
+		// Same operations as XMMatrixRotationQuaternion.
+		inline Matrix MatrixRotationQuaternion( Vector q ) noexcept
+		{
+			const Vector constant1110 = VectorSet( 1.0f, 1.0f, 1.0f, 0.0f );
+			const Vector q0 = VectorAdd( q, q );
+			const Vector q1 = VectorMultiply( q, q0 );
+
+			Vector v0 = VectorPermute<1, 0, 0, 7>( q1, constant1110 );
+			Vector v1 = VectorPermute<2, 2, 1, 7>( q1, constant1110 );
+			Vector r0 = VectorSubtract( constant1110, v0 );
+			r0 = VectorSubtract( r0, v1 );
+
+			v0 = VectorMultiply( VectorSwizzle<0, 0, 1, 3>( q ), VectorSwizzle<2, 1, 2, 3>( q0 ) );
+			v1 = VectorMultiply( VectorSplatW( q ), VectorSwizzle<1, 2, 0, 3>( q0 ) );
+			const Vector r1 = VectorAdd( v0, v1 );
+			const Vector r2 = VectorSubtract( v0, v1 );
+
+			v0 = VectorPermute<1, 4, 5, 2>( r1, r2 );
+			v1 = VectorPermute<0, 6, 0, 6>( r1, r2 );
+			return { { VectorPermute<0, 4, 5, 3>( r0, v0 ), VectorPermute<6, 1, 7, 3>( r0, v0 ),
+				VectorPermute<4, 5, 2, 3>( r0, v1 ), VectorSet( 0.0f, 0.0f, 0.0f, 1.0f ) } };
+		}
+
+		// scale * rotation * translation, like XMMatrixAffineTransformation with a zero rotation origin.
+		inline Matrix MatrixAffineTransformation( Vector scale, Vector rotation, Vector translation ) noexcept
+		{
+			Matrix m = MatrixMultiply( MatrixScalingFromVector( scale ), MatrixRotationQuaternion( rotation ) );
+			m.r[3] = VectorAdd( m.r[3], VectorSelect( VectorZero(), translation, VectorSetInt( 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu, 0u ) ) );
+			return m;
+		}
+
+		// Transforms the point (x, y, z, 1).
+		inline Vector Vector3Transform( Vector v, const Matrix& m ) noexcept
+		{
+			Vector result = VectorMultiplyAdd( VectorSplatZ( v ), m.r[2], m.r[3] );
+			result = VectorMultiplyAdd( VectorSplatY( v ), m.r[1], result );
+			return VectorMultiplyAdd( VectorSplatX( v ), m.r[0], result );
+		}
+
+		// Transforms the direction (x, y, z, 0).
+		inline Vector Vector3TransformNormal( Vector v, const Matrix& m ) noexcept
+		{
+			Vector result = VectorMultiply( VectorSplatZ( v ), m.r[2] );
+			result = VectorMultiplyAdd( VectorSplatY( v ), m.r[1], result );
+			return VectorMultiplyAdd( VectorSplatX( v ), m.r[0], result );
+		}
+
+		inline Vector Vector4Transform( Vector v, const Matrix& m ) noexcept
+		{
+			Vector result = VectorMultiply( VectorSplatW( v ), m.r[3] );
+			result = VectorMultiplyAdd( VectorSplatZ( v ), m.r[2], result );
+			result = VectorMultiplyAdd( VectorSplatY( v ), m.r[1], result );
+			return VectorMultiplyAdd( VectorSplatX( v ), m.r[0], result );
+		}
+	}
+}
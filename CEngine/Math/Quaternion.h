@@ -0,0 +1,92 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+#include "Vector.h"
+
+namespace CronoEngine
+{
+	namespace Math
+	{
+		// Quaternions are Vectors laid out (x, y, z, w) with w the real part.
+
+		inline Vector QuaternionIdentity() noexcept
+		{
+			return VectorSet( 0.0f, 0.0f, 0.0f, 1.0f );
+		}
+
+		/**
+		 * Rotation from Euler angles in radians: roll around Z first, then pitch around X,
+		 * then yaw around Y. Same operations as XMQuaternionRotationRollPitchYawFromVector.
+		 */
+		inline Vector QuaternionRotationRollPitchYawFromVector( Vector angles ) noexcept
+		{
+			Vector sinAngles, cosAngles;
+			VectorSinCos( &sinAngles, &cosAngles, VectorMultiply( angles, VectorReplicate( 0.5f ) ) );
+
+			const Vector p0 = VectorPermute<0, 4, 4, 4>( sinAngles, cosAngles );
+			const Vector y0 = VectorPermute<5, 1, 5, 5>( sinAngles, cosAngles );
+			const Vector r0 = VectorPermute<6, 6, 2, 6>( sinAngles, cosAngles );
+			const Vector p1 = VectorPermute<0, 4, 4, 4>( cosAngles, sinAngles );
+			const Vector y1 = VectorPermute<5, 1, 5, 5>( cosAngles, sinAngles );
+			const Vector r1 = VectorPermute<6, 6, 2, 6>( cosAngles, sinAngles );
+
+			Vector q1 = VectorMultiply( p1, VectorSet( 1.0f, -1.0f, -1.0f, 1.0f ) );
+			Vector q0 = VectorMultiply( p0, y0 );
+			q1 = VectorMultiply( q1, y1 );
+			q0 = VectorMultiply( q0, r0 );
+			return VectorMultiplyAdd( q1, r1, q0 );
+		}
+
+		inline Vector QuaternionRotationRollPitchYaw( float pitch, float yaw, float roll ) noexcept
+		{
+			return QuaternionRotationRollPitchYawFromVector( VectorSet( pitch, yaw, roll, 0.0f ) );
+		}
+
+		// Rotation q1 followed by q2, i.e. the product q2 * q1 (same order as XMQuaternionMultiply).
+		inline Vector QuaternionMultiply( Vector q1, Vector q2 ) noexcept
+		{
+			Vector result = VectorMultiply( VectorSplatW( q2 ), q1 );
+			const Vector q1WZYX = VectorSwizzle<3, 2, 1, 0>( q1 );
+			const Vector q1ZWXY = VectorSwizzle<2, 3, 0, 1>( q1 );
+			const Vector q1YXWZ = VectorSwizzle<1, 0, 3, 2>( q1 );
+			result = VectorMultiplyAdd( VectorMultiply( VectorSplatX( q2 ), q1WZYX ), VectorSet( 1.0f, -1.0f, 1.0f, -1.0f ), result );
+			Vector y = VectorMultiply( VectorMultiply( VectorSplatY( q2 ), q1ZWXY ), VectorSet( 1.0f, 1.0f, -1.0f, -1.0f ) );
+			y = VectorMultiplyAdd( VectorMultiply( VectorSplatZ( q2 ), q1YXWZ ), VectorSet( -1.0f, 1.0f, 1.0f, -1.0f ), y );
+			return VectorAdd( result, y );
+		}
+
+		inline Vector QuaternionConjugate( Vector q ) noexcept
+		{
+			return VectorMultiply( q, VectorSet( -1.0f, -1.0f, -1.0f, 1.0f ) );
+		}
+
+		inline Vector QuaternionNormalize( Vector q ) noexcept
+		{
+			return Vector4Normalize( q );
+		}
+
+		// Rotates v by the unit quaternion q.
+		inline Vector Vector3Rotate( Vector v, Vector q ) noexcept
+		{
+			const Vector a = VectorSelect( VectorZero(), v, VectorSetInt( 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu, 0u ) );
+			return QuaternionMultiply( QuaternionMultiply( QuaternionConjugate( q ), a ), q );
+		}
+	}
+}
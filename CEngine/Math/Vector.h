@@ -0,0 +1,547 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+#include "MathCommon.h"
+#include <cmath>
+
+namespace CronoEngine
+{
+	namespace Math
+	{
+		/**
+		 * Four floats in a SIMD register, or a plain array on the scalar path. Pass by value.
+		 * Functions above the primitive section are written once on top of the primitives,
+		 * so every backend does the same operations in the same order.
+		 */
+#if defined(CRONO_MATH_SSE2)
+		using Vector = __m128;
+#else
+		struct alignas(16) Vector
+		{
+			float f[4];
+		};
+#endif
+
+		/* Primitives, one implementation per backend. */
+
+		inline Vector VectorZero() noexcept
+		{
+#if defined(CRONO_MATH_SSE2)
+			return _mm_setzero_ps();
+#else
+			return { { 0.0f, 0.0f, 0.0f, 0.0f } };
+#endif
+		}
+
+		inline Vector VectorSet( float x, float y, float z, float w ) noexcept
+		{
+#if defined(CRONO_MATH_SSE2)
+			return _mm_setr_ps( x, y, z, w );
+#else
+			return { { x, y, z, w } };
+#endif
+		}
+
+		inline Vector VectorReplicate( float value ) noexcept
+		{
+#if defined(CRONO_MATH_SSE2)
+			return _mm_set1_ps( value );
+#else
+			return { { value, value, value, value } };
+#endif
+		}
+
+		// Integer bit patterns, for masks and sign tricks.
+		inline Vector VectorSetInt( uint32_t x, uint32_t y, uint32_t z, uint32_t w ) noexcept
+		{
+#if defined(CRONO_MATH_SSE2)
+			return _mm_castsi128_ps( _mm_setr_epi32( static_cast<int>(x), static_cast<int>(y), static_cast<int>(z), static_cast<int>(w) ) );
+#else
+			const uint32_t bits[4] = { x, y, z, w };
+			Vector result;
+			std::memcpy( result.f, bits, sizeof( bits ) );
+			return result;
+#endif
+		}
+
+		inline Vector VectorReplicateInt( uint32_t value ) noexcept
+		{
+			return VectorSetInt( value, value, value, value );
+		}
+
+		inline float VectorGetX( Vector v ) noexcept
+		{
+#if defined(CRONO_MATH_SSE2)
+			return _mm_cvtss_f32( v );
+#else
+			return v.f[0];
+#endif
+		}
+
+		// Lanes 0-3 of v in any order.
+		template<uint32_t X, uint32_t Y, uint32_t Z, uint32_t W>
+		inline Vector VectorSwizzle( Vector v ) noexcept
+		{
+			static_assert( X < 4 && Y < 4 && Z < 4 && W < 4, "Swizzle indices must be 0-3." );
+#if defined(CRONO_MATH_SSE2)
+			return _mm_shuffle_ps( v, v, _MM_SHUFFLE( W, Z, Y, X ) );
+#else
+			return { { v.f[X], v.f[Y], v.f[Z], v.f[W] } };
+#endif
+		}
+
+		// Per lane: mask bits set take b, clear take a.
+		inline Vector VectorSelect( Vector a, Vector b, Vector mask ) noexcept
+		{
+#if defined(CRONO_MATH_SSE4)
+			return _mm_blendv_ps( a, b, mask );
+#elif defined(CRONO_MATH_SSE2)
+			return _mm_or_ps( _mm_andnot_ps( mask, a ), _mm_and_ps( b, mask ) );
+#else
+			uint32_t ia[4], ib[4], im[4];
+			std::memcpy( ia, a.f, sizeof( ia ) );
+			std::memcpy( ib, b.f, sizeof( ib ) );
+			std::memcpy( im, mask.f, sizeof( im ) );
+			for (int i = 0; i < 4; ++i)
+			{
+				ia[i] = (ia[i] & ~im[i]) | (ib[i] & im[i]);
+			}
+			Vector result;
+			std::memcpy( result.f, ia, sizeof( ia ) );
+			return result;
+#endif
+		}
+
+		inline Vector VectorAndInt( Vector a, Vector b ) noexcept
+		{
+#if defined(CRONO_MATH_SSE2)
+			return _mm_and_ps( a, b );
+#else
+			return VectorSelect( VectorZero(), a, b );
+#endif
+		}
+
+		// a & ~b
+		inline Vector VectorAndCInt( Vector a, Vector b ) noexcept
+		{
+#if defined(CRONO_MATH_SSE2)
+			return _mm_andnot_ps( b, a );
+#else
+			return VectorSelect( a, VectorZero(), b );
+#endif
+		}
+
+		inline Vector VectorOrInt( Vector a, Vector b ) noexcept
+		{
+#if defined(CRONO_MATH_SSE2)
+			return _mm_or_ps( a, b );
+#else
+			return VectorSelect( a, VectorReplicateInt( 0xFFFFFFFFu ), b );
+#endif
+		}
+
+#if defined(CRONO_MATH_SSE2)
+#define CRONO_MATH_LANEWISE( sse, op ) return sse( a, b )
+#else
+#define CRONO_MATH_LANEWISE( sse, op ) return { { op( a.f[0], b.f[0] ), op( a.f[1], b.f[1] ), op( a.f[2], b.f[2] ), op( a.f[3], b.f[3] ) } }
+#endif
+#define CRONO_MATH_ADD( a, b ) (a) + (b)
+#define CRONO_MATH_SUB( a, b ) (a) - (b)
+#define CRONO_MATH_MUL( a, b ) (a) * (b)
+#define CRONO_MATH_DIV( a, b ) (a) / (b)
+#define CRONO_MATH_MIN( a, b ) ((b) < (a) ? (b) : (a))
+#define CRONO_MATH_MAX( a, b ) ((a) < (b) ? (b) : (a))
+
+		inline Vector VectorAdd( Vector a, Vector b ) noexcept
+		{
+			CRONO_MATH_LANEWISE( _mm_add_ps, CRONO_MATH_ADD );
+		}
+		inline Vector VectorSubtract( Vector a, Vector b ) noexcept
+		{
+			CRONO_MATH_LANEWISE( _mm_sub_ps, CRONO_MATH_SUB );
+		}
+		inline Vector VectorMultiply( Vector a, Vector b ) noexcept
+		{
+			CRONO_MATH_LANEWISE( _mm_mul_ps, CRONO_MATH_MUL );
+		}
+		inline Vector VectorDivide( Vector a, Vector b ) noexcept
+		{
+			CRONO_MATH_LANEWISE( _mm_div_ps, CRONO_MATH_DIV );
+		}
+		inline Vector VectorMin( Vector a, Vector b ) noexcept
+		{
+			CRONO_MATH_LANEWISE( _mm_min_ps, CRONO_MATH_MIN );
+		}
+		inline Vector VectorMax( Vector a, Vector b ) noexcept
+		{
+			CRONO_MATH_LANEWISE( _mm_max_ps, CRONO_MATH_MAX );
+		}
+		// Comparisons return all bits set in the lanes where they hold, for VectorSelect.
+		inline Vector VectorLessOrEqual( Vector a, Vector b ) noexcept
+		{
+#if defined(CRONO_MATH_SSE2)
+			return _mm_cmple_ps( a, b );
+#else
+			return VectorSetInt( a.f[0] <= b.f[0] ? 0xFFFFFFFFu : 0u, a.f[1] <= b.f[1] ? 0xFFFFFFFFu : 0u,
+				a.f[2] <= b.f[2] ? 0xFFFFFFFFu : 0u, a.f[3] <= b.f[3] ? 0xFFFFFFFFu : 0u );
+#endif
+		}
+		inline Vector VectorLess( Vector a, Vector b ) noexcept
+		{
+#if defined(CRONO_MATH_SSE2)
+			return _mm_cmplt_ps( a, b );
+#else
+			return VectorSetInt( a.f[0] < b.f[0] ? 0xFFFFFFFFu : 0u, a.f[1] < b.f[1] ? 0xFFFFFFFFu : 0u,
+				a.f[2] < b.f[2] ? 0xFFFFFFFFu : 0u, a.f[3] < b.f[3] ? 0xFFFFFFFFu : 0u );
+#endif
+		}
+		// Bit i is the sign bit of lane i, e.g. whether a comparison held there.
+		inline uint32_t VectorMoveMask( Vector v ) noexcept
+		{
+#if defined(CRONO_MATH_SSE2)
+			return static_cast<uint32_t>(_mm_movemask_ps( v ));
+#else
+			uint32_t bits[4];
+			std::memcpy( bits, v.f, sizeof( bits ) );
+			return (bits[0] >> 31) | ((bits[1] >> 31) << 1) | ((bits[2] >> 31) << 2) | ((bits[3] >> 31) << 3);
+#endif
+		}
+
+#undef CRONO_MATH_LANEWISE
+#undef CRONO_MATH_ADD
+#undef CRONO_MATH_SUB
+#undef CRONO_MATH_MUL
+#undef CRONO_MATH_DIV
+#undef CRONO_MATH_MIN
+#undef CRONO_MATH_MAX
+
+		// a * b + c, fused on AVX2 builds.
+		inline Vector VectorMultiplyAdd( Vector a, Vector b, Vector c ) noexcept
+		{
+#if defined(CRONO_MATH_AVX2)
+			return _mm_fmadd_ps( a, b, c );
+#else
+			return VectorAdd( VectorMultiply( a, b ), c );
+#endif
+		}
+
+		// c - a * b, fused on AVX2 builds.
+		inline Vector VectorNegativeMultiplySubtract( Vector a, Vector b, Vector c ) noexcept
+		{
+#if defined(CRONO_MATH_AVX2)
+			return _mm_fnmadd_ps( a, b, c );
+#else
+			return VectorSubtract( c, VectorMultiply( a, b ) );
+#endif
+		}
+
+		inline Vector VectorSqrt( Vector v ) noexcept
+		{
+#if defined(CRONO_MATH_SSE2)
+			return _mm_sqrt_ps( v );
+#else
+			return { { std::sqrt( v.f[0] ), std::sqrt( v.f[1] ), std::sqrt( v.f[2] ), std::sqrt( v.f[3] ) } };
+#endif
+		}
+
+		// Round to nearest, ties to even.
+		inline Vector VectorRound( Vector v ) noexcept
+		{
+#if defined(CRONO_MATH_SSE4)
+			return _mm_round_ps( v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC );
+#elif defined(CRONO_MATH_SSE2)
+			// Adding 2^23 pushes the fraction out of the mantissa, larger values have none.
+			const __m128 sign = _mm_and_ps( v, _mm_castsi128_ps( _mm_set1_epi32( static_cast<int>(0x80000000u) ) ) );
+			const __m128 magic = _mm_or_ps( _mm_set1_ps( 8388608.0f ), sign );
+			__m128 rounded = _mm_sub_ps( _mm_add_ps( v, magic ), magic );
+			const __m128 inRange = _mm_cmple_ps( _mm_andnot_ps( sign, v ), _mm_set1_ps( 8388608.0f ) );
+			return _mm_or_ps( _mm_and_ps( inRange, rounded ), _mm_andnot_ps( inRange, v ) );
+#else
+			return { { std::nearbyint( v.f[0] ), std::nearbyint( v.f[1] ), std::nearbyint( v.f[2] ), std::nearbyint( v.f[3] ) } };
+#endif
+		}
+
+		/* Loads and stores. */
+
+		// Four floats from plain memory, the A variants need 16 byte alignment.
+		inline Vector VectorLoad4( const float* source ) noexcept
+		{
+#if defined(CRONO_MATH_SSE2)
+			return _mm_loadu_ps( source );
+#else
+			return { { source[0], source[1], source[2], source[3] } };
+#endif
+		}
+
+		inline Vector VectorLoad4A( const float* source ) noexcept
+		{
+#if defined(CRONO_MATH_SSE2)
+			return _mm_load_ps( source );
+#else
+			return VectorLoad4( source );
+#endif
+		}
+
+		inline void VectorStore4( float* destination, Vector v ) noexcept
+		{
+#if defined(CRONO_MATH_SSE2)
+			_mm_storeu_ps( destination, v );
+#else
+			std::memcpy( destination, v.f, sizeof( v.f ) );
+#endif
+		}
+
+		inline void VectorStore4A( float* destination, Vector v ) noexcept
+		{
+#if defined(CRONO_MATH_SSE2)
+			_mm_store_ps( destination, v );
+#else
+			VectorStore4( destination, v );
+#endif
+		}
+
+		inline Vector LoadFloat3( const Float3* source ) noexcept
+		{
+			return VectorSet( source->x, source->y, source->z, 0.0f );
+		}
+
+		inline Vector LoadFloat3A( const Float3A* source ) noexcept
+		{
+#if defined(CRONO_MATH_SSE2)
+			const __m128 v = _mm_load_ps( &source->x );
+			return _mm_and_ps( v, _mm_castsi128_ps( _mm_setr_epi32( -1, -1, -1, 0 ) ) );
+#else
+			return LoadFloat3( source );
+#endif
+		}
+
+		inline Vector LoadFloat4( const Float4* source ) noexcept
+		{
+#if defined(CRONO_MATH_SSE2)
+			return _mm_loadu_ps( &source->x );
+#else
+			return VectorSet( source->x, source->y, source->z, source->w );
+#endif
+		}
+
+		inline Vector LoadFloat4A( const Float4A* source ) noexcept
+		{
+#if defined(CRONO_MATH_SSE2)
+			return _mm_load_ps( &source->x );
+#else
+			return LoadFloat4( source );
+#endif
+		}
+
+		inline void StoreFloat4( Float4* destination, Vector v ) noexcept
+		{
+#if defined(CRONO_MATH_SSE2)
+			_mm_storeu_ps( &destination->x, v );
+#else
+			destination->x = v.f[0];
+			destination->y = v.f[1];
+			destination->z = v.f[2];
+			destination->w = v.f[3];
+#endif
+		}
+
+		inline void StoreFloat4A( Float4A* destination, Vector v ) noexcept
+		{
+#if defined(CRONO_MATH_SSE2)
+			_mm_store_ps( &destination->x, v );
+#else
+			StoreFloat4( destination, v );
+#endif
+		}
+
+		inline void StoreFloat3( Float3* destination, Vector v ) noexcept
+		{
+#if defined(CRONO_MATH_SSE2)
+			_mm_storel_pi( reinterpret_cast<__m64*>(&destination->x), v );
+			_mm_store_ss( &destination->z, _mm_movehl_ps( v, v ) );
+#else
+			destination->x = v.f[0];
+			destination->y = v.f[1];
+			destination->z = v.f[2];
+#endif
+		}
+
+		inline void StoreFloat3A( Float3A* destination, Vector v ) noexcept
+		{
+			StoreFloat3( destination, v );
+		}
+
+		/* Everything below is built from the primitives. */
+
+		inline Vector VectorSplatX( Vector v ) noexcept
+		{
+			return VectorSwizzle<0, 0, 0, 0>( v );
+		}
+		inline Vector VectorSplatY( Vector v ) noexcept
+		{
+			return VectorSwizzle<1, 1, 1, 1>( v );
+		}
+		inline Vector VectorSplatZ( Vector v ) noexcept
+		{
+			return VectorSwizzle<2, 2, 2, 2>( v );
+		}
+		inline Vector VectorSplatW( Vector v ) noexcept
+		{
+			return VectorSwizzle<3, 3, 3, 3>( v );
+		}
+		inline float VectorGetY( Vector v ) noexcept
+		{
+			return VectorGetX( VectorSplatY( v ) );
+		}
+		inline float VectorGetZ( Vector v ) noexcept
+		{
+			return VectorGetX( VectorSplatZ( v ) );
+		}
+		inline float VectorGetW( Vector v ) noexcept
+		{
+			return VectorGetX( VectorSplatW( v ) );
+		}
+
+		// Lanes of a (0-3) and b (4-7) in any order.
+		template<uint32_t X, uint32_t Y, uint32_t Z, uint32_t W>
+		inline Vector VectorPermute( Vector a, Vector b ) noexcept
+		{
+			static_assert( X < 8 && Y < 8 && Z < 8 && W < 8, "Permute indices must be 0-7." );
+			const Vector fromA = VectorSwizzle<X & 3, Y & 3, Z & 3, W & 3>( a );
+			const Vector fromB = VectorSwizzle<X & 3, Y & 3, Z & 3, W & 3>( b );
+			const Vector mask = VectorSetInt( X > 3 ? 0xFFFFFFFFu : 0u, Y > 3 ? 0xFFFFFFFFu : 0u,
+				Z > 3 ? 0xFFFFFFFFu : 0u, W > 3 ? 0xFFFFFFFFu : 0u );
+			return VectorSelect( fromA, fromB, mask );
+		}
+
+		inline Vector VectorScale( Vector v, float scale ) noexcept
+		{
+			return VectorMultiply( v, VectorReplicate( scale ) );
+		}
+
+		inline Vector VectorNegate( Vector v ) noexcept
+		{
+			return VectorSubtract( VectorZero(), v );
+		}
+
+		inline Vector VectorAbs( Vector v ) noexcept
+		{
+			return VectorAndCInt( v, VectorReplicateInt( 0x80000000u ) );
+		}
+
+		inline Vector VectorLerp( Vector a, Vector b, float t ) noexcept
+		{
+			return VectorMultiplyAdd( VectorSubtract( b, a ), VectorReplicate( t ), a );
+		}
+
+		// Dot products are replicated into every lane.
+		inline Vector Vector3Dot( Vector a, Vector b ) noexcept
+		{
+			const Vector product = VectorMultiply( a, b );
+			const Vector sum = VectorAdd( VectorAdd( VectorSplatX( product ), VectorSplatY( product ) ), VectorSplatZ( product ) );
+			return sum;
+		}
+
+		inline Vector Vector4Dot( Vector a, Vector b ) noexcept
+		{
+			const Vector product = VectorMultiply( a, b );
+			const Vector pairs = VectorAdd( product, VectorSwizzle<1, 0, 3, 2>( product ) );
+			return VectorAdd( pairs, VectorSwizzle<2, 3, 0, 1>( pairs ) );
+		}
+
+		inline Vector Vector3Cross( Vector a, Vector b ) noexcept
+		{
+			const Vector left = VectorMultiply( VectorSwizzle<1, 2, 0, 3>( a ), VectorSwizzle<2, 0, 1, 3>( b ) );
+			const Vector right = VectorMultiply( VectorSwizzle<2, 0, 1, 3>( a ), VectorSwizzle<1, 2, 0, 3>( b ) );
+			// w ends up 0 since both sides multiply the same w lanes.
+			return VectorSubtract( left, right );
+		}
+
+		inline Vector Vector3LengthSq( Vector v ) noexcept
+		{
+			return Vector3Dot( v, v );
+		}
+
+		inline Vector Vector3Length( Vector v ) noexcept
+		{
+			return VectorSqrt( Vector3Dot( v, v ) );
+		}
+
+		inline Vector Vector4Length( Vector v ) noexcept
+		{
+			return VectorSqrt( Vector4Dot( v, v ) );
+		}
+
+		// Zero length vectors stay zero.
+		inline Vector Vector3Normalize( Vector v ) noexcept
+		{
+			const Vector length = Vector3Length( v );
+			const Vector zero = VectorZero();
+			return VectorSelect( VectorDivide( v, length ), zero, VectorLessOrEqual( length, zero ) );
+		}
+
+		inline Vector Vector4Normalize( Vector v ) noexcept
+		{
+			const Vector length = Vector4Length( v );
+			const Vector zero = VectorZero();
+			return VectorSelect( VectorDivide( v, length ), zero, VectorLessOrEqual( length, zero ) );
+		}
+
+		// Wraps angles into [-Pi, Pi).
+		inline Vector VectorModAngles( Vector angles ) noexcept
+		{
+			const Vector turns = VectorRound( VectorMultiply( angles, VectorReplicate( OneOverTwoPi ) ) );
+			return VectorNegativeMultiplySubtract( turns, VectorReplicate( TwoPi ), angles );
+		}
+
+		/**
+		 * Sine and cosine with the 11/10 degree minimax polynomials of XMVectorSinCos,
+		 * so results match DirectXMath for the same instruction set.
+		 */
+		inline void VectorSinCos( Vector* sin, Vector* cos, Vector angles ) noexcept
+		{
+			// Map into [-Pi/2, Pi/2] with sin(y) = sin(x) and cos(y) = sign * cos(x).
+			Vector x = VectorModAngles( angles );
+			const Vector negativeZero = VectorReplicateInt( 0x80000000u );
+			const Vector sign = VectorAndInt( x, negativeZero );
+			const Vector c = VectorOrInt( VectorReplicate( Pi ), sign );
+			const Vector absX = VectorAndCInt( x, sign );
+			const Vector reflected = VectorSubtract( c, x );
+			const Vector inRange = VectorLessOrEqual( absX, VectorReplicate( PiOverTwo ) );
+			x = VectorSelect( reflected, x, inRange );
+			const Vector cosSign = VectorSelect( VectorReplicate( -1.0f ), VectorReplicate( 1.0f ), inRange );
+			const Vector x2 = VectorMultiply( x, x );
+
+			Vector result = VectorMultiplyAdd( VectorReplicate( -2.3889859e-08f ), x2, VectorReplicate( 2.7525562e-06f ) );
+			result = VectorMultiplyAdd( result, x2, VectorReplicate( -0.00019840874f ) );
+			result = VectorMultiplyAdd( result, x2, VectorReplicate( 0.0083333310f ) );
+			result = VectorMultiplyAdd( result, x2, VectorReplicate( -0.16666667f ) );
+			result = VectorMultiplyAdd( result, x2, VectorReplicate( 1.0f ) );
+			*sin = VectorMultiply( result, x );
+
+			result = VectorMultiplyAdd( VectorReplicate( -2.6051615e-07f ), x2, VectorReplicate( 2.4760495e-05f ) );
+			result = VectorMultiplyAdd( result, x2, VectorReplicate( -0.0013888378f ) );
+			result = VectorMultiplyAdd( result, x2, VectorReplicate( 0.041666638f ) );
+			result = VectorMultiplyAdd( result, x2, VectorReplicate( -0.5f ) );
+			result = VectorMultiplyAdd( result, x2, VectorReplicate( 1.0f ) );
+			*cos = VectorMultiply( result, cosSign );
+		}
+	}
+}
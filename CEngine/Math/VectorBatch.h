@@ -0,0 +1,226 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+#include "Matrix.h"
+
+namespace CronoEngine
+{
+	namespace Math
+	{
+		/**
+		 * BatchWidth floats of one component for that many objects, structure of arrays style.
+		 * Eight lanes in a __m256 on AVX2 builds, otherwise a Vector and its four lanes.
+		 * The composites do the same operations as their Vector versions. A lane only gives the
+		 * same bits as the Vector function while the compiler fuses no a * b + c on its own,
+		 * which GCC does by default on FMA targets, differently for the two.
+		 */
+#if defined(CRONO_MATH_AVX2)
+		using Batch = __m256;
+		constexpr uint32_t BatchWidth = 8;
+#else
+		using Batch = Vector;
+		constexpr uint32_t BatchWidth = 4;
+#endif
+
+		/* Primitives. */
+
+		inline Batch BatchReplicate( float value ) noexcept
+		{
+#if defined(CRONO_MATH_AVX2)
+			return _mm256_set1_ps( value );
+#else
+			return VectorReplicate( value );
+#endif
+		}
+
+		inline Batch BatchReplicateInt( uint32_t value ) noexcept
+		{
+#if defined(CRONO_MATH_AVX2)
+			return _mm256_castsi256_ps( _mm256_set1_epi32( static_cast<int>(value) ) );
+#else
+			return VectorReplicateInt( value );
+#endif
+		}
+
+		// BatchWidth floats, source needs 32 byte alignment on AVX2 and 16 otherwise.
+		inline Batch BatchLoadA( const float* source ) noexcept
+		{
+#if defined(CRONO_MATH_AVX2)
+			return _mm256_load_ps( source );
+#else
+			return VectorLoad4A( source );
+#endif
+		}
+
+		inline void BatchStoreA( float* destination, Batch v ) noexcept
+		{
+#if defined(CRONO_MATH_AVX2)
+			_mm256_store_ps( destination, v );
+#else
+			VectorStore4A( destination, v );
+#endif
+		}
+
+#if defined(CRONO_MATH_AVX2)
+#define CRONO_MATH_BATCH( avx, vector ) return avx
+#else
+#define CRONO_MATH_BATCH( avx, vector ) return vector
+#endif
+
+		inline Batch BatchAdd( Batch a, Batch b ) noexcept
+		{
+			CRONO_MATH_BATCH( _mm256_add_ps( a, b ), VectorAdd( a, b ) );
+		}
+		inline Batch BatchSubtract( Batch a, Batch b ) noexcept
+		{
+			CRONO_MATH_BATCH( _mm256_sub_ps( a, b ), VectorSubtract( a, b ) );
+		}
+		inline Batch BatchMultiply( Batch a, Batch b ) noexcept
+		{
+			CRONO_MATH_BATCH( _mm256_mul_ps( a, b ), VectorMultiply( a, b ) );
+		}
+		inline Batch BatchMultiplyAdd( Batch a, Batch b, Batch c ) noexcept
+		{
+			CRONO_MATH_BATCH( _mm256_fmadd_ps( a, b, c ), VectorMultiplyAdd( a, b, c ) );
+		}
+		inline Batch BatchMin( Batch a, Batch b ) noexcept
+		{
+			CRONO_MATH_BATCH( _mm256_min_ps( a, b ), VectorMin( a, b ) );
+		}
+		inline Batch BatchMax( Batch a, Batch b ) noexcept
+		{
+			CRONO_MATH_BATCH( _mm256_max_ps( a, b ), VectorMax( a, b ) );
+		}
+		inline Batch BatchNegativeMultiplySubtract( Batch a, Batch b, Batch c ) noexcept
+		{
+			CRONO_MATH_BATCH( _mm256_fnmadd_ps( a, b, c ), VectorNegativeMultiplySubtract( a, b, c ) );
+		}
+		inline Batch BatchRound( Batch v ) noexcept
+		{
+			CRONO_MATH_BATCH( _mm256_round_ps( v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC ), VectorRound( v ) );
+		}
+		inline Batch BatchAndInt( Batch a, Batch b ) noexcept
+		{
+			CRONO_MATH_BATCH( _mm256_and_ps( a, b ), VectorAndInt( a, b ) );
+		}
+		// a & ~b
+		inline Batch BatchAndCInt( Batch a, Batch b ) noexcept
+		{
+			CRONO_MATH_BATCH( _mm256_andnot_ps( b, a ), VectorAndCInt( a, b ) );
+		}
+		inline Batch BatchOrInt( Batch a, Batch b ) noexcept
+		{
+			CRONO_MATH_BATCH( _mm256_or_ps( a, b ), VectorOrInt( a, b ) );
+		}
+		inline Batch BatchLessOrEqual( Batch a, Batch b ) noexcept
+		{
+			CRONO_MATH_BATCH( _mm256_cmp_ps( a, b, _CMP_LE_OQ ), VectorLessOrEqual( a, b ) );
+		}
+		inline Batch BatchLess( Batch a, Batch b ) noexcept
+		{
+			CRONO_MATH_BATCH( _mm256_cmp_ps( a, b, _CMP_LT_OQ ), VectorLess( a, b ) );
+		}
+		// Bit i is the sign bit of lane i.
+		inline uint32_t BatchMoveMask( Batch v ) noexcept
+		{
+			CRONO_MATH_BATCH( static_cast<uint32_t>(_mm256_movemask_ps( v )), VectorMoveMask( v ) );
+		}
+		// Per lane: mask bits set take b, clear take a.
+		inline Batch BatchSelect( Batch a, Batch b, Batch mask ) noexcept
+		{
+			CRONO_MATH_BATCH( _mm256_blendv_ps( a, b, mask ), VectorSelect( a, b, mask ) );
+		}
+
+#undef CRONO_MATH_BATCH
+
+		/**
+		 * Transposes four batches (x, y, z and w of BatchWidth objects) into one
+		 * (x, y, z, w) Vector per object.
+		 */
+		inline void BatchTranspose( Batch x, Batch y, Batch z, Batch w, Vector* rows ) noexcept
+		{
+#if defined(CRONO_MATH_AVX2)
+			const __m256 xy01 = _mm256_unpacklo_ps( x, y );
+			const __m256 xy23 = _mm256_unpackhi_ps( x, y );
+			const __m256 zw01 = _mm256_unpacklo_ps( z, w );
+			const __m256 zw23 = _mm256_unpackhi_ps( z, w );
+			// Each holds object i in the low half and object i + 4 in the high half.
+			const __m256 row0 = _mm256_shuffle_ps( xy01, zw01, _MM_SHUFFLE( 1, 0, 1, 0 ) );
+			const __m256 row1 = _mm256_shuffle_ps( xy01, zw01, _MM_SHUFFLE( 3, 2, 3, 2 ) );
+			const __m256 row2 = _mm256_shuffle_ps( xy23, zw23, _MM_SHUFFLE( 1, 0, 1, 0 ) );
+			const __m256 row3 = _mm256_shuffle_ps( xy23, zw23, _MM_SHUFFLE( 3, 2, 3, 2 ) );
+			rows[0] = _mm256_castps256_ps128( row0 );
+			rows[1] = _mm256_castps256_ps128( row1 );
+			rows[2] = _mm256_castps256_ps128( row2 );
+			rows[3] = _mm256_castps256_ps128( row3 );
+			rows[4] = _mm256_extractf128_ps( row0, 1 );
+			rows[5] = _mm256_extractf128_ps( row1, 1 );
+			rows[6] = _mm256_extractf128_ps( row2, 1 );
+			rows[7] = _mm256_extractf128_ps( row3, 1 );
+#else
+			const Matrix m = MatrixTranspose( { { x, y, z, w } } );
+			for (uint32_t i = 0; i < 4; ++i)
+			{
+				rows[i] = m.r[i];
+			}
+#endif
+		}
+
+		/* Composites, same operations as the Vector versions. */
+
+		inline Batch BatchAbs( Batch v ) noexcept
+		{
+			return BatchAndCInt( v, BatchReplicateInt( 0x80000000u ) );
+		}
+
+		inline Batch BatchModAngles( Batch angles ) noexcept
+		{
+			const Batch turns = BatchRound( BatchMultiply( angles, BatchReplicate( OneOverTwoPi ) ) );
+			return BatchNegativeMultiplySubtract( turns, BatchReplicate( TwoPi ), angles );
+		}
+
+		inline void BatchSinCos( Batch* sin, Batch* cos, Batch angles ) noexcept
+		{
+			Batch x = BatchModAngles( angles );
+			const Batch sign = BatchAndInt( x, BatchReplicateInt( 0x80000000u ) );
+			const Batch c = BatchOrInt( BatchReplicate( Pi ), sign );
+			const Batch absX = BatchAndCInt( x, sign );
+			const Batch reflected = BatchSubtract( c, x );
+			const Batch inRange = BatchLessOrEqual( absX, BatchReplicate( PiOverTwo ) );
+			x = BatchSelect( reflected, x, inRange );
+			const Batch cosSign = BatchSelect( BatchReplicate( -1.0f ), BatchReplicate( 1.0f ), inRange );
+			const Batch x2 = BatchMultiply( x, x );
+
+			Batch result = BatchMultiplyAdd( BatchReplicate( -2.3889859e-08f ), x2, BatchReplicate( 2.7525562e-06f ) );
+			result = BatchMultiplyAdd( result, x2, BatchReplicate( -0.00019840874f ) );
+			result = BatchMultiplyAdd( result, x2, BatchReplicate( 0.0083333310f ) );
+			result = BatchMultiplyAdd( result, x2, BatchReplicate( -0.16666667f ) );
+			result = BatchMultiplyAdd( result, x2, BatchReplicate( 1.0f ) );
+			*sin = BatchMultiply( result, x );
+
+			result = BatchMultiplyAdd( BatchReplicate( -2.6051615e-07f ), x2, BatchReplicate( 2.4760495e-05f ) );
+			result = BatchMultiplyAdd( result, x2, BatchReplicate( -0.0013888378f ) );
+			result = BatchMultiplyAdd( result, x2, BatchReplicate( 0.041666638f ) );
+			result = BatchMultiplyAdd( result, x2, BatchReplicate( -0.5f ) );
+			result = BatchMultiplyAdd( result, x2, BatchReplicate( 1.0f ) );
+			*cos = BatchMultiply( result, cosSign );
+		}
+	}
+}
@@ -0,0 +1,155 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "HeadlessPlatform.h"
+#include "Graphics/FramePacket.h"
+#include <csignal>
+#include <thread>
+
+namespace CronoEngine
+{
+	namespace
+	{
+		// Set from the signal handler so Ctrl+C / SIGTERM end the run with a normal shutdown.
+		volatile std::sig_atomic_t g_StopSignal = 0;
+
+		void OnStopSignal( int signal )
+		{
+			g_StopSignal = signal;
+		}
+	}
+
+	HeadlessPlatform::HeadlessPlatform( const PlatformConfig& config )
+		: _Width( config.Width ), _Height( config.Height ), _MaxFrames( config.MaxFrames )
+	{
+		std::signal( SIGINT, OnStopSignal );
+		std::signal( SIGTERM, OnStopSignal );
+
+		Graphics::RHI::SwapChainDesc swapChain;
+		swapChain.Width = static_cast<uint32_t>(std::max( 1, _Width ));
+		swapChain.Height = static_cast<uint32_t>(std::max( 1, _Height ));
+		_SwapChain = _Device.CreateSwapChain( swapChain );
+		_Frames = std::make_unique<Graphics::FrameRenderer>( _Device, *_SwapChain );
+	}
+
+	HeadlessPlatform::~HeadlessPlatform()
+	{
+		std::signal( SIGINT, SIG_DFL );
+		std::signal( SIGTERM, SIG_DFL );
+	}
+
+	std::optional<int> HeadlessPlatform::ProcessMessages()
+	{
+		if (g_StopSignal != 0)
+		{
+			RequestQuit( 0 );
+		}
+		if (_MaxFrames != 0 && _FrameCount >= _MaxFrames)
+		{
+			RequestQuit( 0 );
+		}
+		return _ExitCode;
+	}
+
+	bool HeadlessPlatform::HadEvents() const noexcept
+	{
+		return false;
+	}
+
+	bool HeadlessPlatform::WaitForEvents( std::chrono::milliseconds timeout )
+	{
+		// Nothing can arrive, so this is a plain sleep.
+		std::this_thread::sleep_for( timeout );
+		return false;
+	}
+
+	void HeadlessPlatform::BeginFrame()
+	{
+	}
+
+	void HeadlessPlatform::EndFrame()
+	{
+		std::lock_guard<std::mutex> lock( _FrameMutex );
+		_Frames->Render( nullptr, false );
+		++_FrameCount;
+	}
+
+	void HeadlessPlatform::BuildFrame( Graphics::FramePacket& )
+	{
+		++_FrameCount;
+	}
+
+	void HeadlessPlatform::SubmitFrame( Graphics::FramePacket& packet )
+	{
+		// Resize may come in on the simulation thread while the render thread submits.
+		std::lock_guard<std::mutex> lock( _FrameMutex );
+		_Frames->Render( packet.UI.Get(), false );
+	}
+
+	void HeadlessPlatform::Shutdown()
+	{
+	}
+
+	void HeadlessPlatform::Resize( int32_t width, int32_t height )
+	{
+		std::lock_guard<std::mutex> lock( _FrameMutex );
+		_Width = width;
+		_Height = height;
+		_Frames->Resize( static_cast<uint32_t>(std::max( 1, width )), static_cast<uint32_t>(std::max( 1, height )) );
+	}
+
+	void HeadlessPlatform::RequestQuit( int exitCode )
+	{
+		// The first request wins, like PostQuitMessage.
+		if (!_ExitCode)
+		{
+			_ExitCode = exitCode;
+		}
+	}
+
+	Keyboard& HeadlessPlatform::GetKeyboard()
+	{
+		return _Keyboard;
+	}
+
+	Mouse& HeadlessPlatform::GetMouse()
+	{
+		return _Mouse;
+	}
+
+	bool HeadlessPlatform::IsHeadless() const noexcept
+	{
+		return true;
+	}
+
+	Graphics::RHI::Device& HeadlessPlatform::GetDevice()
+	{
+		return _Device;
+	}
+
+	uint64_t HeadlessPlatform::GetFrameCount() const noexcept
+	{
+		return _FrameCount;
+	}
+
+	Graphics::RHI::NullDevice& HeadlessPlatform::GetNullDevice() noexcept
+	{
+		return _Device;
+	}
+}
@@ -0,0 +1,71 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+#include "Platform.h"
+#include "Graphics/FrameRenderer.h"
+#include "Graphics/RHI/NullDevice.h"
+
+namespace CronoEngine
+{
+	/**
+	 * Platform without a window or GPU. Frames are recorded and submitted to an RHI::NullDevice,
+	 * which checks and counts them but draws nothing, so the simulation and the CPU side of
+	 * rendering run as fast as the CPU allows (soak tests, benchmarks, servers).
+	 */
+	class HeadlessPlatform : public Platform
+	{
+	public:
+		HeadlessPlatform( const PlatformConfig& config );
+		~HeadlessPlatform();
+		HeadlessPlatform( const HeadlessPlatform& ) = delete;
+		HeadlessPlatform& operator=( const HeadlessPlatform& ) = delete;
+
+		std::optional<int> ProcessMessages() override;
+		bool HadEvents() const noexcept override;
+		bool WaitForEvents( std::chrono::milliseconds timeout ) override;
+		void BeginFrame() override;
+		void EndFrame() override;
+		void BuildFrame( Graphics::FramePacket& packet ) override;
+		void SubmitFrame( Graphics::FramePacket& packet ) override;
+		void Shutdown() override;
+		void Resize( int32_t width, int32_t height ) override;
+		void RequestQuit( int exitCode ) override;
+		Keyboard& GetKeyboard() override;
+		Mouse& GetMouse() override;
+		bool IsHeadless() const noexcept override;
+		Graphics::RHI::Device& GetDevice() override;
+
+		uint64_t GetFrameCount() const noexcept;
+		Graphics::RHI::NullDevice& GetNullDevice() noexcept;
+	private:
+		int32_t _Width;
+		int32_t _Height;
+		uint64_t _MaxFrames;
+		uint64_t _FrameCount = 0;
+		std::optional<int> _ExitCode;
+		Keyboard _Keyboard;
+		Mouse _Mouse;
+		Graphics::RHI::NullDevice _Device;
+		std::unique_ptr<Graphics::RHI::SwapChain> _SwapChain;
+		std::unique_ptr<Graphics::FrameRenderer> _Frames;
+		// Held while a frame is rendered so Resize can't swap the back buffers underneath it, as in DX12Core.
+		std::mutex _FrameMutex;
+	};
+}
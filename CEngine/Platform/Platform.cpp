@@ -0,0 +1,210 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "Platform.h"
+#include <charconv>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#if defined(_WIN32)
+#include "Windows/WinInclude.h"
+#endif
+
+namespace CronoEngine
+{
+	namespace
+	{
+		// Options that take no value on the command line, and the ones that do.
+		constexpr const char* SwitchKeys[] = { "warp", "headless", "pipelined" };
+		constexpr const char* ValueKeys[] = { "width", "height", "frames", "workers", "fps" };
+
+		template<size_t N>
+		bool IsOneOf( const std::string& key, const char* const (&keys)[N] )
+		{
+			return std::find( std::begin( keys ), std::end( keys ), key ) != std::end( keys );
+		}
+
+		/**
+		 * Reads "key=value" lines (# starts a comment) and turns them into "--key value" arguments
+		 * so config files and stdin go through the same parser as the command line. A switch is
+		 * passed on for true, 1 or no value and dropped for false or 0. Unknown keys, bad switch
+		 * values and nested configs are reported and ignored.
+		 */
+		void AppendConfigArgs( std::istream& in, std::vector<std::string>& args )
+		{
+			std::string line;
+			while (std::getline( in, line ))
+			{
+				line.erase( std::find( line.begin(), line.end(), '#' ), line.end() );
+				const auto eq = line.find( '=' );
+				std::istringstream key( line.substr( 0, eq ) );
+				std::string name;
+				if (!(key >> name))
+				{
+					continue;
+				}
+				std::string token;
+				if (eq != std::string::npos)
+				{
+					std::istringstream value( line.substr( eq + 1 ) );
+					value >> token;
+				}
+				if (IsOneOf( name, SwitchKeys ))
+				{
+					if (token.empty() || token == "true" || token == "1")
+					{
+						args.push_back( "--" + name );
+					}
+					else if (token != "false" && token != "0")
+					{
+						std::cerr << "Ignoring " << name << "=" << token << ", not true, false, 1 or 0." << std::endl;
+					}
+				}
+				else if (IsOneOf( name, ValueKeys ) && !token.empty())
+				{
+					args.push_back( "--" + name );
+					args.push_back( token );
+				}
+				else if (name == "config")
+				{
+					// Configs don't nest, so one can't pull itself in forever.
+					std::cerr << "Ignoring config=" << token << ", a config can't include another." << std::endl;
+				}
+				else
+				{
+					std::cerr << "Ignoring " << name << "=" << token << ", not a config option with a value." << std::endl;
+				}
+			}
+		}
+
+		// Sets value from the whole of text. A malformed or out of range value is reported and ignored.
+		template<typename T>
+		void ParseValue( const std::string& option, const std::string& text, T& value )
+		{
+			T parsed{};
+			const char* end = text.data() + text.size();
+			const auto [last, error] = std::from_chars( text.data(), end, parsed );
+			if (error != std::errc() || last != end)
+			{
+				std::cerr << "Ignoring " << option << " " << text << ", not a valid value." << std::endl;
+				return;
+			}
+			value = parsed;
+		}
+
+#if !defined(_WIN32)
+		std::vector<std::string> s_CommandLineArgs;
+#endif
+	}
+
+	std::vector<std::string> Platform::GetCommandLineArgs()
+	{
+		std::vector<std::string> args;
+#if defined(_WIN32)
+		int argc;
+		wchar_t** argv = ::CommandLineToArgvW( ::GetCommandLineW(), &argc );
+		for (int i = 0; i < argc; ++i)
+		{
+			const int size = ::WideCharToMultiByte( CP_UTF8, 0, argv[i], -1, nullptr, 0, nullptr, nullptr );
+			std::string arg( size > 0 ? size - 1 : 0, '\0' );
+			::WideCharToMultiByte( CP_UTF8, 0, argv[i], -1, arg.data(), size, nullptr, nullptr );
+			args.push_back( std::move( arg ) );
+		}
+		// Free memory allocated by CommandLineToArgvW
+		::LocalFree( argv );
+#else
+		args = s_CommandLineArgs;
+#endif
+		return args;
+	}
+
+	void Platform::SetCommandLineArgs( int argc, char** argv )
+	{
+#if !defined(_WIN32)
+		s_CommandLineArgs.assign( argv, argv + argc );
+#endif
+	}
+
+	void Platform::ParseCommandLine( const std::vector<std::string>& input, PlatformConfig& config )
+	{
+		std::vector<std::string> args = input;
+		for (size_t i = 0; i < args.size(); ++i)
+		{
+			const std::string& arg = args[i];
+			const bool hasValue = i + 1 < args.size();
+			if ((arg == "-w" || arg == "--width") && hasValue)
+			{
+				ParseValue( arg, args[++i], config.Width );
+			}
+			else if ((arg == "-h" || arg == "--height") && hasValue)
+			{
+				ParseValue( arg, args[++i], config.Height );
+			}
+			else if (arg == "-warp" || arg == "--warp")
+			{
+				config.UseWarp = true;
+			}
+			else if (arg == "--headless")
+			{
+				config.Headless = true;
+			}
+			else if (arg == "--frames" && hasValue)
+			{
+				ParseValue( arg, args[++i], config.MaxFrames );
+			}
+			else if (arg == "--pipelined")
+			{
+				config.Pipelined = true;
+			}
+			else if (arg == "--workers" && hasValue)
+			{
+				ParseValue( arg, args[++i], config.WorkerThreads );
+			}
+			else if (arg == "--fps" && hasValue)
+			{
+				ParseValue( arg, args[++i], config.TargetFrameRate );
+			}
+			else if (arg == "--config" && hasValue)
+			{
+				// "-" reads the config from stdin, anything else is a file path.
+				std::vector<std::string> extra;
+				const std::string source = args[++i];
+				if (source == "-")
+				{
+					AppendConfigArgs( std::cin, extra );
+				}
+				else
+				{
+					std::ifstream file( source );
+					if (!file)
+					{
+						std::cerr << "Ignoring --config " << source << ", the file can't be opened." << std::endl;
+					}
+					AppendConfigArgs( file, extra );
+				}
+				args.insert( args.begin() + i + 1, extra.begin(), extra.end() );
+			}
+		}
+#if !defined(_WIN32)
+		// There is no window or graphics backend outside of Windows yet.
+		config.Headless = true;
+#endif
+	}
+}
@@ -0,0 +1,94 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+#include "Common/CommonHeaders.h"
+#include "Windows/Keyboard.h"
+#include "Windows/Mouse.h"
+
+namespace CronoEngine
+{
+	namespace Graphics
+	{
+		struct FramePacket;
+		namespace RHI
+		{
+			class Device;
+		}
+	}
+
+	/**
+	 * Startup options for the platform layer. Filled from the Application constructor
+	 * and then overridden by the command line (and an optional --config file or stdin).
+	 */
+	struct PlatformConfig
+	{
+		int32_t Width = 1920;
+		int32_t Height = 1080;
+		std::string Title;
+		bool HasBorder = false;
+		bool UseWarp = false;
+		// Run without a window or graphics device (always true on non-Windows builds).
+		bool Headless = false;
+		// Quit after this many frames, 0 runs until a quit is requested.
+		uint64_t MaxFrames = 0;
+		// Frame rate cap applied by the FramePacer, 0 leaves the rate to VSync (or unlimited).
+		double TargetFrameRate = 0.0;
+		// Run the render submission on its own thread, fed by frame packets from the simulation.
+		bool Pipelined = false;
+		// Job system worker threads, 0 uses one per hardware thread minus the main thread.
+		uint32_t WorkerThreads = 0;
+	};
+
+	/**
+	 * Everything Application::Run needs from the OS and the graphics backend.
+	 */
+	class Platform
+	{
+	public:
+		virtual ~Platform() = default;
+
+		// Pump pending OS messages without blocking, returns the exit code once quitting.
+		virtual std::optional<int> ProcessMessages() = 0;
+		// True if the last ProcessMessages call had any messages to handle.
+		virtual bool HadEvents() const noexcept = 0;
+		// Blocks until a message arrives or the timeout passes, returns false on timeout.
+		virtual bool WaitForEvents( std::chrono::milliseconds timeout ) = 0;
+		virtual void BeginFrame() = 0;
+		virtual void EndFrame() = 0;
+		// Pipelined mode splits EndFrame in two: BuildFrame runs on the simulation thread and
+		// captures what the submission needs into the packet, SubmitFrame runs on the render thread.
+		virtual void BuildFrame( Graphics::FramePacket& packet ) = 0;
+		virtual void SubmitFrame( Graphics::FramePacket& packet ) = 0;
+		virtual void Shutdown() = 0;
+		virtual void Resize( int32_t width, int32_t height ) = 0;
+		virtual void RequestQuit( int exitCode ) = 0;
+		virtual Keyboard& GetKeyboard() = 0;
+		virtual Mouse& GetMouse() = 0;
+		virtual bool IsHeadless() const noexcept = 0;
+		// What frames are rendered with, the null device when headless.
+		virtual Graphics::RHI::Device& GetDevice() = 0;
+
+		// Arguments of the running process, argv[0] included. Outside of Windows main hands them
+		// over with SetCommandLineArgs before the application is created.
+		static std::vector<std::string> GetCommandLineArgs();
+		static void SetCommandLineArgs( int argc, char** argv );
+		static void ParseCommandLine( const std::vector<std::string>& args, PlatformConfig& config );
+	};
+}
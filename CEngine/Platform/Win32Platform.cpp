@@ -0,0 +1,111 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "Win32Platform.h"
+#include "Graphics/FramePacket.h"
+
+namespace CronoEngine
+{
+	Win32Platform::Win32Platform( const PlatformConfig& config )
+	{
+		_Renderer = std::make_unique<Graphics::Renderer>( config.Width, config.Height, config.Title, config.HasBorder, config.UseWarp );
+	}
+
+	Win32Platform::~Win32Platform()
+	{
+	}
+
+	std::optional<int> Win32Platform::ProcessMessages()
+	{
+		_HadEvents = HIWORD( ::GetQueueStatus( QS_ALLINPUT ) ) != 0;
+		return Window::ProcessMessages();
+	}
+
+	bool Win32Platform::HadEvents() const noexcept
+	{
+		return _HadEvents;
+	}
+
+	bool Win32Platform::WaitForEvents( std::chrono::milliseconds timeout )
+	{
+		const DWORD result = ::MsgWaitForMultipleObjectsEx( 0, nullptr, static_cast<DWORD>(timeout.count()),
+			QS_ALLINPUT, MWMO_INPUTAVAILABLE );
+		return result != WAIT_TIMEOUT;
+	}
+
+	void Win32Platform::BeginFrame()
+	{
+		_Renderer->Gfx().BeginFrame();
+	}
+
+	void Win32Platform::EndFrame()
+	{
+		_Renderer->Gfx().EndFrame();
+	}
+
+	void Win32Platform::BuildFrame( Graphics::FramePacket& packet )
+	{
+		packet.UI.Capture( _Renderer->Gfx().RenderUI() );
+	}
+
+	void Win32Platform::SubmitFrame( Graphics::FramePacket& packet )
+	{
+		_Renderer->Gfx().SubmitFrame( packet.UI.Get() );
+	}
+
+	void Win32Platform::Shutdown()
+	{
+		_Renderer->Gfx().Shutdown();
+	}
+
+	void Win32Platform::Resize( int32_t width, int32_t height )
+	{
+		_Renderer->Resize( width, height );
+	}
+
+	void Win32Platform::RequestQuit( int exitCode )
+	{
+		PostQuitMessage( exitCode );
+	}
+
+	Keyboard& Win32Platform::GetKeyboard()
+	{
+		return _Renderer->GetWindow()->kbd;
+	}
+
+	Mouse& Win32Platform::GetMouse()
+	{
+		return _Renderer->GetWindow()->mouse;
+	}
+
+	bool Win32Platform::IsHeadless() const noexcept
+	{
+		return false;
+	}
+
+	Graphics::RHI::Device& Win32Platform::GetDevice()
+	{
+		return _Renderer->Gfx().GetDevice();
+	}
+
+	Graphics::Renderer& Win32Platform::GetRenderer()
+	{
+		return *_Renderer;
+	}
+}
@@ -0,0 +1,57 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+#include "Platform.h"
+#include "Graphics/Renderer.h"
+
+namespace CronoEngine
+{
+	/**
+	 * Win32 window + DX12 renderer backend.
+	 */
+	class Win32Platform : public Platform
+	{
+	public:
+		Win32Platform( const PlatformConfig& config );
+		~Win32Platform();
+		Win32Platform( const Win32Platform& ) = delete;
+		Win32Platform& operator=( const Win32Platform& ) = delete;
+
+		std::optional<int> ProcessMessages() override;
+		bool HadEvents() const noexcept override;
+		bool WaitForEvents( std::chrono::milliseconds timeout ) override;
+		void BeginFrame() override;
+		void EndFrame() override;
+		void BuildFrame( Graphics::FramePacket& packet ) override;
+		void SubmitFrame( Graphics::FramePacket& packet ) override;
+		void Shutdown() override;
+		void Resize( int32_t width, int32_t height ) override;
+		void RequestQuit( int exitCode ) override;
+		Keyboard& GetKeyboard() override;
+		Mouse& GetMouse() override;
+		bool IsHeadless() const noexcept override;
+		Graphics::RHI::Device& GetDevice() override;
+
+		Graphics::Renderer& GetRenderer();
+	private:
+		std::unique_ptr<Graphics::Renderer> _Renderer;
+		bool _HadEvents = false;
+	};
+}
@@ -18,6 +18,7 @@
 *	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
 ******************************************************************************************/
 #include "Project.h"
+#include "Scene/SceneSerializer.h"
 
 CronoEngine::Project::Project()
 {
@@ -26,5 +27,56 @@ CronoEngine::Project::Project()
 
 CronoEngine::Project::~Project()
 {
+	m_World.reset();
+	m_Journal.reset();
+	delete ActiveScene;
+}
 
+void CronoEngine::Project::SaveScene( const std::string& path )
+{
+	if (m_Journal != nullptr && m_Journal->GetPath() == path)
+	{
+		m_Journal->Append( *ActiveScene );
+		return;
+	}
+	SaveSceneSnapshot( path );
+}
+
+void CronoEngine::Project::SaveSceneSnapshot( const std::string& path )
+{
+	m_Journal.reset();
+	const SceneSerializer::FileHeader header = SceneSerializer::Save( *ActiveScene, path );
+	// The new lineage already makes them stale, this just frees the space.
+	SceneJournal::Remove( path );
+	m_Journal = std::make_unique<SceneJournal>( path, header, ActiveScene->GetJobSystem() );
+}
+
+void CronoEngine::Project::LoadScene( const std::string& path )
+{
+	m_World.reset();
+	m_Journal.reset();
+	SceneSerializer::FileHeader header{};
+	std::unique_ptr<Scene> scene = SceneSerializer::Load( path, &header );
+	auto journal = std::make_unique<SceneJournal>( path, header, ActiveScene->GetJobSystem() );
+	journal->Replay( *scene );
+	scene->SetJobSystem( ActiveScene->GetJobSystem() );
+	delete ActiveScene;
+	ActiveScene = scene.release();
+	m_Journal = std::move( journal );
+}
+
+void CronoEngine::Project::OpenWorld( const std::string& directory, const WorldPartition::Settings& settings )
+{
+	m_World.reset();
+	m_World = std::make_unique<WorldPartition>( *ActiveScene, directory, settings );
+}
+
+void CronoEngine::Project::CloseWorld()
+{
+	m_World.reset();
+}
+
+CronoEngine::WorldPartition* CronoEngine::Project::GetWorld() const noexcept
+{
+	return m_World.get();
 }
@@ -20,8 +20,9 @@
 #pragma once
 #include "Common/CommonHeaders.h"
 #include "Scene/Scene.h"
-#include "Windows/Window.h"
-#include "Graphics/Renderer.h"
+#include "Scene/SceneJournal.h"
+#include "Scene/WorldPartition.h"
+#include <memory>
 
 namespace CronoEngine
 {
@@ -30,7 +31,26 @@ namespace CronoEngine
 	public:
 		Project();
 		~Project();
+		/**
+		 * All throw FileException, see SceneSerializer and SceneJournal. SaveScene only appends the
+		 * edits to the journal when path is the scene's snapshot, SaveSceneSnapshot always writes
+		 * the whole scene. Loading replays the journal, replaces ActiveScene and keeps its job system.
+		 */
+		void SaveScene( const std::string& path );
+		void SaveSceneSnapshot( const std::string& path );
+		void LoadScene( const std::string& path );
+		/**
+		 * Streams the world built into directory (see WorldPartition::Build) into ActiveScene,
+		 * replacing the open one. Throws FileException. LoadScene closes it, the cells belonged
+		 * to the old scene.
+		 */
+		void OpenWorld( const std::string& directory, const WorldPartition::Settings& settings = {} );
+		void CloseWorld();
+		// Null when no world is open.
+		WorldPartition* GetWorld() const noexcept;
 	private:
+		std::unique_ptr<SceneJournal> m_Journal;
+		std::unique_ptr<WorldPartition> m_World;
 	public:		
 		Scene* ActiveScene;
 	private:
@@ -0,0 +1,689 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "AabbTree.h"
+#include "Entity/Component/BoundsComponent.h"
+#include <algorithm>
+
+namespace CronoEngine
+{
+	namespace
+	{
+		constexpr uint32_t BinCount = 16;
+		// Subtrees at least this big are built on another job.
+		constexpr uint32_t ParallelBuildCount = 16 * 1024;
+		constexpr uint32_t QueryGrain = 16;
+
+		Math::Aabb EmptyAabb() noexcept
+		{
+			return { { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX } };
+		}
+
+		float Axis( const Math::Float3& v, int axis ) noexcept
+		{
+			return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+		}
+	}
+
+	Math::Aabb AabbTree::GetWorldBounds( const entt::registry& registry, entt::entity entity, const Math::Float4x4A& world )
+	{
+		const BoundsComponent* bounds = registry.try_get<BoundsComponent>( entity );
+		const Math::Aabb local = bounds != nullptr ? Math::AabbFromCenterExtents( bounds->Center, bounds->Extents )
+			: Math::Aabb{ { -0.5f, -0.5f, -0.5f }, { 0.5f, 0.5f, 0.5f } };
+		return Math::AabbTransform( local, Math::LoadFloat4x4A( &world ) );
+	}
+
+	uint32_t AabbTree::GetLeafCount() const noexcept
+	{
+		return m_LeafCount;
+	}
+
+	int32_t AabbTree::GetHeight() const noexcept
+	{
+		return m_Root != NullNode ? m_Nodes[m_Root].Height : 0;
+	}
+
+	float AabbTree::ComputeCost() const
+	{
+		if (m_Root == NullNode || IsLeaf( m_Root ))
+		{
+			return 0.0f;
+		}
+		float sum = 0.0f;
+		for (const Node& node : m_Nodes)
+		{
+			// Freed nodes have a negative height, leaves zero.
+			if (node.Height > 0)
+			{
+				sum += Math::AabbSurfaceArea( node.Bounds );
+			}
+		}
+		return sum / Math::AabbSurfaceArea( m_Nodes[m_Root].Bounds );
+	}
+
+	const Math::Aabb* AabbTree::FindBounds( entt::entity entity ) const noexcept
+	{
+		const int32_t leaf = FindLeaf( entity );
+		return leaf != NullNode ? &m_Nodes[leaf].Bounds : nullptr;
+	}
+
+	bool AabbTree::IsLeaf( int32_t node ) const noexcept
+	{
+		return m_Nodes[node].Left == NullNode;
+	}
+
+	int32_t AabbTree::FindLeaf( entt::entity entity ) const noexcept
+	{
+		const uint32_t id = entt::to_entity( entity );
+		if (id >= m_Leaves.size())
+		{
+			return NullNode;
+		}
+		const int32_t leaf = m_Leaves[id];
+		if (leaf == NullNode || m_Nodes[leaf].Height != 0 || m_Nodes[leaf].Entity != entity)
+		{
+			return NullNode;
+		}
+		return leaf;
+	}
+
+	int32_t AabbTree::AllocateNode()
+	{
+		if (m_FreeList != NullNode)
+		{
+			const int32_t node = m_FreeList;
+			m_FreeList = m_Nodes[node].Parent;
+			return node;
+		}
+		m_Nodes.emplace_back();
+		return static_cast<int32_t>(m_Nodes.size() - 1);
+	}
+
+	void AabbTree::FreeNode( int32_t node ) noexcept
+	{
+		m_Nodes[node].Parent = m_FreeList;
+		m_Nodes[node].Height = -1;
+		m_Nodes[node].Entity = entt::null;
+		m_FreeList = node;
+	}
+
+	void AabbTree::Clear()
+	{
+		m_Nodes.clear();
+		m_Leaves.clear();
+		m_Root = NullNode;
+		m_FreeList = NullNode;
+		m_LeafCount = 0;
+	}
+
+	void AabbTree::Update( entt::registry& registry, const TransformSystem& transforms,
+		const std::vector<entt::entity>& changed, JobSystem* jobs )
+	{
+		const std::vector<uint32_t>& dirty = transforms.GetDirtyIndices();
+		const size_t touched = dirty.size() + changed.size();
+		if (touched == 0)
+		{
+			return;
+		}
+		if (m_Root == NullNode || touched > m_LeafCount / RebuildDivisor)
+		{
+			Rebuild( registry, transforms, jobs );
+			return;
+		}
+		for (const entt::entity entity : changed)
+		{
+			SyncEntity( registry, transforms, entity, TransformSystem::InvalidIndex );
+		}
+		for (const uint32_t index : dirty)
+		{
+			SyncEntity( registry, transforms, transforms.GetEntity( index ), index );
+		}
+	}
+
+	void AabbTree::SyncEntity( entt::registry& registry, const TransformSystem& transforms, entt::entity entity, uint32_t index )
+	{
+		if (index == TransformSystem::InvalidIndex)
+		{
+			index = transforms.FindIndex( entity );
+		}
+		const uint32_t id = entt::to_entity( entity );
+		int32_t leaf = FindLeaf( entity );
+		if (index == TransformSystem::InvalidIndex)
+		{
+			if (leaf != NullNode)
+			{
+				RemoveLeaf( leaf );
+				FreeNode( leaf );
+				m_Leaves[id] = NullNode;
+				--m_LeafCount;
+			}
+			return;
+		}
+
+		const Math::Aabb bounds = GetWorldBounds( registry, entity, transforms.GetWorldMatrix( index ) );
+		if (leaf == NullNode)
+		{
+			leaf = AllocateNode();
+			m_Nodes[leaf] = { bounds, NullNode, NullNode, NullNode, 0, entity };
+			if (id >= m_Leaves.size())
+			{
+				m_Leaves.resize( static_cast<size_t>(id) + 1, NullNode );
+			}
+			m_Leaves[id] = leaf;
+			++m_LeafCount;
+			InsertLeaf( leaf );
+			return;
+		}
+		if (Math::AabbEqual( m_Nodes[leaf].Bounds, bounds ))
+		{
+			return;
+		}
+		if (Math::AabbOverlaps( m_Nodes[leaf].Bounds, bounds ))
+		{
+			m_Nodes[leaf].Bounds = bounds;
+			Refit( m_Nodes[leaf].Parent );
+			return;
+		}
+		// Jumped somewhere else, refitting would stretch every ancestor across the gap.
+		RemoveLeaf( leaf );
+		m_Nodes[leaf].Bounds = bounds;
+		InsertLeaf( leaf );
+	}
+
+	void AabbTree::Rebuild( entt::registry& registry, const TransformSystem& transforms, JobSystem* jobs )
+	{
+		Clear();
+		const uint32_t count = transforms.GetCount();
+		if (count == 0)
+		{
+			return;
+		}
+
+		// Leaves take the first count nodes in TransformSystem order, internal nodes the rest.
+		m_Nodes.resize( 2 * static_cast<size_t>(count) - 1 );
+		std::vector<Math::Float3> centroids( count );
+		std::vector<int32_t> leaves( count );
+		const entt::registry& reader = registry;
+		auto fill = [&]( uint32_t begin, uint32_t end )
+		{
+			for (uint32_t i = begin; i < end; ++i)
+			{
+				const entt::entity entity = transforms.GetEntity( i );
+				const Math::Aabb bounds = GetWorldBounds( reader, entity, transforms.GetWorldMatrix( i ) );
+				m_Nodes[i] = { bounds, NullNode, NullNode, NullNode, 0, entity };
+				centroids[i] = { (bounds.Min.x + bounds.Max.x) * 0.5f, (bounds.Min.y + bounds.Max.y) * 0.5f,
+					(bounds.Min.z + bounds.Max.z) * 0.5f };
+				leaves[i] = static_cast<int32_t>(i);
+			}
+		};
+		if (jobs == nullptr)
+		{
+			fill( 0, count );
+		}
+		else
+		{
+			jobs->ParallelFor( count, 4096, fill );
+		}
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const uint32_t id = entt::to_entity( m_Nodes[i].Entity );
+			if (id >= m_Leaves.size())
+			{
+				m_Leaves.resize( static_cast<size_t>(id) + 1, NullNode );
+			}
+			m_Leaves[id] = static_cast<int32_t>(i);
+		}
+		m_LeafCount = count;
+		m_Root = BuildRange( leaves.data(), centroids.data(), count, static_cast<int32_t>(count), jobs );
+		m_Nodes[m_Root].Parent = NullNode;
+	}
+
+	int32_t AabbTree::BuildRange( int32_t* leaves, const Math::Float3* centroids, uint32_t count, int32_t firstInternal, JobSystem* jobs )
+	{
+		if (count == 1)
+		{
+			return leaves[0];
+		}
+
+		// Split along the axis the centroids spread most on.
+		Math::Aabb centroidBounds = EmptyAabb();
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const Math::Float3& c = centroids[leaves[i]];
+			centroidBounds = Math::AabbUnion( centroidBounds, { c, c } );
+		}
+		const Math::Float3 extent( centroidBounds.Max.x - centroidBounds.Min.x, centroidBounds.Max.y - centroidBounds.Min.y,
+			centroidBounds.Max.z - centroidBounds.Min.z );
+		const int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+		const float axisMin = Axis( centroidBounds.Min, axis );
+		const float axisExtent = Axis( extent, axis );
+
+		uint32_t split = 0;
+		if (axisExtent > 0.0f)
+		{
+			const float scale = BinCount / axisExtent;
+			auto binOf = [&]( int32_t leaf )
+			{
+				const uint32_t bin = static_cast<uint32_t>((Axis( centroids[leaf], axis ) - axisMin) * scale);
+				return std::min( bin, BinCount - 1 );
+			};
+			uint32_t binCounts[BinCount] = {};
+			Math::Aabb binBounds[BinCount];
+			std::fill( binBounds, binBounds + BinCount, EmptyAabb() );
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				const uint32_t bin = binOf( leaves[i] );
+				++binCounts[bin];
+				binBounds[bin] = Math::AabbUnion( binBounds[bin], m_Nodes[leaves[i]].Bounds );
+			}
+
+			// SAH: cost of cutting after bin i is area * count on both sides.
+			float rightCosts[BinCount] = {};
+			Math::Aabb rightBounds = EmptyAabb();
+			uint32_t rightCount = 0;
+			for (uint32_t i = BinCount - 1; i > 0; --i)
+			{
+				rightBounds = Math::AabbUnion( rightBounds, binBounds[i] );
+				rightCount += binCounts[i];
+				rightCosts[i] = rightCount > 0 ? Math::AabbSurfaceArea( rightBounds ) * rightCount : 0.0f;
+			}
+			Math::Aabb leftBounds = EmptyAabb();
+			uint32_t leftCount = 0;
+			float bestCost = FLT_MAX;
+			uint32_t bestBin = BinCount;
+			for (uint32_t i = 0; i + 1 < BinCount; ++i)
+			{
+				leftBounds = Math::AabbUnion( leftBounds, binBounds[i] );
+				leftCount += binCounts[i];
+				if (leftCount == 0 || leftCount == count)
+				{
+					continue;
+				}
+				const float cost = Math::AabbSurfaceArea( leftBounds ) * leftCount + rightCosts[i + 1];
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestBin = i;
+				}
+			}
+			if (bestBin != BinCount)
+			{
+				split = static_cast<uint32_t>(std::partition( leaves, leaves + count,
+					[&]( int32_t leaf ) { return binOf( leaf ) <= bestBin; } ) - leaves);
+			}
+		}
+		if (split == 0 || split == count)
+		{
+			// Everything in one spot, halve it so the depth stays logarithmic.
+			split = count / 2;
+			std::nth_element( leaves, leaves + split, leaves + count, [&]( int32_t a, int32_t b )
+			{
+				return Axis( centroids[a], axis ) < Axis( centroids[b], axis );
+			} );
+		}
+
+		// A subtree of n leaves uses n - 1 internal nodes: this one, then the left's, then the right's.
+		const int32_t node = firstInternal;
+		int32_t left = NullNode;
+		int32_t right = NullNode;
+		if (jobs != nullptr && count >= ParallelBuildCount)
+		{
+			JobCounter counter;
+			jobs->Run( [&]() { left = BuildRange( leaves, centroids, split, firstInternal + 1, jobs ); }, &counter );
+			right = BuildRange( leaves + split, centroids, count - split, firstInternal + static_cast<int32_t>(split), jobs );
+			jobs->Wait( counter );
+		}
+		else
+		{
+			left = BuildRange( leaves, centroids, split, firstInternal + 1, jobs );
+			right = BuildRange( leaves + split, centroids, count - split, firstInternal + static_cast<int32_t>(split), jobs );
+		}
+
+		m_Nodes[node] = { Math::AabbUnion( m_Nodes[left].Bounds, m_Nodes[right].Bounds ), NullNode, left, right,
+			1 + std::max( m_Nodes[left].Height, m_Nodes[right].Height ), entt::null };
+		m_Nodes[left].Parent = node;
+		m_Nodes[right].Parent = node;
+		return node;
+	}
+
+	void AabbTree::InsertLeaf( int32_t leaf )
+	{
+		if (m_Root == NullNode)
+		{
+			m_Root = leaf;
+			m_Nodes[leaf].Parent = NullNode;
+			return;
+		}
+
+		// Walk down to the sibling that grows the tree least, the cost of going deeper includes
+		// every ancestor the leaf enlarges on the way.
+		const Math::Aabb bounds = m_Nodes[leaf].Bounds;
+		int32_t sibling = m_Root;
+		while (!IsLeaf( sibling ))
+		{
+			const Node& node = m_Nodes[sibling];
+			const float area = Math::AabbSurfaceArea( node.Bounds );
+			const float combinedArea = Math::AabbSurfaceArea( Math::AabbUnion( node.Bounds, bounds ) );
+			const float cost = 2.0f * combinedArea;
+			const float inheritance = 2.0f * (combinedArea - area);
+			auto descendCost = [&]( int32_t child )
+			{
+				const float grown = Math::AabbSurfaceArea( Math::AabbUnion( m_Nodes[child].Bounds, bounds ) );
+				return (IsLeaf( child ) ? grown : grown - Math::AabbSurfaceArea( m_Nodes[child].Bounds )) + inheritance;
+			};
+			const float leftCost = descendCost( node.Left );
+			const float rightCost = descendCost( node.Right );
+			if (cost < leftCost && cost < rightCost)
+			{
+				break;
+			}
+			sibling = leftCost < rightCost ? node.Left : node.Right;
+		}
+
+		const int32_t oldParent = m_Nodes[sibling].Parent;
+		const int32_t parent = AllocateNode();
+		m_Nodes[parent] = { Math::AabbUnion( bounds, m_Nodes[sibling].Bounds ), oldParent, sibling, leaf,
+			m_Nodes[sibling].Height + 1, entt::null };
+		m_Nodes[sibling].Parent = parent;
+		m_Nodes[leaf].Parent = parent;
+		if (oldParent == NullNode)
+		{
+			m_Root = parent;
+			return;
+		}
+		Node& grandparent = m_Nodes[oldParent];
+		(grandparent.Left == sibling ? grandparent.Left : grandparent.Right) = parent;
+		Refit( oldParent );
+	}
+
+	void AabbTree::RemoveLeaf( int32_t leaf )
+	{
+		if (leaf == m_Root)
+		{
+			m_Root = NullNode;
+			return;
+		}
+		const int32_t parent = m_Nodes[leaf].Parent;
+		const int32_t grandparent = m_Nodes[parent].Parent;
+		const int32_t sibling = m_Nodes[parent].Left == leaf ? m_Nodes[parent].Right : m_Nodes[parent].Left;
+		FreeNode( parent );
+		m_Nodes[sibling].Parent = grandparent;
+		if (grandparent == NullNode)
+		{
+			m_Root = sibling;
+			return;
+		}
+		Node& node = m_Nodes[grandparent];
+		(node.Left == parent ? node.Left : node.Right) = sibling;
+		Refit( grandparent );
+	}
+
+	void AabbTree::Refit( int32_t node )
+	{
+		while (node != NullNode)
+		{
+			Rotate( node );
+			Node& current = m_Nodes[node];
+			const Math::Aabb bounds = Math::AabbUnion( m_Nodes[current.Left].Bounds, m_Nodes[current.Right].Bounds );
+			const int32_t height = 1 + std::max( m_Nodes[current.Left].Height, m_Nodes[current.Right].Height );
+			if (Math::AabbEqual( bounds, current.Bounds ) && height == current.Height)
+			{
+				// Nothing above can change.
+				return;
+			}
+			current.Bounds = bounds;
+			current.Height = height;
+			node = current.Parent;
+		}
+	}
+
+	void AabbTree::Rotate( int32_t node )
+	{
+		// Kensler's rotations: swap a child with a grandchild on the other side when that shrinks
+		// the surface area of the grandchild's parent, which is all the SAH cost they change.
+		const int32_t left = m_Nodes[node].Left;
+		const int32_t right = m_Nodes[node].Right;
+		float bestGain = 0.0f;
+		int32_t outer = NullNode;
+		int32_t inner = NullNode;
+		auto consider = [&]( int32_t child, int32_t grandchild, int32_t keptGrandchild, int32_t innerParent )
+		{
+			const float gain = Math::AabbSurfaceArea( m_Nodes[innerParent].Bounds ) -
+				Math::AabbSurfaceArea( Math::AabbUnion( m_Nodes[child].Bounds, m_Nodes[keptGrandchild].Bounds ) );
+			if (gain > bestGain)
+			{
+				bestGain = gain;
+				outer = child;
+				inner = grandchild;
+			}
+		};
+		if (!IsLeaf( right ))
+		{
+			consider( left, m_Nodes[right].Left, m_Nodes[right].Right, right );
+			consider( left, m_Nodes[right].Right, m_Nodes[right].Left, right );
+		}
+		if (!IsLeaf( left ))
+		{
+			consider( right, m_Nodes[left].Left, m_Nodes[left].Right, left );
+			consider( right, m_Nodes[left].Right, m_Nodes[left].Left, left );
+		}
+		if (outer == NullNode)
+		{
+			return;
+		}
+
+		const int32_t innerParent = m_Nodes[inner].Parent;
+		Node& current = m_Nodes[node];
+		(current.Left == outer ? current.Left : current.Right) = inner;
+		Node& swapped = m_Nodes[innerParent];
+		(swapped.Left == inner ? swapped.Left : swapped.Right) = outer;
+		m_Nodes[inner].Parent = node;
+		m_Nodes[outer].Parent = innerParent;
+		swapped.Bounds = Math::AabbUnion( m_Nodes[swapped.Left].Bounds, m_Nodes[swapped.Right].Bounds );
+		swapped.Height = 1 + std::max( m_Nodes[swapped.Left].Height, m_Nodes[swapped.Right].Height );
+	}
+
+	void AabbTree::QueryAabb( const Math::Aabb& box, std::vector<entt::entity>& results ) const
+	{
+		std::vector<int32_t> stack;
+		QueryAabb( box, results, stack );
+	}
+
+	void AabbTree::QueryAabb( const Math::Aabb& box, std::vector<entt::entity>& results, std::vector<int32_t>& stack ) const
+	{
+		if (m_Root == NullNode)
+		{
+			return;
+		}
+		stack.clear();
+		stack.push_back( m_Root );
+		while (!stack.empty())
+		{
+			const Node& node = m_Nodes[stack.back()];
+			stack.pop_back();
+			if (!Math::AabbOverlaps( node.Bounds, box ))
+			{
+				continue;
+			}
+			if (node.Left == NullNode)
+			{
+				results.push_back( node.Entity );
+				continue;
+			}
+			stack.push_back( node.Right );
+			stack.push_back( node.Left );
+		}
+	}
+
+	void AabbTree::QueryFrustum( const Math::Frustum& frustum, std::vector<entt::entity>& results ) const
+	{
+		std::vector<int32_t> stack;
+		QueryFrustum( frustum, results, stack );
+	}
+
+	void AabbTree::QueryFrustum( const Math::Frustum& frustum, std::vector<entt::entity>& results, std::vector<int32_t>& stack ) const
+	{
+		if (m_Root == NullNode)
+		{
+			return;
+		}
+		// Nodes known to be inside go on the stack complemented, their leaves are taken untested.
+		stack.clear();
+		stack.push_back( m_Root );
+		while (!stack.empty())
+		{
+			const int32_t entry = stack.back();
+			stack.pop_back();
+			const bool inside = entry < 0;
+			const Node& node = m_Nodes[inside ? ~entry : entry];
+			Math::Containment containment = Math::Containment::Contains;
+			if (!inside)
+			{
+				containment = Math::FrustumContainsAabb( frustum, node.Bounds );
+				if (containment == Math::Containment::Disjoint)
+				{
+					continue;
+				}
+			}
+			if (node.Left == NullNode)
+			{
+				results.push_back( node.Entity );
+				continue;
+			}
+			if (containment == Math::Containment::Contains)
+			{
+				stack.push_back( ~node.Right );
+				stack.push_back( ~node.Left );
+				continue;
+			}
+			stack.push_back( node.Right );
+			stack.push_back( node.Left );
+		}
+	}
+
+	AabbTree::RayHit AabbTree::Raycast( const Math::Ray& ray ) const
+	{
+		std::vector<int32_t> stack;
+		return Raycast( ray, stack );
+	}
+
+	AabbTree::RayHit AabbTree::Raycast( const Math::Ray& ray, std::vector<int32_t>& stack ) const
+	{
+		RayHit hit;
+		if (m_Root == NullNode)
+		{
+			return hit;
+		}
+		// Shortened to the nearest hit so far, which prunes everything behind it.
+		Math::Ray clipped = ray;
+		const Math::Float3 inverseDirection = Math::RayInverseDirection( ray );
+		stack.clear();
+		stack.push_back( m_Root );
+		while (!stack.empty())
+		{
+			const Node& node = m_Nodes[stack.back()];
+			stack.pop_back();
+			float distance = 0.0f;
+			if (!Math::RayIntersectsAabb( clipped, inverseDirection, node.Bounds, distance ))
+			{
+				continue;
+			}
+			if (node.Left == NullNode)
+			{
+				hit = { node.Entity, distance };
+				clipped.MaxDistance = distance;
+				continue;
+			}
+			// Nearer child on top, so its hits prune the other one.
+			float leftDistance = 0.0f;
+			float rightDistance = 0.0f;
+			const bool leftHit = Math::RayIntersectsAabb( clipped, inverseDirection, m_Nodes[node.Left].Bounds, leftDistance );
+			const bool rightHit = Math::RayIntersectsAabb( clipped, inverseDirection, m_Nodes[node.Right].Bounds, rightDistance );
+			if (leftHit && rightHit)
+			{
+				const bool leftFirst = leftDistance <= rightDistance;
+				stack.push_back( leftFirst ? node.Right : node.Left );
+				stack.push_back( leftFirst ? node.Left : node.Right );
+			}
+			else if (leftHit || rightHit)
+			{
+				stack.push_back( leftHit ? node.Left : node.Right );
+			}
+		}
+		return hit;
+	}
+
+	void AabbTree::QueryAabbs( const Math::Aabb* boxes, uint32_t count, std::vector<entt::entity>* results, JobSystem* jobs ) const
+	{
+		auto run = [&]( uint32_t begin, uint32_t end )
+		{
+			std::vector<int32_t> stack;
+			for (uint32_t i = begin; i < end; ++i)
+			{
+				results[i].clear();
+				QueryAabb( boxes[i], results[i], stack );
+			}
+		};
+		if (jobs == nullptr || count <= QueryGrain)
+		{
+			run( 0, count );
+			return;
+		}
+		jobs->ParallelFor( count, QueryGrain, run );
+	}
+
+	void AabbTree::QueryFrustums( const Math::Frustum* frustums, uint32_t count, std::vector<entt::entity>* results, JobSystem* jobs ) const
+	{
+		auto run = [&]( uint32_t begin, uint32_t end )
+		{
+			std::vector<int32_t> stack;
+			for (uint32_t i = begin; i < end; ++i)
+			{
+				results[i].clear();
+				QueryFrustum( frustums[i], results[i], stack );
+			}
+		};
+		// Few frustums cost a lot each, one per job.
+		if (jobs == nullptr || count <= 1)
+		{
+			run( 0, count );
+			return;
+		}
+		jobs->ParallelFor( count, 1, run );
+	}
+
+	void AabbTree::Raycasts( const Math::Ray* rays, uint32_t count, RayHit* hits, JobSystem* jobs ) const
+	{
+		auto run = [&]( uint32_t begin, uint32_t end )
+		{
+			std::vector<int32_t> stack;
+			for (uint32_t i = begin; i < end; ++i)
+			{
+				hits[i] = Raycast( rays[i], stack );
+			}
+		};
+		if (jobs == nullptr || count <= QueryGrain)
+		{
+			run( 0, count );
+			return;
+		}
+		jobs->ParallelFor( count, QueryGrain, run );
+	}
+}
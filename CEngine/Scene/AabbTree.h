@@ -0,0 +1,120 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+
+#include "entt.hpp" // https://github.com/skypjack/entt
+#include "Jobs/JobSystem.h"
+#include "Math/Math.h"
+#include "TransformSystem.h"
+#include <cfloat>
+#include <cstdint>
+#include <vector>
+
+namespace CronoEngine
+{
+	/**
+	 * Dynamic bounding volume hierarchy over the world bounds of every TransformComponent (its
+	 * BoundsComponent, or a unit cube, through the world matrix). A binned SAH build makes the
+	 * tree when it's empty or when a frame moved a big part of it; after that moved leaves are
+	 * refit in place and new ones inserted where they grow the tree least, with tree rotations
+	 * on the way up so it stays close to the SAH build while things move.
+	 * Queries only read the tree: any number may run at once, but not during Update.
+	 */
+	class AabbTree
+	{
+	public:
+		static constexpr int32_t NullNode = -1;
+		// Rebuilds from scratch when one Update touches more than LeafCount / RebuildDivisor leaves.
+		static constexpr uint32_t RebuildDivisor = 4;
+
+		struct RayHit
+		{
+			entt::entity Entity = entt::null;
+			// Where the ray enters the entity's box, in multiples of its direction.
+			float Distance = FLT_MAX;
+		};
+
+		// entity's BoundsComponent, or a unit cube, through world.
+		static Math::Aabb GetWorldBounds( const entt::registry& registry, entt::entity entity, const Math::Float4x4A& world );
+
+		/**
+		 * Catches up with the TransformSystem's last Update (its dirty indices) and with changed,
+		 * entities whose TransformComponent was removed or whose BoundsComponent changed.
+		 */
+		void Update( entt::registry& registry, const TransformSystem& transforms,
+			const std::vector<entt::entity>& changed, JobSystem* jobs );
+		void Clear();
+
+		// Appends what overlaps box.
+		void QueryAabb( const Math::Aabb& box, std::vector<entt::entity>& results ) const;
+		// Appends what is at least partly inside frustum, whole subtrees at once when they are inside.
+		void QueryFrustum( const Math::Frustum& frustum, std::vector<entt::entity>& results ) const;
+		// Nearest box the ray enters.
+		RayHit Raycast( const Math::Ray& ray ) const;
+
+		// Batches, results[i] (cleared first) or hits[i] for the i-th query, split over jobs when there are some.
+		void QueryAabbs( const Math::Aabb* boxes, uint32_t count, std::vector<entt::entity>* results, JobSystem* jobs ) const;
+		void QueryFrustums( const Math::Frustum* frustums, uint32_t count, std::vector<entt::entity>* results, JobSystem* jobs ) const;
+		void Raycasts( const Math::Ray* rays, uint32_t count, RayHit* hits, JobSystem* jobs ) const;
+
+		uint32_t GetLeafCount() const noexcept;
+		// Longest path from the root to a leaf, 0 for a lone leaf.
+		int32_t GetHeight() const noexcept;
+		// Sum of the internal nodes' surface areas over the root's, lower is better. Walks the whole tree.
+		float ComputeCost() const;
+		// Current world bounds of entity's leaf, null when it has none.
+		const Math::Aabb* FindBounds( entt::entity entity ) const noexcept;
+	private:
+		struct Node
+		{
+			Math::Aabb Bounds;
+			int32_t Parent;
+			// NullNode on both for a leaf.
+			int32_t Left;
+			int32_t Right;
+			int32_t Height;
+			entt::entity Entity;
+		};
+
+		bool IsLeaf( int32_t node ) const noexcept;
+		int32_t FindLeaf( entt::entity entity ) const noexcept;
+		int32_t AllocateNode();
+		void FreeNode( int32_t node ) noexcept;
+		void Rebuild( entt::registry& registry, const TransformSystem& transforms, JobSystem* jobs );
+		int32_t BuildRange( int32_t* leaves, const Math::Float3* centroids, uint32_t count, int32_t firstInternal, JobSystem* jobs );
+		void SyncEntity( entt::registry& registry, const TransformSystem& transforms, entt::entity entity, uint32_t index );
+		void InsertLeaf( int32_t leaf );
+		void RemoveLeaf( int32_t leaf );
+		// Recomputes bounds and heights from node up to the root, rotating where it lowers the SAH cost.
+		void Refit( int32_t node );
+		void Rotate( int32_t node );
+		void QueryAabb( const Math::Aabb& box, std::vector<entt::entity>& results, std::vector<int32_t>& stack ) const;
+		void QueryFrustum( const Math::Frustum& frustum, std::vector<entt::entity>& results, std::vector<int32_t>& stack ) const;
+		RayHit Raycast( const Math::Ray& ray, std::vector<int32_t>& stack ) const;
+	private:
+		std::vector<Node> m_Nodes;
+		int32_t m_Root = NullNode;
+		// Freed nodes, linked through Parent.
+		int32_t m_FreeList = NullNode;
+		uint32_t m_LeafCount = 0;
+		// Entity id to its leaf, only trusted when the leaf's Entity agrees.
+		std::vector<int32_t> m_Leaves;
+	};
+}
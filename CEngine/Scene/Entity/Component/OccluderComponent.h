@@ -0,0 +1,39 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+#include "Math/Math.h"
+#include <memory>
+#include <vector>
+
+// Simplified closed geometry in local space, a wall without its trim, a building without its
+// windows. It must not stick out of what it stands for or it hides things that should show.
+struct OccluderMesh
+{
+	std::vector<CronoEngine::Math::Float3> Vertices;
+	// Three per triangle, either winding.
+	std::vector<uint32_t> Indices;
+};
+
+// Marks an entity as an occluder: its mesh goes through its world matrix into the OcclusionBuffer.
+struct OccluderComponent
+{
+	// Shared between every entity that uses the same shape.
+	std::shared_ptr<const OccluderMesh> Mesh;
+};
@@ -18,14 +18,23 @@
 *	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
 ******************************************************************************************/
 #pragma once
-#include <DirectXMath.h>
+#include "Math/Math.h"
+#include "Scene/TransformSystem.h"
 
 struct TransformComponent
 {
+	friend class CronoEngine::TransformSystem;
 private:
-	DirectX::XMFLOAT3A m_Position{};
-	DirectX::XMFLOAT3A m_Rotation{};
-	DirectX::XMFLOAT3A m_Scale{};
+	CronoEngine::Math::Float3A m_Position{};
+	CronoEngine::Math::Float3A m_Rotation{};
+	CronoEngine::Math::Float3A m_Scale{};
+	// Rebuilt on first use after a setter changed what they depend on, or by the scene's TransformSystem.
+	CronoEngine::Math::Float4A m_Quaternion{};
+	CronoEngine::Math::Float4x4A m_LocalMatrix{};
+	bool m_QuaternionDirty = true;
+	bool m_MatrixDirty = true;
+	// Set by the setters, cleared once the scene's TransformSystem picked the change up.
+	bool m_Moved = true;
 public:
 	TransformComponent()
 	{
@@ -34,14 +43,14 @@ public:
 		m_Scale = { 1.0f, 1.0f, 1.0f };
 	}
 
-	TransformComponent( DirectX::XMFLOAT3A position, DirectX::XMFLOAT3A rotation, DirectX::XMFLOAT3A scale )
+	TransformComponent( CronoEngine::Math::Float3A position, CronoEngine::Math::Float3A rotation, CronoEngine::Math::Float3A scale )
 	{
 		m_Position = position;
 		m_Rotation = rotation;
 		m_Scale = scale;
 	}
 
-	DirectX::XMFLOAT3A GetPosition()
+	CronoEngine::Math::Float3A GetPosition() const
 	{
 		return m_Position;
 	}
@@ -50,9 +59,11 @@ public:
 		m_Position.x = x;
 		m_Position.y = y;
 		m_Position.z = z;
+		m_MatrixDirty = true;
+		m_Moved = true;
 	}
 
-	DirectX::XMFLOAT3A GetRotation()
+	CronoEngine::Math::Float3A GetRotation() const
 	{
 		return m_Rotation;
 	}
@@ -61,9 +72,12 @@ public:
 		m_Rotation.x = x;
 		m_Rotation.y = y;
 		m_Rotation.z = z;
+		m_QuaternionDirty = true;
+		m_MatrixDirty = true;
+		m_Moved = true;
 	}
 
-	DirectX::XMFLOAT3A GetScale()
+	CronoEngine::Math::Float3A GetScale() const
 	{
 		return m_Scale;
 	}
@@ -72,17 +86,37 @@ public:
 		m_Scale.x = x;
 		m_Scale.y = y;
 		m_Scale.z = z;
+		m_MatrixDirty = true;
+		m_Moved = true;
 	}
 
-	DirectX::XMFLOAT4 GetRotationQuaternionFloat4()
+	// Changed since the last TransformSystem::Update of its scene.
+	bool HasMoved() const
 	{
-		DirectX::XMVECTOR quaternion = DirectX::XMQuaternionRotationRollPitchYaw( m_Rotation.x, m_Rotation.y, m_Rotation.z );
-		DirectX::XMFLOAT4 quaternionFloat4{};
-		DirectX::XMStoreFloat4( &quaternionFloat4, quaternion );
-		return quaternionFloat4;
+		return m_Moved;
 	}
-	DirectX::XMVECTOR GetRotationQuaternion()
+
+	CronoEngine::Math::Float4 GetRotationQuaternionFloat4()
+	{
+		if (m_QuaternionDirty)
+		{
+			CronoEngine::TransformSystem::ComputeLocal( *this );
+		}
+		return m_Quaternion;
+	}
+	CronoEngine::Math::Vector GetRotationQuaternion()
+	{
+		GetRotationQuaternionFloat4();
+		return CronoEngine::Math::LoadFloat4A( &m_Quaternion );
+	}
+
+	// Scale, then rotation, then translation.
+	const CronoEngine::Math::Float4x4A& GetLocalMatrix()
 	{
-		return DirectX::XMQuaternionRotationRollPitchYaw( m_Rotation.x, m_Rotation.y, m_Rotation.z );
+		if (m_MatrixDirty)
+		{
+			CronoEngine::TransformSystem::ComputeLocal( *this );
+		}
+		return m_LocalMatrix;
 	}
 };
\ No newline at end of file
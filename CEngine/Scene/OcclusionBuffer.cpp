@@ -0,0 +1,413 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "OcclusionBuffer.h"
+#include "Common/CronoTimer.h"
+#include "Math/VectorBatch.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace CronoEngine
+{
+	using namespace Math;
+
+	namespace
+	{
+		// Pixel centers of a span.
+		alignas(32) constexpr float SpanOffsets[OcclusionBuffer::TileWidth] = { 0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f };
+		constexpr uint32_t TestGrain = 256;
+		constexpr uint32_t SetupGrain = 8;
+
+		template<typename F>
+		void ForEachRange( uint32_t count, uint32_t grain, JobSystem* jobs, F&& function )
+		{
+			if (jobs == nullptr || count <= grain)
+			{
+				function( 0, count );
+				return;
+			}
+			jobs->ParallelFor( count, grain, function );
+		}
+	}
+
+	OcclusionBuffer::OcclusionBuffer()
+	{
+		Resize( DefaultWidth, DefaultHeight );
+	}
+
+	void OcclusionBuffer::Resize( uint32_t width, uint32_t height )
+	{
+		m_TilesX = std::max( 1u, (width + TileWidth - 1) / TileWidth );
+		m_TilesY = std::max( 1u, (height + TileHeight - 1) / TileHeight );
+		m_Width = m_TilesX * TileWidth;
+		m_Height = m_TilesY * TileHeight;
+		Span cleared;
+		std::fill( std::begin( cleared.Depth ), std::end( cleared.Depth ), 1.0f );
+		m_Depth.assign( static_cast<size_t>(m_TilesX) * m_Height, cleared );
+		m_TileMaxDepth.assign( static_cast<size_t>(m_TilesX) * m_TilesY, 1.0f );
+	}
+
+	uint32_t OcclusionBuffer::GetWidth() const noexcept
+	{
+		return m_Width;
+	}
+
+	uint32_t OcclusionBuffer::GetHeight() const noexcept
+	{
+		return m_Height;
+	}
+
+	const OcclusionBuffer::Metrics& OcclusionBuffer::GetMetrics() const noexcept
+	{
+		return m_Metrics;
+	}
+
+	float OcclusionBuffer::GetDepth( uint32_t x, uint32_t y ) const noexcept
+	{
+		return m_Depth[static_cast<size_t>(y) * m_TilesX + x / TileWidth].Depth[x % TileWidth];
+	}
+
+	void OcclusionBuffer::Render( const Float4x4& viewProjection, const Instance* occluders, uint32_t count, JobSystem* jobs )
+	{
+		CronoTimer timer;
+		m_ViewProjection = viewProjection;
+		m_Metrics = {};
+		m_Metrics.Occluders = count;
+
+		m_Triangles.resize( count );
+		ForEachRange( count, SetupGrain, jobs, [&]( uint32_t begin, uint32_t end )
+		{
+			for (uint32_t i = begin; i < end; ++i)
+			{
+				m_Triangles[i].clear();
+				SetupTriangles( occluders[i], m_Triangles[i] );
+			}
+		} );
+		m_AllTriangles.clear();
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			m_Metrics.OccluderTriangles += static_cast<uint32_t>(occluders[i].Mesh->Indices.size() / 3);
+			m_AllTriangles.insert( m_AllTriangles.end(), m_Triangles[i].begin(), m_Triangles[i].end() );
+		}
+		m_Metrics.RasterizedTriangles = static_cast<uint32_t>(m_AllTriangles.size());
+
+		// Bands own whole tile rows, so no two jobs write the same pixel or tile.
+		const uint32_t bandRows = BandTileRows * TileHeight;
+		const uint32_t bandCount = (m_Height + bandRows - 1) / bandRows;
+		ForEachRange( bandCount, 1, jobs, [&]( uint32_t begin, uint32_t end )
+		{
+			for (uint32_t band = begin; band < end; ++band)
+			{
+				RasterizeBand( m_AllTriangles.data(), static_cast<uint32_t>(m_AllTriangles.size()),
+					band * bandRows, std::min( m_Height, (band + 1) * bandRows ) );
+			}
+		} );
+		m_Metrics.RenderMilliseconds = timer.Mark() * 1000.0;
+	}
+
+	void OcclusionBuffer::SetupTriangles( const Instance& occluder, std::vector<Triangle>& triangles ) const
+	{
+		const OccluderMesh& mesh = *occluder.Mesh;
+		const Matrix m = MatrixMultiply( LoadFloat4x4A( occluder.World ), LoadFloat4x4( &m_ViewProjection ) );
+		std::vector<Float4> clip( mesh.Vertices.size() );
+		for (size_t i = 0; i < clip.size(); ++i)
+		{
+			StoreFloat4( &clip[i], Vector3Transform( LoadFloat3( &mesh.Vertices[i] ), m ) );
+		}
+
+		for (size_t i = 0; i + 2 < mesh.Indices.size(); i += 3)
+		{
+			const Float4 vertices[3] = { clip[mesh.Indices[i]], clip[mesh.Indices[i + 1]], clip[mesh.Indices[i + 2]] };
+			// Entirely outside one of the side planes, or in front of the near plane.
+			bool outside = false;
+			for (int plane = 0; plane < 5 && !outside; ++plane)
+			{
+				auto distance = [plane]( const Float4& v )
+				{
+					return plane == 0 ? v.w + v.x : plane == 1 ? v.w - v.x : plane == 2 ? v.w + v.y : plane == 3 ? v.w - v.y : v.z;
+				};
+				outside = distance( vertices[0] ) < 0.0f && distance( vertices[1] ) < 0.0f && distance( vertices[2] ) < 0.0f;
+			}
+			if (outside)
+			{
+				continue;
+			}
+			if (vertices[0].z >= 0.0f && vertices[1].z >= 0.0f && vertices[2].z >= 0.0f)
+			{
+				AddTriangle( vertices, triangles );
+				continue;
+			}
+
+			// Clip against the near plane (z >= 0), which leaves a triangle or a quad.
+			Float4 polygon[4];
+			uint32_t corners = 0;
+			for (int k = 0; k < 3; ++k)
+			{
+				const Float4& a = vertices[k];
+				const Float4& b = vertices[(k + 1) % 3];
+				if (a.z >= 0.0f)
+				{
+					polygon[corners++] = a;
+				}
+				if ((a.z >= 0.0f) != (b.z >= 0.0f))
+				{
+					const float t = a.z / (a.z - b.z);
+					polygon[corners++] = { a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, 0.0f, a.w + (b.w - a.w) * t };
+				}
+			}
+			for (uint32_t k = 2; k < corners; ++k)
+			{
+				const Float4 fan[3] = { polygon[0], polygon[k - 1], polygon[k] };
+				AddTriangle( fan, triangles );
+			}
+		}
+	}
+
+	void OcclusionBuffer::AddTriangle( const Float4* clip, std::vector<Triangle>& triangles ) const
+	{
+		float x[3], y[3], z[3];
+		for (int k = 0; k < 3; ++k)
+		{
+			const float inverseW = 1.0f / clip[k].w;
+			x[k] = (clip[k].x * inverseW * 0.5f + 0.5f) * m_Width;
+			y[k] = (0.5f - clip[k].y * inverseW * 0.5f) * m_Height;
+			z[k] = clip[k].z * inverseW;
+		}
+		float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+		if (!(std::abs( area ) > 1e-8f))
+		{
+			return;
+		}
+		if (area < 0.0f)
+		{
+			// Both windings rasterize, make it positive so inside is E >= 0.
+			std::swap( x[1], x[2] );
+			std::swap( y[1], y[2] );
+			std::swap( z[1], z[2] );
+			area = -area;
+		}
+
+		// Pixels whose centers (i + 0.5) fall in the bounds, clamped in float before the cast.
+		const float width = static_cast<float>(m_Width);
+		const float height = static_cast<float>(m_Height);
+		const float minX = std::clamp( std::min( { x[0], x[1], x[2] } ), -1.0f, width + 1.0f );
+		const float maxX = std::clamp( std::max( { x[0], x[1], x[2] } ), -1.0f, width + 1.0f );
+		const float minY = std::clamp( std::min( { y[0], y[1], y[2] } ), -1.0f, height + 1.0f );
+		const float maxY = std::clamp( std::max( { y[0], y[1], y[2] } ), -1.0f, height + 1.0f );
+		Triangle triangle;
+		triangle.MinX = std::max( 0, static_cast<int32_t>(std::ceil( minX - 0.5f )) );
+		triangle.MaxX = std::min( static_cast<int32_t>(m_Width) - 1, static_cast<int32_t>(std::floor( maxX - 0.5f )) );
+		triangle.MinY = std::max( 0, static_cast<int32_t>(std::ceil( minY - 0.5f )) );
+		triangle.MaxY = std::min( static_cast<int32_t>(m_Height) - 1, static_cast<int32_t>(std::floor( maxY - 0.5f )) );
+		if (triangle.MinX > triangle.MaxX || triangle.MinY > triangle.MaxY)
+		{
+			return;
+		}
+
+		for (int k = 0; k < 3; ++k)
+		{
+			const int next = (k + 1) % 3;
+			triangle.EdgeA[k] = y[k] - y[next];
+			triangle.EdgeB[k] = x[next] - x[k];
+			triangle.EdgeC[k] = -(triangle.EdgeA[k] * x[k] + triangle.EdgeB[k] * y[k]);
+		}
+		const float inverseArea = 1.0f / area;
+		triangle.DepthX = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) * inverseArea;
+		triangle.DepthY = ((z[2] - z[0]) * (x[1] - x[0]) - (z[1] - z[0]) * (x[2] - x[0])) * inverseArea;
+		triangle.Depth0 = z[0] - triangle.DepthX * x[0] - triangle.DepthY * y[0];
+		triangles.push_back( triangle );
+	}
+
+	void OcclusionBuffer::RasterizeBand( const Triangle* triangles, uint32_t count, uint32_t beginRow, uint32_t endRow ) noexcept
+	{
+		Span* const rows = m_Depth.data();
+		const Batch cleared = BatchReplicate( 1.0f );
+		for (size_t i = static_cast<size_t>(beginRow) * m_TilesX; i < static_cast<size_t>(endRow) * m_TilesX; ++i)
+		{
+			for (uint32_t lane = 0; lane < TileWidth; lane += BatchWidth)
+			{
+				BatchStoreA( rows[i].Depth + lane, cleared );
+			}
+		}
+
+		const Batch zero = BatchReplicate( 0.0f );
+		for (uint32_t t = 0; t < count; ++t)
+		{
+			const Triangle& triangle = triangles[t];
+			const int32_t firstRow = std::max( triangle.MinY, static_cast<int32_t>(beginRow) );
+			const int32_t lastRow = std::min( triangle.MaxY, static_cast<int32_t>(endRow) - 1 );
+			if (firstRow > lastRow)
+			{
+				continue;
+			}
+			const Batch a0 = BatchReplicate( triangle.EdgeA[0] );
+			const Batch a1 = BatchReplicate( triangle.EdgeA[1] );
+			const Batch a2 = BatchReplicate( triangle.EdgeA[2] );
+			const Batch depthX = BatchReplicate( triangle.DepthX );
+			const uint32_t firstSpan = static_cast<uint32_t>(triangle.MinX) / TileWidth;
+			const uint32_t lastSpan = static_cast<uint32_t>(triangle.MaxX) / TileWidth;
+			for (int32_t y = firstRow; y <= lastRow; ++y)
+			{
+				const float py = static_cast<float>(y) + 0.5f;
+				const Batch row0 = BatchReplicate( triangle.EdgeB[0] * py + triangle.EdgeC[0] );
+				const Batch row1 = BatchReplicate( triangle.EdgeB[1] * py + triangle.EdgeC[1] );
+				const Batch row2 = BatchReplicate( triangle.EdgeB[2] * py + triangle.EdgeC[2] );
+				const Batch rowDepth = BatchReplicate( triangle.DepthY * py + triangle.Depth0 );
+				Span* const row = rows + static_cast<size_t>(y) * m_TilesX;
+				for (uint32_t span = firstSpan; span <= lastSpan; ++span)
+				{
+					const Batch spanX = BatchReplicate( static_cast<float>(span * TileWidth) );
+					for (uint32_t lane = 0; lane < TileWidth; lane += BatchWidth)
+					{
+						const Batch px = BatchAdd( spanX, BatchLoadA( SpanOffsets + lane ) );
+						Batch inside = BatchLessOrEqual( zero, BatchMultiplyAdd( a0, px, row0 ) );
+						inside = BatchAndInt( inside, BatchLessOrEqual( zero, BatchMultiplyAdd( a1, px, row1 ) ) );
+						inside = BatchAndInt( inside, BatchLessOrEqual( zero, BatchMultiplyAdd( a2, px, row2 ) ) );
+						const Batch depth = BatchMultiplyAdd( depthX, px, rowDepth );
+						float* const stored = row[span].Depth + lane;
+						const Batch current = BatchLoadA( stored );
+						BatchStoreA( stored, BatchSelect( current, BatchMin( current, depth ), inside ) );
+					}
+				}
+			}
+		}
+
+		// Farthest depth per tile, what lets TestBoxes skip whole tiles.
+		for (uint32_t tileY = beginRow / TileHeight; tileY < endRow / TileHeight; ++tileY)
+		{
+			for (uint32_t tileX = 0; tileX < m_TilesX; ++tileX)
+			{
+				Batch farthest = zero;
+				for (uint32_t y = tileY * TileHeight; y < (tileY + 1) * TileHeight; ++y)
+				{
+					for (uint32_t lane = 0; lane < TileWidth; lane += BatchWidth)
+					{
+						farthest = BatchMax( farthest, BatchLoadA( rows[static_cast<size_t>(y) * m_TilesX + tileX].Depth + lane ) );
+					}
+				}
+				alignas(32) float lanes[BatchWidth];
+				BatchStoreA( lanes, farthest );
+				m_TileMaxDepth[static_cast<size_t>(tileY) * m_TilesX + tileX] = *std::max_element( lanes, lanes + BatchWidth );
+			}
+		}
+	}
+
+	bool OcclusionBuffer::IsVisible( const Aabb& box ) const noexcept
+	{
+		const Matrix m = LoadFloat4x4( &m_ViewProjection );
+		float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+		float nearest = FLT_MAX;
+		for (int corner = 0; corner < 8; ++corner)
+		{
+			const Float3 point( corner & 1 ? box.Max.x : box.Min.x, corner & 2 ? box.Max.y : box.Min.y, corner & 4 ? box.Max.z : box.Min.z );
+			Float4 clip;
+			StoreFloat4( &clip, Vector3Transform( LoadFloat3( &point ), m ) );
+			if (!(clip.w > 0.0f) || clip.z < 0.0f)
+			{
+				// Crosses the near plane, it may cover the whole screen.
+				return true;
+			}
+			const float inverseW = 1.0f / clip.w;
+			const float x = (clip.x * inverseW * 0.5f + 0.5f) * m_Width;
+			const float y = (0.5f - clip.y * inverseW * 0.5f) * m_Height;
+			minX = std::min( minX, x );
+			maxX = std::max( maxX, x );
+			minY = std::min( minY, y );
+			maxY = std::max( maxY, y );
+			nearest = std::min( nearest, clip.z * inverseW );
+		}
+		if (maxX < 0.0f || minX > m_Width || maxY < 0.0f || minY > m_Height)
+		{
+			return false;
+		}
+
+		// Every pixel the rectangle touches, not only the centers inside it, so small boxes
+		// between pixel centers are still tested.
+		const int32_t x0 = std::max( 0, static_cast<int32_t>(std::floor( minX )) );
+		const int32_t x1 = std::min( static_cast<int32_t>(m_Width) - 1, std::max( x0, static_cast<int32_t>(std::ceil( maxX )) - 1 ) );
+		const int32_t y0 = std::max( 0, static_cast<int32_t>(std::floor( minY )) );
+		const int32_t y1 = std::min( static_cast<int32_t>(m_Height) - 1, std::max( y0, static_cast<int32_t>(std::ceil( maxY )) - 1 ) );
+		const Batch boxDepth = BatchReplicate( nearest );
+		for (int32_t tileY = y0 / static_cast<int32_t>(TileHeight); tileY <= y1 / static_cast<int32_t>(TileHeight); ++tileY)
+		{
+			for (int32_t tileX = x0 / static_cast<int32_t>(TileWidth); tileX <= x1 / static_cast<int32_t>(TileWidth); ++tileX)
+			{
+				if (m_TileMaxDepth[static_cast<size_t>(tileY) * m_TilesX + tileX] < nearest)
+				{
+					continue;
+				}
+				const int32_t left = tileX * static_cast<int32_t>(TileWidth);
+				const uint32_t columns = ((2u << (std::min( x1, left + static_cast<int32_t>(TileWidth) - 1 ) - left)) - 1) &
+					~((1u << (std::max( x0, left ) - left)) - 1);
+				const int32_t top = tileY * static_cast<int32_t>(TileHeight);
+				for (int32_t y = std::max( y0, top ); y <= std::min( y1, top + static_cast<int32_t>(TileHeight) - 1 ); ++y)
+				{
+					const Span& span = m_Depth[static_cast<size_t>(y) * m_TilesX + tileX];
+					for (uint32_t lane = 0; lane < TileWidth; lane += BatchWidth)
+					{
+						const uint32_t behind = BatchMoveMask( BatchLessOrEqual( boxDepth, BatchLoadA( span.Depth + lane ) ) ) << lane;
+						if (behind & columns)
+						{
+							return true;
+						}
+					}
+				}
+			}
+		}
+		return false;
+	}
+
+	void OcclusionBuffer::TestBoxes( const Aabb* boxes, uint32_t count, uint8_t* visible, JobSystem* jobs )
+	{
+		CronoTimer timer;
+		std::atomic<uint32_t> occluded = 0;
+		ForEachRange( count, TestGrain, jobs, [&]( uint32_t begin, uint32_t end )
+		{
+			uint32_t hidden = 0;
+			for (uint32_t i = begin; i < end; ++i)
+			{
+				visible[i] = IsVisible( boxes[i] ) ? 1 : 0;
+				hidden += visible[i] ^ 1;
+			}
+			occluded.fetch_add( hidden, std::memory_order_relaxed );
+		} );
+		m_Metrics.TestedBoxes = count;
+		m_Metrics.OccludedBoxes = occluded.load();
+		m_Metrics.TestMilliseconds = timer.Mark() * 1000.0;
+	}
+
+	OccluderMesh OcclusionBuffer::MakeBox( const Aabb& box )
+	{
+		OccluderMesh mesh;
+		for (int corner = 0; corner < 8; ++corner)
+		{
+			mesh.Vertices.emplace_back( corner & 1 ? box.Max.x : box.Min.x, corner & 2 ? box.Max.y : box.Min.y, corner & 4 ? box.Max.z : box.Min.z );
+		}
+		// Two triangles per face: -x, +x, -y, +y, -z, +z.
+		mesh.Indices = {
+			0, 4, 6, 0, 6, 2,
+			1, 3, 7, 1, 7, 5,
+			0, 1, 5, 0, 5, 4,
+			2, 6, 7, 2, 7, 3,
+			0, 2, 3, 0, 3, 1,
+			4, 5, 7, 4, 7, 6 };
+		return mesh;
+	}
+}
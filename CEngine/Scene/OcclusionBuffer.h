@@ -0,0 +1,138 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+
+#include "Entity/Component/OccluderComponent.h"
+#include "Jobs/JobSystem.h"
+#include "Math/Math.h"
+#include <cstdint>
+#include <vector>
+
+namespace CronoEngine
+{
+	/**
+	 * Low resolution depth buffer on the CPU for occlusion culling. Render rasterizes occluder
+	 * meshes into it a Math::Batch of pixels at a time (8 on AVX2, 4 on SSE), keeping the
+	 * nearest depth, in horizontal bands over the job system, then stores the farthest depth
+	 * of every 8x4 tile. TestBoxes projects boxes to a screen rectangle and their nearest
+	 * depth: tiles whose farthest depth is nearer hide the box outright, the others are
+	 * checked pixel by pixel. Depth is D3D style, 0 at the near plane and 1 at the far one.
+	 * Occluders are rasterized on both sides and at pixel centers, so they should be a bit
+	 * smaller than what they stand for.
+	 */
+	class OcclusionBuffer
+	{
+	public:
+		static constexpr uint32_t TileWidth = 8;
+		static constexpr uint32_t TileHeight = 4;
+		static constexpr uint32_t DefaultWidth = 256;
+		static constexpr uint32_t DefaultHeight = 128;
+
+		struct Instance
+		{
+			const OccluderMesh* Mesh;
+			const Math::Float4x4A* World;
+		};
+
+		// Of the last Render and TestBoxes.
+		struct Metrics
+		{
+			uint32_t Occluders = 0;
+			uint32_t OccluderTriangles = 0;
+			// Left after near plane clipping and dropping the ones that cover no pixel center.
+			uint32_t RasterizedTriangles = 0;
+			uint32_t TestedBoxes = 0;
+			uint32_t OccludedBoxes = 0;
+			double RenderMilliseconds = 0.0;
+			double TestMilliseconds = 0.0;
+
+			float GetOccludedPercent() const noexcept
+			{
+				return TestedBoxes != 0 ? 100.0f * OccludedBoxes / TestedBoxes : 0.0f;
+			}
+		};
+
+		OcclusionBuffer();
+		// Rounded up to whole tiles.
+		void Resize( uint32_t width, uint32_t height );
+		uint32_t GetWidth() const noexcept;
+		uint32_t GetHeight() const noexcept;
+
+		/**
+		 * Clears the buffer and rasterizes the occluders as seen through viewProjection (row
+		 * vectors, D3D depth), which TestBoxes then uses too.
+		 */
+		void Render( const Math::Float4x4& viewProjection, const Instance* occluders, uint32_t count, JobSystem* jobs );
+		// Whether some of box may show over the occluders. Boxes crossing the near plane always do.
+		bool IsVisible( const Math::Aabb& box ) const noexcept;
+		// visible[i] = IsVisible( boxes[i] ), split over jobs and counted in the metrics.
+		void TestBoxes( const Math::Aabb* boxes, uint32_t count, uint8_t* visible, JobSystem* jobs );
+
+		const Metrics& GetMetrics() const noexcept;
+		// Nearest depth at pixel (x, y), y going down from the top row.
+		float GetDepth( uint32_t x, uint32_t y ) const noexcept;
+
+		// Closed box mesh, twelve triangles.
+		static OccluderMesh MakeBox( const Math::Aabb& box );
+	private:
+		// One row of a tile.
+		struct alignas(32) Span
+		{
+			float Depth[TileWidth];
+		};
+
+		// Screen space triangle set up for edge functions, E(x, y) = A * x + B * y + C >= 0 inside.
+		struct Triangle
+		{
+			float EdgeA[3];
+			float EdgeB[3];
+			float EdgeC[3];
+			// Depth = DepthX * x + DepthY * y + Depth0.
+			float DepthX;
+			float DepthY;
+			float Depth0;
+			int32_t MinX;
+			int32_t MinY;
+			int32_t MaxX;
+			int32_t MaxY;
+		};
+
+		void SetupTriangles( const Instance& occluder, std::vector<Triangle>& triangles ) const;
+		void AddTriangle( const Math::Float4* clip, std::vector<Triangle>& triangles ) const;
+		void RasterizeBand( const Triangle* triangles, uint32_t count, uint32_t beginRow, uint32_t endRow ) noexcept;
+	private:
+		// Tile rows per band job.
+		static constexpr uint32_t BandTileRows = 4;
+
+		uint32_t m_Width = 0;
+		uint32_t m_Height = 0;
+		uint32_t m_TilesX = 0;
+		uint32_t m_TilesY = 0;
+		Math::Float4x4 m_ViewProjection;
+		// Row major, m_TilesX spans per pixel row.
+		std::vector<Span> m_Depth;
+		// Farthest depth of each tile.
+		std::vector<float> m_TileMaxDepth;
+		// Per occluder, so they can be set up side by side.
+		std::vector<std::vector<Triangle>> m_Triangles;
+		std::vector<Triangle> m_AllTriangles;
+		Metrics m_Metrics;
+	};
+}
@@ -19,16 +19,275 @@
 ******************************************************************************************/
 #include "Scene.h"
 #include "Entity/Component/TransformComponent.h"
+#include "Entity/Component/HierarchyComponent.h"
+#include "Entity/Component/BoundsComponent.h"
+#include "Entity/Component/OccluderComponent.h"
+#include "Graphics/FramePacket.h"
 
 namespace CronoEngine
 {
 	Scene::Scene()
 	{
-		
+		m_Registry.on_construct<TransformComponent>().connect<&Scene::OnTransformChanged>( this );
+		m_Registry.on_update<TransformComponent>().connect<&Scene::OnTransformChanged>( this );
+		m_Registry.on_destroy<TransformComponent>().connect<&Scene::OnTransformChanged>( this );
+		m_Registry.on_destroy<TransformComponent>().connect<&Scene::OnTransformRemoved>( this );
+		m_Registry.on_construct<HierarchyComponent>().connect<&Scene::OnHierarchyChanged>( this );
+		m_Registry.on_update<HierarchyComponent>().connect<&Scene::OnHierarchyChanged>( this );
+		m_Registry.on_destroy<HierarchyComponent>().connect<&Scene::OnHierarchyChanged>( this );
+		m_Registry.on_construct<BoundsComponent>().connect<&Scene::OnBoundsChanged>( this );
+		m_Registry.on_update<BoundsComponent>().connect<&Scene::OnBoundsChanged>( this );
+		m_Registry.on_destroy<BoundsComponent>().connect<&Scene::OnBoundsChanged>( this );
 	}
 
 	Scene::~Scene()
 	{
 
 	}
+
+	uint64_t Scene::GetChangeCount() const noexcept
+	{
+		return m_ChangeCount;
+	}
+
+	const std::vector<entt::entity>& Scene::GetUnsavedEntities() const noexcept
+	{
+		return m_Unsaved;
+	}
+
+	void Scene::ClearUnsaved() noexcept
+	{
+		for (const entt::entity entity : m_Unsaved)
+		{
+			m_UnsavedSlots[entt::to_entity( entity )] = entt::null;
+		}
+		m_Unsaved.clear();
+	}
+
+	void Scene::MarkMovedUnsaved()
+	{
+		auto transforms = m_Registry.view<TransformComponent>();
+		const auto& entities = *transforms.handle();
+		for (size_t i = 0; i < entities.size(); ++i)
+		{
+			if (transforms.get<TransformComponent>( entities[i] ).HasMoved())
+			{
+				MarkUnsaved( entities[i] );
+			}
+		}
+	}
+
+	void Scene::SetUnsavedTracking( bool enabled ) noexcept
+	{
+		m_TrackUnsaved = enabled;
+	}
+
+	void Scene::SetStreamed( entt::entity entity, bool streamed )
+	{
+		const uint32_t id = entt::to_entity( entity );
+		if (id >= m_StreamedSlots.size())
+		{
+			if (!streamed)
+			{
+				return;
+			}
+			m_StreamedSlots.resize( static_cast<size_t>(id) + 1, entt::null );
+		}
+		if (streamed)
+		{
+			m_StreamedSlots[id] = entity;
+		}
+		else if (m_StreamedSlots[id] == entity)
+		{
+			m_StreamedSlots[id] = entt::null;
+		}
+	}
+
+	void Scene::MarkUnsaved( entt::entity entity )
+	{
+		const uint32_t id = entt::to_entity( entity );
+		if (!m_TrackUnsaved || (id < m_StreamedSlots.size() && m_StreamedSlots[id] == entity))
+		{
+			return;
+		}
+		if (id >= m_UnsavedSlots.size())
+		{
+			m_UnsavedSlots.resize( static_cast<size_t>(id) + 1, entt::null );
+		}
+		if (m_UnsavedSlots[id] != entity)
+		{
+			m_UnsavedSlots[id] = entity;
+			m_Unsaved.push_back( entity );
+		}
+	}
+
+	void Scene::SetJobSystem( JobSystem* jobs ) noexcept
+	{
+		m_Jobs = jobs;
+	}
+
+	JobSystem* Scene::GetJobSystem() const noexcept
+	{
+		return m_Jobs;
+	}
+
+	void Scene::UpdateTransforms()
+	{
+		m_Transforms.Update( m_Registry, m_Jobs );
+		// The setters bypass the registry's signals, the TransformSystem's scan is what sees them.
+		for (const entt::entity entity : m_Transforms.GetMovedEntities())
+		{
+			MarkUnsaved( entity );
+		}
+		m_Spatial.Update( m_Registry, m_Transforms, m_SpatialChanges, m_Jobs );
+		m_Visibility.Update( m_Registry, m_Transforms, m_SpatialChanges, m_Jobs );
+		m_SpatialChanges.clear();
+	}
+
+	const TransformSystem& Scene::GetTransforms() const noexcept
+	{
+		return m_Transforms;
+	}
+
+	const AabbTree& Scene::GetSpatialTree() const noexcept
+	{
+		return m_Spatial;
+	}
+
+	void Scene::Cull( const Math::Frustum* frustums, uint32_t viewCount, VisibilityList* lists ) const
+	{
+		m_Visibility.Cull( frustums, viewCount, lists, m_Jobs );
+	}
+
+	void Scene::CullOcclusion( const Math::Float4x4& viewProjection, OcclusionBuffer& buffer, VisibilityList& visible )
+	{
+		m_Occluders.clear();
+		m_Registry.view<OccluderComponent>().each( [&]( entt::entity entity, OccluderComponent& occluder )
+		{
+			const uint32_t index = m_Transforms.FindIndex( entity );
+			if (occluder.Mesh != nullptr && index != TransformSystem::InvalidIndex)
+			{
+				m_Occluders.push_back( { occluder.Mesh.get(), &m_Transforms.GetWorldMatrix( index ) } );
+			}
+		} );
+		buffer.Render( viewProjection, m_Occluders.data(), static_cast<uint32_t>(m_Occluders.size()), m_Jobs );
+
+		const uint32_t count = static_cast<uint32_t>(visible.Indices.size());
+		m_OccludeeBounds.resize( count );
+		m_OccludeeVisible.resize( count );
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			m_OccludeeBounds[i] = m_Visibility.GetBounds( visible.Indices[i] );
+		}
+		buffer.TestBoxes( m_OccludeeBounds.data(), count, m_OccludeeVisible.data(), m_Jobs );
+
+		uint32_t kept = 0;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const uint32_t index = visible.Indices[i];
+			if (m_OccludeeVisible[i] != 0)
+			{
+				visible.Indices[kept++] = index;
+			}
+			else
+			{
+				visible.BlockMasks[index / VisibilitySystem::BlockWidth] &= static_cast<uint8_t>(~(1u << (index % VisibilitySystem::BlockWidth)));
+			}
+		}
+		visible.Indices.resize( kept );
+	}
+
+	bool Scene::SetParent( entt::entity child, entt::entity parent )
+	{
+		if (parent == entt::null)
+		{
+			m_Registry.remove<HierarchyComponent>( child );
+			return true;
+		}
+		for (entt::entity ancestor = parent; ancestor != entt::null; )
+		{
+			if (ancestor == child)
+			{
+				return false;
+			}
+			const HierarchyComponent* hierarchy = m_Registry.try_get<HierarchyComponent>( ancestor );
+			ancestor = hierarchy != nullptr ? hierarchy->Parent : entt::null;
+		}
+		m_Registry.emplace_or_replace<HierarchyComponent>( child, parent );
+		return true;
+	}
+
+	entt::entity Scene::GetParent( entt::entity child ) const
+	{
+		const HierarchyComponent* hierarchy = m_Registry.try_get<HierarchyComponent>( child );
+		return hierarchy != nullptr ? hierarchy->Parent : entt::null;
+	}
+
+	void Scene::OnTransformChanged( entt::registry&, entt::entity entity )
+	{
+		++m_ChangeCount;
+		MarkUnsaved( entity );
+	}
+
+	void Scene::OnHierarchyChanged( entt::registry&, entt::entity entity )
+	{
+		++m_ChangeCount;
+		MarkUnsaved( entity );
+		m_Transforms.InvalidateHierarchy();
+	}
+
+	void Scene::OnTransformRemoved( entt::registry&, entt::entity entity )
+	{
+		m_SpatialChanges.push_back( entity );
+	}
+
+	void Scene::OnBoundsChanged( entt::registry&, entt::entity entity )
+	{
+		m_SpatialChanges.push_back( entity );
+	}
+
+	void Scene::CollectDrawItems( std::vector<Graphics::DrawItem>& drawItems )
+	{
+		drawItems.clear();
+		m_Registry.view<TransformComponent>().each( [&]( entt::entity entity, TransformComponent& transform )
+		{
+			AddDrawItem( drawItems, entity, transform, m_Transforms.FindIndex( entity ) );
+		} );
+	}
+
+	void Scene::CollectDrawItems( std::vector<Graphics::DrawItem>& drawItems, const VisibilityList& visible )
+	{
+		drawItems.clear();
+		drawItems.reserve( visible.Indices.size() );
+		for (const uint32_t index : visible.Indices)
+		{
+			const entt::entity entity = m_Transforms.GetEntity( index );
+			// Skips what lost its transform after the last UpdateTransforms.
+			if (TransformComponent* transform = m_Registry.try_get<TransformComponent>( entity ))
+			{
+				AddDrawItem( drawItems, entity, *transform, index );
+			}
+		}
+	}
+
+	void Scene::AddDrawItem( std::vector<Graphics::DrawItem>& drawItems, entt::entity entity, TransformComponent& transform, uint32_t index )
+	{
+		const auto position = transform.GetPosition();
+		const auto rotation = transform.GetRotationQuaternionFloat4();
+		const auto scale = transform.GetScale();
+		Graphics::DrawItem& item = drawItems.emplace_back( Graphics::DrawItem{
+			static_cast<uint32_t>(entity),
+			{ position.x, position.y, position.z },
+			{ rotation.x, rotation.y, rotation.z, rotation.w },
+			{ scale.x, scale.y, scale.z } } );
+		if (index != TransformSystem::InvalidIndex)
+		{
+			std::memcpy( item.World, m_Transforms.GetWorldMatrix( index ).m, sizeof( item.World ) );
+		}
+		else
+		{
+			// Added after the last UpdateTransforms.
+			std::memcpy( item.World, transform.GetLocalMatrix().m, sizeof( item.World ) );
+		}
+	}
 }
\ No newline at end of file
@@ -20,15 +20,174 @@
 #pragma once
 
 #include "entt.hpp" // https://github.com/skypjack/entt
+#include "AabbTree.h"
+#include "OcclusionBuffer.h"
+#include "Jobs/JobSystem.h"
+#include "TransformSystem.h"
+#include "VisibilitySystem.h"
+#include <cstdint>
+#include <vector>
 
 namespace CronoEngine
 {
+	namespace Graphics
+	{
+		struct DrawItem;
+	}
+
 	class Scene
 	{
 	public:
 		Scene();
 		~Scene();
+		// Copies the transform of every drawable entity, replacing the contents of drawItems.
+		void CollectDrawItems( std::vector<Graphics::DrawItem>& drawItems );
+		// Same, only for the entities in visible, which must come from Cull since the last UpdateTransforms.
+		void CollectDrawItems( std::vector<Graphics::DrawItem>& drawItems, const VisibilityList& visible );
+		/**
+		 * Recomputes the world matrix of every TransformComponent, see TransformSystem, and brings
+		 * the spatial tree and the culling bounds up to date with them.
+		 */
+		void UpdateTransforms();
+		const TransformSystem& GetTransforms() const noexcept;
+		// World bounds of every TransformComponent as of the last UpdateTransforms.
+		const AabbTree& GetSpatialTree() const noexcept;
+		// Fills lists[i] with the entities at least partly inside frustums[i], see VisibilitySystem.
+		void Cull( const Math::Frustum* frustums, uint32_t viewCount, VisibilityList* lists ) const;
+		/**
+		 * Renders every OccluderComponent into buffer as seen through viewProjection, then drops
+		 * from visible (Cull's list for that view) what the occluders hide. See buffer's metrics
+		 * for what it cost and how much it culled.
+		 */
+		void CullOcclusion( const Math::Float4x4& viewProjection, OcclusionBuffer& buffer, VisibilityList& visible );
+		/**
+		 * Parents child's transform to parent's, entt::null detaches it. Returns false and
+		 * changes nothing when parent is child or one of its descendants.
+		 */
+		bool SetParent( entt::entity child, entt::entity parent );
+		entt::entity GetParent( entt::entity child ) const;
+		// Bumped whenever a TransformComponent or HierarchyComponent is added, replaced/patched or removed.
+		uint64_t GetChangeCount() const noexcept;
+		/**
+		 * Entities whose TransformComponent or HierarchyComponent was added, replaced/patched or
+		 * removed since the last save, destroyed ones included; SceneJournal writes these. An entity
+		 * can show up more than once. Transforms changed through their setters join the list at the
+		 * next UpdateTransforms or MarkMovedUnsaved.
+		 */
+		const std::vector<entt::entity>& GetUnsavedEntities() const noexcept;
+		void ClearUnsaved() noexcept;
+		// Marks unsaved the transforms a setter changed since the last UpdateTransforms, for saving in between.
+		void MarkMovedUnsaved();
+		// While off, changes aren't marked unsaved, e.g. for streamed cells that live in their own files.
+		void SetUnsavedTracking( bool enabled ) noexcept;
+		// Streamed entities are never marked unsaved, whatever happens to them; they belong to their cell's file.
+		void SetStreamed( entt::entity entity, bool streamed );
+
+		// Jobs used by ParallelEach/ParallelEachGroup, without one they run on the calling thread.
+		void SetJobSystem( JobSystem* jobs ) noexcept;
+		JobSystem* GetJobSystem() const noexcept;
+
+		/**
+		 * Calls function( entity, components&... ) for every entity that has all of Components,
+		 * split over the job system and waits for all of them. The entities are walked in the
+		 * order of the view's leading pool and cut into fixed chunks of chunkSize (0 picks one
+		 * that keeps a chunk's components in L1), so the same registry is always split the same way.
+		 * The function must not add or remove components or entities.
+		 */
+		template<typename... Components, typename F>
+		void ParallelEach( F&& function, uint32_t chunkSize = 0 )
+		{
+			auto view = m_Registry.view<Components...>();
+			const auto& entities = *view.handle();
+			ForEachChunk( static_cast<uint32_t>(entities.size()), ChunkSizeFor<Components...>( chunkSize ),
+				[&]( uint32_t begin, uint32_t end )
+			{
+				for (uint32_t i = begin; i < end; ++i)
+				{
+					const entt::entity entity = entities[i];
+					if (view.contains( entity ))
+					{
+						function( entity, view.template get<Components>( entity )... );
+					}
+				}
+			} );
+		}
+
+		/**
+		 * Same as ParallelEach, over an owning group. The owned components of the group are packed
+		 * at the front of their pools, so every chunk reads contiguous memory.
+		 */
+		template<typename... Owned, typename F>
+		void ParallelEachGroup( F&& function, uint32_t chunkSize = 0 )
+		{
+			auto group = m_Registry.group<Owned...>();
+			const auto first = group.begin();
+			ForEachChunk( static_cast<uint32_t>(group.size()), ChunkSizeFor<Owned...>( chunkSize ),
+				[&]( uint32_t begin, uint32_t end )
+			{
+				for (uint32_t i = begin; i < end; ++i)
+				{
+					const entt::entity entity = first[i];
+					function( entity, group.template get<Owned>( entity )... );
+				}
+			} );
+		}
+	private:
+		// About half of a 32 KiB L1 data cache per chunk.
+		static constexpr size_t ChunkBytes = 16 * 1024;
+
+		template<typename... Components>
+		static uint32_t ChunkSizeFor( uint32_t chunkSize ) noexcept
+		{
+			if (chunkSize != 0)
+			{
+				return chunkSize;
+			}
+			const size_t bytesPerEntity = sizeof( entt::entity ) + (sizeof( Components ) + ... + 0);
+			return static_cast<uint32_t>(std::max<size_t>( 64, ChunkBytes / bytesPerEntity ));
+		}
+
+		template<typename F>
+		void ForEachChunk( uint32_t count, uint32_t chunkSize, F&& function )
+		{
+			if (m_Jobs == nullptr || count <= chunkSize)
+			{
+				// Same chunk boundaries as the parallel path.
+				for (uint32_t begin = 0; begin < count; begin += chunkSize)
+				{
+					function( begin, std::min( count, begin + chunkSize ) );
+				}
+				return;
+			}
+			m_Jobs->ParallelFor( count, chunkSize, function );
+		}
+	private:
+		// index is the entity's TransformSystem index, InvalidIndex when it has none yet.
+		void AddDrawItem( std::vector<Graphics::DrawItem>& drawItems, entt::entity entity, TransformComponent& transform, uint32_t index );
+		void OnTransformChanged( entt::registry& registry, entt::entity entity );
+		void OnHierarchyChanged( entt::registry& registry, entt::entity entity );
+		void OnTransformRemoved( entt::registry& registry, entt::entity entity );
+		void OnBoundsChanged( entt::registry& registry, entt::entity entity );
+		void MarkUnsaved( entt::entity entity );
 	public:
 		entt::registry m_Registry;
+	private:
+		uint64_t m_ChangeCount = 0;
+		std::vector<entt::entity> m_Unsaved;
+		// Per entity id, the entity last added to m_Unsaved, so edits to it don't pile up.
+		std::vector<entt::entity> m_UnsavedSlots;
+		// Per entity id, the streamed entity holding it, entt::null for none.
+		std::vector<entt::entity> m_StreamedSlots;
+		bool m_TrackUnsaved = true;
+		JobSystem* m_Jobs = nullptr;
+		TransformSystem m_Transforms;
+		AabbTree m_Spatial;
+		VisibilitySystem m_Visibility;
+		// Removed transforms and changed bounds, which the TransformSystem doesn't report.
+		std::vector<entt::entity> m_SpatialChanges;
+		// Scratch for CullOcclusion.
+		std::vector<OcclusionBuffer::Instance> m_Occluders;
+		std::vector<Math::Aabb> m_OccludeeBounds;
+		std::vector<uint8_t> m_OccludeeVisible;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,340 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "SceneJournal.h"
+#include "Entity/Component/HierarchyComponent.h"
+#include "Common/MappedFile.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace CronoEngine
+{
+	namespace
+	{
+		uint32_t Checksum( const void* data, size_t size ) noexcept
+		{
+			const uint8_t* bytes = static_cast<const uint8_t*>(data);
+			uint32_t hash = 2166136261u;
+			for (size_t i = 0; i < size; ++i)
+			{
+				hash = (hash ^ bytes[i]) * 16777619u;
+			}
+			return hash;
+		}
+	}
+
+	SceneJournal::SceneJournal( std::string path, const SceneSerializer::FileHeader& snapshot, JobSystem* jobs )
+		:
+		m_Path( std::move( path ) ),
+		m_Lineage( snapshot.Lineage ),
+		m_SnapshotSequence( snapshot.JournalSequence ),
+		m_Sequence( snapshot.JournalSequence + 1 ),
+		m_SnapshotBytes( snapshot.FileSize ),
+		m_Jobs( jobs )
+	{}
+
+	SceneJournal::~SceneJournal()
+	{
+		WaitForCompaction();
+	}
+
+	const std::string& SceneJournal::GetPath() const noexcept
+	{
+		return m_Path;
+	}
+
+	std::string SceneJournal::JournalPath() const
+	{
+		return m_Path + ".journal";
+	}
+
+	std::string SceneJournal::CompactingPath() const
+	{
+		return m_Path + ".journal.compacting";
+	}
+
+	void SceneJournal::Remove( const std::string& path )
+	{
+		std::error_code error;
+		std::filesystem::remove( path + ".journal", error );
+		std::filesystem::remove( path + ".journal.compacting", error );
+	}
+
+	void SceneJournal::Replay( Scene& scene )
+	{
+		std::error_code error;
+		uint64_t sequence = 0;
+		// An interrupted compaction leaves its segment behind, older than the journal.
+		if (ReplaySegment( scene, CompactingPath(), m_Lineage, m_SnapshotSequence, sequence ) != 0)
+		{
+			m_CompactingSequence = sequence;
+			m_Sequence = std::max( m_Sequence, sequence + 1 );
+		}
+		else
+		{
+			std::filesystem::remove( CompactingPath(), error );
+		}
+
+		const uint64_t length = ReplaySegment( scene, JournalPath(), m_Lineage, m_SnapshotSequence, sequence );
+		if (length != 0)
+		{
+			// Cut a torn last block, appends go right after the last good one.
+			if (std::filesystem::file_size( JournalPath(), error ) != length)
+			{
+				std::filesystem::resize_file( JournalPath(), length, error );
+				if (error)
+				{
+					throw CHWND_FILE_EXCEPT( JournalPath(), "Could not repair the scene journal: " + error.message() );
+				}
+			}
+			m_Sequence = std::max( m_Sequence, sequence );
+			m_JournalBytes = length;
+		}
+		else
+		{
+			std::filesystem::remove( JournalPath(), error );
+		}
+		scene.ClearUnsaved();
+	}
+
+	uint64_t SceneJournal::ReplaySegment( Scene& scene, const std::string& segmentPath, uint64_t lineage,
+		uint64_t afterSequence, uint64_t& sequence )
+	{
+		std::error_code error;
+		if (!std::filesystem::exists( segmentPath, error ))
+		{
+			return 0;
+		}
+		const MappedFile file( segmentPath );
+		const std::byte* data = file.GetData();
+		const uint64_t size = file.GetSize();
+
+		JournalHeader header{};
+		if (size < sizeof( JournalHeader ))
+		{
+			return 0;
+		}
+		std::memcpy( &header, data, sizeof( header ) );
+		if (header.Magic != Magic || header.RecordSize != sizeof( Record ))
+		{
+			return 0;
+		}
+		if (header.Version > Version)
+		{
+			throw CHWND_FILE_EXCEPT( segmentPath, "Scene journal version " + std::to_string( header.Version ) + " is newer than this build." );
+		}
+		if (header.Lineage != lineage || header.Sequence <= afterSequence)
+		{
+			return 0;
+		}
+		sequence = header.Sequence;
+
+		entt::registry& registry = scene.m_Registry;
+		uint64_t offset = sizeof( JournalHeader );
+		while (size - offset >= sizeof( BlockHeader ))
+		{
+			BlockHeader block{};
+			std::memcpy( &block, data + offset, sizeof( block ) );
+			const uint64_t recordBytes = static_cast<uint64_t>(block.RecordCount) * sizeof( Record );
+			const std::byte* records = data + offset + sizeof( BlockHeader );
+			if (recordBytes > size - offset - sizeof( BlockHeader ) || Checksum( records, recordBytes ) != block.Checksum)
+			{
+				break;
+			}
+			for (uint32_t i = 0; i < block.RecordCount; ++i)
+			{
+				Record record{};
+				std::memcpy( &record, records + i * sizeof( Record ), sizeof( record ) );
+				ApplyRecord( registry, record );
+			}
+			offset += sizeof( BlockHeader ) + recordBytes;
+		}
+		return offset;
+	}
+
+	void SceneJournal::ApplyRecord( entt::registry& registry, const Record& record )
+	{
+		const entt::entity entity = static_cast<entt::entity>(record.Entity);
+		if (record.Components == 0)
+		{
+			if (registry.valid( entity ))
+			{
+				registry.destroy( entity );
+			}
+			return;
+		}
+
+		if (!SceneSerializer::CreateEntity( registry, entity ))
+		{
+			// Another version of the id the journal never saw go, the record is the newer state.
+			registry.destroy( SceneSerializer::GetLiveEntity( registry, entity ) );
+			SceneSerializer::CreateEntity( registry, entity );
+		}
+		if (record.Components & HasTransform)
+		{
+			registry.emplace_or_replace<TransformComponent>( entity, SceneSerializer::MakeTransform( record.Transform ) );
+		}
+		else
+		{
+			registry.remove<TransformComponent>( entity );
+		}
+		if (record.Components & HasHierarchy)
+		{
+			registry.emplace_or_replace<HierarchyComponent>( entity, static_cast<entt::entity>(record.Hierarchy.Parent) );
+		}
+		else
+		{
+			registry.remove<HierarchyComponent>( entity );
+		}
+	}
+
+	void SceneJournal::Append( Scene& scene )
+	{
+		scene.MarkMovedUnsaved();
+		const std::vector<entt::entity>& unsaved = scene.GetUnsavedEntities();
+		if (unsaved.empty())
+		{
+			return;
+		}
+
+		entt::registry& registry = scene.m_Registry;
+		std::vector<Record> records( unsaved.size() );
+		for (size_t i = 0; i < unsaved.size(); ++i)
+		{
+			const entt::entity entity = unsaved[i];
+			Record& record = records[i];
+			record.Entity = static_cast<uint32_t>(entity);
+			if (!registry.valid( entity ))
+			{
+				continue;
+			}
+			if (const TransformComponent* transform = registry.try_get<TransformComponent>( entity ))
+			{
+				record.Components |= HasTransform;
+				record.Transform = SceneSerializer::MakeRecord( *transform );
+			}
+			if (const HierarchyComponent* hierarchy = registry.try_get<HierarchyComponent>( entity ))
+			{
+				record.Components |= HasHierarchy;
+				record.Hierarchy.Parent = static_cast<uint32_t>(hierarchy->Parent);
+			}
+		}
+		// Destroyed entities first, a later one in this block may have reused their id.
+		std::stable_partition( records.begin(), records.end(), []( const Record& record ) { return record.Components == 0; } );
+
+		const std::string journalPath = JournalPath();
+		const bool newSegment = m_JournalBytes == 0;
+		std::ofstream file( journalPath, std::ios::binary | (newSegment ? std::ios::trunc : std::ios::app) );
+		if (newSegment)
+		{
+			const JournalHeader header{ Magic, Version, m_Lineage, m_Sequence, sizeof( Record ), 0 };
+			file.write( reinterpret_cast<const char*>(&header), sizeof( header ) );
+		}
+		const uint64_t recordBytes = records.size() * sizeof( Record );
+		const BlockHeader block{ static_cast<uint32_t>(records.size()), Checksum( records.data(), recordBytes ) };
+		file.write( reinterpret_cast<const char*>(&block), sizeof( block ) );
+		file.write( reinterpret_cast<const char*>(records.data()), static_cast<std::streamsize>(recordBytes) );
+		file.flush();
+		if (!file)
+		{
+			// Drop whatever part of the block made it, so later appends stay readable.
+			file.close();
+			std::error_code error;
+			std::filesystem::resize_file( journalPath, m_JournalBytes, error );
+			throw CHWND_FILE_EXCEPT( journalPath, "Could not write the scene journal." );
+		}
+		m_JournalBytes += (newSegment ? sizeof( JournalHeader ) : 0) + sizeof( BlockHeader ) + recordBytes;
+		scene.ClearUnsaved();
+
+		if (m_JournalBytes >= std::max( MinCompactionBytes, m_SnapshotBytes.load() / CompactionDivisor ))
+		{
+			Compact();
+		}
+	}
+
+	void SceneJournal::Compact()
+	{
+		if (!m_Compaction.IsDone())
+		{
+			return;
+		}
+		std::error_code error;
+		if (!std::filesystem::exists( CompactingPath(), error ))
+		{
+			if (m_JournalBytes == 0)
+			{
+				return;
+			}
+			// From here on appends start the next segment.
+			std::filesystem::rename( JournalPath(), CompactingPath(), error );
+			if (error)
+			{
+				m_CompactionFailed = true;
+				return;
+			}
+			m_CompactingSequence = m_Sequence++;
+			m_JournalBytes = 0;
+		}
+
+		m_CompactionFailed = false;
+		const uint64_t sequence = m_CompactingSequence;
+		if (m_Jobs == nullptr)
+		{
+			CompactSegment( sequence );
+			return;
+		}
+		m_Jobs->Run( [this, sequence]() { CompactSegment( sequence ); }, &m_Compaction );
+	}
+
+	void SceneJournal::CompactSegment( uint64_t sequence ) noexcept
+	{
+		try
+		{
+			SceneSerializer::FileHeader snapshot{};
+			std::unique_ptr<Scene> scene = SceneSerializer::Load( m_Path, &snapshot );
+			if (snapshot.Lineage == m_Lineage && snapshot.JournalSequence < sequence)
+			{
+				uint64_t segmentSequence = 0;
+				ReplaySegment( *scene, CompactingPath(), m_Lineage, snapshot.JournalSequence, segmentSequence );
+				const SceneSerializer::FileHeader written = SceneSerializer::Save( *scene, m_Path, m_Lineage, sequence );
+				m_SnapshotBytes = written.FileSize;
+			}
+			std::filesystem::remove( CompactingPath() );
+		}
+		catch (const std::exception&)
+		{
+			m_CompactionFailed = true;
+		}
+	}
+
+	void SceneJournal::WaitForCompaction()
+	{
+		if (m_Jobs != nullptr)
+		{
+			m_Jobs->Wait( m_Compaction );
+		}
+	}
+
+	bool SceneJournal::CompactionFailed() const noexcept
+	{
+		return m_CompactionFailed;
+	}
+}
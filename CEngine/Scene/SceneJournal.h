@@ -0,0 +1,128 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+#include "SceneSerializer.h"
+#include "Jobs/JobSystem.h"
+#include <atomic>
+#include <string>
+
+namespace CronoEngine
+{
+	/**
+	 * Delta saves on top of a scene snapshot. Append writes one block with the current state of
+	 * every entity the scene marked unsaved to "<snapshot>.journal", so a save costs as much as
+	 * the edit, not the scene. Records hold whole component values, never differences, and a
+	 * block only counts once its checksum matches, so a torn write loses that save alone.
+	 * Once the journal outgrows a quarter of the snapshot it is renamed to
+	 * "<snapshot>.journal.compacting" and folded into a new snapshot on the job system, while
+	 * new saves start the next journal segment. Segments are numbered and the snapshot records
+	 * the last one it contains, so a crash at any point never replays an edit twice.
+	 */
+	class SceneJournal
+	{
+	public:
+		static constexpr uint32_t Magic = 0x4C4E4A43; // "CJNL"
+		static constexpr uint32_t Version = 1;
+		// Compacts once the journal is past SnapshotSize / CompactionDivisor and MinCompactionBytes.
+		static constexpr uint64_t CompactionDivisor = 4;
+		static constexpr uint64_t MinCompactionBytes = 1024 * 1024;
+
+		enum ComponentFlags : uint32_t
+		{
+			HasTransform = 1 << 0,
+			HasHierarchy = 1 << 1,
+		};
+
+		struct JournalHeader
+		{
+			uint32_t Magic;
+			uint32_t Version;
+			// Must match the snapshot's, see SceneSerializer::FileHeader.
+			uint64_t Lineage;
+			uint64_t Sequence;
+			uint32_t RecordSize;
+			uint32_t Reserved;
+		};
+
+		// Followed by RecordCount records.
+		struct BlockHeader
+		{
+			uint32_t RecordCount;
+			// FNV-1a of the records.
+			uint32_t Checksum;
+		};
+
+		// Components 0 means the entity is gone.
+		struct Record
+		{
+			uint32_t Entity;
+			uint32_t Components;
+			SceneSerializer::TransformRecord Transform;
+			SceneSerializer::HierarchyRecord Hierarchy;
+		};
+
+		// snapshot is the header of the file at path, as Save wrote it or Load read it.
+		SceneJournal( std::string path, const SceneSerializer::FileHeader& snapshot, JobSystem* jobs );
+		// Waits for a running compaction.
+		~SceneJournal();
+		SceneJournal( const SceneJournal& ) = delete;
+		SceneJournal& operator=( const SceneJournal& ) = delete;
+
+		/**
+		 * Replays the journal segments newer than the snapshot onto scene, freshly loaded from it,
+		 * and drops stale or torn data so appends continue from a clean end. Throws FileException.
+		 */
+		void Replay( Scene& scene );
+		// Writes the scene's unsaved entities, transforms moved by their setters included, and clears them. Throws FileException.
+		void Append( Scene& scene );
+		// Starts folding the journal into the snapshot, unless one is already running.
+		void Compact();
+		void WaitForCompaction();
+		// Whether the last compaction failed; its segment stays on disk and the next Compact retries it.
+		bool CompactionFailed() const noexcept;
+		// Deletes every journal segment of the snapshot at path, for when it gets overwritten by a full save.
+		static void Remove( const std::string& path );
+
+		const std::string& GetPath() const noexcept;
+	private:
+		/**
+		 * Applies the valid blocks of a segment of lineage numbered after afterSequence and returns
+		 * the bytes they span with its header, 0 when the segment is missing, stale or not a journal.
+		 */
+		static uint64_t ReplaySegment( Scene& scene, const std::string& segmentPath, uint64_t lineage,
+			uint64_t afterSequence, uint64_t& sequence );
+		static void ApplyRecord( entt::registry& registry, const Record& record );
+		void CompactSegment( uint64_t sequence ) noexcept;
+		std::string JournalPath() const;
+		std::string CompactingPath() const;
+	private:
+		std::string m_Path;
+		uint64_t m_Lineage = 0;
+		uint64_t m_SnapshotSequence = 0;
+		// Of the segment Append writes to, and of the one being compacted.
+		uint64_t m_Sequence = 0;
+		uint64_t m_CompactingSequence = 0;
+		uint64_t m_JournalBytes = 0;
+		std::atomic<uint64_t> m_SnapshotBytes = 0;
+		std::atomic<bool> m_CompactionFailed = false;
+		JobSystem* m_Jobs = nullptr;
+		JobCounter m_Compaction;
+	};
+}
@@ -0,0 +1,329 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "SceneSerializer.h"
+#include "Entity/Component/TransformComponent.h"
+#include "Entity/Component/HierarchyComponent.h"
+#include "Common/MappedFile.h"
+#if defined(_WIN32)
+#include "Windows/WinInclude.h"
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <random>
+
+namespace CronoEngine
+{
+	namespace
+	{
+		constexpr uint64_t AlignUp( uint64_t value ) noexcept
+		{
+			return (value + SceneSerializer::Alignment - 1) & ~(SceneSerializer::Alignment - 1);
+		}
+
+		// Lays out one pool after offset and returns the end of it.
+		uint64_t PlacePool( SceneSerializer::PoolEntry& entry, SceneSerializer::PoolType type, uint32_t recordSize, uint64_t count, uint64_t offset ) noexcept
+		{
+			entry.Type = type;
+			entry.RecordSize = recordSize;
+			entry.Count = count;
+			entry.EntitiesOffset = AlignUp( offset );
+			entry.RecordsOffset = AlignUp( entry.EntitiesOffset + count * sizeof( uint32_t ) );
+			return entry.RecordsOffset + count * recordSize;
+		}
+
+		bool IsInside( uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t fileSize ) noexcept
+		{
+			return offset % SceneSerializer::Alignment == 0 && offset <= fileSize &&
+				count <= (fileSize - offset) / elementSize;
+		}
+
+		// What version 1 files have, before Lineage and JournalSequence.
+		constexpr uint32_t MinHeaderSize = 32;
+
+		// Writes the whole file and has the OS put it on disk before returning, throws FileException.
+		void WriteFileToDisk( const std::string& path, const std::byte* data, uint64_t size )
+		{
+#if defined(_WIN32)
+			HANDLE file = CreateFileA( path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr );
+			if (file == INVALID_HANDLE_VALUE)
+			{
+				throw CHWND_FILE_EXCEPT( path, HrException::TranslateErrorCode( HRESULT_FROM_WIN32( GetLastError() ) ) );
+			}
+			bool written = true;
+			for (uint64_t offset = 0; written && offset < size; )
+			{
+				DWORD chunk = 0;
+				written = WriteFile( file, data + offset, static_cast<DWORD>(std::min<uint64_t>( size - offset, 1u << 30 )), &chunk, nullptr ) != 0;
+				offset += chunk;
+			}
+			written = written && FlushFileBuffers( file ) != 0;
+			CloseHandle( file );
+#else
+			const int file = open( path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+			if (file < 0)
+			{
+				throw CHWND_FILE_EXCEPT( path, "Could not create the scene file." );
+			}
+			bool written = true;
+			for (uint64_t offset = 0; written && offset < size; )
+			{
+				const ssize_t chunk = write( file, data + offset, static_cast<size_t>(size - offset) );
+				written = chunk > 0;
+				offset += written ? static_cast<uint64_t>(chunk) : 0;
+			}
+			written = written && fsync( file ) == 0;
+			written = close( file ) == 0 && written;
+#endif
+			if (!written)
+			{
+				std::error_code error;
+				std::filesystem::remove( path, error );
+				throw CHWND_FILE_EXCEPT( path, "Could not write the scene file." );
+			}
+		}
+
+		/**
+		 * Creates the entities of pool number poolIndex into live. Throws FileException when one
+		 * comes twice, already has Component or another version of its id is alive, all only in
+		 * corrupt files.
+		 */
+		template<typename Component>
+		void CreatePoolEntities( entt::registry& registry, const uint32_t* ids, uint64_t count, uint32_t poolIndex,
+			std::vector<uint32_t>& lastPool, std::vector<entt::entity>& live, const std::string& path )
+		{
+			live.resize( count );
+			for (uint64_t i = 0; i < count; ++i)
+			{
+				const entt::entity entity = static_cast<entt::entity>(ids[i]);
+				const uint32_t id = entt::to_entity( entity );
+				if (id >= lastPool.size())
+				{
+					lastPool.resize( static_cast<size_t>(id) + 1, 0 );
+				}
+				if (lastPool[id] == poolIndex + 1 || !SceneSerializer::CreateEntity( registry, entity ) || registry.all_of<Component>( entity ))
+				{
+					throw CHWND_FILE_EXCEPT( path, "Scene file is truncated or corrupt." );
+				}
+				lastPool[id] = poolIndex + 1;
+				live[i] = entity;
+			}
+		}
+	}
+
+	uint64_t SceneSerializer::NewLineage()
+	{
+		std::random_device device;
+		const uint64_t random = (static_cast<uint64_t>(device()) << 32) | device();
+		return random ^ static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+	}
+
+	SceneSerializer::TransformRecord SceneSerializer::MakeRecord( const TransformComponent& transform )
+	{
+		const auto position = transform.GetPosition();
+		const auto rotation = transform.GetRotation();
+		const auto scale = transform.GetScale();
+		return { { position.x, position.y, position.z },
+			{ rotation.x, rotation.y, rotation.z }, { scale.x, scale.y, scale.z } };
+	}
+
+	TransformComponent SceneSerializer::MakeTransform( const TransformRecord& record )
+	{
+		return TransformComponent( Math::Float3A( record.Position[0], record.Position[1], record.Position[2] ),
+			Math::Float3A( record.Rotation[0], record.Rotation[1], record.Rotation[2] ),
+			Math::Float3A( record.Scale[0], record.Scale[1], record.Scale[2] ) );
+	}
+
+	bool SceneSerializer::CreateEntity( entt::registry& registry, entt::entity entity )
+	{
+		if (registry.valid( entity ))
+		{
+			return true;
+		}
+		if (GetLiveEntity( registry, entity ) != entt::null)
+		{
+			return false;
+		}
+		registry.create( entity );
+		return true;
+	}
+
+	entt::entity SceneSerializer::GetLiveEntity( const entt::registry& registry, entt::entity entity )
+	{
+		const entt::entity live = entt::entt_traits<entt::entity>::construct( entt::to_entity( entity ), registry.current( entity ) );
+		return registry.valid( live ) ? live : entt::null;
+	}
+
+	SceneSerializer::FileHeader SceneSerializer::Save( Scene& scene, const std::string& path, uint64_t lineage, uint64_t journalSequence )
+	{
+		auto transforms = scene.m_Registry.view<TransformComponent>();
+		auto hierarchy = scene.m_Registry.view<HierarchyComponent>();
+		const auto& transformEntities = *transforms.handle();
+		const auto& hierarchyEntities = *hierarchy.handle();
+
+		FileHeader header{};
+		header.Magic = Magic;
+		header.Version = Version;
+		header.PoolCount = 2;
+		header.HeaderSize = sizeof( FileHeader );
+		header.Lineage = lineage;
+		header.JournalSequence = journalSequence;
+		PoolEntry pools[2]{};
+		uint64_t offset = header.HeaderSize + sizeof( pools );
+		offset = PlacePool( pools[0], PoolType::Transform, sizeof( TransformRecord ), transformEntities.size(), offset );
+		offset = PlacePool( pools[1], PoolType::Hierarchy, sizeof( HierarchyRecord ), hierarchyEntities.size(), offset );
+		header.FileSize = AlignUp( offset );
+
+		// Built in memory and written at once, the padding stays zero.
+		std::vector<std::byte> buffer( header.FileSize );
+		std::byte* data = buffer.data();
+		std::memcpy( data, &header, sizeof( header ) );
+		std::memcpy( data + header.HeaderSize, pools, sizeof( pools ) );
+
+		uint32_t* entities = reinterpret_cast<uint32_t*>(data + pools[0].EntitiesOffset);
+		TransformRecord* transformRecords = reinterpret_cast<TransformRecord*>(data + pools[0].RecordsOffset);
+		for (size_t i = 0; i < transformEntities.size(); ++i)
+		{
+			const entt::entity entity = transformEntities[i];
+			entities[i] = static_cast<uint32_t>(entity);
+			transformRecords[i] = MakeRecord( transforms.get<TransformComponent>( entity ) );
+		}
+
+		entities = reinterpret_cast<uint32_t*>(data + pools[1].EntitiesOffset);
+		HierarchyRecord* hierarchyRecords = reinterpret_cast<HierarchyRecord*>(data + pools[1].RecordsOffset);
+		for (size_t i = 0; i < hierarchyEntities.size(); ++i)
+		{
+			const entt::entity entity = hierarchyEntities[i];
+			entities[i] = static_cast<uint32_t>(entity);
+			hierarchyRecords[i].Parent = static_cast<uint32_t>(hierarchy.get<HierarchyComponent>( entity ).Parent);
+		}
+
+		// Written aside and renamed over, a failed save leaves the previous file whole.
+		const std::string temporaryPath = path + ".tmp";
+		// On disk before the rename, or a crash could leave the rename done and the data not.
+		WriteFileToDisk( temporaryPath, data, buffer.size() );
+		std::error_code error;
+		std::filesystem::rename( temporaryPath, path, error );
+		if (error)
+		{
+			std::filesystem::remove( temporaryPath, error );
+			throw CHWND_FILE_EXCEPT( path, "Could not replace the scene file." );
+		}
+		scene.ClearUnsaved();
+		return header;
+	}
+
+	std::unique_ptr<Scene> SceneSerializer::Load( const std::string& path, FileHeader* header )
+	{
+		const MappedFile file( path );
+		const std::byte* data = file.GetData();
+		const uint64_t size = file.GetSize();
+
+		FileHeader fileHeader{};
+		if (size < MinHeaderSize)
+		{
+			throw CHWND_FILE_EXCEPT( path, "Not a scene file." );
+		}
+		std::memcpy( &fileHeader, data, MinHeaderSize );
+		if (fileHeader.Magic != Magic)
+		{
+			throw CHWND_FILE_EXCEPT( path, "Not a scene file." );
+		}
+		if (fileHeader.Version > Version)
+		{
+			throw CHWND_FILE_EXCEPT( path, "Scene file version " + std::to_string( fileHeader.Version ) + " is newer than this build." );
+		}
+		if (fileHeader.FileSize != size || fileHeader.HeaderSize < MinHeaderSize || fileHeader.HeaderSize > size ||
+			fileHeader.PoolCount > (size - fileHeader.HeaderSize) / sizeof( PoolEntry ))
+		{
+			throw CHWND_FILE_EXCEPT( path, "Scene file is truncated or corrupt." );
+		}
+		// Fields an older version doesn't have stay zero.
+		std::memcpy( &fileHeader, data, std::min<uint64_t>( fileHeader.HeaderSize, sizeof( FileHeader ) ) );
+
+		auto scene = std::make_unique<Scene>();
+		entt::registry& registry = scene->m_Registry;
+		// Loading is not an edit, and each pool goes in with one insert.
+		scene->SetUnsavedTracking( false );
+		std::vector<entt::entity> live;
+		std::vector<uint32_t> lastPool;
+		for (uint32_t p = 0; p < fileHeader.PoolCount; ++p)
+		{
+			PoolEntry pool{};
+			std::memcpy( &pool, data + fileHeader.HeaderSize + p * sizeof( PoolEntry ), sizeof( pool ) );
+			if (pool.RecordSize == 0 || !IsInside( pool.EntitiesOffset, pool.Count, sizeof( uint32_t ), size ) ||
+				!IsInside( pool.RecordsOffset, pool.Count, pool.RecordSize, size ))
+			{
+				throw CHWND_FILE_EXCEPT( path, "Scene file is truncated or corrupt." );
+			}
+			// The mapping is page aligned and the arrays 64 byte aligned, so they are read in place.
+			const uint32_t* entities = reinterpret_cast<const uint32_t*>(data + pool.EntitiesOffset);
+			const std::byte* records = data + pool.RecordsOffset;
+			switch (pool.Type)
+			{
+			case PoolType::Transform:
+			{
+				if (pool.RecordSize != sizeof( TransformRecord ))
+				{
+					throw CHWND_FILE_EXCEPT( path, "Scene file has an unexpected transform record size." );
+				}
+				const TransformRecord* transforms = reinterpret_cast<const TransformRecord*>(records);
+				CreatePoolEntities<TransformComponent>( registry, entities, pool.Count, p, lastPool, live, path );
+				std::vector<TransformComponent> components;
+				components.reserve( live.size() );
+				for (uint64_t i = 0; i < pool.Count; ++i)
+				{
+					components.push_back( MakeTransform( transforms[i] ) );
+				}
+				registry.insert<TransformComponent>( live.begin(), live.end(), components.begin() );
+				break;
+			}
+			case PoolType::Hierarchy:
+			{
+				if (pool.RecordSize != sizeof( HierarchyRecord ))
+				{
+					throw CHWND_FILE_EXCEPT( path, "Scene file has an unexpected hierarchy record size." );
+				}
+				const HierarchyRecord* parents = reinterpret_cast<const HierarchyRecord*>(records);
+				CreatePoolEntities<HierarchyComponent>( registry, entities, pool.Count, p, lastPool, live, path );
+				std::vector<HierarchyComponent> components( live.size() );
+				for (uint64_t i = 0; i < pool.Count; ++i)
+				{
+					components[i].Parent = static_cast<entt::entity>(parents[i].Parent);
+				}
+				registry.insert<HierarchyComponent>( live.begin(), live.end(), components.begin() );
+				break;
+			}
+			default:
+				// Unknown pools are skipped, so adding one needs no version bump.
+				break;
+			}
+		}
+		scene->SetUnsavedTracking( true );
+		if (header != nullptr)
+		{
+			*header = fileHeader;
+		}
+		return scene;
+	}
+}
@@ -0,0 +1,105 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+#include "Scene.h"
+#include "Entity/Component/TransformComponent.h"
+#include <memory>
+#include <string>
+
+namespace CronoEngine
+{
+	/**
+	 * Binary scene files. Every component pool is written as two contiguous, 64 byte aligned
+	 * arrays, the entity ids and then fixed size records, in pool order. Loading maps the file
+	 * and reads the records in place; entities keep their ids, so references between them
+	 * (e.g. HierarchyComponent::Parent) need no fixups. Little endian, like every target we build.
+	 * Edits made after a save go to the snapshot's journal, see SceneJournal.
+	 */
+	class SceneSerializer
+	{
+	public:
+		static constexpr uint32_t Magic = 0x4E435343; // "CSCN"
+		// Bump when a record or the layout changes, Load rejects newer files.
+		static constexpr uint32_t Version = 2;
+		static constexpr uint64_t Alignment = 64;
+
+		enum class PoolType : uint32_t
+		{
+			Transform = 1,
+			Hierarchy = 2,
+		};
+
+		struct FileHeader
+		{
+			uint32_t Magic;
+			uint32_t Version;
+			uint32_t PoolCount;
+			// Offset of the pool table.
+			uint32_t HeaderSize;
+			uint64_t FileSize;
+			// Random id of the full save this file comes from, compaction keeps it. Journals of another lineage are stale.
+			uint64_t Lineage;
+			// Last journal segment already folded in by compaction, 0 for a full save. Added in version 2.
+			uint64_t JournalSequence;
+		};
+
+		struct PoolEntry
+		{
+			PoolType Type;
+			uint32_t RecordSize;
+			uint64_t Count;
+			// uint32_t entity ids, then Count records of RecordSize bytes.
+			uint64_t EntitiesOffset;
+			uint64_t RecordsOffset;
+		};
+
+		struct TransformRecord
+		{
+			float Position[3];
+			float Rotation[3];
+			float Scale[3];
+		};
+
+		struct HierarchyRecord
+		{
+			uint32_t Parent;
+		};
+
+		/**
+		 * Both throw FileException. Save returns the header it wrote, Load the one it read in header.
+		 * Save writes "<path>.tmp", has it put on disk and renames it over path, so path always
+		 * holds a whole file. Load rejects files naming an entity twice in a pool.
+		 */
+		static FileHeader Save( Scene& scene, const std::string& path, uint64_t lineage = NewLineage(), uint64_t journalSequence = 0 );
+		static std::unique_ptr<Scene> Load( const std::string& path, FileHeader* header = nullptr );
+		static uint64_t NewLineage();
+
+		// Shared with SceneJournal, which stores the same records.
+		static TransformRecord MakeRecord( const TransformComponent& transform );
+		static TransformComponent MakeTransform( const TransformRecord& record );
+		/**
+		 * Creates entity with that exact id and version unless it is already alive. Returns false
+		 * and creates nothing when another version of its id is alive, see GetLiveEntity.
+		 */
+		static bool CreateEntity( entt::registry& registry, entt::entity entity );
+		// The alive entity holding entity's id, whatever its version, entt::null when there is none.
+		static entt::entity GetLiveEntity( const entt::registry& registry, entt::entity entity );
+	};
+}
@@ -0,0 +1,422 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "TransformSystem.h"
+#include "Entity/Component/TransformComponent.h"
+#include "Entity/Component/HierarchyComponent.h"
+#include <algorithm>
+
+namespace CronoEngine
+{
+	void TransformSystem::Update( entt::registry& registry, JobSystem* jobs )
+	{
+		auto view = registry.view<TransformComponent>();
+		const auto& entities = *view.handle();
+		const uint32_t previousCount = m_Count;
+		m_Count = static_cast<uint32_t>(entities.size());
+		m_Entities.resize( m_Count );
+		m_WorldMatrices.resize( m_Count );
+
+		auto forEachChunk = [jobs]( uint32_t count, auto&& function )
+		{
+			const uint32_t chunkCount = (count + ChunkSize - 1) / ChunkSize;
+			if (jobs == nullptr || chunkCount <= 1)
+			{
+				function( 0, chunkCount );
+				return;
+			}
+			jobs->ParallelFor( chunkCount, 1, function );
+		};
+
+		// Find what moved, was added or now sits in a different slot of the pool.
+		m_ChunkDirtyIndices.resize( (m_Count + ChunkSize - 1) / ChunkSize );
+		std::atomic<bool> slotsChanged = m_Count < previousCount;
+		forEachChunk( m_Count, [&]( uint32_t beginChunk, uint32_t endChunk )
+		{
+			for (uint32_t chunk = beginChunk; chunk < endChunk; ++chunk)
+			{
+				std::vector<uint32_t>& dirty = m_ChunkDirtyIndices[chunk];
+				dirty.clear();
+				const uint32_t end = std::min( m_Count, (chunk + 1) * ChunkSize );
+				for (uint32_t i = chunk * ChunkSize; i < end; ++i)
+				{
+					const entt::entity entity = entities[i];
+					const bool slotChanged = i >= previousCount || m_Entities[i] != entity;
+					if (slotChanged || view.get<TransformComponent>( entity ).m_Moved)
+					{
+						if (slotChanged)
+						{
+							slotsChanged.store( true, std::memory_order_relaxed );
+						}
+						m_Entities[i] = entity;
+						dirty.push_back( i );
+					}
+				}
+			}
+		} );
+
+		m_DirtyIndices.clear();
+		m_DirtyComponents.clear();
+		m_MovedEntities.clear();
+		for (const std::vector<uint32_t>& dirty : m_ChunkDirtyIndices)
+		{
+			for (const uint32_t index : dirty)
+			{
+				const entt::entity entity = m_Entities[index];
+				const uint32_t id = entt::to_entity( entity );
+				if (id >= m_Indices.size())
+				{
+					m_Indices.resize( static_cast<size_t>(id) + 1, InvalidIndex );
+				}
+				m_Indices[id] = index;
+				TransformComponent& transform = view.get<TransformComponent>( entity );
+				if (transform.m_Moved)
+				{
+					m_MovedEntities.push_back( entity );
+				}
+				m_DirtyIndices.push_back( index );
+				m_DirtyComponents.push_back( &transform );
+			}
+		}
+
+		// Recompute the dirty ones, BlockWidth at a time.
+		const uint32_t dirtyCount = static_cast<uint32_t>(m_DirtyIndices.size());
+		forEachChunk( dirtyCount, [&]( uint32_t beginChunk, uint32_t endChunk )
+		{
+			const uint32_t end = std::min( dirtyCount, endChunk * ChunkSize );
+			for (uint32_t first = beginChunk * ChunkSize; first < end; first += BlockWidth)
+			{
+				const uint32_t lanes = std::min( BlockWidth, end - first );
+				TransformBlock block;
+				for (uint32_t lane = 0; lane < BlockWidth; ++lane)
+				{
+					if (lane >= lanes)
+					{
+						// Identity padding, its results are dropped.
+						block.PositionX[lane] = block.PositionY[lane] = block.PositionZ[lane] = 0.0f;
+						block.RotationX[lane] = block.RotationY[lane] = block.RotationZ[lane] = 0.0f;
+						block.ScaleX[lane] = block.ScaleY[lane] = block.ScaleZ[lane] = 1.0f;
+						continue;
+					}
+					const TransformComponent& transform = *m_DirtyComponents[first + lane];
+					block.PositionX[lane] = transform.m_Position.x;
+					block.PositionY[lane] = transform.m_Position.y;
+					block.PositionZ[lane] = transform.m_Position.z;
+					block.RotationX[lane] = transform.m_Rotation.x;
+					block.RotationY[lane] = transform.m_Rotation.y;
+					block.RotationZ[lane] = transform.m_Rotation.z;
+					block.ScaleX[lane] = transform.m_Scale.x;
+					block.ScaleY[lane] = transform.m_Scale.y;
+					block.ScaleZ[lane] = transform.m_Scale.z;
+				}
+
+				Math::Float4x4A localMatrices[BlockWidth];
+				Math::Float4A quaternions[BlockWidth];
+				ComputeBlock( block, lanes, localMatrices, quaternions );
+				for (uint32_t lane = 0; lane < lanes; ++lane)
+				{
+					TransformComponent& transform = *m_DirtyComponents[first + lane];
+					transform.m_Quaternion = quaternions[lane];
+					transform.m_LocalMatrix = localMatrices[lane];
+					transform.m_QuaternionDirty = false;
+					transform.m_MatrixDirty = false;
+					transform.m_Moved = false;
+					m_WorldMatrices[m_DirtyIndices[first + lane]] = localMatrices[lane];
+				}
+			}
+		} );
+
+		// Moved slots invalidate the hierarchy's indices too.
+		UpdateHierarchy( registry, slotsChanged.load() );
+	}
+
+	void TransformSystem::UpdateHierarchy( entt::registry& registry, bool rebuild )
+	{
+		rebuild = rebuild || m_HierarchyDirty;
+		if (!rebuild && (m_Nodes.empty() || m_DirtyIndices.empty()))
+		{
+			return;
+		}
+
+		m_Changed.resize( m_Count, 0 );
+		for (const uint32_t index : m_DirtyIndices)
+		{
+			m_Changed[index] = 1;
+		}
+		const size_t locallyDirty = m_DirtyIndices.size();
+		auto markChanged = [this]( uint32_t index )
+		{
+			if (!m_Changed[index])
+			{
+				m_Changed[index] = 1;
+				m_DirtyIndices.push_back( index );
+			}
+		};
+
+		if (rebuild)
+		{
+			// Former children go back to their local matrix, the sweep redoes the ones that still have a parent.
+			auto transforms = registry.view<TransformComponent>();
+			for (const HierarchyNode& node : m_Nodes)
+			{
+				if (node.Index < m_Count)
+				{
+					m_WorldMatrices[node.Index] = transforms.get<TransformComponent>( m_Entities[node.Index] ).m_LocalMatrix;
+					markChanged( node.Index );
+				}
+			}
+			RebuildHierarchy( registry );
+		}
+
+		for (const HierarchyNode& node : m_Nodes)
+		{
+			if (rebuild || m_Changed[node.Index] || m_Changed[node.Parent])
+			{
+				const Math::Matrix world = Math::MatrixMultiply( Math::LoadFloat4x4A( &node.Transform->m_LocalMatrix ),
+					Math::LoadFloat4x4A( &m_WorldMatrices[node.Parent] ) );
+				Math::StoreFloat4x4A( &m_WorldMatrices[node.Index], world );
+				markChanged( node.Index );
+			}
+		}
+
+		if (m_DirtyIndices.size() != locallyDirty)
+		{
+			std::sort( m_DirtyIndices.begin(), m_DirtyIndices.end() );
+		}
+		for (const uint32_t index : m_DirtyIndices)
+		{
+			m_Changed[index] = 0;
+		}
+	}
+
+	void TransformSystem::RebuildHierarchy( entt::registry& registry )
+	{
+		m_HierarchyDirty = false;
+		m_Nodes.clear();
+
+		// Parent index of every transform, InvalidIndex for roots.
+		auto hierarchy = registry.view<HierarchyComponent>();
+		const auto& children = *hierarchy.handle();
+		std::vector<uint32_t> parents( m_Count, InvalidIndex );
+		std::vector<uint32_t> childIndices;
+		for (size_t i = 0; i < children.size(); ++i)
+		{
+			const entt::entity entity = children[i];
+			const uint32_t index = FindIndex( entity );
+			const uint32_t parent = FindIndex( hierarchy.get<HierarchyComponent>( entity ).Parent );
+			if (index != InvalidIndex && parent != InvalidIndex && parent != index)
+			{
+				parents[index] = parent;
+				childIndices.push_back( index );
+			}
+		}
+		std::sort( childIndices.begin(), childIndices.end() );
+
+		// Depth of every child, walking up until a known depth or a root.
+		constexpr uint32_t visiting = InvalidIndex - 1;
+		std::vector<uint32_t> depths( m_Count, InvalidIndex );
+		std::vector<uint32_t> path;
+		uint32_t maxDepth = 0;
+		for (const uint32_t child : childIndices)
+		{
+			uint32_t index = child;
+			path.clear();
+			while (depths[index] == InvalidIndex && parents[index] != InvalidIndex)
+			{
+				depths[index] = visiting;
+				path.push_back( index );
+				index = parents[index];
+			}
+			if (depths[index] == visiting)
+			{
+				// A cycle that didn't go through Scene::SetParent, cut it at the top.
+				index = path.back();
+				path.pop_back();
+				parents[index] = InvalidIndex;
+			}
+			if (depths[index] == InvalidIndex || depths[index] == visiting)
+			{
+				depths[index] = 0;
+			}
+			uint32_t depth = depths[index];
+			for (auto it = path.rbegin(); it != path.rend(); ++it)
+			{
+				depths[*it] = ++depth;
+			}
+			maxDepth = std::max( maxDepth, depth );
+		}
+
+		// Counting sort by depth, index order within a depth.
+		std::vector<uint32_t> offsets( static_cast<size_t>(maxDepth) + 2, 0 );
+		for (const uint32_t child : childIndices)
+		{
+			if (parents[child] != InvalidIndex)
+			{
+				++offsets[depths[child] + 1];
+			}
+		}
+		for (size_t depth = 1; depth < offsets.size(); ++depth)
+		{
+			offsets[depth] += offsets[depth - 1];
+		}
+		m_Nodes.resize( offsets.back() );
+		auto transforms = registry.view<TransformComponent>();
+		for (const uint32_t child : childIndices)
+		{
+			if (parents[child] != InvalidIndex)
+			{
+				m_Nodes[offsets[depths[child]]++] = { child, parents[child], &transforms.get<TransformComponent>( m_Entities[child] ) };
+			}
+		}
+	}
+
+	void TransformSystem::ComputeLocal( TransformComponent& transform ) noexcept
+	{
+		TransformBlock block;
+		block.PositionX[0] = transform.m_Position.x;
+		block.PositionY[0] = transform.m_Position.y;
+		block.PositionZ[0] = transform.m_Position.z;
+		block.RotationX[0] = transform.m_Rotation.x;
+		block.RotationY[0] = transform.m_Rotation.y;
+		block.RotationZ[0] = transform.m_Rotation.z;
+		block.ScaleX[0] = transform.m_Scale.x;
+		block.ScaleY[0] = transform.m_Scale.y;
+		block.ScaleZ[0] = transform.m_Scale.z;
+		for (uint32_t lane = 1; lane < Math::BatchWidth; ++lane)
+		{
+			block.PositionX[lane] = block.PositionY[lane] = block.PositionZ[lane] = 0.0f;
+			block.RotationX[lane] = block.RotationY[lane] = block.RotationZ[lane] = 0.0f;
+			block.ScaleX[lane] = block.ScaleY[lane] = block.ScaleZ[lane] = 1.0f;
+		}
+
+		Math::Float4x4A localMatrices[BlockWidth];
+		Math::Float4A quaternions[BlockWidth];
+		ComputeBlock( block, 1, localMatrices, quaternions );
+		transform.m_Quaternion = quaternions[0];
+		transform.m_LocalMatrix = localMatrices[0];
+		transform.m_QuaternionDirty = false;
+		transform.m_MatrixDirty = false;
+	}
+
+	void TransformSystem::ComputeBlock( const TransformBlock& block, uint32_t lanes, Math::Float4x4A* localMatrices, Math::Float4A* quaternions ) noexcept
+	{
+		using namespace Math;
+		const Batch zero = BatchReplicate( 0.0f );
+		const Batch one = BatchReplicate( 1.0f );
+		const Batch half = BatchReplicate( 0.5f );
+		const Batch minusOne = BatchReplicate( -1.0f );
+		for (uint32_t lane = 0; lane < lanes; lane += BatchWidth)
+		{
+			Batch sinPitch, cosPitch, sinYaw, cosYaw, sinRoll, cosRoll;
+			BatchSinCos( &sinPitch, &cosPitch, BatchMultiply( BatchLoadA( block.RotationX + lane ), half ) );
+			BatchSinCos( &sinYaw, &cosYaw, BatchMultiply( BatchLoadA( block.RotationY + lane ), half ) );
+			BatchSinCos( &sinRoll, &cosRoll, BatchMultiply( BatchLoadA( block.RotationZ + lane ), half ) );
+
+			// Same operations as QuaternionRotationRollPitchYaw, one component at a time.
+			const Batch minusSinPitch = BatchMultiply( sinPitch, minusOne );
+			const Batch x = BatchMultiplyAdd( BatchMultiply( cosPitch, sinYaw ), sinRoll, BatchMultiply( BatchMultiply( sinPitch, cosYaw ), cosRoll ) );
+			const Batch y = BatchMultiplyAdd( BatchMultiply( minusSinPitch, cosYaw ), sinRoll, BatchMultiply( BatchMultiply( cosPitch, sinYaw ), cosRoll ) );
+			const Batch z = BatchMultiplyAdd( BatchMultiply( minusSinPitch, sinYaw ), cosRoll, BatchMultiply( BatchMultiply( cosPitch, cosYaw ), sinRoll ) );
+			const Batch w = BatchMultiplyAdd( BatchMultiply( sinPitch, sinYaw ), sinRoll, BatchMultiply( BatchMultiply( cosPitch, cosYaw ), cosRoll ) );
+
+			Vector transposed[BatchWidth];
+			BatchTranspose( x, y, z, w, transposed );
+			for (uint32_t i = 0; i < BatchWidth; ++i)
+			{
+				StoreFloat4A( &quaternions[lane + i], transposed[i] );
+			}
+
+			// And as MatrixRotationQuaternion.
+			const Batch x2 = BatchAdd( x, x );
+			const Batch y2 = BatchAdd( y, y );
+			const Batch z2 = BatchAdd( z, z );
+			const Batch xx = BatchMultiply( x, x2 );
+			const Batch yy = BatchMultiply( y, y2 );
+			const Batch zz = BatchMultiply( z, z2 );
+			const Batch xy = BatchMultiply( x, y2 );
+			const Batch xz = BatchMultiply( x, z2 );
+			const Batch yz = BatchMultiply( y, z2 );
+			const Batch wx = BatchMultiply( w, x2 );
+			const Batch wy = BatchMultiply( w, y2 );
+			const Batch wz = BatchMultiply( w, z2 );
+
+			const Batch scaleX = BatchLoadA( block.ScaleX + lane );
+			const Batch scaleY = BatchLoadA( block.ScaleY + lane );
+			const Batch scaleZ = BatchLoadA( block.ScaleZ + lane );
+			const Batch rows[4][4] = {
+				{ BatchMultiply( scaleX, BatchSubtract( BatchSubtract( one, yy ), zz ) ), BatchMultiply( scaleX, BatchAdd( xy, wz ) ),
+					BatchMultiply( scaleX, BatchSubtract( xz, wy ) ), zero },
+				{ BatchMultiply( scaleY, BatchSubtract( xy, wz ) ), BatchMultiply( scaleY, BatchSubtract( BatchSubtract( one, xx ), zz ) ),
+					BatchMultiply( scaleY, BatchAdd( yz, wx ) ), zero },
+				{ BatchMultiply( scaleZ, BatchAdd( xz, wy ) ), BatchMultiply( scaleZ, BatchSubtract( yz, wx ) ),
+					BatchMultiply( scaleZ, BatchSubtract( BatchSubtract( one, xx ), yy ) ), zero },
+				{ BatchLoadA( block.PositionX + lane ), BatchLoadA( block.PositionY + lane ), BatchLoadA( block.PositionZ + lane ), one } };
+
+			for (uint32_t row = 0; row < 4; ++row)
+			{
+				BatchTranspose( rows[row][0], rows[row][1], rows[row][2], rows[row][3], transposed );
+				for (uint32_t i = 0; i < BatchWidth; ++i)
+				{
+					VectorStore4A( localMatrices[lane + i].m[row], transposed[i] );
+				}
+			}
+		}
+	}
+
+	uint32_t TransformSystem::GetCount() const noexcept
+	{
+		return m_Count;
+	}
+
+	entt::entity TransformSystem::GetEntity( uint32_t index ) const noexcept
+	{
+		return m_Entities[index];
+	}
+
+	const Math::Float4x4A& TransformSystem::GetWorldMatrix( uint32_t index ) const noexcept
+	{
+		return m_WorldMatrices[index];
+	}
+
+	const std::vector<uint32_t>& TransformSystem::GetDirtyIndices() const noexcept
+	{
+		return m_DirtyIndices;
+	}
+
+	const std::vector<entt::entity>& TransformSystem::GetMovedEntities() const noexcept
+	{
+		return m_MovedEntities;
+	}
+
+	void TransformSystem::InvalidateHierarchy() noexcept
+	{
+		m_HierarchyDirty = true;
+	}
+
+	uint32_t TransformSystem::FindIndex( entt::entity entity ) const noexcept
+	{
+		const uint32_t id = entt::to_entity( entity );
+		if (id >= m_Indices.size())
+		{
+			return InvalidIndex;
+		}
+		const uint32_t index = m_Indices[id];
+		return index < m_Count && m_Entities[index] == entity ? index : InvalidIndex;
+	}
+}
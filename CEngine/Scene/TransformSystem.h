@@ -0,0 +1,120 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+
+#include "entt.hpp" // https://github.com/skypjack/entt
+#include "Jobs/JobSystem.h"
+#include "Math/Math.h"
+#include <cstdint>
+#include <vector>
+
+struct TransformComponent;
+
+namespace CronoEngine
+{
+	/**
+	 * Keeps the world matrix of every TransformComponent, once per frame. Only transforms that
+	 * moved since the last Update, were added, or changed places in the pool are recomputed:
+	 * they are copied into structure of arrays blocks of BlockWidth and turned into matrices a
+	 * whole Math::Batch at a time (8 lanes on AVX2, 4 on SSE), in chunks over the job system.
+	 * The results also refill the components' cached quaternion and local matrix, which
+	 * TransformComponent computes with the same ComputeBlock, so whichever of the two did it
+	 * last gives the same bits. Compilers fuse a * b + c differently in the Vector functions.
+	 * Transforms with a HierarchyComponent are then multiplied by their parent's world matrix
+	 * in one sweep over a list kept sorted by depth, so parents are always done first. Any
+	 * parent change re-sorts the whole list; it holds indices, the world matrices stay in pool
+	 * order for the culling and spatial passes. Only subtrees under something that changed are
+	 * redone, static hierarchies cost nothing.
+	 * Results are indexed in the order of the TransformComponent pool at the last Update.
+	 */
+	class TransformSystem
+	{
+	public:
+		static constexpr uint32_t BlockWidth = 8;
+		static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+		struct alignas(32) TransformBlock
+		{
+			float PositionX[BlockWidth];
+			float PositionY[BlockWidth];
+			float PositionZ[BlockWidth];
+			// Euler angles in radians, pitch (x), yaw (y) and roll (z).
+			float RotationX[BlockWidth];
+			float RotationY[BlockWidth];
+			float RotationZ[BlockWidth];
+			float ScaleX[BlockWidth];
+			float ScaleY[BlockWidth];
+			float ScaleZ[BlockWidth];
+		};
+
+		// Without jobs everything runs on the calling thread.
+		void Update( entt::registry& registry, JobSystem* jobs );
+		// Refills the cached quaternion and local matrix of one transform, for TransformComponent.
+		static void ComputeLocal( TransformComponent& transform ) noexcept;
+
+		uint32_t GetCount() const noexcept;
+		entt::entity GetEntity( uint32_t index ) const noexcept;
+		// Row major, row vectors: scale, then rotation, then translation, then the parent's world matrix.
+		const Math::Float4x4A& GetWorldMatrix( uint32_t index ) const noexcept;
+		// Index of entity at the last Update, InvalidIndex if it had no TransformComponent then.
+		uint32_t FindIndex( entt::entity entity ) const noexcept;
+		/**
+		 * Indices whose world matrix the last Update recomputed, in increasing order. Valid until
+		 * the next Update. Removed transforms don't show up here, indices at or past GetCount are gone.
+		 */
+		const std::vector<uint32_t>& GetDirtyIndices() const noexcept;
+		// Entities whose transform a setter changed since the Update before, valid until the next Update.
+		const std::vector<entt::entity>& GetMovedEntities() const noexcept;
+		// Re-sorts the hierarchy at the next Update, for when a HierarchyComponent changed.
+		void InvalidateHierarchy() noexcept;
+	private:
+		struct HierarchyNode
+		{
+			uint32_t Index;
+			uint32_t Parent;
+			const TransformComponent* Transform;
+		};
+
+		void UpdateHierarchy( entt::registry& registry, bool rebuild );
+		void RebuildHierarchy( entt::registry& registry );
+		// Only the batches holding the first lanes are computed.
+		static void ComputeBlock( const TransformBlock& block, uint32_t lanes, Math::Float4x4A* localMatrices, Math::Float4A* quaternions ) noexcept;
+	private:
+		// Transforms per job, for both the dirty scan and the recompute.
+		static constexpr uint32_t ChunkSize = 256;
+
+		uint32_t m_Count = 0;
+		std::vector<entt::entity> m_Entities;
+		std::vector<Math::Float4x4A> m_WorldMatrices;
+		// Entity id to index, only trusted when m_Entities agrees.
+		std::vector<uint32_t> m_Indices;
+		std::vector<uint32_t> m_DirtyIndices;
+		std::vector<entt::entity> m_MovedEntities;
+		// Scratch, one list of dirty indices per scan chunk and the components behind m_DirtyIndices.
+		std::vector<std::vector<uint32_t>> m_ChunkDirtyIndices;
+		std::vector<TransformComponent*> m_DirtyComponents;
+
+		bool m_HierarchyDirty = true;
+		// Transforms that have a parent, sorted by depth.
+		std::vector<HierarchyNode> m_Nodes;
+		// Per index, set while it is in m_DirtyIndices during UpdateHierarchy.
+		std::vector<uint8_t> m_Changed;
+	};
+}
@@ -0,0 +1,203 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "VisibilitySystem.h"
+#include "AabbTree.h"
+#include "Math/VectorBatch.h"
+#include <algorithm>
+#include <bit>
+
+namespace CronoEngine
+{
+	using namespace Math;
+
+	uint32_t VisibilitySystem::GetCount() const noexcept
+	{
+		return m_Count;
+	}
+
+	Aabb VisibilitySystem::GetBounds( uint32_t index ) const noexcept
+	{
+		const BoundsBlock& block = m_Blocks[index / BlockWidth];
+		const uint32_t lane = index % BlockWidth;
+		return AabbFromCenterExtents( { block.CenterX[lane], block.CenterY[lane], block.CenterZ[lane] },
+			{ block.ExtentsX[lane], block.ExtentsY[lane], block.ExtentsZ[lane] } );
+	}
+
+	void VisibilitySystem::WriteBounds( const entt::registry& registry, const TransformSystem& transforms, uint32_t index ) noexcept
+	{
+		const Aabb bounds = AabbTree::GetWorldBounds( registry, transforms.GetEntity( index ), transforms.GetWorldMatrix( index ) );
+		BoundsBlock& block = m_Blocks[index / BlockWidth];
+		const uint32_t lane = index % BlockWidth;
+		block.CenterX[lane] = (bounds.Min.x + bounds.Max.x) * 0.5f;
+		block.CenterY[lane] = (bounds.Min.y + bounds.Max.y) * 0.5f;
+		block.CenterZ[lane] = (bounds.Min.z + bounds.Max.z) * 0.5f;
+		block.ExtentsX[lane] = (bounds.Max.x - bounds.Min.x) * 0.5f;
+		block.ExtentsY[lane] = (bounds.Max.y - bounds.Min.y) * 0.5f;
+		block.ExtentsZ[lane] = (bounds.Max.z - bounds.Min.z) * 0.5f;
+	}
+
+	void VisibilitySystem::Update( const entt::registry& registry, const TransformSystem& transforms,
+		const std::vector<entt::entity>& changed, JobSystem* jobs )
+	{
+		m_Count = transforms.GetCount();
+		m_Blocks.resize( (m_Count + BlockWidth - 1) / BlockWidth );
+
+		// Dirty indices are unique and never share a lane, so jobs can write them side by side.
+		const std::vector<uint32_t>& dirty = transforms.GetDirtyIndices();
+		const uint32_t dirtyCount = static_cast<uint32_t>(dirty.size());
+		auto write = [&]( uint32_t begin, uint32_t end )
+		{
+			for (uint32_t i = begin; i < end; ++i)
+			{
+				WriteBounds( registry, transforms, dirty[i] );
+			}
+		};
+		if (jobs == nullptr || dirtyCount <= UpdateGrain)
+		{
+			write( 0, dirtyCount );
+		}
+		else
+		{
+			jobs->ParallelFor( dirtyCount, UpdateGrain, write );
+		}
+
+		for (const entt::entity entity : changed)
+		{
+			const uint32_t index = transforms.FindIndex( entity );
+			if (index != TransformSystem::InvalidIndex)
+			{
+				WriteBounds( registry, transforms, index );
+			}
+		}
+	}
+
+	void VisibilitySystem::Cull( const Frustum* frustums, uint32_t viewCount, VisibilityList* lists, JobSystem* jobs ) const
+	{
+		const uint32_t blockCount = static_cast<uint32_t>(m_Blocks.size());
+		const uint32_t chunkCount = (blockCount + ChunkBlocks - 1) / ChunkBlocks;
+		for (uint32_t view = 0; view < viewCount; ++view)
+		{
+			lists[view].BlockMasks.resize( blockCount );
+			lists[view].ChunkCounts.resize( chunkCount );
+		}
+		auto forEachChunk = [&]( auto&& function )
+		{
+			if (jobs == nullptr || chunkCount <= 1)
+			{
+				function( 0, chunkCount );
+				return;
+			}
+			jobs->ParallelFor( chunkCount, 1, function );
+		};
+
+		// A box is out when it is fully behind one plane: distance to its center plus its
+		// projected radius is negative.
+		forEachChunk( [&]( uint32_t beginChunk, uint32_t endChunk )
+		{
+			const Batch zero = BatchReplicate( 0.0f );
+			for (uint32_t chunk = beginChunk; chunk < endChunk; ++chunk)
+			{
+				const uint32_t endBlock = std::min( blockCount, (chunk + 1) * ChunkBlocks );
+				for (uint32_t view = 0; view < viewCount; ++view)
+				{
+					lists[view].ChunkCounts[chunk] = 0;
+				}
+				for (uint32_t b = chunk * ChunkBlocks; b < endBlock; ++b)
+				{
+					const BoundsBlock& block = m_Blocks[b];
+					// The last block may be partly past the end.
+					const uint32_t lanes = std::min( BlockWidth, m_Count - b * BlockWidth );
+					const uint32_t laneMask = (1u << lanes) - 1;
+					for (uint32_t view = 0; view < viewCount; ++view)
+					{
+						// Outside bits first, flipped to visible ones below.
+						lists[view].BlockMasks[b] = 0;
+					}
+					for (uint32_t lane = 0; lane < BlockWidth; lane += BatchWidth)
+					{
+						const Batch centerX = BatchLoadA( block.CenterX + lane );
+						const Batch centerY = BatchLoadA( block.CenterY + lane );
+						const Batch centerZ = BatchLoadA( block.CenterZ + lane );
+						const Batch extentsX = BatchLoadA( block.ExtentsX + lane );
+						const Batch extentsY = BatchLoadA( block.ExtentsY + lane );
+						const Batch extentsZ = BatchLoadA( block.ExtentsZ + lane );
+						for (uint32_t view = 0; view < viewCount; ++view)
+						{
+							Batch out = zero;
+							for (const Float4& plane : frustums[view].Planes)
+							{
+								const Batch nx = BatchReplicate( plane.x );
+								const Batch ny = BatchReplicate( plane.y );
+								const Batch nz = BatchReplicate( plane.z );
+								Batch distance = BatchMultiplyAdd( nx, centerX, BatchReplicate( plane.w ) );
+								distance = BatchMultiplyAdd( ny, centerY, distance );
+								distance = BatchMultiplyAdd( nz, centerZ, distance );
+								Batch radius = BatchMultiply( BatchAbs( nx ), extentsX );
+								radius = BatchMultiplyAdd( BatchAbs( ny ), extentsY, radius );
+								radius = BatchMultiplyAdd( BatchAbs( nz ), extentsZ, radius );
+								out = BatchOrInt( out, BatchLess( BatchAdd( distance, radius ), zero ) );
+							}
+							lists[view].BlockMasks[b] |= static_cast<uint8_t>(BatchMoveMask( out ) << lane);
+						}
+					}
+					for (uint32_t view = 0; view < viewCount; ++view)
+					{
+						const uint32_t visible = ~static_cast<uint32_t>(lists[view].BlockMasks[b]) & laneMask;
+						lists[view].BlockMasks[b] = static_cast<uint8_t>(visible);
+						lists[view].ChunkCounts[chunk] += static_cast<uint32_t>(std::popcount( visible ));
+					}
+				}
+			}
+		} );
+
+		// Turn the counts into where each chunk starts writing.
+		for (uint32_t view = 0; view < viewCount; ++view)
+		{
+			uint32_t total = 0;
+			for (uint32_t& count : lists[view].ChunkCounts)
+			{
+				const uint32_t chunkVisible = count;
+				count = total;
+				total += chunkVisible;
+			}
+			lists[view].Indices.resize( total );
+		}
+
+		forEachChunk( [&]( uint32_t beginChunk, uint32_t endChunk )
+		{
+			for (uint32_t chunk = beginChunk; chunk < endChunk; ++chunk)
+			{
+				const uint32_t endBlock = std::min( blockCount, (chunk + 1) * ChunkBlocks );
+				for (uint32_t view = 0; view < viewCount; ++view)
+				{
+					VisibilityList& list = lists[view];
+					uint32_t* output = list.Indices.data() + list.ChunkCounts[chunk];
+					for (uint32_t b = chunk * ChunkBlocks; b < endBlock; ++b)
+					{
+						for (uint32_t visible = list.BlockMasks[b]; visible != 0; visible &= visible - 1)
+						{
+							*output++ = b * BlockWidth + static_cast<uint32_t>(std::countr_zero( visible ));
+						}
+					}
+				}
+			}
+		} );
+	}
+}
@@ -0,0 +1,90 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+
+#include "entt.hpp" // https://github.com/skypjack/entt
+#include "Jobs/JobSystem.h"
+#include "Math/Math.h"
+#include "TransformSystem.h"
+#include <cstdint>
+#include <vector>
+
+namespace CronoEngine
+{
+	/**
+	 * What one view can see, as TransformSystem indices. Keep it around between frames, Cull
+	 * reuses its memory.
+	 */
+	struct VisibilityList
+	{
+		// Increasing. Valid until the next UpdateTransforms.
+		std::vector<uint32_t> Indices;
+		// One per VisibilitySystem::BlockWidth indices, bit i stands for index block * BlockWidth + i.
+		std::vector<uint8_t> BlockMasks;
+		// Scratch, how many visible indices each cull chunk found.
+		std::vector<uint32_t> ChunkCounts;
+	};
+
+	/**
+	 * World space bounds of every TransformComponent in TransformSystem order, kept as
+	 * structure of arrays blocks (center and extents) so Cull tests them against the frustums
+	 * a whole Math::Batch at a time (8 lanes on AVX2, 4 on SSE). Update only redoes the
+	 * TransformSystem's dirty indices and the entities whose BoundsComponent changed.
+	 */
+	class VisibilitySystem
+	{
+	public:
+		static constexpr uint32_t BlockWidth = 8;
+
+		struct alignas(32) BoundsBlock
+		{
+			float CenterX[BlockWidth];
+			float CenterY[BlockWidth];
+			float CenterZ[BlockWidth];
+			float ExtentsX[BlockWidth];
+			float ExtentsY[BlockWidth];
+			float ExtentsZ[BlockWidth];
+		};
+
+		// After the TransformSystem's Update. changed may hold entities without a transform, they are skipped.
+		void Update( const entt::registry& registry, const TransformSystem& transforms,
+			const std::vector<entt::entity>& changed, JobSystem* jobs );
+		/**
+		 * Fills lists[i] with what is at least partly inside frustums[i]. Every block of bounds
+		 * is read once for all the views, in chunks over the job system; each chunk counts what
+		 * it found first, so the indices are written straight to their place without locks.
+		 */
+		void Cull( const Math::Frustum* frustums, uint32_t viewCount, VisibilityList* lists, JobSystem* jobs ) const;
+
+		uint32_t GetCount() const noexcept;
+		// World bounds of the transform at index, as culled.
+		Math::Aabb GetBounds( uint32_t index ) const noexcept;
+	private:
+		void WriteBounds( const entt::registry& registry, const TransformSystem& transforms, uint32_t index ) noexcept;
+	private:
+		// Blocks per cull chunk, 12 KiB of bounds.
+		static constexpr uint32_t ChunkBlocks = 64;
+		// Bounds recomputed per job in Update.
+		static constexpr uint32_t UpdateGrain = 1024;
+
+		uint32_t m_Count = 0;
+		std::vector<BoundsBlock> m_Blocks;
+	};
+}
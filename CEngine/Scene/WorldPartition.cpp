@@ -0,0 +1,470 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "WorldPartition.h"
+#include "SceneSerializer.h"
+#include "Entity/Component/TransformComponent.h"
+#include "Entity/Component/HierarchyComponent.h"
+#include "Common/CronoTimer.h"
+#include "Common/MappedFile.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+
+namespace CronoEngine
+{
+	namespace
+	{
+		const char* ManifestName = "world.cells";
+
+		// Components, entt's dense and sparse entries and the TransformSystem's matrix per entity.
+		uint64_t EstimateBytes( uint32_t transformCount, uint32_t hierarchyCount ) noexcept
+		{
+			const uint64_t perTransform = sizeof( TransformComponent ) + 2 * sizeof( entt::entity ) + sizeof( Math::Float4x4A );
+			const uint64_t perHierarchy = sizeof( HierarchyComponent ) + 2 * sizeof( entt::entity );
+			return transformCount * perTransform + hierarchyCount * perHierarchy;
+		}
+
+		int32_t CellCoordinate( float position, float cellSize ) noexcept
+		{
+			return static_cast<int32_t>(std::floor( position / cellSize ));
+		}
+	}
+
+	uint64_t WorldPartition::CellKey( int32_t x, int32_t z ) noexcept
+	{
+		return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(z);
+	}
+
+	std::string WorldPartition::CellFileName( int32_t x, int32_t z )
+	{
+		return "cell_" + std::to_string( x ) + "_" + std::to_string( z ) + ".scene";
+	}
+
+	void WorldPartition::Build( Scene& scene, const std::string& directory, float cellSize )
+	{
+		std::error_code error;
+		std::filesystem::create_directories( directory, error );
+		if (error)
+		{
+			throw CHWND_FILE_EXCEPT( directory, "Could not create the world directory: " + error.message() );
+		}
+
+		entt::registry& registry = scene.m_Registry;
+		auto transforms = registry.view<TransformComponent>();
+		const auto& entities = *transforms.handle();
+		// Every transform goes to the cell of its hierarchy root, ordered so the manifest is stable.
+		std::map<uint64_t, std::vector<entt::entity>> cells;
+		for (size_t i = 0; i < entities.size(); ++i)
+		{
+			const entt::entity entity = entities[i];
+			entt::entity root = entity;
+			// Bounded in case of a cycle that didn't go through Scene::SetParent.
+			for (size_t depth = 0; depth < entities.size(); ++depth)
+			{
+				const HierarchyComponent* hierarchy = registry.try_get<HierarchyComponent>( root );
+				if (hierarchy == nullptr || !registry.valid( hierarchy->Parent ) ||
+					!registry.all_of<TransformComponent>( hierarchy->Parent ))
+				{
+					break;
+				}
+				root = hierarchy->Parent;
+			}
+			const auto position = transforms.get<TransformComponent>( root ).GetPosition();
+			cells[CellKey( CellCoordinate( position.x, cellSize ), CellCoordinate( position.z, cellSize ) )].push_back( entity );
+		}
+
+		std::vector<ManifestCell> manifest;
+		manifest.reserve( cells.size() );
+		for (const auto& [key, cellEntities] : cells)
+		{
+			ManifestCell& entry = manifest.emplace_back();
+			entry.X = static_cast<int32_t>(key >> 32);
+			entry.Z = static_cast<int32_t>(key & 0xFFFFFFFFu);
+			entry.TransformCount = static_cast<uint32_t>(cellEntities.size());
+			entry.HierarchyCount = 0;
+
+			Scene cellScene;
+			entt::registry& cellRegistry = cellScene.m_Registry;
+			for (const entt::entity entity : cellEntities)
+			{
+				cellRegistry.create( entity );
+				cellRegistry.emplace<TransformComponent>( entity, transforms.get<TransformComponent>( entity ) );
+			}
+			for (const entt::entity entity : cellEntities)
+			{
+				// Parents without a transform stayed behind, their children become roots.
+				const HierarchyComponent* hierarchy = registry.try_get<HierarchyComponent>( entity );
+				if (hierarchy != nullptr && cellRegistry.valid( hierarchy->Parent ))
+				{
+					cellRegistry.emplace<HierarchyComponent>( entity, hierarchy->Parent );
+					++entry.HierarchyCount;
+				}
+			}
+			SceneSerializer::Save( cellScene, directory + "/" + CellFileName( entry.X, entry.Z ) );
+		}
+
+		const std::string manifestPath = directory + "/" + ManifestName;
+		const ManifestHeader header{ Magic, Version, cellSize, static_cast<uint32_t>(manifest.size()) };
+		std::ofstream file( manifestPath, std::ios::binary | std::ios::trunc );
+		file.write( reinterpret_cast<const char*>(&header), sizeof( header ) );
+		file.write( reinterpret_cast<const char*>(manifest.data()), static_cast<std::streamsize>(manifest.size() * sizeof( ManifestCell )) );
+		if (!file)
+		{
+			throw CHWND_FILE_EXCEPT( manifestPath, "Could not write the world manifest." );
+		}
+	}
+
+	WorldPartition::WorldPartition( Scene& scene, std::string directory )
+		:
+		WorldPartition( scene, std::move( directory ), Settings() )
+	{}
+
+	WorldPartition::WorldPartition( Scene& scene, std::string directory, const Settings& settings )
+		:
+		m_Scene( scene ),
+		m_Directory( std::move( directory ) ),
+		m_Settings( settings ),
+		m_Jobs( scene.GetJobSystem() )
+	{
+		const std::string manifestPath = m_Directory + "/" + ManifestName;
+		const MappedFile file( manifestPath );
+		ManifestHeader header{};
+		if (file.GetSize() < sizeof( ManifestHeader ))
+		{
+			throw CHWND_FILE_EXCEPT( manifestPath, "Not a world manifest." );
+		}
+		std::memcpy( &header, file.GetData(), sizeof( header ) );
+		if (header.Magic != Magic || header.Version > Version || !(header.CellSize > 0.0f))
+		{
+			throw CHWND_FILE_EXCEPT( manifestPath, "Not a world manifest this build can read." );
+		}
+		if (header.CellCount > (file.GetSize() - sizeof( ManifestHeader )) / sizeof( ManifestCell ))
+		{
+			throw CHWND_FILE_EXCEPT( manifestPath, "World manifest is truncated." );
+		}
+
+		m_CellSize = header.CellSize;
+		m_Cells = std::vector<Cell>( header.CellCount );
+		for (uint32_t i = 0; i < header.CellCount; ++i)
+		{
+			ManifestCell entry{};
+			std::memcpy( &entry, file.GetData() + sizeof( ManifestHeader ) + i * sizeof( ManifestCell ), sizeof( entry ) );
+			Cell& cell = m_Cells[i];
+			cell.X = entry.X;
+			cell.Z = entry.Z;
+			cell.Bytes = EstimateBytes( entry.TransformCount, entry.HierarchyCount );
+			m_CellIndices[CellKey( entry.X, entry.Z )] = i;
+		}
+	}
+
+	WorldPartition::~WorldPartition()
+	{
+		if (m_Jobs != nullptr)
+		{
+			m_Jobs->Wait( m_Loads );
+		}
+	}
+
+	uint32_t WorldPartition::AddObserver( float x, float z )
+	{
+		for (uint32_t i = 0; i < m_Observers.size(); ++i)
+		{
+			if (!m_Observers[i].Active)
+			{
+				m_Observers[i] = { x, z, true };
+				return i;
+			}
+		}
+		m_Observers.push_back( { x, z, true } );
+		return static_cast<uint32_t>(m_Observers.size() - 1);
+	}
+
+	void WorldPartition::SetObserver( uint32_t observer, float x, float z )
+	{
+		m_Observers[observer].X = x;
+		m_Observers[observer].Z = z;
+	}
+
+	void WorldPartition::RemoveObserver( uint32_t observer )
+	{
+		m_Observers[observer].Active = false;
+	}
+
+	const WorldPartition::Metrics& WorldPartition::GetMetrics() const noexcept
+	{
+		return m_Metrics;
+	}
+
+	float WorldPartition::GetCellSize() const noexcept
+	{
+		return m_CellSize;
+	}
+
+	bool WorldPartition::IsResident( int32_t x, int32_t z ) const
+	{
+		const auto it = m_CellIndices.find( CellKey( x, z ) );
+		return it != m_CellIndices.end() && m_Cells[it->second].State == CellState::Resident;
+	}
+
+	float WorldPartition::DistanceTo( const Cell& cell ) const noexcept
+	{
+		const float minX = cell.X * m_CellSize;
+		const float minZ = cell.Z * m_CellSize;
+		float nearest = FLT_MAX;
+		for (const Observer& observer : m_Observers)
+		{
+			if (!observer.Active)
+			{
+				continue;
+			}
+			const float dx = std::max( { minX - observer.X, 0.0f, observer.X - (minX + m_CellSize) } );
+			const float dz = std::max( { minZ - observer.Z, 0.0f, observer.Z - (minZ + m_CellSize) } );
+			nearest = std::min( nearest, std::sqrt( dx * dx + dz * dz ) );
+		}
+		return nearest;
+	}
+
+	void WorldPartition::Update()
+	{
+		CronoTimer timer;
+
+		// Finished loads, merge the ones still in range and drop the rest.
+		uint32_t merges = 0;
+		for (size_t i = 0; i < m_Loading.size(); )
+		{
+			Cell& cell = m_Cells[m_Loading[i]];
+			if (!cell.Ready.load( std::memory_order_acquire ))
+			{
+				++i;
+				continue;
+			}
+			const bool wanted = !cell.Failed && DistanceTo( cell ) <= m_Settings.UnloadRadius;
+			if (wanted && merges >= m_Settings.MaxMergesPerUpdate)
+			{
+				++i;
+				continue;
+			}
+			m_Loading[i] = m_Loading.back();
+			m_Loading.pop_back();
+			m_InFlightBytes -= cell.Bytes;
+			cell.Ready.store( false, std::memory_order_relaxed );
+			if (wanted)
+			{
+				Merge( cell );
+				++merges;
+				continue;
+			}
+			// A failed cell stays Failed and isn't tried again.
+			m_Metrics.FailedLoads += cell.Failed ? 1 : 0;
+			cell.Staged.reset();
+			cell.State = CellState::Unloaded;
+		}
+
+		// Resident cells past every observer's UnloadRadius go.
+		for (size_t i = 0; i < m_Resident.size(); )
+		{
+			Cell& cell = m_Cells[m_Resident[i]];
+			cell.Distance = DistanceTo( cell );
+			if (cell.Distance > m_Settings.UnloadRadius)
+			{
+				Unload( cell );
+				m_Resident[i] = m_Resident.back();
+				m_Resident.pop_back();
+				continue;
+			}
+			++i;
+		}
+
+		// Unloaded cells in LoadRadius of an observer, nearest first.
+		m_Wanted.clear();
+		const int32_t reach = static_cast<int32_t>(std::ceil( m_Settings.LoadRadius / m_CellSize ));
+		for (const Observer& observer : m_Observers)
+		{
+			if (!observer.Active)
+			{
+				continue;
+			}
+			const int32_t centerX = CellCoordinate( observer.X, m_CellSize );
+			const int32_t centerZ = CellCoordinate( observer.Z, m_CellSize );
+			for (int32_t z = centerZ - reach; z <= centerZ + reach; ++z)
+			{
+				for (int32_t x = centerX - reach; x <= centerX + reach; ++x)
+				{
+					const auto it = m_CellIndices.find( CellKey( x, z ) );
+					if (it == m_CellIndices.end())
+					{
+						continue;
+					}
+					Cell& cell = m_Cells[it->second];
+					if (cell.State == CellState::Unloaded && !cell.Failed)
+					{
+						cell.Distance = DistanceTo( cell );
+						if (cell.Distance <= m_Settings.LoadRadius)
+						{
+							m_Wanted.push_back( it->second );
+						}
+					}
+				}
+			}
+		}
+		std::sort( m_Wanted.begin(), m_Wanted.end() );
+		m_Wanted.erase( std::unique( m_Wanted.begin(), m_Wanted.end() ), m_Wanted.end() );
+		std::sort( m_Wanted.begin(), m_Wanted.end(), [this]( uint32_t a, uint32_t b )
+		{
+			return m_Cells[a].Distance < m_Cells[b].Distance || (m_Cells[a].Distance == m_Cells[b].Distance && a < b);
+		} );
+
+		m_Metrics.BudgetDeferredCells = 0;
+		bool residentSorted = false;
+		for (const uint32_t index : m_Wanted)
+		{
+			if (m_Loading.size() >= m_Settings.MaxLoadsInFlight)
+			{
+				break;
+			}
+			Cell& cell = m_Cells[index];
+			if (m_Settings.MemoryBudget != 0 && m_Metrics.ResidentBytes + m_InFlightBytes + cell.Bytes > m_Settings.MemoryBudget)
+			{
+				// Make room from cells kept only by the hysteresis, farthest first and only for nearer ones.
+				if (!residentSorted)
+				{
+					std::sort( m_Resident.begin(), m_Resident.end(), [this]( uint32_t a, uint32_t b )
+					{
+						return m_Cells[a].Distance < m_Cells[b].Distance;
+					} );
+					residentSorted = true;
+				}
+				while (!m_Resident.empty() && m_Metrics.ResidentBytes + m_InFlightBytes + cell.Bytes > m_Settings.MemoryBudget)
+				{
+					Cell& farthest = m_Cells[m_Resident.back()];
+					if (farthest.Distance <= m_Settings.LoadRadius || farthest.Distance <= cell.Distance)
+					{
+						break;
+					}
+					Unload( farthest );
+					m_Resident.pop_back();
+				}
+				if (m_Metrics.ResidentBytes + m_InFlightBytes + cell.Bytes > m_Settings.MemoryBudget)
+				{
+					++m_Metrics.BudgetDeferredCells;
+					continue;
+				}
+			}
+			StartLoad( cell );
+		}
+
+		m_Metrics.ResidentCells = static_cast<uint32_t>(m_Resident.size());
+		m_Metrics.CellsInFlight = static_cast<uint32_t>(m_Loading.size());
+		m_Metrics.LastStallMilliseconds = timer.Mark() * 1000.0;
+		m_Metrics.MaxStallMilliseconds = std::max( m_Metrics.MaxStallMilliseconds, m_Metrics.LastStallMilliseconds );
+		m_Metrics.TotalStallMilliseconds += m_Metrics.LastStallMilliseconds;
+	}
+
+	void WorldPartition::StartLoad( Cell& cell )
+	{
+		cell.State = CellState::Loading;
+		m_Loading.push_back( static_cast<uint32_t>(&cell - m_Cells.data()) );
+		m_InFlightBytes += cell.Bytes;
+
+		auto load = [&cell, path = m_Directory + "/" + CellFileName( cell.X, cell.Z )]()
+		{
+			try
+			{
+				cell.Staged = SceneSerializer::Load( path );
+			}
+			catch (const std::exception&)
+			{
+				cell.Failed = true;
+			}
+			cell.Ready.store( true, std::memory_order_release );
+		};
+		if (m_Jobs == nullptr)
+		{
+			load();
+			return;
+		}
+		m_Jobs->Run( std::move( load ), &m_Loads );
+	}
+
+	void WorldPartition::Merge( Cell& cell )
+	{
+		entt::registry& source = cell.Staged->m_Registry;
+		entt::registry& target = m_Scene.m_Registry;
+		m_Scene.SetUnsavedTracking( false );
+
+		// Ids are kept unless something in the scene took them meanwhile, parents follow.
+		auto transforms = source.view<TransformComponent>();
+		const auto& entities = *transforms.handle();
+		std::unordered_map<uint32_t, entt::entity> remap;
+		remap.reserve( entities.size() );
+		cell.Entities.clear();
+		cell.Entities.reserve( entities.size() );
+		for (size_t i = 0; i < entities.size(); ++i)
+		{
+			const entt::entity entity = entities[i];
+			const entt::entity live = target.valid( entity ) ? target.create() : target.create( entity );
+			remap[static_cast<uint32_t>(entity)] = live;
+			cell.Entities.push_back( live );
+			m_Scene.SetStreamed( live, true );
+			target.emplace<TransformComponent>( live, transforms.get<TransformComponent>( entity ) );
+		}
+		auto hierarchy = source.view<HierarchyComponent>();
+		const auto& children = *hierarchy.handle();
+		for (size_t i = 0; i < children.size(); ++i)
+		{
+			const auto child = remap.find( static_cast<uint32_t>(children[i]) );
+			const auto parent = remap.find( static_cast<uint32_t>(hierarchy.get<HierarchyComponent>( children[i] ).Parent) );
+			if (child != remap.end() && parent != remap.end())
+			{
+				target.emplace<HierarchyComponent>( child->second, parent->second );
+			}
+		}
+
+		m_Scene.SetUnsavedTracking( true );
+		cell.Staged.reset();
+		cell.State = CellState::Resident;
+		m_Resident.push_back( static_cast<uint32_t>(&cell - m_Cells.data()) );
+		m_Metrics.ResidentBytes += cell.Bytes;
+		++m_Metrics.LoadedCells;
+	}
+
+	void WorldPartition::Unload( Cell& cell )
+	{
+		entt::registry& registry = m_Scene.m_Registry;
+		m_Scene.SetUnsavedTracking( false );
+		for (const entt::entity entity : cell.Entities)
+		{
+			if (registry.valid( entity ))
+			{
+				registry.destroy( entity );
+			}
+			m_Scene.SetStreamed( entity, false );
+		}
+		m_Scene.SetUnsavedTracking( true );
+		cell.Entities.clear();
+		cell.State = CellState::Unloaded;
+		m_Metrics.ResidentBytes -= cell.Bytes;
+		++m_Metrics.UnloadedCells;
+	}
+}
@@ -0,0 +1,170 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+#include "Scene.h"
+#include "Jobs/JobSystem.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace CronoEngine
+{
+	/**
+	 * Streams a world cut into square cells on the XZ plane in and out of a Scene around a set
+	 * of observers. Build writes one scene snapshot per cell plus a manifest; every hierarchy
+	 * goes whole into the cell of its root. Update loads the cells in LoadRadius of an observer
+	 * on the job system, nearest first, and merges the finished ones into the scene; cells past
+	 * UnloadRadius of every observer are unloaded. Streamed entities are read only as far as
+	 * the world is concerned: unloading drops them, edits included, and they never reach the
+	 * scene's journal.
+	 */
+	class WorldPartition
+	{
+	public:
+		static constexpr uint32_t Magic = 0x444C5743; // "CWLD"
+		static constexpr uint32_t Version = 1;
+
+		struct Settings
+		{
+			// Distances on the XZ plane, from an observer to the nearest point of a cell.
+			float LoadRadius = 192.0f;
+			// Keep it above LoadRadius, the gap keeps cells on the edge from thrashing.
+			float UnloadRadius = 256.0f;
+			// Estimated bytes of resident and loading cells, 0 for no limit.
+			uint64_t MemoryBudget = 256ull * 1024 * 1024;
+			uint32_t MaxLoadsInFlight = 4;
+			// Loaded cells merged into the scene per Update, the rest wait for the next one.
+			uint32_t MaxMergesPerUpdate = 2;
+		};
+
+		struct Metrics
+		{
+			uint32_t ResidentCells = 0;
+			uint32_t CellsInFlight = 0;
+			uint64_t ResidentBytes = 0;
+			// Wanted cells the budget kept from loading at the last Update.
+			uint32_t BudgetDeferredCells = 0;
+			uint64_t LoadedCells = 0;
+			uint64_t UnloadedCells = 0;
+			uint64_t FailedLoads = 0;
+			// Time Update spent on the calling thread, merging and unloading are most of it.
+			double LastStallMilliseconds = 0.0;
+			double MaxStallMilliseconds = 0.0;
+			double TotalStallMilliseconds = 0.0;
+		};
+
+		struct ManifestHeader
+		{
+			uint32_t Magic;
+			uint32_t Version;
+			float CellSize;
+			uint32_t CellCount;
+		};
+
+		struct ManifestCell
+		{
+			int32_t X;
+			int32_t Z;
+			uint32_t TransformCount;
+			uint32_t HierarchyCount;
+		};
+
+		/**
+		 * Splits scene into cells of cellSize under directory and writes the manifest. Entities
+		 * keep their ids, so they stay unique across cells. Throws FileException.
+		 */
+		static void Build( Scene& scene, const std::string& directory, float cellSize );
+
+		// Reads the manifest in directory, throws FileException. Uses scene's job system.
+		WorldPartition( Scene& scene, std::string directory );
+		WorldPartition( Scene& scene, std::string directory, const Settings& settings );
+		// Waits for the loads in flight, the resident cells stay in the scene.
+		~WorldPartition();
+		WorldPartition( const WorldPartition& ) = delete;
+		WorldPartition& operator=( const WorldPartition& ) = delete;
+
+		uint32_t AddObserver( float x, float z );
+		void SetObserver( uint32_t observer, float x, float z );
+		void RemoveObserver( uint32_t observer );
+
+		// Once per frame, from the thread that owns the scene.
+		void Update();
+		const Metrics& GetMetrics() const noexcept;
+		float GetCellSize() const noexcept;
+		bool IsResident( int32_t x, int32_t z ) const;
+	private:
+		enum class CellState
+		{
+			Unloaded,
+			Loading,
+			Resident,
+		};
+
+		struct Cell
+		{
+			int32_t X = 0;
+			int32_t Z = 0;
+			uint64_t Bytes = 0;
+			CellState State = CellState::Unloaded;
+			bool Failed = false;
+			// Written by the load job, handed over through Ready.
+			std::unique_ptr<Scene> Staged;
+			std::atomic<bool> Ready = false;
+			// What the cell put into the scene, to destroy on unload.
+			std::vector<entt::entity> Entities;
+			// Nearest observer, refreshed every Update.
+			float Distance = 0.0f;
+		};
+
+		struct Observer
+		{
+			float X;
+			float Z;
+			bool Active;
+		};
+
+		static uint64_t CellKey( int32_t x, int32_t z ) noexcept;
+		static std::string CellFileName( int32_t x, int32_t z );
+		float DistanceTo( const Cell& cell ) const noexcept;
+		void StartLoad( Cell& cell );
+		void Merge( Cell& cell );
+		void Unload( Cell& cell );
+	private:
+		Scene& m_Scene;
+		std::string m_Directory;
+		Settings m_Settings;
+		float m_CellSize = 0.0f;
+		// Never resized after the constructor, load jobs hold on to their Cell.
+		std::vector<Cell> m_Cells;
+		std::unordered_map<uint64_t, uint32_t> m_CellIndices;
+		std::vector<Observer> m_Observers;
+		// Indices into m_Cells.
+		std::vector<uint32_t> m_Loading;
+		std::vector<uint32_t> m_Resident;
+		// Scratch for Update, the unloaded cells in LoadRadius.
+		std::vector<uint32_t> m_Wanted;
+		uint64_t m_InFlightBytes = 0;
+		Metrics m_Metrics;
+		JobSystem* m_Jobs = nullptr;
+		JobCounter m_Loads;
+	};
+}
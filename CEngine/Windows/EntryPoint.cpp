@@ -17,13 +17,16 @@
 *	You should have received a copy of the GNU General Public License					  *
 *	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
 ******************************************************************************************/
+#if defined(_WIN32)
 #include "WinInclude.h"
+#endif
 #include "../Application/Application.h"
 #include <exception>
 #include "../Common/CronoException.h"
 
 extern CronoEngine::Application* CreateEngineApp();
 
+#if defined(_WIN32)
 int CALLBACK WinMain(HINSTANCE hInstance,HINSTANCE hPrevInstance,LPSTR lpCmdLine,int nShowCmd )
 {
 	try
@@ -46,4 +49,30 @@ int CALLBACK WinMain(HINSTANCE hInstance,HINSTANCE hPrevInstance,LPSTR lpCmdLine
 		MessageBox( nullptr, "No details available", "Unknown Exception", MB_OK | MB_ICONEXCLAMATION );
 	}
 	return -1;
-}
\ No newline at end of file
+}
+#else
+#include <iostream>
+
+int main( int argc, char** argv )
+{
+	try
+	{
+		CronoEngine::Platform::SetCommandLineArgs( argc, argv );
+		CronoEngine::Application* app = CreateEngineApp();
+		return app->Run();
+	}
+	catch (const CronoEngine::CronoException& e)
+	{
+		std::cerr << e.GetType() << std::endl << e.what() << std::endl;
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "Standard Exception" << std::endl << e.what() << std::endl;
+	}
+	catch (...)
+	{
+		std::cerr << "Unknown Exception" << std::endl << "No details available" << std::endl;
+	}
+	return -1;
+}
+#endif
@@ -23,49 +23,46 @@ namespace CronoEngine
 {
 	bool Keyboard::KeyIsPressed( unsigned char keycode ) const noexcept
 	{
-		return keystates[keycode];
+		return (keystates[keycode / 64].load( std::memory_order_relaxed ) >> (keycode % 64)) & 1u;
 	}
 
 	std::optional<Keyboard::Event> Keyboard::ReadKey() noexcept
 	{
-		if (keybuffer.size() > 0u)
-		{
-			Keyboard::Event e = keybuffer.front();
-			keybuffer.pop();
-			return e;
-		}
-		return {};
+		return keybuffer.TryPop();
 	}
 
 	bool Keyboard::KeyIsEmpty() const noexcept
 	{
-		return keybuffer.empty();
+		return keybuffer.IsEmpty();
 	}
 
 	std::optional<char> Keyboard::ReadChar() noexcept
 	{
-		if (charbuffer.size() > 0u)
+		if (const auto e = charbuffer.TryPop())
 		{
-			unsigned char charcode = charbuffer.front();
-			charbuffer.pop();
-			return charcode;
+			return e->character;
 		}
 		return {};
 	}
 
+	std::optional<Keyboard::CharEvent> Keyboard::ReadCharEvent() noexcept
+	{
+		return charbuffer.TryPop();
+	}
+
 	bool Keyboard::CharIsEmpty() const noexcept
 	{
-		return charbuffer.empty();
+		return charbuffer.IsEmpty();
 	}
 
 	void Keyboard::FlushKey() noexcept
 	{
-		keybuffer = std::queue<Event>();
+		keybuffer.Clear();
 	}
 
 	void Keyboard::FlushChar() noexcept
 	{
-		charbuffer = std::queue<char>();
+		charbuffer.Clear();
 	}
 
 	void Keyboard::Flush() noexcept
@@ -89,37 +86,77 @@ namespace CronoEngine
 		return autorepeatEnabled;
 	}
 
+	uint64_t Keyboard::GetDroppedKeyCount() const noexcept
+	{
+		return keybuffer.GetDropCount();
+	}
+
+	uint64_t Keyboard::GetDroppedCharCount() const noexcept
+	{
+		return charbuffer.GetDropCount();
+	}
+
+	Keyboard::KeyMask Keyboard::GetKeyStates() const noexcept
+	{
+		KeyMask mask;
+		for (size_t i = 0; i < mask.size(); ++i)
+		{
+			mask[i] = keystates[i].load( std::memory_order_relaxed );
+		}
+		return mask;
+	}
+
+	Keyboard::KeyMask Keyboard::ReadPressedKeys() noexcept
+	{
+		KeyMask mask;
+		for (size_t i = 0; i < mask.size(); ++i)
+		{
+			mask[i] = pressedKeys[i].exchange( 0, std::memory_order_relaxed );
+		}
+		return mask;
+	}
+
+	Keyboard::KeyMask Keyboard::ReadReleasedKeys() noexcept
+	{
+		KeyMask mask;
+		for (size_t i = 0; i < mask.size(); ++i)
+		{
+			mask[i] = releasedKeys[i].exchange( 0, std::memory_order_relaxed );
+		}
+		return mask;
+	}
+
 	void Keyboard::OnKeyPressed( unsigned char keycode ) noexcept
 	{
-		keystates[keycode] = true;
-		keybuffer.push( Keyboard::Event( Keyboard::Event::Type::Press, keycode ) );
-		TrimBuffer( keybuffer );
+		const uint64_t bit = uint64_t( 1 ) << (keycode % 64);
+		if (!(keystates[keycode / 64].fetch_or( bit, std::memory_order_relaxed ) & bit))
+		{
+			pressedKeys[keycode / 64].fetch_or( bit, std::memory_order_relaxed );
+		}
+		keybuffer.TryPush( Keyboard::Event( Keyboard::Event::Type::Press, keycode ) );
 	}
 
 	void Keyboard::OnKeyReleased( unsigned char keycode ) noexcept
 	{
-		keystates[keycode] = false;
-		keybuffer.push( Keyboard::Event( Keyboard::Event::Type::Release, keycode ) );
-		TrimBuffer( keybuffer );
+		const uint64_t bit = uint64_t( 1 ) << (keycode % 64);
+		if (keystates[keycode / 64].fetch_and( ~bit, std::memory_order_relaxed ) & bit)
+		{
+			releasedKeys[keycode / 64].fetch_or( bit, std::memory_order_relaxed );
+		}
+		keybuffer.TryPush( Keyboard::Event( Keyboard::Event::Type::Release, keycode ) );
 	}
 
 	void Keyboard::OnChar( char character ) noexcept
 	{
-		charbuffer.push( character );
-		TrimBuffer( charbuffer );
+		charbuffer.TryPush( { character, Clock::now() } );
 	}
 
 	void Keyboard::ClearState() noexcept
 	{
-		keystates.reset();
-	}
-
-	template<typename T>
-	void Keyboard::TrimBuffer( std::queue<T>& buffer ) noexcept
-	{
-		while (buffer.size() > bufferSize)
+		// Everything that was held counts as released.
+		for (size_t i = 0; i < keystates.size(); ++i)
 		{
-			buffer.pop();
+			releasedKeys[i].fetch_or( keystates[i].exchange( 0, std::memory_order_relaxed ), std::memory_order_relaxed );
 		}
 	}
 }
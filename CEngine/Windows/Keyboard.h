@@ -18,15 +18,24 @@
 *	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
 ******************************************************************************************/
 #pragma once
-#include <queue>
-#include <bitset>
+#include "Common/SpscRing.h"
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <optional>
 namespace CronoEngine
 {
+	/**
+	 * Key state and event queues. The On* handlers are the producer side and may run on
+	 * a dedicated input thread, everything else is the consumer side (the game thread).
+	 */
 	class Keyboard
 	{
 		friend class Window;
 	public:
+		using Clock = std::chrono::steady_clock;
+		// One bit per virtual key code, 64 keys per word.
+		using KeyMask = std::array<uint64_t, 4>;
 		class Event
 		{
 		public:
@@ -36,13 +45,16 @@ namespace CronoEngine
 				Release,
 			};
 		private:
-			Type type;
-			unsigned char code;
+			Type type = Type::Press;
+			unsigned char code = 0;
+			Clock::time_point timestamp;
 		public:
-			Event( Type type, unsigned char code ) noexcept
+			Event() noexcept = default;
+			Event( Type type, unsigned char code, Clock::time_point timestamp = Clock::now() ) noexcept
 				:
 				type( type ),
-				code( code )
+				code( code ),
+				timestamp( timestamp )
 			{
 			}
 			bool IsPress() const noexcept
@@ -57,6 +69,16 @@ namespace CronoEngine
 			{
 				return code;
 			}
+			// When the OS message was handled.
+			Clock::time_point GetTimestamp() const noexcept
+			{
+				return timestamp;
+			}
+		};
+		struct CharEvent
+		{
+			char character = 0;
+			Clock::time_point timestamp;
 		};
 	public:
 		Keyboard() = default;
@@ -69,6 +91,7 @@ namespace CronoEngine
 		void FlushKey() noexcept;
 		// char event stuff
 		std::optional<char> ReadChar() noexcept;
+		std::optional<CharEvent> ReadCharEvent() noexcept;
 		bool CharIsEmpty() const noexcept;
 		void FlushChar() noexcept;
 		void Flush() noexcept;
@@ -76,19 +99,28 @@ namespace CronoEngine
 		void EnableAutorepeat() noexcept;
 		void DisableAutorepeat() noexcept;
 		bool AutorepeatIsEnabled() const noexcept;
+		// Events lost because the consumer didn't read them in time.
+		uint64_t GetDroppedKeyCount() const noexcept;
+		uint64_t GetDroppedCharCount() const noexcept;
+		// Keys held right now.
+		KeyMask GetKeyStates() const noexcept;
+		// Keys that went down / up since the last call, taps shorter than a frame included.
+		// Autorepeat doesn't count. Used by InputSystem, one consumer only.
+		KeyMask ReadPressedKeys() noexcept;
+		KeyMask ReadReleasedKeys() noexcept;
 	private:
 		void OnKeyPressed( unsigned char keycode ) noexcept;
 		void OnKeyReleased( unsigned char keycode ) noexcept;
 		void OnChar( char character ) noexcept;
 		void ClearState() noexcept;
-		template<typename T>
-		static void TrimBuffer( std::queue<T>& buffer ) noexcept;
 	private:
 		static constexpr unsigned int nKeys = 256u;
-		static constexpr unsigned int bufferSize = 16u;
-		bool autorepeatEnabled = false;
-		std::bitset<nKeys> keystates;
-		std::queue<Event> keybuffer;
-		std::queue<char> charbuffer;
+		static constexpr unsigned int bufferSize = 64u;
+		std::atomic<bool> autorepeatEnabled = false;
+		std::array<std::atomic<uint64_t>, nKeys / 64> keystates{};
+		std::array<std::atomic<uint64_t>, nKeys / 64> pressedKeys{};
+		std::array<std::atomic<uint64_t>, nKeys / 64> releasedKeys{};
+		SpscRing<Event, bufferSize> keybuffer;
+		SpscRing<CharEvent, bufferSize> charbuffer;
 	};
 }
\ No newline at end of file
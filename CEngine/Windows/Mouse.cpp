@@ -17,8 +17,13 @@
 *	You should have received a copy of the GNU General Public License					  *
 *	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
 ******************************************************************************************/
-#include "WinInclude.h"
 #include "Mouse.h"
+#if defined(_WIN32)
+#include "WinInclude.h"
+#else
+// Same granularity as the Win32 wheel messages.
+#define WHEEL_DELTA 120
+#endif
 
 namespace CronoEngine
 {
@@ -29,13 +34,16 @@ namespace CronoEngine
 
 	std::optional<Mouse::RawDelta> Mouse::ReadRawDelta() noexcept
 	{
-		if (rawDeltaBuffer.empty())
+		if (rawDeltaReports.load( std::memory_order_acquire ) == 0)
 		{
 			return std::nullopt;
 		}
-		const RawDelta d = rawDeltaBuffer.front();
-		rawDeltaBuffer.pop();
-		return d;
+		// Reports are cleared before the delta is taken: OnRawDelta adds its movement first, so a
+		// report landing in between is either in this delta or still counted for the next call.
+		rawDeltaReports.exchange( 0, std::memory_order_acq_rel );
+		const uint64_t packed = rawDelta.exchange( 0, std::memory_order_acq_rel );
+		const Clock::time_point timestamp{ Clock::duration( rawDeltaTime.load( std::memory_order_relaxed ) ) };
+		return RawDelta{ static_cast<int32_t>(packed & 0xFFFFFFFFu), static_cast<int32_t>(packed >> 32), timestamp };
 	}
 
 	int Mouse::GetPosX() const noexcept
@@ -65,18 +73,12 @@ namespace CronoEngine
 
 	std::optional<Mouse::Event> Mouse::Read() noexcept
 	{
-		if (buffer.size() > 0u)
-		{
-			Mouse::Event e = buffer.front();
-			buffer.pop();
-			return e;
-		}
-		return {};
+		return buffer.TryPop();
 	}
 
 	void Mouse::Flush() noexcept
 	{
-		buffer = std::queue<Event>();
+		buffer.Clear();
 	}
 
 	void Mouse::EnableRaw() noexcept
@@ -94,97 +96,118 @@ namespace CronoEngine
 		return rawEnabled;
 	}
 
+	uint64_t Mouse::GetDroppedEventCount() const noexcept
+	{
+		return buffer.GetDropCount();
+	}
+
+	uint64_t Mouse::GetCoalescedRawDeltaCount() const noexcept
+	{
+		return coalescedRawDeltas.load( std::memory_order_relaxed );
+	}
+
+	uint32_t Mouse::GetButtonStates() const noexcept
+	{
+		return (leftIsPressed ? LeftButton : 0u) | (rightIsPressed ? RightButton : 0u);
+	}
+
+	uint32_t Mouse::ReadPressedButtons() noexcept
+	{
+		return pressedButtons.exchange( 0, std::memory_order_relaxed );
+	}
+
+	uint32_t Mouse::ReadReleasedButtons() noexcept
+	{
+		return releasedButtons.exchange( 0, std::memory_order_relaxed );
+	}
+
+	int Mouse::ReadWheelDelta() noexcept
+	{
+		return wheelDelta.exchange( 0, std::memory_order_relaxed );
+	}
+
 	void Mouse::OnMouseMove( int newx, int newy ) noexcept
 	{
 		x = newx;
 		y = newy;
 
-		buffer.push( Mouse::Event( Mouse::Event::Type::Move, *this ) );
-		TrimBuffer();
+		buffer.TryPush( Mouse::Event( Mouse::Event::Type::Move, *this ) );
 	}
 
 	void Mouse::OnMouseLeave() noexcept
 	{
 		isInWindow = false;
-		buffer.push( Mouse::Event( Mouse::Event::Type::Leave, *this ) );
-		TrimBuffer();
+		buffer.TryPush( Mouse::Event( Mouse::Event::Type::Leave, *this ) );
 	}
 
 	void Mouse::OnMouseEnter() noexcept
 	{
 		isInWindow = true;
-		buffer.push( Mouse::Event( Mouse::Event::Type::Enter, *this ) );
-		TrimBuffer();
+		buffer.TryPush( Mouse::Event( Mouse::Event::Type::Enter, *this ) );
 	}
 
 	void Mouse::OnRawDelta( int dx, int dy ) noexcept
 	{
-		rawDeltaBuffer.push( { dx,dy } );
-		TrimBuffer();
+		uint64_t packed = rawDelta.load( std::memory_order_relaxed );
+		uint64_t summed;
+		do
+		{
+			const uint32_t sumX = static_cast<uint32_t>(packed) + static_cast<uint32_t>(dx);
+			const uint32_t sumY = static_cast<uint32_t>(packed >> 32) + static_cast<uint32_t>(dy);
+			summed = (uint64_t( sumY ) << 32) | sumX;
+		} while (!rawDelta.compare_exchange_weak( packed, summed, std::memory_order_acq_rel, std::memory_order_relaxed ));
+		rawDeltaTime.store( Clock::now().time_since_epoch().count(), std::memory_order_relaxed );
+		if (rawDeltaReports.fetch_add( 1, std::memory_order_release ) != 0)
+		{
+			coalescedRawDeltas.fetch_add( 1, std::memory_order_relaxed );
+		}
 	}
 
 	void Mouse::OnLeftPressed( int x, int y ) noexcept
 	{
 		leftIsPressed = true;
+		OnButton( LeftButton, true );
 
-		buffer.push( Mouse::Event( Mouse::Event::Type::LPress, *this ) );
-		TrimBuffer();
+		buffer.TryPush( Mouse::Event( Mouse::Event::Type::LPress, *this ) );
 	}
 
 	void Mouse::OnLeftReleased( int x, int y ) noexcept
 	{
 		leftIsPressed = false;
+		OnButton( LeftButton, false );
 
-		buffer.push( Mouse::Event( Mouse::Event::Type::LRelease, *this ) );
-		TrimBuffer();
+		buffer.TryPush( Mouse::Event( Mouse::Event::Type::LRelease, *this ) );
 	}
 
 	void Mouse::OnRightPressed( int x, int y ) noexcept
 	{
 		rightIsPressed = true;
+		OnButton( RightButton, true );
 
-		buffer.push( Mouse::Event( Mouse::Event::Type::RPress, *this ) );
-		TrimBuffer();
+		buffer.TryPush( Mouse::Event( Mouse::Event::Type::RPress, *this ) );
 	}
 
 	void Mouse::OnRightReleased( int x, int y ) noexcept
 	{
 		rightIsPressed = false;
+		OnButton( RightButton, false );
 
-		buffer.push( Mouse::Event( Mouse::Event::Type::RRelease, *this ) );
-		TrimBuffer();
+		buffer.TryPush( Mouse::Event( Mouse::Event::Type::RRelease, *this ) );
 	}
 
 	void Mouse::OnWheelUp( int x, int y ) noexcept
 	{
-		buffer.push( Mouse::Event( Mouse::Event::Type::WheelUp, *this ) );
-		TrimBuffer();
+		buffer.TryPush( Mouse::Event( Mouse::Event::Type::WheelUp, *this ) );
 	}
 
 	void Mouse::OnWheelDown( int x, int y ) noexcept
 	{
-		buffer.push( Mouse::Event( Mouse::Event::Type::WheelDown, *this ) );
-		TrimBuffer();
-	}
-
-	void Mouse::TrimBuffer() noexcept
-	{
-		while (buffer.size() > bufferSize)
-		{
-			buffer.pop();
-		}
-	}
-
-	void Mouse::TrimRawInputBuffer() noexcept
-	{
-		while (rawDeltaBuffer.size() > bufferSize)
-		{
-			rawDeltaBuffer.pop();
-		}
+		buffer.TryPush( Mouse::Event( Mouse::Event::Type::WheelDown, *this ) );
 	}
 
 	void Mouse::OnWheelDelta( int x, int y, int delta ) noexcept
 	{
+		wheelDelta.fetch_add( delta, std::memory_order_relaxed );
 		wheelDeltaCarry += delta;
 		// generate events for every 120 
 		while (wheelDeltaCarry >= WHEEL_DELTA)
@@ -198,4 +221,9 @@ namespace CronoEngine
 			OnWheelDown( x, y );
 		}
 	}
+
+	void Mouse::OnButton( uint32_t button, bool pressed ) noexcept
+	{
+		(pressed ? pressedButtons : releasedButtons).fetch_or( button, std::memory_order_relaxed );
+	}
 }
\ No newline at end of file
@@ -18,18 +18,30 @@
 *	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
 ******************************************************************************************/
 #pragma once
-#include <queue>
+#include "Common/SpscRing.h"
+#include <atomic>
+#include <chrono>
 #include <optional>
 
 namespace CronoEngine
 {
+	/**
+	 * Mouse state and event queue. The On* handlers are the producer side and may run on
+	 * a dedicated input thread, everything else is the consumer side (the game thread).
+	 */
 	class Mouse
 	{
 		friend class Window;
 	public:
+		using Clock = std::chrono::steady_clock;
+		// Bits of the button masks.
+		static constexpr uint32_t LeftButton = 1u << 0;
+		static constexpr uint32_t RightButton = 1u << 1;
 		struct RawDelta
 		{
 			int x, y;
+			// Time of the newest report summed into this delta.
+			Clock::time_point timestamp;
 		};
 		class Event
 		{
@@ -47,19 +59,22 @@ namespace CronoEngine
 				Leave,
 			};
 		private:
-			Type type;
-			bool leftIsPressed;
-			bool rightIsPressed;
-			int x;
-			int y;
+			Type type = Type::Move;
+			bool leftIsPressed = false;
+			bool rightIsPressed = false;
+			int x = 0;
+			int y = 0;
+			Clock::time_point timestamp;
 		public:
+			Event() noexcept = default;
 			Event( Type type, const Mouse& parent ) noexcept
 				:
 				type( type ),
 				leftIsPressed( parent.leftIsPressed ),
 				rightIsPressed( parent.rightIsPressed ),
 				x( parent.x ),
-				y( parent.y )
+				y( parent.y ),
+				timestamp( Clock::now() )
 			{
 			}
 			Type GetType() const noexcept
@@ -86,12 +101,19 @@ namespace CronoEngine
 			{
 				return rightIsPressed;
 			}
+			// When the OS message was handled.
+			Clock::time_point GetTimestamp() const noexcept
+			{
+				return timestamp;
+			}
 		};
 	public:
 		Mouse() = default;
 		Mouse( const Mouse& ) = delete;
 		Mouse& operator=( const Mouse& ) = delete;
 		std::pair<int, int> GetPos() const noexcept;
+		// Sum of the raw deltas reported since the last call, nullopt if none was reported. Moves
+		// that cancel out still give a (zero) delta.
 		std::optional<RawDelta> ReadRawDelta() noexcept;
 		int GetPosX() const noexcept;
 		int GetPosY() const noexcept;
@@ -101,12 +123,23 @@ namespace CronoEngine
 		std::optional<Mouse::Event> Read() noexcept;
 		bool IsEmpty() const noexcept
 		{
-			return buffer.empty();
+			return buffer.IsEmpty();
 		}
 		void Flush() noexcept;
 		void EnableRaw() noexcept;
 		void DisableRaw() noexcept;
 		bool RawEnabled() const noexcept;
+		// Events lost because the consumer didn't read them in time.
+		uint64_t GetDroppedEventCount() const noexcept;
+		// Raw reports merged into an earlier unread delta instead of being queued.
+		uint64_t GetCoalescedRawDeltaCount() const noexcept;
+		// Buttons held right now.
+		uint32_t GetButtonStates() const noexcept;
+		// Buttons that went down / up since the last call. Used by InputSystem, one consumer only.
+		uint32_t ReadPressedButtons() noexcept;
+		uint32_t ReadReleasedButtons() noexcept;
+		// Wheel movement since the last call, in WHEEL_DELTA units (120 per notch).
+		int ReadWheelDelta() noexcept;
 	private:
 		void OnMouseMove( int x, int y ) noexcept;
 		void OnMouseLeave() noexcept;
@@ -118,19 +151,26 @@ namespace CronoEngine
 		void OnRightReleased( int x, int y ) noexcept;
 		void OnWheelUp( int x, int y ) noexcept;
 		void OnWheelDown( int x, int y ) noexcept;
-		void TrimBuffer() noexcept;
-		void TrimRawInputBuffer() noexcept;
 		void OnWheelDelta( int x, int y, int delta ) noexcept;
+		void OnButton( uint32_t button, bool pressed ) noexcept;
 	private:
-		static constexpr unsigned int bufferSize = 16u;
-		int x;
-		int y;
-		bool leftIsPressed = false;
-		bool rightIsPressed = false;
-		bool isInWindow = false;
+		static constexpr unsigned int bufferSize = 128u;
+		std::atomic<int> x = 0;
+		std::atomic<int> y = 0;
+		std::atomic<bool> leftIsPressed = false;
+		std::atomic<bool> rightIsPressed = false;
+		std::atomic<bool> isInWindow = false;
+		std::atomic<uint32_t> pressedButtons = 0;
+		std::atomic<uint32_t> releasedButtons = 0;
 		int wheelDeltaCarry = 0;
-		bool rawEnabled = false;
-		std::queue<Event> buffer;
-		std::queue<RawDelta> rawDeltaBuffer;
+		std::atomic<int> wheelDelta = 0;
+		std::atomic<bool> rawEnabled = false;
+		SpscRing<Event, bufferSize> buffer;
+		// Unread raw delta, x in the low and y in the high 32 bits. High rate raw input is
+		// summed here instead of queued, so no movement is lost however slow the consumer is.
+		std::atomic<uint64_t> rawDelta = 0;
+		std::atomic<Clock::rep> rawDeltaTime = 0;
+		std::atomic<uint64_t> rawDeltaReports = 0;
+		std::atomic<uint64_t> coalescedRawDeltas = 0;
 	};
 }
@@ -0,0 +1,232 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "Test.h"
+#include "Scene/Scene.h"
+#include "Scene/Entity/Component/TransformComponent.h"
+#include <algorithm>
+#include <random>
+#include <sstream>
+#include <thread>
+
+using namespace CronoEngine;
+
+namespace
+{
+	constexpr float WorldSize = 1000.0f;
+
+	void CreateEntities( Scene& scene, uint32_t count, std::mt19937& random )
+	{
+		std::uniform_real_distribution<float> position( -WorldSize, WorldSize );
+		std::uniform_real_distribution<float> scale( 0.5f, 4.0f );
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const float size = scale( random );
+			scene.m_Registry.emplace<TransformComponent>( scene.m_Registry.create(), Math::Float3A{ position( random ), position( random ), position( random ) },
+				Math::Float3A{ 0.0f, 0.0f, 0.0f }, Math::Float3A{ size, size, size } );
+		}
+	}
+
+	Math::Aabb RandomBox( std::mt19937& random, float maxExtent )
+	{
+		std::uniform_real_distribution<float> center( -WorldSize, WorldSize );
+		std::uniform_real_distribution<float> extent( 1.0f, maxExtent );
+		return Math::AabbFromCenterExtents( { center( random ), center( random ), center( random ) },
+			{ extent( random ), extent( random ), extent( random ) } );
+	}
+
+	// The six inward planes of box, a frustum that QueryFrustum can take.
+	Math::Frustum BoxFrustum( const Math::Aabb& box )
+	{
+		return { { { 1.0f, 0.0f, 0.0f, -box.Min.x }, { -1.0f, 0.0f, 0.0f, box.Max.x },
+			{ 0.0f, 1.0f, 0.0f, -box.Min.y }, { 0.0f, -1.0f, 0.0f, box.Max.y },
+			{ 0.0f, 0.0f, 1.0f, -box.Min.z }, { 0.0f, 0.0f, -1.0f, box.Max.z } } };
+	}
+
+	Math::Ray RandomRay( std::mt19937& random )
+	{
+		std::uniform_real_distribution<float> origin( -WorldSize, WorldSize );
+		std::uniform_real_distribution<float> direction( -1.0f, 1.0f );
+		return { { origin( random ), origin( random ), origin( random ) }, { direction( random ), direction( random ), direction( random ) } };
+	}
+
+	struct Leaf
+	{
+		entt::entity Entity;
+		Math::Aabb Bounds;
+	};
+
+	// What the tree should hold, straight from the TransformSystem.
+	std::vector<Leaf> CollectLeaves( Scene& scene )
+	{
+		const TransformSystem& transforms = scene.GetTransforms();
+		std::vector<Leaf> leaves( transforms.GetCount() );
+		for (uint32_t i = 0; i < transforms.GetCount(); ++i)
+		{
+			leaves[i].Entity = transforms.GetEntity( i );
+			leaves[i].Bounds = AabbTree::GetWorldBounds( scene.m_Registry, leaves[i].Entity, transforms.GetWorldMatrix( i ) );
+		}
+		return leaves;
+	}
+
+	bool SameEntities( std::vector<entt::entity> a, std::vector<entt::entity> b )
+	{
+		std::sort( a.begin(), a.end() );
+		std::sort( b.begin(), b.end() );
+		return a == b;
+	}
+
+	// Every query kind against a linear scan over leaves.
+	void CheckQueries( const AabbTree& tree, const std::vector<Leaf>& leaves, std::mt19937& random )
+	{
+		CRONO_CHECK( tree.GetLeafCount() == leaves.size() );
+		std::vector<entt::entity> found;
+		std::vector<entt::entity> expected;
+		for (uint32_t query = 0; query < 200; ++query)
+		{
+			const Math::Aabb box = RandomBox( random, 100.0f );
+			found.clear();
+			expected.clear();
+			tree.QueryAabb( box, found );
+			for (const Leaf& leaf : leaves)
+			{
+				if (Math::AabbOverlaps( box, leaf.Bounds ))
+				{
+					expected.push_back( leaf.Entity );
+				}
+			}
+			CRONO_CHECK( SameEntities( found, expected ) );
+
+			const Math::Frustum frustum = BoxFrustum( RandomBox( random, 200.0f ) );
+			found.clear();
+			expected.clear();
+			tree.QueryFrustum( frustum, found );
+			for (const Leaf& leaf : leaves)
+			{
+				if (Math::FrustumContainsAabb( frustum, leaf.Bounds ) != Math::Containment::Disjoint)
+				{
+					expected.push_back( leaf.Entity );
+				}
+			}
+			CRONO_CHECK( SameEntities( found, expected ) );
+
+			const Math::Ray ray = RandomRay( random );
+			const Math::Float3 inverseDirection = Math::RayInverseDirection( ray );
+			float nearest = FLT_MAX;
+			for (const Leaf& leaf : leaves)
+			{
+				float distance = 0.0f;
+				if (Math::RayIntersectsAabb( ray, inverseDirection, leaf.Bounds, distance ))
+				{
+					nearest = std::min( nearest, distance );
+				}
+			}
+			CRONO_CHECK( tree.Raycast( ray ).Distance == nearest );
+		}
+	}
+}
+
+CRONO_TEST( AabbTreeMatchesLinearScan )
+{
+	std::mt19937 random( 18 );
+	Scene scene;
+	CreateEntities( scene, 20000, random );
+	scene.UpdateTransforms();
+	CheckQueries( scene.GetSpatialTree(), CollectLeaves( scene ), random );
+
+	// Few enough moves and removals to refit and insert instead of rebuilding.
+	auto transforms = scene.m_Registry.view<TransformComponent>();
+	std::vector<entt::entity> entities;
+	for (size_t i = 0; i < transforms.handle()->size(); ++i)
+	{
+		entities.push_back( (*transforms.handle())[i] );
+	}
+	std::uniform_real_distribution<float> offset( -50.0f, 50.0f );
+	for (size_t i = 0; i < entities.size(); i += 20)
+	{
+		TransformComponent& transform = transforms.get<TransformComponent>( entities[i] );
+		const Math::Float3A position = transform.GetPosition();
+		transform.SetPosition( position.x + offset( random ), position.y + offset( random ), position.z + offset( random ) );
+	}
+	for (size_t i = 7; i < entities.size(); i += 50)
+	{
+		scene.m_Registry.destroy( entities[i] );
+	}
+	CreateEntities( scene, 500, random );
+	scene.UpdateTransforms();
+	CheckQueries( scene.GetSpatialTree(), CollectLeaves( scene ), random );
+}
+
+CRONO_BENCHMARK( AabbTreeQueries )
+{
+	constexpr uint32_t EntityCount = 1000000;
+	constexpr uint32_t QueryCount = 10000;
+	std::mt19937 random( 18 );
+	const uint32_t threads = std::max( 1u, std::thread::hardware_concurrency() );
+	std::unique_ptr<JobSystem> jobs = threads > 1 ? std::make_unique<JobSystem>( threads - 1 ) : nullptr;
+	Scene scene;
+	scene.SetJobSystem( jobs.get() );
+	CreateEntities( scene, EntityCount, random );
+	const double buildSeconds = CronoTests::MeasureSeconds( 1, [&]() { scene.UpdateTransforms(); } );
+	const AabbTree& tree = scene.GetSpatialTree();
+
+	std::vector<Math::Aabb> boxes( QueryCount );
+	std::vector<Math::Frustum> frustums( QueryCount );
+	std::vector<Math::Ray> rays( QueryCount );
+	for (uint32_t i = 0; i < QueryCount; ++i)
+	{
+		boxes[i] = RandomBox( random, 20.0f );
+		frustums[i] = BoxFrustum( RandomBox( random, 50.0f ) );
+		rays[i] = RandomRay( random );
+	}
+	std::vector<std::vector<entt::entity>> results( QueryCount );
+	std::vector<AabbTree::RayHit> hits( QueryCount );
+	size_t found = 0;
+	const double aabbSeconds = CronoTests::MeasureSeconds( 3, [&]() { tree.QueryAabbs( boxes.data(), QueryCount, results.data(), jobs.get() ); } );
+	for (const std::vector<entt::entity>& result : results)
+	{
+		found += result.size();
+	}
+	const double frustumSeconds = CronoTests::MeasureSeconds( 3, [&]() { tree.QueryFrustums( frustums.data(), QueryCount, results.data(), jobs.get() ); } );
+	const double raySeconds = CronoTests::MeasureSeconds( 3, [&]() { tree.Raycasts( rays.data(), QueryCount, hits.data(), jobs.get() ); } );
+
+	// One percent of the entities moving, the refit path.
+	auto transforms = scene.m_Registry.view<TransformComponent>();
+	const auto& entities = *transforms.handle();
+	const double refitSeconds = CronoTests::MeasureSeconds( 3, [&]()
+	{
+		for (size_t i = 0; i < entities.size(); i += 100)
+		{
+			TransformComponent& transform = transforms.get<TransformComponent>( entities[i] );
+			const Math::Float3A position = transform.GetPosition();
+			transform.SetPosition( position.x + 1.0f, position.y, position.z );
+		}
+		scene.UpdateTransforms();
+	} );
+
+	std::ostringstream oss;
+	oss << EntityCount << " entities, " << threads << " threads: build " << buildSeconds * 1e3 << " ms, height "
+		<< tree.GetHeight() << ", SAH cost " << tree.ComputeCost();
+	CronoTests::Report( oss.str() );
+	oss.str( "" );
+	oss << QueryCount << " box queries " << aabbSeconds * 1e3 << " ms (" << found << " hits), frustums " << frustumSeconds * 1e3
+		<< " ms, rays " << raySeconds * 1e3 << " ms, moving 1% and updating " << refitSeconds * 1e3 << " ms";
+	CronoTests::Report( oss.str() );
+	scene.SetJobSystem( nullptr );
+}
@@ -0,0 +1,181 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "Test.h"
+#include "Graphics/RHI/DescriptorAllocator.h"
+#include "Common/CronoException.h"
+#include <random>
+#include <sstream>
+
+using namespace CronoEngine;
+using namespace CronoEngine::Graphics::RHI;
+
+CRONO_TEST( DescriptorAllocatorRejectsBadFrees )
+{
+	DescriptorAllocator allocator( { 4096, 256 } );
+	const DescriptorRange small = allocator.Allocate( 4 );
+	const DescriptorRange large = allocator.Allocate( 100 );
+	CRONO_CHECK_THROWS( allocator.Free( { small.Index, 100 } ), RhiException );
+	CRONO_CHECK_THROWS( allocator.Free( { small.Index, 2 } ), RhiException );
+	CRONO_CHECK_THROWS( allocator.Free( { small.Index + 1, 1 } ), RhiException );
+	CRONO_CHECK_THROWS( allocator.Free( { large.Index, 64 } ), RhiException );
+	CRONO_CHECK_THROWS( allocator.Free( { 5000, 1 } ), RhiException );
+	CRONO_CHECK( allocator.GetStats().Frees == 0 );
+
+	allocator.Free( small );
+	allocator.Free( large );
+	CRONO_CHECK_THROWS( allocator.Free( small ), RhiException );
+	CRONO_CHECK( allocator.GetStats().PendingFrees == 104 );
+	allocator.BeginFrame( allocator.GetFrame() );
+	const DescriptorAllocatorStats stats = allocator.GetStats();
+	CRONO_CHECK( stats.PersistentUsed == 0 && stats.PendingFrees == 0 );
+}
+
+CRONO_TEST( DescriptorAllocatorReturnsFreeSlabs )
+{
+	constexpr uint32_t Count = 4096;
+	DescriptorAllocator allocator( { Count, 0 } );
+	// A burst of single slots spread over every slab, then a large range needing nearly all of them.
+	std::vector<DescriptorRange> ranges;
+	for (uint32_t i = 0; i < Count; ++i)
+	{
+		ranges.push_back( allocator.Allocate( 1 ) );
+	}
+	CRONO_CHECK_THROWS( allocator.Allocate( 1 ), RhiException );
+	for (const DescriptorRange& range : ranges)
+	{
+		allocator.Free( range );
+	}
+	allocator.BeginFrame( allocator.GetFrame() );
+	// One empty slab stays for the next single slot.
+	CRONO_CHECK( allocator.GetStats().PersistentReserved == 256 );
+	const DescriptorRange large = allocator.Allocate( Count - 256 );
+	CRONO_CHECK( allocator.Allocate( 1 ).IsValid() );
+	allocator.Free( large );
+}
+
+CRONO_TEST( DescriptorAllocatorRandomRanges )
+{
+	constexpr uint32_t Count = 16384;
+	DescriptorAllocator allocator( { Count, 1024 } );
+	std::mt19937 random( 23 );
+	std::vector<uint8_t> used( Count, 0 );
+	std::vector<DescriptorRange> live;
+	for (uint32_t step = 0; step < 50000; ++step)
+	{
+		if (random() % 2 == 0 || live.empty())
+		{
+			// Mostly small ranges of every class, sometimes a large one.
+			const uint32_t count = random() % 8 == 0 ? 33 + random() % 200 : 1 + random() % 32;
+			DescriptorRange range;
+			try
+			{
+				range = allocator.Allocate( count );
+			}
+			catch (const RhiException&)
+			{
+				continue;
+			}
+			CRONO_CHECK( range.Count == count && range.Index + count <= Count );
+			for (uint32_t slot = range.Index; slot < range.Index + count; ++slot)
+			{
+				CRONO_CHECK( !used[slot] );
+				used[slot] = 1;
+			}
+			live.push_back( range );
+		}
+		else
+		{
+			const size_t which = random() % live.size();
+			const DescriptorRange range = live[which];
+			live[which] = live.back();
+			live.pop_back();
+			allocator.Free( range );
+			std::fill( used.begin() + range.Index, used.begin() + range.Index + range.Count, 0 );
+		}
+		if (step % 64 == 0)
+		{
+			allocator.BeginFrame( allocator.GetFrame() - 1 );
+		}
+	}
+
+	for (const DescriptorRange& range : live)
+	{
+		allocator.Free( range );
+	}
+	allocator.BeginFrame( allocator.GetFrame() );
+	const DescriptorAllocatorStats stats = allocator.GetStats();
+	CRONO_CHECK( stats.PersistentUsed == 0 && stats.PendingFrees == 0 );
+	// At most one empty slab per size class is kept, the rest merged back: 6 slabs cut 7 ranges at most.
+	CRONO_CHECK( stats.PersistentReserved <= 6 * 256 );
+	CRONO_CHECK( allocator.Allocate( (Count - 6 * 256) / 7 ).IsValid() );
+}
+
+CRONO_BENCHMARK( DescriptorAllocatorThroughput )
+{
+	constexpr uint32_t Count = 1000000;
+	constexpr uint32_t Operations = 1000000;
+	DescriptorAllocator allocator( { Count, 65536 } );
+	std::mt19937 random( 23 );
+	std::vector<uint32_t> sizes( Operations );
+	for (uint32_t& size : sizes)
+	{
+		size = random() % 16 == 0 ? 64 + random() % 64 : 1 + random() % 8;
+	}
+	std::vector<DescriptorRange> live;
+	live.reserve( 4096 );
+	const double persistentSeconds = CronoTests::MeasureSeconds( 3, [&]()
+	{
+		// A working set of 4096 ranges, each allocation frees the oldest once it is full.
+		for (uint32_t i = 0; i < Operations; ++i)
+		{
+			if (live.size() == 4096)
+			{
+				allocator.Free( live[i % 4096] );
+				live[i % 4096] = allocator.Allocate( sizes[i] );
+			}
+			else
+			{
+				live.push_back( allocator.Allocate( sizes[i] ) );
+			}
+			if (i % 1024 == 0)
+			{
+				allocator.BeginFrame( allocator.GetFrame() - 1 );
+			}
+		}
+	} );
+	const double frameSeconds = CronoTests::MeasureSeconds( 3, [&]()
+	{
+		for (uint32_t i = 0; i < Operations; ++i)
+		{
+			allocator.AllocateFrame( 1 + i % 8 );
+			if (i % 1024 == 1023)
+			{
+				allocator.BeginFrame( allocator.GetFrame() - 1 );
+			}
+		}
+	} );
+
+	const DescriptorAllocatorStats stats = allocator.GetStats();
+	std::ostringstream oss;
+	oss << Operations << " persistent allocations with frees " << persistentSeconds * 1e3 << " ms (" << persistentSeconds * 1e9 / Operations
+		<< " ns each), frame allocations " << frameSeconds * 1e3 << " ms (" << frameSeconds * 1e9 / Operations << " ns each), "
+		<< stats.PersistentReserved << " slots reserved for " << stats.PersistentUsed << " in use";
+	CronoTests::Report( oss.str() );
+}
@@ -0,0 +1,356 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "Test.h"
+#include "Graphics/GpuMemoryAllocator.h"
+#include "Graphics/RHI/NullDevice.h"
+#include "Common/CronoException.h"
+#include <random>
+#include <sstream>
+
+using namespace CronoEngine;
+using namespace CronoEngine::Graphics;
+
+namespace
+{
+	constexpr uint64_t MB = 1024 * 1024;
+
+	// Every block is free or not, they tile the whole range and no two free ones touch.
+	void CheckBlocks( const TlsfAllocator& allocator, uint64_t size )
+	{
+		const TlsfAllocator::Stats stats = allocator.GetStats();
+		uint64_t end = 0;
+		uint64_t largest = 0;
+		uint32_t freeBlocks = 0;
+		bool previousFree = false;
+		allocator.ForEachBlock( [&]( const TlsfAllocator::BlockInfo& block )
+		{
+			CRONO_CHECK( block.Offset == end && !(block.Free && previousFree) );
+			if (block.Free)
+			{
+				largest = std::max( largest, block.Size );
+				++freeBlocks;
+			}
+			previousFree = block.Free;
+			end = block.Offset + block.Size;
+		} );
+		CRONO_CHECK( end == size && largest == stats.LargestFreeBlock && freeBlocks == stats.FreeBlocks );
+	}
+
+	RHI::ResourceAllocationInfo BufferInfo( uint64_t size, uint64_t alignment = 64 * 1024 )
+	{
+		return { size, alignment };
+	}
+}
+
+CRONO_TEST( TlsfMatchesShadowMap )
+{
+	for (const uint64_t granularity : { 1ull, 256ull, 65536ull })
+	{
+		constexpr uint64_t Units = 4096;
+		TlsfAllocator allocator( Units * granularity, granularity );
+		// One byte per granularity step, set while allocated.
+		std::vector<uint8_t> shadow( Units, 0 );
+		std::vector<TlsfAllocator::Allocation> live;
+		std::mt19937 random( 25 );
+		uint64_t used = 0;
+		for (uint32_t step = 0; step < 200000; ++step)
+		{
+			if (live.empty() || random() % 100 < 55)
+			{
+				const uint64_t size = 1 + random() % (random() % 10 == 0 ? 400 * granularity : 16 * granularity);
+				const uint64_t alignment = granularity << (random() % 5);
+				const TlsfAllocator::Allocation allocation = allocator.Allocate( size, alignment );
+				if (!allocation.IsValid())
+				{
+					continue;
+				}
+				CRONO_CHECK( allocation.Offset % alignment == 0 && allocation.Size >= size && allocation.Size % granularity == 0 );
+				CRONO_CHECK( allocation.Offset + allocation.Size <= Units * granularity );
+				for (uint64_t unit = allocation.Offset / granularity; unit < (allocation.Offset + allocation.Size) / granularity; ++unit)
+				{
+					CRONO_CHECK( !shadow[unit] );
+					shadow[unit] = 1;
+				}
+				used += allocation.Size;
+				live.push_back( allocation );
+			}
+			else
+			{
+				const size_t which = random() % live.size();
+				const TlsfAllocator::Allocation allocation = live[which];
+				live[which] = live.back();
+				live.pop_back();
+				std::fill( shadow.begin() + allocation.Offset / granularity, shadow.begin() + (allocation.Offset + allocation.Size) / granularity, 0 );
+				allocator.Free( allocation.Block );
+				used -= allocation.Size;
+			}
+			if (step % 5000 == 0)
+			{
+				const TlsfAllocator::Stats stats = allocator.GetStats();
+				CRONO_CHECK( stats.UsedBytes == used && stats.Allocations == live.size() );
+				CheckBlocks( allocator, Units * granularity );
+			}
+		}
+		CRONO_CHECK_THROWS( allocator.Free( 123456 ), RhiException );
+		for (const TlsfAllocator::Allocation& allocation : live)
+		{
+			allocator.Free( allocation.Block );
+		}
+		const TlsfAllocator::Stats stats = allocator.GetStats();
+		CRONO_CHECK( allocator.IsEmpty() && stats.FreeBlocks == 1 && stats.LargestFreeBlock == Units * granularity );
+	}
+}
+
+CRONO_TEST( TlsfFillsBlocksOfTheirOwnSizeClass )
+{
+	// A range of exactly the request, between two size classes.
+	constexpr uint64_t Size = 64 * MB + 64 * 1024;
+	TlsfAllocator exact( Size, 64 * 1024 );
+	const TlsfAllocator::Allocation whole = exact.Allocate( Size, 64 * 1024 );
+	CRONO_CHECK( whole.IsValid() && whole.Offset == 0 && whole.Size == Size );
+
+	// Alignment padding the only free block doesn't need.
+	TlsfAllocator aligned( 64 * MB, 64 * 1024 );
+	CRONO_CHECK( aligned.Allocate( 64 * MB, 4 * MB ).IsValid() );
+
+	// A leftover block holding a request from its own class, next to a used one.
+	TlsfAllocator leftover( 100 * MB, 64 * 1024 );
+	const TlsfAllocator::Allocation first = leftover.Allocate( 100 * MB - Size, 64 * 1024 );
+	CRONO_CHECK( first.IsValid() );
+	const TlsfAllocator::Allocation rest = leftover.Allocate( Size, 64 * 1024 );
+	CRONO_CHECK( rest.IsValid() && rest.Offset == first.Size );
+	CRONO_CHECK( !leftover.Allocate( 1, 1 ).IsValid() );
+	CheckBlocks( leftover, 100 * MB );
+}
+
+CRONO_TEST( GpuMemoryDedicatedHeaps )
+{
+	RHI::NullDevice device;
+	GpuMemoryAllocator allocator( device, { 64 * MB, 1 } );
+	// Just past HeapSize, what used to not fit the dedicated heap made for it.
+	const GpuAllocation large = allocator.Allocate( RHI::MemoryType::Default, RHI::HeapContents::Buffers, BufferInfo( 64 * MB + 64 * 1024 ) );
+	CRONO_CHECK( large.IsValid() && large.Offset == 0 && large.Size == 64 * MB + 64 * 1024 );
+	const GpuAllocation aligned = allocator.Allocate( RHI::MemoryType::Default, RHI::HeapContents::Textures, BufferInfo( 64 * MB, 4 * MB ) );
+	CRONO_CHECK( aligned.IsValid() );
+	const GpuAllocation small = allocator.Allocate( RHI::MemoryType::Default, RHI::HeapContents::Buffers, BufferInfo( MB ) );
+	CRONO_CHECK( small.Heap != large.Heap );
+
+	GpuMemoryStats stats = allocator.GetStats();
+	CRONO_CHECK( stats.Allocations == 3 && stats.Pools.size() == 2 );
+	CRONO_CHECK( stats.Pools[0].DedicatedHeaps == 1 && stats.Pools[0].Heaps == 2 );
+	allocator.Free( large );
+	allocator.Free( aligned );
+	allocator.Free( small );
+	// The dedicated heap goes at once, the pool keeps one empty heap.
+	stats = allocator.GetStats();
+	CRONO_CHECK( stats.Allocations == 0 && stats.HeapBytes == 128 * MB );
+	CRONO_CHECK_THROWS( allocator.Free( large ), RhiException );
+}
+
+CRONO_TEST( GpuMemoryDefragmentation )
+{
+	RHI::NullDevice device;
+	// No empty heap kept, so the drained one is released.
+	GpuMemoryAllocator allocator( device, { 4 * MB, 0 } );
+	RHI::BufferDesc desc;
+	desc.Size = 200 * 1024;
+	desc.Usage = RHI::BufferUsage::Vertex;
+	desc.DebugName = "Defragmented";
+	struct Placed
+	{
+		std::unique_ptr<RHI::Buffer> Buffer;
+		GpuAllocation Allocation;
+	};
+	// 256 KB each, 16 per heap.
+	std::vector<Placed> buffers( 40 );
+	for (Placed& placed : buffers)
+	{
+		placed.Buffer = allocator.CreateBuffer( desc, placed.Allocation );
+	}
+	CRONO_CHECK( allocator.GetStats().Pools[0].Heaps == 3 );
+
+	// Every other one freed leaves the three heaps half used.
+	for (size_t i = 0; i < buffers.size(); i += 2)
+	{
+		buffers[i].Buffer.reset();
+		allocator.Free( buffers[i].Allocation );
+		buffers[i].Allocation = {};
+	}
+	CRONO_CHECK( allocator.GetStats().Pools[0].Fragmentation > 0.0 );
+	const std::vector<GpuDefragmentMove> moves = allocator.BeginDefragmentation( UINT64_MAX );
+	CRONO_CHECK( !moves.empty() );
+	for (const GpuDefragmentMove& move : moves)
+	{
+		CRONO_CHECK( move.To.Heap != move.From.Heap && move.To.Size >= move.From.Size );
+		for (Placed& placed : buffers)
+		{
+			if (placed.Allocation.IsValid() && placed.Allocation.Heap == move.From.Heap && placed.Allocation.Offset == move.From.Offset)
+			{
+				placed.Buffer = device.CreatePlacedBuffer( desc, *move.To.Heap, move.To.Offset );
+				placed.Allocation = move.To;
+			}
+		}
+	}
+	allocator.EndDefragmentation( moves );
+	// The emptiest heap was drained into the holes of the others.
+	const GpuMemoryStats stats = allocator.GetStats();
+	CRONO_CHECK( stats.Allocations == 20 && stats.Pools[0].Heaps == 2 );
+	// The device counts every heap, the allocator only its own.
+	CRONO_CHECK( allocator.GetBudget().LocalUsage >= stats.HeapBytes && !allocator.IsOverBudget() );
+	CRONO_CHECK( !allocator.Describe().empty() );
+
+	for (Placed& placed : buffers)
+	{
+		if (placed.Allocation.IsValid())
+		{
+			placed.Buffer.reset();
+			allocator.Free( placed.Allocation );
+		}
+	}
+	CRONO_CHECK( allocator.GetStats().Allocations == 0 );
+}
+
+CRONO_TEST( GpuMemoryDefragmentationDroppedMove )
+{
+	RHI::NullDevice device;
+	GpuMemoryAllocator allocator( device, { 4 * MB, 0 } );
+	RHI::BufferDesc desc;
+	desc.Size = 200 * 1024;
+	desc.Usage = RHI::BufferUsage::Vertex;
+	desc.DebugName = "Dropped";
+	std::vector<GpuAllocation> allocations( 40 );
+	std::vector<std::unique_ptr<RHI::Buffer>> buffers( allocations.size() );
+	for (size_t i = 0; i < buffers.size(); ++i)
+	{
+		buffers[i] = allocator.CreateBuffer( desc, allocations[i] );
+	}
+	for (size_t i = 0; i < buffers.size(); i += 2)
+	{
+		buffers[i].reset();
+		allocator.Free( allocations[i] );
+		allocations[i] = {};
+	}
+
+	// The first move is dropped, its resource stays at From; the others are made.
+	std::vector<GpuDefragmentMove> moves = allocator.BeginDefragmentation( UINT64_MAX );
+	CRONO_CHECK( moves.size() > 1 );
+	moves[0].Dropped = true;
+	size_t kept = SIZE_MAX;
+	for (size_t i = 0; i < allocations.size(); ++i)
+	{
+		for (const GpuDefragmentMove& move : moves)
+		{
+			if (allocations[i].IsValid() && allocations[i].Heap == move.From.Heap && allocations[i].Offset == move.From.Offset)
+			{
+				if (move.Dropped)
+				{
+					kept = i;
+					continue;
+				}
+				buffers[i] = device.CreatePlacedBuffer( desc, *move.To.Heap, move.To.Offset );
+				allocations[i] = move.To;
+			}
+		}
+	}
+	CRONO_CHECK( kept != SIZE_MAX );
+	allocator.EndDefragmentation( moves );
+	CRONO_CHECK( allocator.GetStats().Allocations == 20 );
+
+	// The dropped move's range is still taken: nothing new lands on it, and it frees normally.
+	std::vector<GpuAllocation> fresh( 16 );
+	for (GpuAllocation& allocation : fresh)
+	{
+		allocation = allocator.Allocate( RHI::MemoryType::Default, RHI::HeapContents::Buffers, device.GetBufferAllocationInfo( desc ) );
+		CRONO_CHECK( allocation.Heap != allocations[kept].Heap || allocation.Offset + allocation.Size <= allocations[kept].Offset ||
+			allocations[kept].Offset + allocations[kept].Size <= allocation.Offset );
+	}
+	for (const GpuAllocation& allocation : fresh)
+	{
+		allocator.Free( allocation );
+	}
+	for (size_t i = 0; i < buffers.size(); ++i)
+	{
+		if (allocations[i].IsValid())
+		{
+			buffers[i].reset();
+			allocator.Free( allocations[i] );
+		}
+	}
+	CRONO_CHECK( allocator.GetStats().Allocations == 0 );
+}
+
+CRONO_BENCHMARK( GpuMemoryThroughput )
+{
+	constexpr uint32_t Operations = 2000000;
+	constexpr uint64_t Page = 64 * 1024;
+	// Bare TLSF over 1 GB, random frees and allocations of 1 to 4 pages.
+	TlsfAllocator tlsf( 1024 * MB, Page );
+	std::vector<uint32_t> blocks( 4096, TlsfAllocator::InvalidBlock );
+	std::mt19937 random( 25 );
+	const double tlsfSeconds = CronoTests::MeasureSeconds( 1, [&]()
+	{
+		for (uint32_t i = 0; i < Operations; ++i)
+		{
+			uint32_t& block = blocks[random() % blocks.size()];
+			if (block != TlsfAllocator::InvalidBlock)
+			{
+				tlsf.Free( block );
+				block = TlsfAllocator::InvalidBlock;
+			}
+			else
+			{
+				block = tlsf.Allocate( Page * (1 + random() % 4), Page ).Block;
+			}
+		}
+	} );
+
+	// The same through the pools of a GpuMemoryAllocator, heaps coming and going included.
+	RHI::NullDevice device;
+	GpuMemoryAllocator allocator( device );
+	std::vector<GpuAllocation> allocations( 4096 );
+	const double poolSeconds = CronoTests::MeasureSeconds( 1, [&]()
+	{
+		for (uint32_t i = 0; i < Operations; ++i)
+		{
+			GpuAllocation& allocation = allocations[random() % allocations.size()];
+			if (allocation.IsValid())
+			{
+				allocator.Free( allocation );
+				allocation = {};
+			}
+			else
+			{
+				allocation = allocator.Allocate( RHI::MemoryType::Default, RHI::HeapContents::Buffers, BufferInfo( Page * (1 + random() % 4) ) );
+			}
+		}
+	} );
+	for (GpuAllocation& allocation : allocations)
+	{
+		if (allocation.IsValid())
+		{
+			allocator.Free( allocation );
+		}
+	}
+
+	std::ostringstream oss;
+	oss << Operations << " random allocations and frees: TLSF " << tlsfSeconds * 1e9 / Operations << " ns each, GpuMemoryAllocator "
+		<< poolSeconds * 1e9 / Operations << " ns each";
+	CronoTests::Report( oss.str() );
+}
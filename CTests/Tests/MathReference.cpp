@@ -0,0 +1,86 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "MathReference.h"
+#if !defined(CRONO_MATH_NO_INTRINSICS)
+#define CRONO_MATH_NO_INTRINSICS
+#endif
+// Compilers may fuse a * b + c on their own when the target has FMA, or reorder under /fp:fast,
+// which the scalar path of a normal build never does.
+#if defined(_MSC_VER)
+#pragma float_control( precise, on )
+#pragma fp_contract( off )
+#elif defined(__GNUC__)
+#pragma GCC optimize( "fp-contract=off" )
+#endif
+// In a namespace of its own, so these inline functions don't clash with the tested build's.
+#define CronoEngine CronoMathReference
+#include "Math/Math.h"
+#undef CronoEngine
+
+namespace CronoTests::MathReference
+{
+	using namespace CronoMathReference::Math;
+
+	namespace
+	{
+		Matrix LoadMatrix( const float matrix[16] )
+		{
+			Float4x4 storage;
+			std::memcpy( storage.m, matrix, sizeof( storage.m ) );
+			return LoadFloat4x4( &storage );
+		}
+
+		void StoreMatrix( float matrix[16], const Matrix& m )
+		{
+			Float4x4 storage;
+			StoreFloat4x4( &storage, m );
+			std::memcpy( matrix, storage.m, sizeof( storage.m ) );
+		}
+	}
+
+	void SinCos( const float angles[4], float sin[4], float cos[4] )
+	{
+		Vector s, c;
+		VectorSinCos( &s, &c, VectorLoad4( angles ) );
+		VectorStore4( sin, s );
+		VectorStore4( cos, c );
+	}
+
+	void QuaternionRollPitchYaw( float pitch, float yaw, float roll, float quaternion[4] )
+	{
+		VectorStore4( quaternion, QuaternionRotationRollPitchYaw( pitch, yaw, roll ) );
+	}
+
+	void AffineTransformation( const float scale[3], const float quaternion[4], const float translation[3], float matrix[16] )
+	{
+		StoreMatrix( matrix, MatrixAffineTransformation( VectorSet( scale[0], scale[1], scale[2], 0.0f ), VectorLoad4( quaternion ),
+			VectorSet( translation[0], translation[1], translation[2], 0.0f ) ) );
+	}
+
+	void MatrixMultiply( const float a[16], const float b[16], float matrix[16] )
+	{
+		StoreMatrix( matrix, CronoMathReference::Math::MatrixMultiply( LoadMatrix( a ), LoadMatrix( b ) ) );
+	}
+
+	void Vector3Transform( const float v[3], const float matrix[16], float result[4] )
+	{
+		VectorStore4( result, CronoMathReference::Math::Vector3Transform( VectorSet( v[0], v[1], v[2], 0.0f ), LoadMatrix( matrix ) ) );
+	}
+}
@@ -0,0 +1,37 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+
+namespace CronoTests
+{
+	/**
+	 * The math library built for the scalar path (CRONO_MATH_NO_INTRINSICS), whatever the
+	 * instruction sets of this build, to compare the SIMD paths against. Plain arrays in and
+	 * out so its types don't meet the tested build's; matrices are row major.
+	 */
+	namespace MathReference
+	{
+		void SinCos( const float angles[4], float sin[4], float cos[4] );
+		void QuaternionRollPitchYaw( float pitch, float yaw, float roll, float quaternion[4] );
+		void AffineTransformation( const float scale[3], const float quaternion[4], const float translation[3], float matrix[16] );
+		void MatrixMultiply( const float a[16], const float b[16], float matrix[16] );
+		void Vector3Transform( const float v[3], const float matrix[16], float result[4] );
+	}
+}
@@ -0,0 +1,303 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "Test.h"
+#include "MathReference.h"
+#include "Math/Math.h"
+#include <bit>
+#include <random>
+#include <sstream>
+#if defined(_WIN32)
+#include <DirectXMath.h>
+#endif
+
+using namespace CronoEngine;
+
+namespace
+{
+	constexpr uint32_t SampleCount = 20000;
+
+	/**
+	 * How far results may be from the scalar path, relative to the largest of 1 and the
+	 * magnitudes of a result's floats (sums cancel, so single floats can't be compared on
+	 * their own). The SSE paths do the same roundings as the scalar one; AVX2 builds fuse
+	 * multiply-adds, which round once where the others round twice.
+	 */
+#if defined(CRONO_MATH_AVX2)
+	constexpr float Tolerance = 2e-6f;
+#else
+	constexpr float Tolerance = 0.0f;
+#endif
+
+	struct Comparison
+	{
+		const char* Name;
+		float MaxError = 0.0f;
+		uint32_t Differences = 0;
+
+		void Add( const float* values, const float* references, uint32_t count )
+		{
+			float magnitude = 1.0f;
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				magnitude = std::max( magnitude, std::abs( references[i] ) );
+			}
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				if (std::bit_cast<uint32_t>( values[i] ) != std::bit_cast<uint32_t>( references[i] ))
+				{
+					++Differences;
+					MaxError = std::max( MaxError, std::abs( values[i] - references[i] ) / magnitude );
+				}
+			}
+		}
+
+		void Check( float tolerance ) const
+		{
+			std::ostringstream oss;
+			oss << Name << ": " << Differences << " floats differ, largest relative error " << MaxError;
+			CronoTests::Report( oss.str() );
+			CRONO_CHECK( tolerance > 0.0f ? MaxError <= tolerance : Differences == 0 );
+		}
+	};
+
+	struct Sample
+	{
+		float Angles[4];
+		float Scale[3];
+		float Translation[3];
+		float Point[3];
+	};
+
+	std::vector<Sample> MakeSamples()
+	{
+		std::mt19937 random( 1234 );
+		std::uniform_real_distribution<float> angle( -10.0f, 10.0f );
+		std::uniform_real_distribution<float> scale( 0.1f, 10.0f );
+		std::uniform_real_distribution<float> position( -1000.0f, 1000.0f );
+		std::vector<Sample> samples( SampleCount );
+		for (Sample& sample : samples)
+		{
+			for (float& value : sample.Angles)
+			{
+				value = angle( random );
+			}
+			for (uint32_t i = 0; i < 3; ++i)
+			{
+				sample.Scale[i] = scale( random );
+				sample.Translation[i] = position( random );
+				sample.Point[i] = position( random );
+			}
+		}
+		return samples;
+	}
+
+	void StoreMatrix( float matrix[16], const Math::Matrix& m )
+	{
+		Math::Float4x4 storage;
+		Math::StoreFloat4x4( &storage, m );
+		std::memcpy( matrix, storage.m, sizeof( storage.m ) );
+	}
+}
+
+CRONO_TEST( MathMatchesScalarReference )
+{
+	Comparison sinCos{ "VectorSinCos" };
+	Comparison quaternion{ "QuaternionRotationRollPitchYaw" };
+	Comparison affine{ "MatrixAffineTransformation" };
+	Comparison multiply{ "MatrixMultiply" };
+	Comparison transform{ "Vector3Transform" };
+	float previous[16] = { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+	for (const Sample& sample : MakeSamples())
+	{
+		float values[16], references[16];
+		Math::Vector sin, cos;
+		Math::VectorSinCos( &sin, &cos, Math::VectorLoad4( sample.Angles ) );
+		Math::VectorStore4( values, sin );
+		Math::VectorStore4( values + 4, cos );
+		CronoTests::MathReference::SinCos( sample.Angles, references, references + 4 );
+		sinCos.Add( values, references, 4 );
+		sinCos.Add( values + 4, references + 4, 4 );
+
+		// The reference quaternion feeds the matrices, so each comparison only sees its own function.
+		float rotation[4];
+		Math::VectorStore4( values, Math::QuaternionRotationRollPitchYaw( sample.Angles[0], sample.Angles[1], sample.Angles[2] ) );
+		CronoTests::MathReference::QuaternionRollPitchYaw( sample.Angles[0], sample.Angles[1], sample.Angles[2], rotation );
+		quaternion.Add( values, rotation, 4 );
+
+		float matrix[16];
+		StoreMatrix( values, Math::MatrixAffineTransformation( Math::VectorSet( sample.Scale[0], sample.Scale[1], sample.Scale[2], 0.0f ),
+			Math::VectorLoad4( rotation ), Math::VectorSet( sample.Translation[0], sample.Translation[1], sample.Translation[2], 0.0f ) ) );
+		CronoTests::MathReference::AffineTransformation( sample.Scale, rotation, sample.Translation, matrix );
+		affine.Add( values, matrix, 16 );
+
+		Math::Float4x4 a, b;
+		std::memcpy( a.m, matrix, sizeof( a.m ) );
+		std::memcpy( b.m, previous, sizeof( b.m ) );
+		StoreMatrix( values, Math::MatrixMultiply( Math::LoadFloat4x4( &a ), Math::LoadFloat4x4( &b ) ) );
+		CronoTests::MathReference::MatrixMultiply( matrix, previous, references );
+		multiply.Add( values, references, 16 );
+		std::memcpy( previous, matrix, sizeof( previous ) );
+
+		Math::VectorStore4( values, Math::Vector3Transform( Math::VectorSet( sample.Point[0], sample.Point[1], sample.Point[2], 0.0f ),
+			Math::LoadFloat4x4( &a ) ) );
+		CronoTests::MathReference::Vector3Transform( sample.Point, matrix, references );
+		transform.Add( values, references, 4 );
+	}
+	sinCos.Check( Tolerance );
+	quaternion.Check( Tolerance );
+	affine.Check( Tolerance );
+	multiply.Check( Tolerance );
+	transform.Check( Tolerance );
+}
+
+#if defined(_WIN32)
+// TransformComponent switched from DirectXMath to Math, which does the same operations for the same instruction set.
+CRONO_TEST( MathMatchesDirectXMath )
+{
+	Comparison sinCos{ "VectorSinCos" };
+	Comparison quaternion{ "QuaternionRotationRollPitchYaw" };
+	Comparison affine{ "MatrixAffineTransformation" };
+	for (const Sample& sample : MakeSamples())
+	{
+		float values[16], references[16];
+		Math::Vector sin, cos;
+		Math::VectorSinCos( &sin, &cos, Math::VectorLoad4( sample.Angles ) );
+		Math::VectorStore4( values, sin );
+		Math::VectorStore4( values + 4, cos );
+		DirectX::XMVECTOR xmSin, xmCos;
+		DirectX::XMVectorSinCos( &xmSin, &xmCos, DirectX::XMVectorSet( sample.Angles[0], sample.Angles[1], sample.Angles[2], sample.Angles[3] ) );
+		DirectX::XMStoreFloat4( reinterpret_cast<DirectX::XMFLOAT4*>(references), xmSin );
+		DirectX::XMStoreFloat4( reinterpret_cast<DirectX::XMFLOAT4*>(references + 4), xmCos );
+		sinCos.Add( values, references, 4 );
+		sinCos.Add( values + 4, references + 4, 4 );
+
+		const Math::Vector rotation = Math::QuaternionRotationRollPitchYaw( sample.Angles[0], sample.Angles[1], sample.Angles[2] );
+		const DirectX::XMVECTOR xmRotation = DirectX::XMQuaternionRotationRollPitchYaw( sample.Angles[0], sample.Angles[1], sample.Angles[2] );
+		Math::VectorStore4( values, rotation );
+		DirectX::XMStoreFloat4( reinterpret_cast<DirectX::XMFLOAT4*>(references), xmRotation );
+		quaternion.Add( values, references, 4 );
+
+		StoreMatrix( values, Math::MatrixAffineTransformation( Math::VectorSet( sample.Scale[0], sample.Scale[1], sample.Scale[2], 0.0f ),
+			rotation, Math::VectorSet( sample.Translation[0], sample.Translation[1], sample.Translation[2], 0.0f ) ) );
+		DirectX::XMStoreFloat4x4( reinterpret_cast<DirectX::XMFLOAT4X4*>(references), DirectX::XMMatrixAffineTransformation(
+			DirectX::XMVectorSet( sample.Scale[0], sample.Scale[1], sample.Scale[2], 0.0f ), DirectX::XMVectorZero(), xmRotation,
+			DirectX::XMVectorSet( sample.Translation[0], sample.Translation[1], sample.Translation[2], 0.0f ) ) );
+		affine.Add( values, references, 16 );
+	}
+	sinCos.Check( 0.0f );
+	quaternion.Check( 0.0f );
+	affine.Check( 0.0f );
+}
+#endif
+
+CRONO_BENCHMARK( MathThroughput )
+{
+	const std::vector<Sample> samples = MakeSamples();
+	std::vector<Math::Float4x4A> matrices( samples.size() );
+	std::vector<Math::Float4x4A> products( samples.size() );
+	// Sums carry over from run to run, so the compiler can't hoist the loops out of MeasureSeconds.
+	Math::Float4A sink{};
+	const auto report = [&]( const char* name, double seconds )
+	{
+		std::ostringstream oss;
+		oss << name << ": " << seconds * 1e9 / samples.size() << " ns";
+		CronoTests::Report( oss.str() );
+	};
+
+	report( "QuaternionRotationRollPitchYaw", CronoTests::MeasureSeconds( 20, [&]()
+	{
+		Math::Vector sum = Math::LoadFloat4A( &sink );
+		for (const Sample& sample : samples)
+		{
+			sum = Math::VectorAdd( sum, Math::QuaternionRotationRollPitchYaw( sample.Angles[0], sample.Angles[1], sample.Angles[2] ) );
+		}
+		Math::StoreFloat4A( &sink, sum );
+	} ) );
+	report( "MatrixAffineTransformation", CronoTests::MeasureSeconds( 20, [&]()
+	{
+		for (size_t i = 0; i < samples.size(); ++i)
+		{
+			const Sample& sample = samples[i];
+			Math::StoreFloat4x4A( &matrices[i], Math::MatrixAffineTransformation( Math::VectorSet( sample.Scale[0], sample.Scale[1], sample.Scale[2], 0.0f ),
+				Math::VectorLoad4( sample.Angles ), Math::VectorSet( sample.Translation[0], sample.Translation[1], sample.Translation[2], 0.0f ) ) );
+		}
+	} ) );
+	report( "MatrixMultiply", CronoTests::MeasureSeconds( 20, [&]()
+	{
+		for (size_t i = 1; i < matrices.size(); ++i)
+		{
+			Math::StoreFloat4x4A( &products[i], Math::MatrixMultiply( Math::LoadFloat4x4A( &matrices[i] ), Math::LoadFloat4x4A( &matrices[i - 1] ) ) );
+		}
+	} ) );
+	report( "Vector3Transform", CronoTests::MeasureSeconds( 20, [&]()
+	{
+		Math::Vector sum = Math::LoadFloat4A( &sink );
+		for (size_t i = 0; i < samples.size(); ++i)
+		{
+			sum = Math::VectorAdd( sum, Math::Vector3Transform( Math::LoadFloat3( reinterpret_cast<const Math::Float3*>(samples[i].Point) ),
+				Math::LoadFloat4x4A( &matrices[i] ) ) );
+		}
+		Math::StoreFloat4A( &sink, sum );
+	} ) );
+#if defined(_WIN32)
+	std::vector<DirectX::XMFLOAT4X4A> xmMatrices( samples.size() );
+	std::vector<DirectX::XMFLOAT4X4A> xmProducts( samples.size() );
+	DirectX::XMFLOAT4A xmSink{};
+	report( "XMQuaternionRotationRollPitchYaw", CronoTests::MeasureSeconds( 20, [&]()
+	{
+		DirectX::XMVECTOR sum = DirectX::XMLoadFloat4A( &xmSink );
+		for (const Sample& sample : samples)
+		{
+			sum = DirectX::XMVectorAdd( sum, DirectX::XMQuaternionRotationRollPitchYaw( sample.Angles[0], sample.Angles[1], sample.Angles[2] ) );
+		}
+		DirectX::XMStoreFloat4A( &xmSink, sum );
+	} ) );
+	report( "XMMatrixAffineTransformation", CronoTests::MeasureSeconds( 20, [&]()
+	{
+		for (size_t i = 0; i < samples.size(); ++i)
+		{
+			const Sample& sample = samples[i];
+			DirectX::XMStoreFloat4x4A( &xmMatrices[i], DirectX::XMMatrixAffineTransformation(
+				DirectX::XMVectorSet( sample.Scale[0], sample.Scale[1], sample.Scale[2], 0.0f ), DirectX::XMVectorZero(),
+				DirectX::XMLoadFloat4( reinterpret_cast<const DirectX::XMFLOAT4*>(sample.Angles) ),
+				DirectX::XMVectorSet( sample.Translation[0], sample.Translation[1], sample.Translation[2], 0.0f ) ) );
+		}
+	} ) );
+	report( "XMMatrixMultiply", CronoTests::MeasureSeconds( 20, [&]()
+	{
+		for (size_t i = 1; i < xmMatrices.size(); ++i)
+		{
+			DirectX::XMStoreFloat4x4A( &xmProducts[i], DirectX::XMMatrixMultiply( DirectX::XMLoadFloat4x4A( &xmMatrices[i] ),
+				DirectX::XMLoadFloat4x4A( &xmMatrices[i - 1] ) ) );
+		}
+	} ) );
+	report( "XMVector3Transform", CronoTests::MeasureSeconds( 20, [&]()
+	{
+		DirectX::XMVECTOR sum = DirectX::XMLoadFloat4A( &xmSink );
+		for (size_t i = 0; i < samples.size(); ++i)
+		{
+			sum = DirectX::XMVectorAdd( sum, DirectX::XMVector3Transform(
+				DirectX::XMLoadFloat3( reinterpret_cast<const DirectX::XMFLOAT3*>(samples[i].Point) ), DirectX::XMLoadFloat4x4A( &xmMatrices[i] ) ) );
+		}
+		DirectX::XMStoreFloat4A( &xmSink, sum );
+	} ) );
+#endif
+	CRONO_CHECK( std::isfinite( sink.x ) && std::isfinite( products.back().m[0][0] ) );
+}
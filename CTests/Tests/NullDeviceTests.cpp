@@ -0,0 +1,240 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "Test.h"
+#include "Graphics/RHI/NullDevice.h"
+#include "Graphics/FrameRenderer.h"
+#include "Common/CronoException.h"
+#include "imgui.h"
+#include <cstring>
+#include <sstream>
+
+using namespace CronoEngine;
+using namespace CronoEngine::Graphics;
+
+namespace
+{
+	std::unique_ptr<RHI::Texture> CreateTarget( RHI::Device& device, const char* name )
+	{
+		RHI::TextureDesc desc;
+		desc.Width = 64;
+		desc.Height = 64;
+		desc.Usage = RHI::TextureUsage::RenderTarget;
+		desc.DebugName = name;
+		return device.CreateTexture( desc );
+	}
+
+	// Whether one of the errors collected so far contains text.
+	bool HasError( const RHI::NullDevice& device, const std::string& text )
+	{
+		const std::vector<std::string> errors = device.GetErrors();
+		return std::any_of( errors.begin(), errors.end(), [&]( const std::string& error )
+		{
+			return error.find( text ) != std::string::npos;
+		} );
+	}
+}
+
+CRONO_TEST( NullDeviceReportsMisuse )
+{
+	RHI::NullDeviceDesc desc;
+	desc.ThrowOnError = false;
+	RHI::NullDevice device( desc );
+	RHI::Queue& queue = device.GetQueue( RHI::QueueType::Graphics );
+	const std::unique_ptr<RHI::Texture> target = CreateTarget( device, "Target" );
+	const std::unique_ptr<RHI::CommandList> commands = device.CreateCommandList( RHI::QueueType::Graphics );
+	const float color[4] = {};
+
+	commands->ClearRenderTarget( *target, color );
+	CRONO_CHECK( HasError( device, "ClearRenderTarget: the list is not recording" ) );
+	device.ClearErrors();
+
+	// Draw with nothing bound, then a clear of a target the list never moved to RenderTarget.
+	commands->Begin();
+	commands->Draw( 3, 1, 0, 0 );
+	CRONO_CHECK( HasError( device, "Draw: no pipeline" ) );
+	commands->ClearRenderTarget( *target, color );
+	RHI::CommandList* lists[] = { commands.get() };
+	queue.Submit( lists, 1 );
+	CRONO_CHECK( HasError( device, "Submit: the list was not closed" ) );
+	commands->End();
+	queue.Submit( lists, 1 );
+	CRONO_CHECK( HasError( device, "(Target) in RenderTarget but it is in Common" ) );
+	device.ClearErrors();
+
+	// Lists only go to their own kind of queue, and copy lists don't draw.
+	const std::unique_ptr<RHI::CommandList> copies = device.CreateCommandList( RHI::QueueType::Copy );
+	copies->Begin();
+	copies->ClearRenderTarget( *target, color );
+	copies->End();
+	RHI::CommandList* copyLists[] = { copies.get() };
+	queue.Submit( copyLists, 1 );
+	CRONO_CHECK( HasError( device, "ClearRenderTarget: only graphics lists" ) && HasError( device, "Submit: list and queue types differ" ) );
+
+	// The errors were collected instead of thrown, and counted.
+	CRONO_CHECK( device.GetStats().ValidationErrors >= 6 && device.GetStats().SubmittedLists == 1 );
+	device.ClearErrors();
+
+	// Without a texture to hand back GetBackBuffer throws either way.
+	const std::unique_ptr<RHI::SwapChain> swapChain = device.CreateSwapChain( { nullptr, 64, 64, 2 } );
+	CRONO_CHECK_THROWS( swapChain->GetBackBuffer( 2 ), RhiException );
+	CRONO_CHECK( HasError( device, "GetBackBuffer: index 2 of 2" ) );
+
+	RHI::NullDevice throwing;
+	const std::unique_ptr<RHI::CommandList> list = throwing.CreateCommandList( RHI::QueueType::Graphics );
+	CRONO_CHECK_THROWS( list->End(), RhiException );
+}
+
+CRONO_TEST( NullDeviceRecordsSubmissions )
+{
+	RHI::NullDeviceDesc desc;
+	desc.RecordSubmissions = true;
+	RHI::NullDevice device( desc );
+	RHI::Queue& queue = device.GetQueue( RHI::QueueType::Graphics );
+	const std::unique_ptr<RHI::Texture> target = CreateTarget( device, "Target" );
+	const std::unique_ptr<RHI::CommandList> commands = device.CreateCommandList( RHI::QueueType::Graphics );
+	const uint32_t id = RHI::NullDevice::GetId( *target );
+	CRONO_CHECK( id != 0 );
+
+	const float color[4] = { 0.5f, 0.25f, 0.0f, 1.0f };
+	commands->Begin();
+	commands->BeginEvent( "Pass" );
+	commands->Barrier( *target, RHI::ResourceState::Common, RHI::ResourceState::RenderTarget );
+	commands->ClearRenderTarget( *target, color );
+	RHI::Texture* targets[] = { target.get() };
+	commands->SetRenderTargets( targets, 1, nullptr );
+	commands->SetViewport( { 0.0f, 0.0f, 64.0f, 64.0f } );
+	commands->Barrier( *target, RHI::ResourceState::RenderTarget, RHI::ResourceState::Common );
+	commands->EndEvent();
+	commands->End();
+	RHI::CommandList* lists[] = { commands.get() };
+	queue.Submit( lists, 1 );
+
+	const std::vector<RHI::NullSubmission> submissions = device.GetSubmissions();
+	CRONO_CHECK( submissions.size() == 1 && submissions[0].Queue == RHI::QueueType::Graphics );
+	std::vector<std::string> lines;
+	for (const RHI::RecordedCommand& command : submissions[0].Commands)
+	{
+		lines.push_back( RHI::NullDevice::Describe( command ) );
+	}
+	const std::string label = "#" + std::to_string( id );
+	const std::vector<std::string> expected = {
+		"BeginEvent Pass",
+		"Barrier " + label + " Common -> RenderTarget",
+		"ClearRenderTarget " + label + " (0.5, 0.25, 0, 1)",
+		"SetRenderTargets " + label,
+		"SetViewport 0 0 64x64",
+		"Barrier " + label + " RenderTarget -> Common",
+		"EndEvent"
+	};
+	CRONO_CHECK( lines == expected );
+	const RHI::NullDeviceStats stats = device.GetStats();
+	CRONO_CHECK( stats.SubmittedLists == 1 && stats.Commands == 7 && stats.Barriers == 2 && stats.Clears == 1 && stats.StateChanges == 2 );
+
+	// Copies between mapped buffers really happen at Submit.
+	RHI::BufferDesc uploadDesc;
+	uploadDesc.Size = 256;
+	uploadDesc.Memory = RHI::MemoryType::Upload;
+	RHI::BufferDesc readbackDesc = uploadDesc;
+	readbackDesc.Memory = RHI::MemoryType::Readback;
+	const std::unique_ptr<RHI::Buffer> upload = device.CreateBuffer( uploadDesc );
+	const std::unique_ptr<RHI::Buffer> readback = device.CreateBuffer( readbackDesc );
+	std::memcpy( upload->GetMappedData(), "Null", 5 );
+	commands->Begin();
+	commands->CopyBuffer( *readback, 16, *upload, 0, 5 );
+	commands->End();
+	queue.Submit( lists, 1 );
+	CRONO_CHECK( std::strcmp( static_cast<const char*>(readback->GetMappedData()) + 16, "Null" ) == 0 );
+	CRONO_CHECK( device.GetStats().CopiedBytes == 5 && device.GetErrors().empty() );
+}
+
+CRONO_TEST( NullDeviceFencesAndQueues )
+{
+	RHI::NullDeviceDesc desc;
+	desc.ThrowOnError = false;
+	RHI::NullDevice device( desc );
+	RHI::Queue& graphics = device.GetQueue( RHI::QueueType::Graphics );
+	RHI::Queue& copy = device.GetQueue( RHI::QueueType::Copy );
+	CRONO_CHECK( graphics.GetType() == RHI::QueueType::Graphics && copy.GetType() == RHI::QueueType::Copy );
+	const std::unique_ptr<RHI::Fence> fence = device.CreateFence( 5 );
+	CRONO_CHECK( fence->GetCompletedValue() == 5 );
+
+	// Work is done at Submit, so a signal is reached at once and waits for it return.
+	copy.Signal( *fence, 7 );
+	CRONO_CHECK( fence->GetCompletedValue() == 7 );
+	fence->Wait( 7 );
+	graphics.Wait( *fence, 6 );
+	CRONO_CHECK( device.GetErrors().empty() );
+
+	// Nothing left could signal more, a real queue or thread would hang.
+	fence->Wait( 8 );
+	CRONO_CHECK( HasError( device, "Fence::Wait( 8 ) would never return" ) );
+	graphics.Wait( *fence, 9 );
+	CRONO_CHECK( HasError( device, "Wait: the queue would wait for 9 forever" ) );
+	graphics.Signal( *fence, 3 );
+	CRONO_CHECK( HasError( device, "Signal: fence values must not go down" ) );
+	device.ClearErrors();
+
+	// The next list starts from the states the one before left.
+	const std::unique_ptr<RHI::Texture> target = CreateTarget( device, "Target" );
+	const std::unique_ptr<RHI::CommandList> first = device.CreateCommandList( RHI::QueueType::Graphics );
+	const std::unique_ptr<RHI::CommandList> second = device.CreateCommandList( RHI::QueueType::Graphics );
+	first->Begin();
+	first->Barrier( *target, RHI::ResourceState::Common, RHI::ResourceState::RenderTarget );
+	first->End();
+	const float color[4] = {};
+	second->Begin();
+	second->ClearRenderTarget( *target, color );
+	second->Barrier( *target, RHI::ResourceState::RenderTarget, RHI::ResourceState::Common );
+	second->End();
+	RHI::CommandList* lists[] = { first.get(), second.get() };
+	graphics.Submit( lists, 2 );
+	graphics.WaitIdle();
+	CRONO_CHECK( device.GetErrors().empty() && device.GetStats().SubmittedLists == 2 );
+	// The other way around the clear finds the target in Common.
+	graphics.Submit( lists + 1, 1 );
+	CRONO_CHECK( HasError( device, "(Target) in RenderTarget but it is in Common" ) );
+}
+
+CRONO_BENCHMARK( FrameRendererCost )
+{
+	// Only the counts of the draw data reach the null device.
+	ImDrawData drawData;
+	drawData.Valid = true;
+	drawData.CmdListsCount = 16;
+	drawData.TotalVtxCount = 40000;
+	drawData.TotalIdxCount = 60000;
+	RHI::NullDevice device;
+	const std::unique_ptr<RHI::SwapChain> swapChain = device.CreateSwapChain( { nullptr, 1920, 1080, 3 } );
+	FrameRenderer renderer( device, *swapChain );
+	constexpr uint32_t Frames = 20000;
+	const double seconds = CronoTests::MeasureSeconds( 3, [&]()
+	{
+		for (uint32_t i = 0; i < Frames; ++i)
+		{
+			renderer.Render( &drawData, false );
+		}
+	} );
+	const RHI::NullDeviceStats stats = device.GetStats();
+	CRONO_CHECK( stats.ValidationErrors == 0 && stats.Presents == 3 * Frames && stats.UIDraws == 3 * Frames );
+	std::ostringstream oss;
+	oss << "FrameRenderer on the null device: " << seconds * 1e6 / Frames << " us of CPU per frame, "
+		<< stats.Commands / stats.SubmittedLists << " commands each";
+	CronoTests::Report( oss.str() );
+}
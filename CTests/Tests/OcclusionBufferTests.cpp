@@ -0,0 +1,244 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "Test.h"
+#include "Scene/OcclusionBuffer.h"
+#include "Scene/Scene.h"
+#include "Scene/Entity/Component/TransformComponent.h"
+#include <random>
+#include <sstream>
+
+using namespace CronoEngine;
+
+namespace
+{
+	// Camera at the origin looking down +z, 90 degrees high, for a 2:1 buffer.
+	Math::Float4x4 Perspective( float nearZ = 0.5f, float farZ = 1000.0f )
+	{
+		Math::Float4x4 m;
+		m.m[0][0] = 0.5f;
+		m.m[1][1] = 1.0f;
+		m.m[2][2] = farZ / (farZ - nearZ);
+		m.m[2][3] = 1.0f;
+		m.m[3][2] = -nearZ * farZ / (farZ - nearZ);
+		return m;
+	}
+
+	Math::Float4x4A Identity()
+	{
+		Math::Float4x4A m;
+		Math::StoreFloat4x4A( &m, Math::MatrixIdentity() );
+		return m;
+	}
+
+	// 10 x 10 wall facing the camera from z = 9.5 to 10.5.
+	const Math::Aabb Wall = { { -5.0f, -5.0f, 9.5f }, { 5.0f, 5.0f, 10.5f } };
+
+	// Hidden right behind the wall, and ones that show around it, in front of it or cross the near plane.
+	const Math::Aabb Hidden[] = {
+		Math::AabbFromCenterExtents( { 0.0f, 0.0f, 20.0f }, { 1.0f, 1.0f, 1.0f } ),
+		Math::AabbFromCenterExtents( { 2.0f, 2.0f, 30.0f }, { 3.0f, 3.0f, 3.0f } ),
+		Math::AabbFromCenterExtents( { -6.0f, 3.0f, 100.0f }, { 10.0f, 5.0f, 1.0f } ),
+	};
+	const Math::Aabb Shown[] = {
+		Math::AabbFromCenterExtents( { 20.0f, 0.0f, 20.0f }, { 1.0f, 1.0f, 1.0f } ),
+		Math::AabbFromCenterExtents( { 0.0f, 0.0f, 5.0f }, { 1.0f, 1.0f, 1.0f } ),
+		Math::AabbFromCenterExtents( { 4.0f, 0.0f, 12.0f }, { 2.0f, 1.0f, 2.0f } ),
+		Math::AabbFromCenterExtents( { 0.0f, 0.0f, 0.3f }, { 0.5f, 0.5f, 0.5f } ),
+		Math::AabbFromCenterExtents( { 0.0f, 0.0f, 200.0f }, { 150.0f, 1.0f, 1.0f } ),
+	};
+}
+
+CRONO_TEST( OcclusionBufferHidesBoxesBehindOccluders )
+{
+	const OccluderMesh wall = OcclusionBuffer::MakeBox( Wall );
+	const Math::Float4x4A world = Identity();
+	const OcclusionBuffer::Instance instance = { &wall, &world };
+	OcclusionBuffer buffer;
+	buffer.Render( Perspective(), &instance, 1, nullptr );
+	CRONO_CHECK( buffer.GetWidth() == 256 && buffer.GetHeight() == 128 );
+	CRONO_CHECK( buffer.GetMetrics().OccluderTriangles == 12 && buffer.GetMetrics().RasterizedTriangles > 0 );
+
+	// The wall covers x and y within 0.5 of the center in clip space, at its near face's depth.
+	const float wallDepth = (1.0f - 0.5f / 9.5f) * 1000.0f / 999.5f;
+	CRONO_CHECK( std::abs( buffer.GetDepth( 128, 64 ) - wallDepth ) < 1e-4f );
+	CRONO_CHECK( buffer.GetDepth( 96, 64 ) < 1.0f && buffer.GetDepth( 128, 34 ) < 1.0f );
+	CRONO_CHECK( buffer.GetDepth( 0, 0 ) == 1.0f && buffer.GetDepth( 80, 64 ) == 1.0f && buffer.GetDepth( 128, 20 ) == 1.0f );
+
+	for (const Math::Aabb& box : Hidden)
+	{
+		CRONO_CHECK( !buffer.IsVisible( box ) );
+	}
+	for (const Math::Aabb& box : Shown)
+	{
+		CRONO_CHECK( buffer.IsVisible( box ) );
+	}
+
+	// TestBoxes over jobs agrees with IsVisible box by box.
+	JobSystem jobs( 2 );
+	std::mt19937 random( 20 );
+	std::uniform_real_distribution<float> position( -30.0f, 30.0f );
+	std::uniform_real_distribution<float> depth( 1.0f, 60.0f );
+	std::uniform_real_distribution<float> extent( 0.1f, 3.0f );
+	std::vector<Math::Aabb> boxes( 5000 );
+	for (Math::Aabb& box : boxes)
+	{
+		box = Math::AabbFromCenterExtents( { position( random ), position( random ), depth( random ) },
+			{ extent( random ), extent( random ), extent( random ) } );
+	}
+	std::vector<uint8_t> visible( boxes.size() );
+	buffer.TestBoxes( boxes.data(), static_cast<uint32_t>(boxes.size()), visible.data(), &jobs );
+	uint32_t occluded = 0;
+	for (size_t i = 0; i < boxes.size(); ++i)
+	{
+		CRONO_CHECK( (visible[i] != 0) == buffer.IsVisible( boxes[i] ) );
+		occluded += visible[i] == 0;
+	}
+	CRONO_CHECK( occluded > 0 && buffer.GetMetrics().TestedBoxes == boxes.size() && buffer.GetMetrics().OccludedBoxes == occluded );
+
+	// Rendered over jobs it is the same buffer.
+	OcclusionBuffer banded;
+	banded.Render( Perspective(), &instance, 1, &jobs );
+	for (uint32_t y = 0; y < buffer.GetHeight(); ++y)
+	{
+		for (uint32_t x = 0; x < buffer.GetWidth(); ++x)
+		{
+			CRONO_CHECK( banded.GetDepth( x, y ) == buffer.GetDepth( x, y ) );
+		}
+	}
+}
+
+CRONO_TEST( SceneCullOcclusionCompactsVisibility )
+{
+	Scene scene;
+	entt::registry& registry = scene.m_Registry;
+	const auto create = [&]( const Math::Float3& position )
+	{
+		const entt::entity entity = registry.create();
+		registry.emplace<TransformComponent>( entity, Math::Float3A{ position.x, position.y, position.z },
+			Math::Float3A{ 0.0f, 0.0f, 0.0f }, Math::Float3A{ 1.0f, 1.0f, 1.0f } );
+		return entity;
+	};
+	// The wall mesh sits in front of its entity, so the entity's own unit cube is hidden too.
+	const entt::entity occluder = create( { 0.0f, 0.0f, 11.0f } );
+	registry.emplace<OccluderComponent>( occluder,
+		std::make_shared<const OccluderMesh>( OcclusionBuffer::MakeBox( { { -5.0f, -5.0f, -1.5f }, { 5.0f, 5.0f, -0.5f } } ) ) );
+	// A row behind the wall and past its sides, a shorter one in front of it and one behind the camera.
+	std::vector<entt::entity> hidden;
+	std::vector<entt::entity> shown;
+	for (int x = -20; x <= 20; x += 2)
+	{
+		(std::abs( x ) <= 8 ? hidden : shown).push_back( create( { static_cast<float>(x), 0.0f, 20.0f } ) );
+		if (std::abs( x ) <= 10)
+		{
+			shown.push_back( create( { static_cast<float>(x), 1.0f, 6.0f } ) );
+		}
+		create( { static_cast<float>(x), 0.0f, -5.0f } );
+	}
+	hidden.push_back( occluder );
+	scene.UpdateTransforms();
+
+	const Math::Float4x4 viewProjection = Perspective();
+	const Math::Frustum frustum = Math::FrustumFromMatrix( viewProjection );
+	VisibilityList visible;
+	scene.Cull( &frustum, 1, &visible );
+	const std::vector<uint32_t> inFrustum = visible.Indices;
+	OcclusionBuffer buffer;
+	scene.CullOcclusion( viewProjection, buffer, visible );
+	CRONO_CHECK( buffer.GetMetrics().Occluders == 1 && buffer.GetMetrics().TestedBoxes == inFrustum.size() );
+
+	const TransformSystem& transforms = scene.GetTransforms();
+	const auto contains = [&]( const std::vector<uint32_t>& indices, entt::entity entity )
+	{
+		return std::binary_search( indices.begin(), indices.end(), transforms.FindIndex( entity ) );
+	};
+	for (entt::entity entity : hidden)
+	{
+		CRONO_CHECK( contains( inFrustum, entity ) && !contains( visible.Indices, entity ) );
+	}
+	for (entt::entity entity : shown)
+	{
+		CRONO_CHECK( contains( visible.Indices, entity ) );
+	}
+	CRONO_CHECK( visible.Indices.size() == inFrustum.size() - hidden.size() && buffer.GetMetrics().OccludedBoxes == hidden.size() );
+
+	// Still increasing, and the masks hold exactly the indices left.
+	CRONO_CHECK( std::is_sorted( visible.Indices.begin(), visible.Indices.end() ) );
+	std::vector<uint32_t> fromMasks;
+	for (uint32_t block = 0; block < visible.BlockMasks.size(); ++block)
+	{
+		for (uint32_t bit = 0; bit < VisibilitySystem::BlockWidth; ++bit)
+		{
+			if (visible.BlockMasks[block] & (1u << bit))
+			{
+				fromMasks.push_back( block * VisibilitySystem::BlockWidth + bit );
+			}
+		}
+	}
+	CRONO_CHECK( fromMasks == visible.Indices );
+}
+
+CRONO_BENCHMARK( OcclusionBufferCost )
+{
+	// A street: 200 building blocks on both sides, 100k boxes of clutter behind and between them.
+	std::mt19937 random( 20 );
+	std::vector<OccluderMesh> meshes;
+	std::vector<Math::Float4x4A> worlds;
+	for (int i = 0; i < 100; ++i)
+	{
+		for (const float side : { -1.0f, 1.0f })
+		{
+			const float z = 5.0f + i * 10.0f;
+			meshes.push_back( OcclusionBuffer::MakeBox( { { side * 6.0f - 4.0f, -1.0f, z }, { side * 6.0f + 4.0f, 15.0f, z + 8.0f } } ) );
+			worlds.push_back( Identity() );
+		}
+	}
+	std::vector<OcclusionBuffer::Instance> instances( meshes.size() );
+	for (size_t i = 0; i < meshes.size(); ++i)
+	{
+		instances[i] = { &meshes[i], &worlds[i] };
+	}
+	std::uniform_real_distribution<float> x( -100.0f, 100.0f );
+	std::uniform_real_distribution<float> z( 1.0f, 1000.0f );
+	std::vector<Math::Aabb> boxes( 100000 );
+	for (Math::Aabb& box : boxes)
+	{
+		box = Math::AabbFromCenterExtents( { x( random ), 1.0f, z( random ) }, { 1.0f, 1.0f, 1.0f } );
+	}
+	std::vector<uint8_t> visible( boxes.size() );
+
+	const uint32_t threads = std::max( 1u, std::thread::hardware_concurrency() );
+	std::unique_ptr<JobSystem> jobs = threads > 1 ? std::make_unique<JobSystem>( threads - 1 ) : nullptr;
+	OcclusionBuffer buffer;
+	const Math::Float4x4 viewProjection = Perspective();
+	const double renderSeconds = CronoTests::MeasureSeconds( 20, [&]()
+	{
+		buffer.Render( viewProjection, instances.data(), static_cast<uint32_t>(instances.size()), jobs.get() );
+	} );
+	const double testSeconds = CronoTests::MeasureSeconds( 20, [&]()
+	{
+		buffer.TestBoxes( boxes.data(), static_cast<uint32_t>(boxes.size()), visible.data(), jobs.get() );
+	} );
+	const OcclusionBuffer::Metrics& metrics = buffer.GetMetrics();
+	std::ostringstream oss;
+	oss << threads << " threads, " << buffer.GetWidth() << "x" << buffer.GetHeight() << ": Render of " << metrics.Occluders
+		<< " occluders " << renderSeconds * 1e3 << " ms, TestBoxes of " << boxes.size() << " boxes " << testSeconds * 1e3
+		<< " ms (" << testSeconds * 1e9 / boxes.size() << " ns each, " << metrics.GetOccludedPercent() << "% occluded)";
+	CronoTests::Report( oss.str() );
+}
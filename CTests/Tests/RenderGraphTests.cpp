@@ -0,0 +1,394 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "Test.h"
+#include "Graphics/RenderGraph.h"
+#include "Graphics/RHI/NullDevice.h"
+#include <sstream>
+
+using namespace CronoEngine;
+using namespace CronoEngine::Graphics;
+
+namespace
+{
+	RHI::TextureDesc TargetDesc( uint32_t size, RHI::PixelFormat format = RHI::PixelFormat::R8G8B8A8_UNorm )
+	{
+		RHI::TextureDesc desc;
+		desc.Width = size;
+		desc.Height = size;
+		desc.Format = format;
+		desc.Usage = RHI::TextureUsage::RenderTarget | RHI::TextureUsage::ShaderResource;
+		return desc;
+	}
+
+	// Records the graph into one list on a validating null device, as FrameRenderer does.
+	struct GraphRunner
+	{
+		explicit GraphRunner( bool record = false )
+			: Device( RHI::NullDeviceDesc{ true, record } ), Graph( Device, 2 ),
+			Commands( Device.CreateCommandList( RHI::QueueType::Graphics ) )
+		{
+			RHI::TextureDesc desc = TargetDesc( 64 );
+			desc.Usage = RHI::TextureUsage::RenderTarget;
+			desc.InitialState = RHI::ResourceState::Present;
+			desc.DebugName = "Back Buffer";
+			BackBuffer = Device.CreateTexture( desc );
+		}
+
+		RenderGraphTexture Import()
+		{
+			return Graph.ImportTexture( *BackBuffer, RHI::ResourceState::Present, RHI::ResourceState::Present );
+		}
+
+		void Execute()
+		{
+			Device.BeginFrame();
+			Commands->Begin();
+			Graph.Execute( *Commands );
+			Commands->End();
+			RHI::CommandList* lists[] = { Commands.get() };
+			Device.GetQueue( RHI::QueueType::Graphics ).Submit( lists, 1 );
+		}
+
+		RHI::NullDevice Device;
+		RenderGraph Graph;
+		std::unique_ptr<RHI::CommandList> Commands;
+		std::unique_ptr<RHI::Texture> BackBuffer;
+	};
+
+	// Pass i reads transient i - 1 and writes transient i, the last one writes the back buffer.
+	void AddChain( GraphRunner& runner, const std::vector<RHI::TextureDesc>& descs )
+	{
+		const RenderGraphTexture backBuffer = runner.Import();
+		RenderGraphTexture previous;
+		for (size_t i = 0; i <= descs.size(); ++i)
+		{
+			runner.Graph.AddPass( "Chain " + std::to_string( i ), [&]( RenderGraphBuilder& builder )
+			{
+				if (previous.IsValid())
+				{
+					builder.Read( previous );
+				}
+				previous = i < descs.size() ? builder.CreateTexture( descs[i] ) : backBuffer;
+				builder.Write( previous );
+			}, []( RenderGraphContext& ) {} );
+		}
+	}
+}
+
+CRONO_TEST( RenderGraphCullsUnusedPasses )
+{
+	GraphRunner runner;
+	RenderGraph& graph = runner.Graph;
+	const RenderGraphTexture backBuffer = runner.Import();
+	RenderGraphTexture used;
+	RenderGraphTexture unused;
+	std::vector<std::string> executed;
+	const auto record = [&]( const char* name )
+	{
+		return [&executed, name]( RenderGraphContext& ) { executed.push_back( name ); };
+	};
+	// 0 writes what only the culled 1 reads, 1 writes what nothing reads.
+	graph.AddPass( "Unused Source", [&]( RenderGraphBuilder& builder )
+	{
+		unused = builder.CreateTexture( TargetDesc( 64 ) );
+		builder.Write( unused );
+	}, record( "Unused Source" ) );
+	graph.AddPass( "Unused", [&]( RenderGraphBuilder& builder )
+	{
+		builder.Read( unused );
+		builder.Write( builder.CreateTexture( TargetDesc( 64 ) ) );
+	}, record( "Unused" ) );
+	graph.AddPass( "Source", [&]( RenderGraphBuilder& builder )
+	{
+		used = builder.CreateTexture( TargetDesc( 64 ) );
+		builder.Write( used );
+	}, record( "Source" ) );
+	graph.AddPass( "Capture", [&]( RenderGraphBuilder& builder )
+	{
+		builder.Read( used );
+		builder.Write( builder.CreateTexture( TargetDesc( 64 ) ) );
+		builder.SetSideEffects();
+	}, record( "Capture" ) );
+	graph.AddPass( "Overwritten", [&]( RenderGraphBuilder& builder ) { builder.Write( used ); }, record( "Overwritten" ) );
+	graph.AddPass( "Present", [&]( RenderGraphBuilder& builder )
+	{
+		builder.Read( used );
+		builder.Write( backBuffer );
+	}, record( "Present" ) );
+	graph.Compile();
+
+	// "Source" is needed by the side effect pass, "Overwritten" by the pass writing the import.
+	CRONO_CHECK( graph.IsCulled( 0 ) && graph.IsCulled( 1 ) && !graph.IsCulled( 2 ) && !graph.IsCulled( 3 ) );
+	CRONO_CHECK( !graph.IsCulled( 4 ) && !graph.IsCulled( 5 ) );
+	CRONO_CHECK( graph.GetStats().Passes == 6 && graph.GetStats().CulledPasses == 2 && graph.GetStats().TransientTextures == 2 );
+	runner.Execute();
+	CRONO_CHECK( (executed == std::vector<std::string>{ "Source", "Capture", "Overwritten", "Present" }) );
+	CRONO_CHECK_THROWS( graph.IsCulled( 6 ), RhiException );
+}
+
+CRONO_TEST( RenderGraphBatchesBarriersPerPass )
+{
+	GraphRunner runner( true );
+	RenderGraph& graph = runner.Graph;
+	const RenderGraphTexture backBuffer = runner.Import();
+	RenderGraphTexture color;
+	RenderGraphTexture normals;
+	RenderGraphTexture lit;
+	graph.AddPass( "GBuffer", [&]( RenderGraphBuilder& builder )
+	{
+		color = builder.CreateTexture( TargetDesc( 64 ) );
+		normals = builder.CreateTexture( TargetDesc( 64 ) );
+		builder.Write( color );
+		builder.Write( normals );
+	}, []( RenderGraphContext& ) {} );
+	graph.AddPass( "Lighting", [&]( RenderGraphBuilder& builder )
+	{
+		builder.Read( color );
+		builder.Read( normals );
+		lit = builder.CreateTexture( TargetDesc( 64 ) );
+		builder.Write( lit );
+	}, []( RenderGraphContext& ) {} );
+	graph.AddPass( "Compose", [&]( RenderGraphBuilder& builder )
+	{
+		builder.Read( lit );
+		builder.Read( normals );
+		builder.Write( backBuffer );
+	}, []( RenderGraphContext& ) {} );
+	graph.Compile();
+	// Two, three and two transitions in front of the passes, the back buffer back to Present.
+	CRONO_CHECK( graph.GetStats().Transitions == 8 && graph.GetStats().BarrierBatches == 4 );
+	runner.Execute();
+
+	// Every run of barriers is one Barrier call, so they all sit right before a pass or at the end.
+	const std::vector<RHI::NullSubmission> submissions = runner.Device.GetSubmissions();
+	CRONO_CHECK( submissions.size() == 1 );
+	const std::vector<RHI::RecordedCommand>& commands = submissions[0].Commands;
+	uint32_t runs = 0;
+	for (size_t i = 0; i < commands.size(); ++i)
+	{
+		if (commands[i].Type != RHI::CommandType::Barrier)
+		{
+			continue;
+		}
+		size_t end = i;
+		while (end < commands.size() && commands[end].Type == RHI::CommandType::Barrier)
+		{
+			++end;
+		}
+		CRONO_CHECK( end == commands.size() || commands[end].Type == RHI::CommandType::BeginEvent );
+		++runs;
+		i = end;
+	}
+	CRONO_CHECK( runs == graph.GetStats().BarrierBatches );
+	// Each transient gets its memory with an aliasing barrier in the batch of its first pass.
+	CRONO_CHECK( graph.GetStats().AliasingBarriers == 3 && runner.Device.GetStats().Barriers == 11 );
+}
+
+CRONO_TEST( RenderGraphMergesReadStates )
+{
+	GraphRunner runner;
+	RenderGraph& graph = runner.Graph;
+	const RenderGraphTexture backBuffer = runner.Import();
+	RenderGraphTexture shadow;
+	graph.AddPass( "Shadow", [&]( RenderGraphBuilder& builder )
+	{
+		RHI::TextureDesc desc = TargetDesc( 64 );
+		desc.DebugName = "Shadow Map";
+		shadow = builder.CreateTexture( desc );
+		builder.Write( shadow );
+	}, []( RenderGraphContext& ) {} );
+	// Three passes in a row only read it, the last one in two states.
+	const RHI::ResourceState readStates[] = {
+		RHI::ResourceState::PixelShaderResource, RHI::ResourceState::NonPixelShaderResource, RHI::ResourceState::CopySource
+	};
+	for (const RHI::ResourceState state : readStates)
+	{
+		graph.AddPass( "Reader", [&]( RenderGraphBuilder& builder )
+		{
+			builder.Read( shadow, state );
+			if (state == RHI::ResourceState::CopySource)
+			{
+				builder.Read( shadow, RHI::ResourceState::PixelShaderResource );
+			}
+			builder.Write( builder.CreateTexture( TargetDesc( 64 ) ) );
+			builder.SetSideEffects();
+		}, []( RenderGraphContext& ) {} );
+	}
+	// Written again, which ends the merged read.
+	graph.AddPass( "Overwrite", [&]( RenderGraphBuilder& builder )
+	{
+		builder.Write( shadow );
+		builder.Write( backBuffer );
+	}, []( RenderGraphContext& ) {} );
+	graph.Compile();
+
+	// One transition into every read state at the first reader, none at the others.
+	const std::string merged = RHI::GetStateName( RHI::ResourceState::ShaderResource | RHI::ResourceState::CopySource );
+	const std::vector<std::string> expected = {
+		"Pass Shadow", "  Barrier Shadow Map ? -> RenderTarget",
+		"Pass Reader", "  Barrier Shadow Map RenderTarget -> " + merged,
+		"Pass Reader", "Pass Reader",
+		"Pass Overwrite", "  Barrier Shadow Map " + merged + " -> RenderTarget"
+	};
+	std::vector<std::string> lines;
+	std::istringstream describe( graph.Describe() );
+	for (std::string line; std::getline( describe, line );)
+	{
+		if (line.rfind( "Pass", 0 ) == 0 || line.find( "Barrier Shadow Map" ) == 2)
+		{
+			lines.push_back( line );
+		}
+	}
+	CRONO_CHECK( lines == expected );
+	// The null device checks every reader finds it in the state it reads.
+	runner.Execute();
+
+	// A pass can't read and write a texture in different states.
+	CRONO_CHECK_THROWS( graph.AddPass( "Conflict", [&]( RenderGraphBuilder& builder )
+	{
+		builder.Read( shadow );
+		builder.Write( shadow, RHI::ResourceState::UnorderedAccess );
+	}, []( RenderGraphContext& ) {} ), RhiException );
+}
+
+CRONO_TEST( RenderGraphAliasesTransients )
+{
+	GraphRunner runner;
+	RenderGraph& graph = runner.Graph;
+	// 1 MB each, the first and the last are never alive together.
+	const RHI::TextureDesc rgba = TargetDesc( 512 );
+	const RHI::TextureDesc bgra = TargetDesc( 512, RHI::PixelFormat::B8G8R8A8_UNorm );
+	const uint64_t size = runner.Device.GetTextureAllocationInfo( rgba ).Size;
+	for (uint32_t frame = 0; frame < 3; ++frame)
+	{
+		graph.Reset();
+		AddChain( runner, { rgba, rgba, bgra } );
+		graph.Compile();
+		const RenderGraphStats& stats = graph.GetStats();
+		CRONO_CHECK( stats.TransientTextures == 3 && stats.UnaliasedMemory == 3 * size && stats.TransientMemory == 2 * size );
+		CRONO_CHECK( graph.GetHeapOffset( { 1 } ) == 0 && graph.GetHeapOffset( { 3 } ) == 0 && graph.GetHeapOffset( { 2 } ) == size );
+		// Throws if a placed texture is used without holding its memory.
+		runner.Execute();
+		// The third takes the first one's memory, so from the second frame on the first needs it back.
+		CRONO_CHECK( graph.GetStats().AliasingBarriers == (frame == 0 ? 3u : 2u) );
+	}
+}
+
+CRONO_TEST( RenderGraphRetiresAfterFramesInFlight )
+{
+	GraphRunner runner;
+	RenderGraph& graph = runner.Graph;
+	const auto heapBytes = [&]() { return runner.Device.GetMemoryBudget().LocalUsage; };
+	const auto textureViews = [&]() { return runner.Device.GetDescriptorStats().PersistentUsed; };
+	const uint32_t baseViews = textureViews();
+	const auto frame = [&]( const std::vector<RHI::TextureDesc>& descs )
+	{
+		graph.Reset();
+		AddChain( runner, descs );
+		runner.Execute();
+	};
+
+	frame( { TargetDesc( 256 ), TargetDesc( 256 ) } );
+	const uint64_t smallHeap = heapBytes();
+	CRONO_CHECK( smallHeap > 0 && textureViews() == baseViews + 2 );
+	// Too big for the heap: a new one, the old one stays while 2 frames may still use it.
+	frame( { TargetDesc( 2048 ), TargetDesc( 2048 ) } );
+	const uint64_t bigHeap = heapBytes() - smallHeap;
+	CRONO_CHECK( bigHeap >= 2 * runner.Device.GetTextureAllocationInfo( TargetDesc( 2048 ) ).Size );
+	frame( { TargetDesc( 2048 ), TargetDesc( 2048 ) } );
+	CRONO_CHECK( heapBytes() == smallHeap + bigHeap );
+	frame( { TargetDesc( 2048 ), TargetDesc( 2048 ) } );
+	CRONO_CHECK( heapBytes() == bigHeap );
+
+	// Without transients the placed ones stay for framesInFlight frames, then are retired
+	// and released framesInFlight frames after that.
+	std::vector<uint32_t> views;
+	for (uint32_t i = 0; i < 6; ++i)
+	{
+		frame( {} );
+		views.push_back( textureViews() );
+	}
+	CRONO_CHECK( views[0] == baseViews + 2 && views[1] == baseViews + 2 && views.back() == baseViews );
+	// Heaps are kept, the next frame needs no new ones.
+	CRONO_CHECK( heapBytes() == bigHeap );
+}
+
+CRONO_BENCHMARK( RenderGraphCompile )
+{
+	// Four passes per group: two write transients, one reads both into the next group's input
+	// and one is never used, so a quarter of the graph is culled.
+	constexpr uint32_t Groups = 256;
+	RHI::NullDevice device;
+	RenderGraph graph( device, 2 );
+	RHI::TextureDesc backBufferDesc = TargetDesc( 64 );
+	backBufferDesc.Usage = RHI::TextureUsage::RenderTarget;
+	const std::unique_ptr<RHI::Texture> backBuffer = device.CreateTexture( backBufferDesc );
+	const auto build = [&]()
+	{
+		graph.Reset();
+		const RenderGraphTexture output = graph.ImportTexture( *backBuffer, RHI::ResourceState::Common, RHI::ResourceState::Common );
+		RenderGraphTexture input;
+		for (uint32_t group = 0; group < Groups; ++group)
+		{
+			RenderGraphTexture a;
+			RenderGraphTexture b;
+			graph.AddPass( "A", [&]( RenderGraphBuilder& builder )
+			{
+				if (input.IsValid())
+				{
+					builder.Read( input );
+				}
+				a = builder.CreateTexture( TargetDesc( 128 << (group % 4) ) );
+				builder.Write( a );
+			}, []( RenderGraphContext& ) {} );
+			graph.AddPass( "B", [&]( RenderGraphBuilder& builder )
+			{
+				b = builder.CreateTexture( TargetDesc( 256 ) );
+				builder.Write( b );
+			}, []( RenderGraphContext& ) {} );
+			graph.AddPass( "Unused", [&]( RenderGraphBuilder& builder )
+			{
+				builder.Read( a );
+				builder.Write( builder.CreateTexture( TargetDesc( 256 ) ) );
+			}, []( RenderGraphContext& ) {} );
+			graph.AddPass( "Combine", [&]( RenderGraphBuilder& builder )
+			{
+				builder.Read( a );
+				builder.Read( b, RHI::ResourceState::NonPixelShaderResource );
+				input = group + 1 < Groups ? builder.CreateTexture( TargetDesc( 256 ) ) : output;
+				builder.Write( input );
+			}, []( RenderGraphContext& ) {} );
+		}
+	};
+	constexpr uint32_t Runs = 50;
+	const double buildSeconds = CronoTests::MeasureSeconds( Runs, build );
+	const double compileSeconds = CronoTests::MeasureSeconds( Runs, [&]()
+	{
+		build();
+		graph.Compile();
+	} ) - buildSeconds;
+	const RenderGraphStats& stats = graph.GetStats();
+	CRONO_CHECK( stats.Passes == 4 * Groups && stats.CulledPasses == Groups && stats.TransientMemory < stats.UnaliasedMemory );
+	std::ostringstream oss;
+	oss << stats.Passes << " passes, " << stats.TransientTextures << " transients: " << buildSeconds * 1e6 << " us to add, "
+		<< compileSeconds * 1e6 << " us to compile (" << stats.Transitions << " transitions in " << stats.BarrierBatches
+		<< " batches, " << stats.TransientMemory / (1024 * 1024) << " of " << stats.UnaliasedMemory / (1024 * 1024) << " MB)";
+	CronoTests::Report( oss.str() );
+}
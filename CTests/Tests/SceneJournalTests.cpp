@@ -0,0 +1,279 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "Test.h"
+#include "Scene/SceneJournal.h"
+#include <filesystem>
+#include <fstream>
+
+using namespace CronoEngine;
+
+namespace
+{
+	// Loads the snapshot at path and replays its journal, as Project::LoadScene does.
+	std::unique_ptr<Scene> Reload( const std::string& path )
+	{
+		SceneSerializer::FileHeader header{};
+		std::unique_ptr<Scene> scene = SceneSerializer::Load( path, &header );
+		SceneJournal journal( path, header, nullptr );
+		journal.Replay( *scene );
+		return scene;
+	}
+
+	// count entities with a transform at the origin.
+	void MakeScene( Scene& scene, entt::entity* entities, uint32_t count )
+	{
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			entities[i] = scene.m_Registry.create();
+			scene.m_Registry.emplace<TransformComponent>( entities[i] );
+		}
+	}
+
+	float GetX( Scene& scene, entt::entity entity )
+	{
+		return scene.m_Registry.get<TransformComponent>( entity ).GetPosition().x;
+	}
+
+	void MoveTo( Scene& scene, entt::entity entity, float x )
+	{
+		scene.m_Registry.patch<TransformComponent>( entity, [x]( TransformComponent& transform ) { transform.SetPosition( x, 0.0f, 0.0f ); } );
+	}
+
+	void RemoveSnapshot( const std::string& path )
+	{
+		SceneJournal::Remove( path );
+		std::filesystem::remove( path );
+	}
+}
+
+CRONO_TEST( SceneJournalKeepsSetterMoves )
+{
+	const std::string path = CronoTests::TemporaryPath( "Journal.cscn" );
+	Scene scene;
+	entt::entity entities[3];
+	for (entt::entity& entity : entities)
+	{
+		entity = scene.m_Registry.create();
+		scene.m_Registry.emplace<TransformComponent>( entity );
+	}
+	scene.UpdateTransforms();
+	SceneJournal journal( path, SceneSerializer::Save( scene, path ), nullptr );
+
+	// Saved before the TransformSystem saw the move.
+	scene.m_Registry.get<TransformComponent>( entities[0] ).SetPosition( 1.0f, 2.0f, 3.0f );
+	journal.Append( scene );
+	CRONO_CHECK( scene.GetUnsavedEntities().empty() );
+
+	// Saved after UpdateTransforms already cleared the moved flags.
+	scene.m_Registry.get<TransformComponent>( entities[1] ).SetRotation( 0.5f, 0.0f, 0.0f );
+	scene.m_Registry.get<TransformComponent>( entities[2] ).SetScale( 2.0f, 2.0f, 2.0f );
+	scene.UpdateTransforms();
+	const std::vector<entt::entity>& unsaved = scene.GetUnsavedEntities();
+	CRONO_CHECK( std::find( unsaved.begin(), unsaved.end(), entities[1] ) != unsaved.end() );
+	CRONO_CHECK( std::find( unsaved.begin(), unsaved.end(), entities[2] ) != unsaved.end() );
+	journal.Append( scene );
+
+	std::unique_ptr<Scene> loaded = Reload( path );
+	const Math::Float3A position = loaded->m_Registry.get<TransformComponent>( entities[0] ).GetPosition();
+	const Math::Float3A rotation = loaded->m_Registry.get<TransformComponent>( entities[1] ).GetRotation();
+	const Math::Float3A scale = loaded->m_Registry.get<TransformComponent>( entities[2] ).GetScale();
+	CRONO_CHECK( position.x == 1.0f && position.y == 2.0f && position.z == 3.0f );
+	CRONO_CHECK( rotation.x == 0.5f );
+	CRONO_CHECK( scale.x == 2.0f && scale.y == 2.0f && scale.z == 2.0f );
+	RemoveSnapshot( path );
+}
+
+CRONO_TEST( SceneJournalDropsTornAndCorruptBlocks )
+{
+	const std::string path = CronoTests::TemporaryPath( "JournalTorn.cscn" );
+	const std::string journalPath = path + ".journal";
+	for (const bool torn : { true, false })
+	{
+		Scene scene;
+		entt::entity entities[2];
+		MakeScene( scene, entities, 2 );
+		SceneJournal journal( path, SceneSerializer::Save( scene, path ), nullptr );
+		MoveTo( scene, entities[0], 1.0f );
+		journal.Append( scene );
+		const uintmax_t goodBytes = std::filesystem::file_size( journalPath );
+		MoveTo( scene, entities[1], 2.0f );
+		journal.Append( scene );
+		const uintmax_t allBytes = std::filesystem::file_size( journalPath );
+		CRONO_CHECK( allBytes == goodBytes + sizeof( SceneJournal::BlockHeader ) + sizeof( SceneJournal::Record ) );
+
+		if (torn)
+		{
+			// The last block only made it halfway.
+			std::filesystem::resize_file( journalPath, allBytes - sizeof( SceneJournal::Record ) / 2 );
+		}
+		else
+		{
+			// The last block is whole but its records don't match the checksum.
+			std::fstream file( journalPath, std::ios::binary | std::ios::in | std::ios::out );
+			file.seekp( static_cast<std::streamoff>(allBytes - 1) );
+			file.put( '\x5A' );
+		}
+
+		SceneSerializer::FileHeader header{};
+		std::unique_ptr<Scene> loaded = SceneSerializer::Load( path, &header );
+		SceneJournal replayed( path, header, nullptr );
+		replayed.Replay( *loaded );
+		CRONO_CHECK( GetX( *loaded, entities[0] ) == 1.0f && GetX( *loaded, entities[1] ) == 0.0f );
+		// Cut back to the last good block, and appends carry on from there.
+		CRONO_CHECK( std::filesystem::file_size( journalPath ) == goodBytes );
+		MoveTo( *loaded, entities[1], 3.0f );
+		replayed.Append( *loaded );
+		std::unique_ptr<Scene> reloaded = Reload( path );
+		CRONO_CHECK( GetX( *reloaded, entities[0] ) == 1.0f && GetX( *reloaded, entities[1] ) == 3.0f );
+		RemoveSnapshot( path );
+	}
+}
+
+CRONO_TEST( SceneJournalCompacts )
+{
+	const std::string path = CronoTests::TemporaryPath( "JournalCompact.cscn" );
+	const std::string journalPath = path + ".journal";
+	const std::string compactingPath = path + ".journal.compacting";
+	entt::entity entities[3];
+	Scene scene;
+	MakeScene( scene, entities, 3 );
+	{
+		// Without a job system Compact folds the journal in before it returns.
+		SceneJournal journal( path, SceneSerializer::Save( scene, path ), nullptr );
+		MoveTo( scene, entities[0], 1.0f );
+		journal.Append( scene );
+		journal.Compact();
+		CRONO_CHECK( !journal.CompactionFailed() );
+		CRONO_CHECK( !std::filesystem::exists( journalPath ) && !std::filesystem::exists( compactingPath ) );
+		SceneSerializer::FileHeader header{};
+		std::unique_ptr<Scene> snapshot = SceneSerializer::Load( path, &header );
+		CRONO_CHECK( header.JournalSequence == 1 && GetX( *snapshot, entities[0] ) == 1.0f );
+
+		// The next save starts the next segment, which the snapshot doesn't hold yet.
+		MoveTo( scene, entities[1], 2.0f );
+		journal.Append( scene );
+		std::unique_ptr<Scene> loaded = Reload( path );
+		CRONO_CHECK( GetX( *loaded, entities[0] ) == 1.0f && GetX( *loaded, entities[1] ) == 2.0f );
+	}
+
+	{
+		// On the job system, saves made while it runs go to the next segment.
+		JobSystem jobs( 2 );
+		SceneSerializer::FileHeader header{};
+		std::unique_ptr<Scene> loaded = SceneSerializer::Load( path, &header );
+		SceneJournal journal( path, header, &jobs );
+		journal.Replay( *loaded );
+		MoveTo( *loaded, entities[2], 3.0f );
+		journal.Append( *loaded );
+		journal.Compact();
+		MoveTo( *loaded, entities[0], 4.0f );
+		journal.Append( *loaded );
+		journal.WaitForCompaction();
+		CRONO_CHECK( !journal.CompactionFailed() && !std::filesystem::exists( compactingPath ) );
+		SceneSerializer::FileHeader compacted{};
+		std::unique_ptr<Scene> snapshot = SceneSerializer::Load( path, &compacted );
+		CRONO_CHECK( compacted.JournalSequence > header.JournalSequence && compacted.Lineage == header.Lineage );
+		CRONO_CHECK( GetX( *snapshot, entities[1] ) == 2.0f && GetX( *snapshot, entities[2] ) == 3.0f );
+		CRONO_CHECK( GetX( *snapshot, entities[0] ) == 1.0f );
+	}
+	std::unique_ptr<Scene> loaded = Reload( path );
+	CRONO_CHECK( GetX( *loaded, entities[0] ) == 4.0f && GetX( *loaded, entities[1] ) == 2.0f && GetX( *loaded, entities[2] ) == 3.0f );
+	RemoveSnapshot( path );
+}
+
+CRONO_TEST( SceneJournalResumesInterruptedCompaction )
+{
+	const std::string path = CronoTests::TemporaryPath( "JournalInterrupted.cscn" );
+	const std::string journalPath = path + ".journal";
+	const std::string compactingPath = path + ".journal.compacting";
+	entt::entity entities[2];
+	Scene scene;
+	MakeScene( scene, entities, 2 );
+	{
+		SceneJournal journal( path, SceneSerializer::Save( scene, path ), nullptr );
+		MoveTo( scene, entities[0], 1.0f );
+		journal.Append( scene );
+	}
+	// What Compact leaves when the process dies before the new snapshot is written.
+	std::filesystem::rename( journalPath, compactingPath );
+
+	{
+		// The leftover segment replays before the journal, and new saves go after both.
+		SceneSerializer::FileHeader header{};
+		std::unique_ptr<Scene> loaded = SceneSerializer::Load( path, &header );
+		SceneJournal journal( path, header, nullptr );
+		journal.Replay( *loaded );
+		CRONO_CHECK( GetX( *loaded, entities[0] ) == 1.0f );
+		MoveTo( *loaded, entities[0], 2.0f );
+		MoveTo( *loaded, entities[1], 3.0f );
+		journal.Append( *loaded );
+		CRONO_CHECK( std::filesystem::exists( compactingPath ) && std::filesystem::exists( journalPath ) );
+		std::unique_ptr<Scene> reloaded = Reload( path );
+		CRONO_CHECK( GetX( *reloaded, entities[0] ) == 2.0f && GetX( *reloaded, entities[1] ) == 3.0f );
+
+		// Compact finishes the leftover segment alone, the journal stays.
+		std::filesystem::copy_file( compactingPath, compactingPath + ".copy" );
+		journal.Compact();
+		CRONO_CHECK( !journal.CompactionFailed() && !std::filesystem::exists( compactingPath ) && std::filesystem::exists( journalPath ) );
+		SceneSerializer::FileHeader compacted{};
+		std::unique_ptr<Scene> snapshot = SceneSerializer::Load( path, &compacted );
+		CRONO_CHECK( compacted.JournalSequence == 1 && GetX( *snapshot, entities[0] ) == 1.0f );
+	}
+
+	// Dying after the snapshot was written but before the segment was removed: it is stale now.
+	std::filesystem::rename( compactingPath + ".copy", compactingPath );
+	std::unique_ptr<Scene> reloaded = Reload( path );
+	CRONO_CHECK( GetX( *reloaded, entities[0] ) == 2.0f && GetX( *reloaded, entities[1] ) == 3.0f );
+	CRONO_CHECK( !std::filesystem::exists( compactingPath ) );
+	RemoveSnapshot( path );
+}
+
+CRONO_TEST( SceneJournalRecreatesEntityIds )
+{
+	const std::string path = CronoTests::TemporaryPath( "JournalRecreate.cscn" );
+	entt::entity entities[2];
+	Scene scene;
+	MakeScene( scene, entities, 2 );
+	SceneJournal journal( path, SceneSerializer::Save( scene, path ), nullptr );
+
+	// Destroyed and its id taken again by a new entity in the same save.
+	scene.m_Registry.destroy( entities[1] );
+	const entt::entity recreated = scene.m_Registry.create();
+	CRONO_CHECK( entt::to_entity( recreated ) == entt::to_entity( entities[1] ) && recreated != entities[1] );
+	scene.m_Registry.emplace<TransformComponent>( recreated );
+	MoveTo( scene, recreated, 5.0f );
+	journal.Append( scene );
+	std::unique_ptr<Scene> loaded = Reload( path );
+	CRONO_CHECK( !loaded->m_Registry.valid( entities[1] ) && loaded->m_Registry.valid( recreated ) );
+	CRONO_CHECK( GetX( *loaded, recreated ) == 5.0f && GetX( *loaded, entities[0] ) == 0.0f );
+
+	// A record for a newer version than the replayed scene holds replaces the old one, not adds to it.
+	scene.m_Registry.destroy( entities[0] );
+	scene.ClearUnsaved();
+	const entt::entity newer = scene.m_Registry.create();
+	CRONO_CHECK( entt::to_entity( newer ) == entt::to_entity( entities[0] ) );
+	scene.m_Registry.emplace<TransformComponent>( newer );
+	MoveTo( scene, newer, 6.0f );
+	journal.Append( scene );
+	loaded = Reload( path );
+	CRONO_CHECK( !loaded->m_Registry.valid( entities[0] ) && loaded->m_Registry.valid( newer ) );
+	CRONO_CHECK( GetX( *loaded, newer ) == 6.0f );
+	RemoveSnapshot( path );
+}
@@ -0,0 +1,194 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "Test.h"
+#include "Scene/SceneSerializer.h"
+#include "Scene/Entity/Component/HierarchyComponent.h"
+#include "Common/CronoException.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+using namespace CronoEngine;
+
+namespace
+{
+	// count transforms, every other one parented to the one before it.
+	void FillScene( Scene& scene, uint32_t count, float offset )
+	{
+		entt::entity previous = entt::null;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const entt::entity entity = scene.m_Registry.create();
+			const float value = static_cast<float>(i) + offset;
+			scene.m_Registry.emplace<TransformComponent>( entity, Math::Float3A{ value, -value, 0.5f * value },
+				Math::Float3A{ 0.001f * value, 0.0f, -0.002f * value }, Math::Float3A{ 1.0f, 2.0f, 3.0f } );
+			if (i % 2 == 1)
+			{
+				scene.m_Registry.emplace<HierarchyComponent>( entity, previous );
+			}
+			previous = entity;
+		}
+	}
+
+	bool SameTransform( const TransformComponent& a, const TransformComponent& b )
+	{
+		const SceneSerializer::TransformRecord recordA = SceneSerializer::MakeRecord( a );
+		const SceneSerializer::TransformRecord recordB = SceneSerializer::MakeRecord( b );
+		return std::memcmp( &recordA, &recordB, sizeof( recordA ) ) == 0;
+	}
+
+	bool SameScene( Scene& a, Scene& b )
+	{
+		auto transformsA = a.m_Registry.view<TransformComponent>();
+		auto transformsB = b.m_Registry.view<TransformComponent>();
+		const auto& entities = *transformsA.handle();
+		if (entities.size() != transformsB.handle()->size())
+		{
+			return false;
+		}
+		for (size_t i = 0; i < entities.size(); ++i)
+		{
+			const entt::entity entity = entities[i];
+			if (!transformsB.contains( entity ) ||
+				!SameTransform( transformsA.get<TransformComponent>( entity ), transformsB.get<TransformComponent>( entity ) ))
+			{
+				return false;
+			}
+			const HierarchyComponent* parentA = a.m_Registry.try_get<HierarchyComponent>( entity );
+			const HierarchyComponent* parentB = b.m_Registry.try_get<HierarchyComponent>( entity );
+			if ((parentA == nullptr) != (parentB == nullptr) || (parentA != nullptr && parentA->Parent != parentB->Parent))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+CRONO_TEST( SceneSerializerRoundTrip )
+{
+	const std::string path = CronoTests::TemporaryPath( "RoundTrip.cscn" );
+	Scene scene;
+	FillScene( scene, 1000, 0.25f );
+	const SceneSerializer::FileHeader written = SceneSerializer::Save( scene, path );
+	CRONO_CHECK( scene.GetUnsavedEntities().empty() );
+	CRONO_CHECK( !std::filesystem::exists( path + ".tmp" ) );
+
+	SceneSerializer::FileHeader read{};
+	std::unique_ptr<Scene> loaded = SceneSerializer::Load( path, &read );
+	CRONO_CHECK( read.Lineage == written.Lineage && read.FileSize == std::filesystem::file_size( path ) );
+	CRONO_CHECK( SameScene( scene, *loaded ) );
+	CRONO_CHECK( loaded->GetUnsavedEntities().empty() );
+	std::filesystem::remove( path );
+}
+
+CRONO_TEST( SceneSerializerRejectsClashingEntities )
+{
+	const std::string path = CronoTests::TemporaryPath( "Clashing.cscn" );
+	Scene scene;
+	FillScene( scene, 10, 0.0f );
+	const SceneSerializer::FileHeader header = SceneSerializer::Save( scene, path );
+	std::vector<char> bytes( header.FileSize );
+	{
+		std::ifstream file( path, std::ios::binary );
+		file.read( bytes.data(), static_cast<std::streamsize>(bytes.size()) );
+	}
+	SceneSerializer::PoolEntry pools[2]{};
+	std::memcpy( pools, bytes.data() + header.HeaderSize, sizeof( pools ) );
+	uint32_t transformIds[2]{};
+	std::memcpy( transformIds, bytes.data() + pools[0].EntitiesOffset, sizeof( transformIds ) );
+
+	// Writes the saved file with ids patched in at offset, which Load must refuse.
+	auto checkRejected = [&]( uint64_t offset, const uint32_t* ids, size_t count )
+	{
+		std::vector<char> corrupt = bytes;
+		std::memcpy( corrupt.data() + offset, ids, count * sizeof( uint32_t ) );
+		{
+			std::ofstream file( path, std::ios::binary | std::ios::trunc );
+			file.write( corrupt.data(), static_cast<std::streamsize>(corrupt.size()) );
+		}
+		CRONO_CHECK_THROWS( SceneSerializer::Load( path ), FileException );
+	};
+	// The same entity twice in a pool.
+	const uint32_t sameTwice[2] = { transformIds[0], transformIds[0] };
+	checkRejected( pools[0].EntitiesOffset, sameTwice, 2 );
+	// A parent record for another version of an id the transform pool holds.
+	const entt::entity first = static_cast<entt::entity>(transformIds[0]);
+	const uint32_t otherVersion = static_cast<uint32_t>(entt::entt_traits<entt::entity>::construct( entt::to_entity( first ), entt::to_version( first ) + 1 ));
+	checkRejected( pools[1].EntitiesOffset, &otherVersion, 1 );
+	std::filesystem::remove( path );
+}
+
+CRONO_TEST( SceneSerializerFailedSaveKeepsFile )
+{
+	const std::string path = CronoTests::TemporaryPath( "FailedSave.cscn" );
+	Scene saved;
+	FillScene( saved, 100, 0.0f );
+	SceneSerializer::Save( saved, path );
+
+	// A directory where the temporary file goes makes the next save fail before it touches path.
+	std::filesystem::create_directory( path + ".tmp" );
+	Scene other;
+	FillScene( other, 200, 1.0f );
+	bool threw = false;
+	try
+	{
+		SceneSerializer::Save( other, path );
+	}
+	catch (const FileException&)
+	{
+		threw = true;
+	}
+	std::filesystem::remove( path + ".tmp" );
+	CRONO_CHECK( threw );
+	CRONO_CHECK( !other.GetUnsavedEntities().empty() );
+	CRONO_CHECK( SameScene( saved, *SceneSerializer::Load( path ) ) );
+
+	SceneSerializer::Save( other, path );
+	CRONO_CHECK( SameScene( other, *SceneSerializer::Load( path ) ) );
+	std::filesystem::remove( path );
+}
+
+CRONO_BENCHMARK( SceneSerializerThroughput )
+{
+	constexpr uint32_t EntityCount = 1000000;
+	const std::string path = CronoTests::TemporaryPath( "Throughput.cscn" );
+	Scene scene;
+	FillScene( scene, EntityCount, 0.0f );
+	uint64_t fileSize = 0;
+	const double saveSeconds = CronoTests::MeasureSeconds( 3, [&]()
+	{
+		fileSize = SceneSerializer::Save( scene, path ).FileSize;
+	} );
+	std::unique_ptr<Scene> loaded;
+	const double loadSeconds = CronoTests::MeasureSeconds( 3, [&]()
+	{
+		loaded = SceneSerializer::Load( path );
+	} );
+	CRONO_CHECK( loaded->m_Registry.view<TransformComponent>().handle()->size() == EntityCount );
+
+	const double megabytes = static_cast<double>(fileSize) / (1024.0 * 1024.0);
+	std::ostringstream oss;
+	oss << EntityCount << " entities, " << megabytes << " MiB: save " << saveSeconds * 1e3 << " ms (" << megabytes / saveSeconds
+		<< " MiB/s), load " << loadSeconds * 1e3 << " ms (" << megabytes / loadSeconds << " MiB/s)";
+	CronoTests::Report( oss.str() );
+	std::filesystem::remove( path );
+}
@@ -0,0 +1,89 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "Test.h"
+#include "Scene/Scene.h"
+#include "Scene/Entity/Component/TransformComponent.h"
+#include <atomic>
+#include <sstream>
+#include <thread>
+
+using namespace CronoEngine;
+
+namespace
+{
+	void CreateEntities( Scene& scene, uint32_t count )
+	{
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const entt::entity entity = scene.m_Registry.create();
+			scene.m_Registry.emplace<TransformComponent>( entity, Math::Float3A{ static_cast<float>(i), 0.0f, 0.0f },
+				Math::Float3A{ 0.0f, 0.0f, 0.0f }, Math::Float3A{ 1.0f, 1.0f, 1.0f } );
+		}
+	}
+}
+
+CRONO_TEST( ParallelEachVisitsEveryEntityOnce )
+{
+	JobSystem jobs( 4 );
+	Scene scene;
+	scene.SetJobSystem( &jobs );
+	CreateEntities( scene, 10000 );
+	std::vector<std::atomic<uint32_t>> visits( 10000 );
+	scene.ParallelEach<TransformComponent>( [&]( entt::entity entity, TransformComponent& )
+	{
+		visits[entt::to_entity( entity )].fetch_add( 1, std::memory_order_relaxed );
+	}, 64 );
+	for (const std::atomic<uint32_t>& count : visits)
+	{
+		CRONO_CHECK( count.load() == 1 );
+	}
+}
+
+CRONO_BENCHMARK( ParallelEachScaling )
+{
+	constexpr uint32_t EntityCount = 1000000;
+	const uint32_t maxThreads = std::max( 1u, std::thread::hardware_concurrency() );
+	Scene scene;
+	CreateEntities( scene, EntityCount );
+	double serialSeconds = 0.0;
+	for (uint32_t threads = 1; threads <= maxThreads; threads *= 2)
+	{
+		// threads - 1 workers, the waiting thread helps.
+		std::unique_ptr<JobSystem> jobs = threads > 1 ? std::make_unique<JobSystem>( threads - 1 ) : nullptr;
+		scene.SetJobSystem( jobs.get() );
+		const double seconds = CronoTests::MeasureSeconds( 5, [&]()
+		{
+			scene.ParallelEach<TransformComponent>( []( entt::entity, TransformComponent& transform )
+			{
+				const Math::Float3A position = transform.GetPosition();
+				transform.SetPosition( position.x + 1.0f, position.y, position.z );
+			} );
+		} );
+		if (threads == 1)
+		{
+			serialSeconds = seconds;
+		}
+		std::ostringstream oss;
+		oss << threads << " threads: " << seconds * 1e3 << " ms for " << EntityCount << " entities, "
+			<< seconds * 1e9 / EntityCount << " ns each, speedup " << serialSeconds / seconds;
+		CronoTests::Report( oss.str() );
+		scene.SetJobSystem( nullptr );
+	}
+}
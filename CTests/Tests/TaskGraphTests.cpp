@@ -0,0 +1,54 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "Test.h"
+#include "Jobs/TaskGraph.h"
+#include <thread>
+
+using namespace CronoEngine;
+
+CRONO_TEST( TaskGraphTimingsAreFromLastExecute )
+{
+	JobSystem jobs( 2 );
+	TaskGraph graph;
+	std::vector<TaskGraph::TaskTiming> seen;
+	const auto sleep = []() { std::this_thread::sleep_for( std::chrono::milliseconds( 2 ) ); };
+	const TaskGraph::TaskId first = graph.AddTask( "First", {}, { "A" }, sleep );
+	const TaskGraph::TaskId reader = graph.AddTask( "Reader", { "A" }, { "B" }, [&]()
+	{
+		seen.clear();
+		for (TaskGraph::TaskId task = 0; task < graph.GetTaskCount(); ++task)
+		{
+			seen.push_back( graph.GetTiming( task ) );
+		}
+	} );
+	const TaskGraph::TaskId last = graph.AddTask( "Last", { "B" }, {}, sleep );
+	CRONO_CHECK( graph.GetTiming( last ).Duration == 0.0 );
+
+	graph.Execute( jobs );
+	// The first run has nothing finished to show yet.
+	CRONO_CHECK( seen.size() == 3 && seen[last].Duration == 0.0 && !seen[first].Critical );
+	const TaskGraph::TaskTiming finished = graph.GetTiming( last );
+	CRONO_CHECK( finished.Duration > 0.0 && finished.Critical );
+
+	// Tasks that run after the reader still show the last run's timings.
+	graph.Execute( jobs );
+	CRONO_CHECK( seen[last].Duration == finished.Duration && seen[last].Critical );
+	CRONO_CHECK( seen[first].Duration > 0.0 && seen[reader].Critical );
+}
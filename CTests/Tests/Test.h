@@ -0,0 +1,103 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace CronoTests
+{
+	struct TestCase
+	{
+		const char* Name;
+		void ( *Function )();
+		// Only run with --bench, they take a while and print timings instead of checking.
+		bool Benchmark;
+	};
+
+	std::vector<TestCase>& GetTests();
+
+	struct TestRegistrar
+	{
+		TestRegistrar( const char* name, void ( *function )(), bool benchmark )
+		{
+			GetTests().push_back( { name, function, benchmark } );
+		}
+	};
+
+	class TestFailure : public std::runtime_error
+	{
+	public:
+		using std::runtime_error::runtime_error;
+	};
+
+	// Best of runs calls, in seconds, so one preempted run doesn't skew the result.
+	template<typename F>
+	double MeasureSeconds( uint32_t runs, F&& function )
+	{
+		double best = 1e30;
+		for (uint32_t i = 0; i < runs; ++i)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			function();
+			best = std::min( best, std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count() );
+		}
+		return best;
+	}
+
+	// Printed under the running test, for benchmark results.
+	void Report( const std::string& line );
+	// name in the system's temporary directory, for tests that write files.
+	std::string TemporaryPath( const std::string& name );
+}
+
+#define CRONO_TEST_CASE( name, benchmark ) \
+	static void name(); \
+	static const CronoTests::TestRegistrar name##Registrar( #name, name, benchmark ); \
+	static void name()
+
+#define CRONO_TEST( name ) CRONO_TEST_CASE( name, false )
+#define CRONO_BENCHMARK( name ) CRONO_TEST_CASE( name, true )
+
+#define CRONO_CHECK( condition ) \
+	if (!(condition)) \
+	{ \
+		throw CronoTests::TestFailure( std::string( __FILE__ ) + "(" + std::to_string( __LINE__ ) + "): " #condition ); \
+	}
+
+#define CRONO_CHECK_THROWS( statement, exception ) \
+	{ \
+		bool threw = false; \
+		try \
+		{ \
+			statement; \
+		} \
+		catch (const exception&) \
+		{ \
+			threw = true; \
+		} \
+		if (!threw) \
+		{ \
+			throw CronoTests::TestFailure( std::string( __FILE__ ) + "(" + std::to_string( __LINE__ ) + "): " #statement " did not throw " #exception ); \
+		} \
+	}
@@ -0,0 +1,109 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "Test.h"
+#include "Common/CronoException.h"
+#include <filesystem>
+#include <iostream>
+
+namespace CronoTests
+{
+	std::vector<TestCase>& GetTests()
+	{
+		static std::vector<TestCase> tests;
+		return tests;
+	}
+
+	void Report( const std::string& line )
+	{
+		std::cout << "    " << line << std::endl;
+	}
+
+	std::string TemporaryPath( const std::string& name )
+	{
+		return (std::filesystem::temp_directory_path() / ("CTests_" + name)).string();
+	}
+}
+
+// CTests [--bench] [name filter...]: runs every test whose name contains one of the filters,
+// benchmarks as well with --bench. Returns the number of failed tests.
+int main( int argc, char** argv )
+{
+	bool benchmarks = false;
+	std::vector<std::string> filters;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+		if (arg == "--bench")
+		{
+			benchmarks = true;
+		}
+		else
+		{
+			filters.push_back( arg );
+		}
+	}
+
+	int failed = 0;
+	int run = 0;
+	for (const CronoTests::TestCase& test : CronoTests::GetTests())
+	{
+		if (test.Benchmark && !benchmarks)
+		{
+			continue;
+		}
+		bool selected = filters.empty();
+		for (const std::string& filter : filters)
+		{
+			selected = selected || std::string( test.Name ).find( filter ) != std::string::npos;
+		}
+		if (!selected)
+		{
+			continue;
+		}
+		std::cout << "[ RUN  ] " << test.Name << std::endl;
+		++run;
+		const auto start = std::chrono::steady_clock::now();
+		std::string error;
+		try
+		{
+			test.Function();
+		}
+		catch (const CronoEngine::CronoException& e)
+		{
+			error = std::string( e.GetType() ) + ": " + e.what();
+		}
+		catch (const std::exception& e)
+		{
+			error = e.what();
+		}
+		const double ms = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count();
+		if (error.empty())
+		{
+			std::cout << "[  OK  ] " << test.Name << " (" << ms << " ms)" << std::endl;
+		}
+		else
+		{
+			std::cout << "[ FAIL ] " << test.Name << std::endl << "    " << error << std::endl;
+			++failed;
+		}
+	}
+	std::cout << run - failed << " of " << run << " tests passed" << std::endl;
+	return failed;
+}
@@ -0,0 +1,177 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "Test.h"
+#include "Scene/Scene.h"
+#include "Scene/TransformSystem.h"
+#include "Scene/Entity/Component/HierarchyComponent.h"
+#include "Scene/Entity/Component/TransformComponent.h"
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <sstream>
+
+using namespace CronoEngine;
+
+CRONO_TEST( TransformSystemReparentsDeepChains )
+{
+	// Two chains of ChainLength, then random reparenting, detaching and moving. After every few edits
+	// each world matrix must match the product of the local matrices up its current parents.
+	constexpr uint32_t ChainLength = 256;
+	constexpr float Tolerance = 1e-4f;
+	std::mt19937 random( 14 );
+	std::uniform_real_distribution<float> angle( -0.1f, 0.1f );
+	Scene scene;
+	entt::registry& registry = scene.m_Registry;
+	std::vector<entt::entity> entities;
+	for (uint32_t i = 0; i < 2 * ChainLength; ++i)
+	{
+		const entt::entity entity = registry.create();
+		registry.emplace<TransformComponent>( entity, Math::Float3A{ 1.0f, 0.5f, 0.0f },
+			Math::Float3A{ angle( random ), angle( random ), angle( random ) }, Math::Float3A{ 1.0f, 1.0f, 1.0f } );
+		if (i % ChainLength != 0)
+		{
+			CRONO_CHECK( scene.SetParent( entity, entities.back() ) );
+		}
+		entities.push_back( entity );
+	}
+
+	auto checkWorldMatrices = [&]()
+	{
+		scene.UpdateTransforms();
+		const TransformSystem& system = scene.GetTransforms();
+		std::vector<entt::entity> path;
+		for (const entt::entity entity : entities)
+		{
+			// From the root down, the order the system multiplies in.
+			path.clear();
+			for (entt::entity ancestor = entity; ancestor != entt::null; ancestor = scene.GetParent( ancestor ))
+			{
+				path.push_back( ancestor );
+			}
+			Math::Matrix expected = Math::LoadFloat4x4A( &registry.get<TransformComponent>( path.back() ).GetLocalMatrix() );
+			for (auto it = path.rbegin() + 1; it != path.rend(); ++it)
+			{
+				expected = Math::MatrixMultiply( Math::LoadFloat4x4A( &registry.get<TransformComponent>( *it ).GetLocalMatrix() ), expected );
+			}
+			Math::Float4x4A reference;
+			Math::StoreFloat4x4A( &reference, expected );
+			const Math::Float4x4A& world = system.GetWorldMatrix( system.FindIndex( entity ) );
+			for (uint32_t row = 0; row < 4; ++row)
+			{
+				for (uint32_t column = 0; column < 4; ++column)
+				{
+					const float magnitude = std::max( 1.0f, std::abs( reference.m[row][column] ) );
+					CRONO_CHECK( std::abs( world.m[row][column] - reference.m[row][column] ) <= Tolerance * magnitude );
+				}
+			}
+		}
+	};
+	checkWorldMatrices();
+
+	// The middle of the first chain goes under the end of the second, its depth doubles.
+	CRONO_CHECK( scene.SetParent( entities[ChainLength / 2], entities[2 * ChainLength - 1] ) );
+	checkWorldMatrices();
+	// A chain can't go under its own descendant.
+	CRONO_CHECK( !scene.SetParent( entities[ChainLength], entities[2 * ChainLength - 1] ) );
+
+	std::uniform_int_distribution<size_t> pick( 0, entities.size() - 1 );
+	for (uint32_t round = 0; round < 50; ++round)
+	{
+		for (uint32_t edit = 0; edit < 8; ++edit)
+		{
+			const entt::entity entity = entities[pick( random )];
+			switch (random() % 4)
+			{
+			case 0:
+				scene.SetParent( entity, entt::null );
+				break;
+			case 1:
+				registry.get<TransformComponent>( entity ).SetPosition( 0.5f, 1.0f, -0.25f );
+				break;
+			default:
+				// Refused when it would make a cycle.
+				scene.SetParent( entity, entities[pick( random )] );
+				break;
+			}
+		}
+		checkWorldMatrices();
+	}
+}
+
+CRONO_TEST( TransformSystemMatchesLocalMatrix )
+{
+	// Through the batched path, then again through GetLocalMatrix on a fresh copy of the same values.
+	// Both must agree exactly, and with MatrixAffineTransformation up to fused a * b + c rounding.
+	constexpr uint32_t Count = 160000;
+	constexpr float Tolerance = 4e-6f;
+	std::mt19937 random( 12 );
+	std::uniform_real_distribution<float> position( -1000.0f, 1000.0f );
+	std::uniform_real_distribution<float> angle( -10.0f, 10.0f );
+	std::uniform_real_distribution<float> scale( 0.01f, 100.0f );
+	entt::registry registry;
+	for (uint32_t i = 0; i < Count; ++i)
+	{
+		registry.emplace<TransformComponent>( registry.create(), Math::Float3A{ position( random ), position( random ), position( random ) },
+			Math::Float3A{ angle( random ), angle( random ), angle( random ) }, Math::Float3A{ scale( random ), scale( random ), scale( random ) } );
+	}
+	TransformSystem system;
+	system.Update( registry, nullptr );
+	CRONO_CHECK( system.GetCount() == Count );
+
+	uint32_t differing = 0;
+	float maxError = 0.0f;
+	for (uint32_t index = 0; index < Count; ++index)
+	{
+		TransformComponent& batched = registry.get<TransformComponent>( system.GetEntity( index ) );
+		TransformComponent single( batched.GetPosition(), batched.GetRotation(), batched.GetScale() );
+		const Math::Float4 batchedQuaternion = batched.GetRotationQuaternionFloat4();
+		const Math::Float4 singleQuaternion = single.GetRotationQuaternionFloat4();
+		if (std::memcmp( &batched.GetLocalMatrix(), &single.GetLocalMatrix(), sizeof( Math::Float4x4A ) ) != 0 ||
+			std::memcmp( &system.GetWorldMatrix( index ), &single.GetLocalMatrix(), sizeof( Math::Float4x4A ) ) != 0 ||
+			std::memcmp( &batchedQuaternion, &singleQuaternion, sizeof( Math::Float4 ) ) != 0)
+		{
+			++differing;
+		}
+
+		const Math::Float3A rotation = batched.GetRotation();
+		const Math::Float3A scaling = batched.GetScale();
+		const Math::Float3A translation = batched.GetPosition();
+		Math::Float4x4A reference;
+		Math::StoreFloat4x4A( &reference, Math::MatrixAffineTransformation( Math::LoadFloat3A( &scaling ),
+			Math::QuaternionRotationRollPitchYaw( rotation.x, rotation.y, rotation.z ), Math::LoadFloat3A( &translation ) ) );
+		for (uint32_t row = 0; row < 4; ++row)
+		{
+			float magnitude = 1.0f;
+			for (uint32_t column = 0; column < 4; ++column)
+			{
+				magnitude = std::max( magnitude, std::abs( reference.m[row][column] ) );
+			}
+			for (uint32_t column = 0; column < 4; ++column)
+			{
+				maxError = std::max( maxError, std::abs( batched.GetLocalMatrix().m[row][column] - reference.m[row][column] ) / magnitude );
+			}
+		}
+	}
+	std::ostringstream oss;
+	oss << differing << " of " << Count << " transforms differ from GetLocalMatrix, " << maxError << " max relative error to MatrixAffineTransformation";
+	CronoTests::Report( oss.str() );
+	CRONO_CHECK( differing == 0 );
+	CRONO_CHECK( maxError <= Tolerance );
+}
@@ -0,0 +1,169 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "Test.h"
+#include "Graphics/UploadRing.h"
+#include "Graphics/RHI/NullDevice.h"
+#include "Common/CronoException.h"
+#include <random>
+#include <sstream>
+
+using namespace CronoEngine;
+using namespace CronoEngine::Graphics;
+
+namespace
+{
+	struct Constants
+	{
+		float Matrix[16];
+	};
+}
+
+CRONO_TEST( RingAllocatorWrapsAndReleasesInOrder )
+{
+	RingAllocator ring( 1024 );
+	CRONO_CHECK( ring.Allocate( 10, 256 ) == 0 );
+	CRONO_CHECK( ring.Allocate( 10, 256 ) == 256 );
+	ring.Close( 1 );
+	CRONO_CHECK( ring.Allocate( 500, 256 ) == 512 );
+	// Wrapping would run into what value 1 still holds.
+	CRONO_CHECK( ring.Allocate( 100, 256 ) == RingAllocator::Full );
+	ring.Close( 2 );
+	CRONO_CHECK( *ring.GetOldestValue() == 1 );
+	ring.Release( 1 );
+	// The 12 bytes left before the end are skipped.
+	CRONO_CHECK( ring.Allocate( 100, 256 ) == 0 );
+	CRONO_CHECK( ring.Allocate( 300, 256 ) == RingAllocator::Full );
+	ring.Release( 2 );
+	CRONO_CHECK( ring.Allocate( 300, 256 ) == 256 );
+	ring.Close( 3 );
+	ring.Close( 4 );
+	CRONO_CHECK( *ring.GetOldestValue() == 3 );
+	ring.Release( 3 );
+	CRONO_CHECK( !ring.GetOldestValue() && ring.GetUsed() == 0 );
+	CRONO_CHECK( ring.Allocate( 2000, 1 ) == RingAllocator::Full );
+}
+
+CRONO_TEST( RingAllocatorRandomFrames )
+{
+	// Allocations of frames not yet released must never overlap.
+	struct Live
+	{
+		uint64_t Value;
+		uint64_t Begin;
+		uint64_t End;
+	};
+	constexpr uint64_t Capacity = 64 * 1024;
+	RingAllocator ring( Capacity );
+	std::mt19937 random( 24 );
+	std::vector<Live> live;
+	uint64_t value = 0;
+	uint64_t released = 0;
+	for (uint32_t step = 0; step < 100000; ++step)
+	{
+		const uint32_t action = random() % 16;
+		if (action == 0)
+		{
+			ring.Close( ++value );
+		}
+		else if (action == 1 && released < value)
+		{
+			released += 1 + random() % (value - released);
+			ring.Release( released );
+			std::erase_if( live, [&]( const Live& allocation ) { return allocation.Value <= released; } );
+		}
+		else
+		{
+			const uint64_t size = 1 + random() % 4096;
+			const uint64_t alignment = 1ull << (random() % 9);
+			const uint64_t offset = ring.Allocate( size, alignment );
+			if (offset == RingAllocator::Full)
+			{
+				continue;
+			}
+			CRONO_CHECK( offset % alignment == 0 && offset + size <= Capacity );
+			for (const Live& allocation : live)
+			{
+				CRONO_CHECK( offset + size <= allocation.Begin || allocation.End <= offset );
+			}
+			live.push_back( { value + 1, offset, offset + size } );
+		}
+		CRONO_CHECK( ring.GetUsed() <= Capacity );
+	}
+}
+
+CRONO_TEST( UploadRingWaitsForTheGpu )
+{
+	RHI::NullDevice device;
+	std::unique_ptr<RHI::Fence> fence = device.CreateFence( 0 );
+	RHI::Queue& queue = device.GetQueue( RHI::QueueType::Graphics );
+	// 100 constants of 256 bytes a frame, about two and a half frames fit.
+	UploadRing ring( device, *fence, 64 * 1024 );
+	const Constants constants{};
+	uint64_t value = 0;
+	for (uint32_t frame = 0; frame < 20; ++frame)
+	{
+		for (uint32_t i = 0; i < 100; ++i)
+		{
+			const UploadAllocation allocation = ring.Upload( constants );
+			CRONO_CHECK( allocation.Offset % RHI::ConstantBufferAlignment == 0 && allocation.Offset + 256 <= 64 * 1024 );
+			CRONO_CHECK( allocation.Buffer == &ring.GetBuffer() );
+		}
+		queue.Signal( *fence, ++value );
+		ring.EndFrame( value );
+	}
+	const UploadRingStats stats = ring.GetStats();
+	CRONO_CHECK( stats.Allocations == 2000 && stats.PeakUsed <= 64 * 1024 );
+
+	// Nothing to allocate is not a full ring, it gives an empty allocation and leaves the ring alone.
+	const UploadAllocation empty = ring.Allocate( 0 );
+	CRONO_CHECK( empty.Data == nullptr && empty.Size == 0 && ring.GetStats().Allocations == 2000 );
+
+	// One frame can't outgrow the ring.
+	CRONO_CHECK_THROWS( for (uint32_t i = 0; i < 300; ++i) { ring.Upload( constants ); }, RhiException );
+	CRONO_CHECK_THROWS( ring.Allocate( 128 * 1024 ), RhiException );
+}
+
+CRONO_BENCHMARK( UploadRingThroughput )
+{
+	constexpr uint32_t Uploads = 4000000;
+	RHI::NullDevice device;
+	std::unique_ptr<RHI::Fence> fence = device.CreateFence( 0 );
+	RHI::Queue& queue = device.GetQueue( RHI::QueueType::Graphics );
+	UploadRing ring( device, *fence, 16 * 1024 * 1024 );
+	const Constants constants{};
+	uint64_t value = 0;
+	const double seconds = CronoTests::MeasureSeconds( 3, [&]()
+	{
+		for (uint32_t i = 0; i < Uploads; ++i)
+		{
+			ring.Upload( constants );
+			if (i % 4096 == 4095)
+			{
+				queue.Signal( *fence, ++value );
+				ring.EndFrame( value );
+			}
+		}
+	} );
+	const UploadRingStats stats = ring.GetStats();
+	std::ostringstream oss;
+	oss << Uploads << " uploads of " << sizeof( Constants ) << " bytes: " << seconds * 1e3 << " ms, " << seconds * 1e9 / Uploads
+		<< " ns each, " << stats.Stalls << " stalls";
+	CronoTests::Report( oss.str() );
+}
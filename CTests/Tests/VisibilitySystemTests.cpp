@@ -0,0 +1,232 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "Test.h"
+#include "Scene/AabbTree.h"
+#include "Scene/Scene.h"
+#include "Scene/Entity/Component/BoundsComponent.h"
+#include "Scene/Entity/Component/TransformComponent.h"
+#include <algorithm>
+#include <random>
+#include <sstream>
+#include <thread>
+
+using namespace CronoEngine;
+
+namespace
+{
+	constexpr float WorldSize = 1000.0f;
+
+	// Randomly placed, rotated and scaled, a third of them with their own local bounds.
+	void CreateEntities( Scene& scene, uint32_t count, std::mt19937& random )
+	{
+		std::uniform_real_distribution<float> position( -WorldSize, WorldSize );
+		std::uniform_real_distribution<float> angle( -3.14159265f, 3.14159265f );
+		std::uniform_real_distribution<float> scale( 0.5f, 4.0f );
+		std::uniform_real_distribution<float> offset( -2.0f, 2.0f );
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const entt::entity entity = scene.m_Registry.create();
+			scene.m_Registry.emplace<TransformComponent>( entity, Math::Float3A{ position( random ), position( random ), position( random ) },
+				Math::Float3A{ angle( random ), angle( random ), angle( random ) }, Math::Float3A{ scale( random ), scale( random ), scale( random ) } );
+			if (i % 3 == 0)
+			{
+				scene.m_Registry.emplace<BoundsComponent>( entity, Math::Float3{ offset( random ), offset( random ), offset( random ) },
+					Math::Float3{ scale( random ), scale( random ), scale( random ) } );
+			}
+		}
+	}
+
+	// A 90 degree camera somewhere in the world looking any way, as a view * projection (row vectors, D3D depth).
+	Math::Float4x4 RandomView( std::mt19937& random, float farZ )
+	{
+		std::uniform_real_distribution<float> position( -WorldSize, WorldSize );
+		std::uniform_real_distribution<float> angle( -3.14159265f, 3.14159265f );
+		const Math::Matrix rotation = Math::MatrixRotationQuaternion( Math::QuaternionRotationRollPitchYaw( angle( random ), angle( random ), angle( random ) ) );
+		const Math::Matrix view = Math::MatrixMultiply( Math::MatrixTranslation( -position( random ), -position( random ), -position( random ) ),
+			Math::MatrixTranspose( rotation ) );
+		constexpr float NearZ = 0.1f;
+		Math::Float4x4A projection;
+		Math::StoreFloat4x4A( &projection, Math::MatrixIdentity() );
+		projection.m[0][0] = 1.0f / 1.5f;
+		projection.m[2][2] = farZ / (farZ - NearZ);
+		projection.m[2][3] = 1.0f;
+		projection.m[3][2] = -NearZ * farZ / (farZ - NearZ);
+		projection.m[3][3] = 0.0f;
+		Math::Float4x4A viewProjection;
+		Math::StoreFloat4x4A( &viewProjection, Math::MatrixMultiply( view, Math::LoadFloat4x4A( &projection ) ) );
+		return viewProjection;
+	}
+
+	// How far box is inside the frustum, negative when it is fully behind one plane.
+	float Inside( const Math::Frustum& frustum, const Math::Aabb& box )
+	{
+		const Math::Float3 center = { (box.Min.x + box.Max.x) * 0.5f, (box.Min.y + box.Max.y) * 0.5f, (box.Min.z + box.Max.z) * 0.5f };
+		const Math::Float3 extents = { (box.Max.x - box.Min.x) * 0.5f, (box.Max.y - box.Min.y) * 0.5f, (box.Max.z - box.Min.z) * 0.5f };
+		float inside = FLT_MAX;
+		for (const Math::Float4& plane : frustum.Planes)
+		{
+			const float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+			const float radius = std::abs( plane.x ) * extents.x + std::abs( plane.y ) * extents.y + std::abs( plane.z ) * extents.z;
+			inside = std::min( inside, distance + radius );
+		}
+		return inside;
+	}
+
+	// Cull against every entity's bounds one by one, straight from its world matrix. Boxes
+	// within rounding of a plane may go either way.
+	void CheckAgainstBruteForce( Scene& scene, const std::vector<Math::Frustum>& frustums )
+	{
+		std::vector<VisibilityList> lists( frustums.size() );
+		scene.Cull( frustums.data(), static_cast<uint32_t>(frustums.size()), lists.data() );
+		const TransformSystem& transforms = scene.GetTransforms();
+		for (size_t view = 0; view < frustums.size(); ++view)
+		{
+			const std::vector<uint32_t>& indices = lists[view].Indices;
+			CRONO_CHECK( std::is_sorted( indices.begin(), indices.end() ) );
+			size_t expected = 0;
+			size_t ambiguous = 0;
+			for (uint32_t i = 0; i < transforms.GetCount(); ++i)
+			{
+				const Math::Aabb bounds = AabbTree::GetWorldBounds( scene.m_Registry, transforms.GetEntity( i ), transforms.GetWorldMatrix( i ) );
+				const float inside = Inside( frustums[view], bounds );
+				const bool culled = std::binary_search( indices.begin(), indices.end(), i );
+				if (std::abs( inside ) < 1e-3f)
+				{
+					ambiguous += culled;
+					continue;
+				}
+				expected += inside >= 0.0f;
+				CRONO_CHECK( culled == (inside >= 0.0f) );
+			}
+			CRONO_CHECK( indices.size() == expected + ambiguous );
+		}
+	}
+}
+
+CRONO_TEST( VisibilityCullMatchesBruteForce )
+{
+	std::mt19937 random( 19 );
+	JobSystem jobs( 2 );
+	Scene scene;
+	scene.SetJobSystem( &jobs );
+	CreateEntities( scene, 20000, random );
+	scene.UpdateTransforms();
+
+	// Cameras that see a part of the world, one that sees all of it from the middle and one that sees nothing.
+	std::vector<Math::Frustum> frustums;
+	for (int i = 0; i < 6; ++i)
+	{
+		frustums.push_back( Math::FrustumFromMatrix( RandomView( random, 800.0f ) ) );
+	}
+	frustums.push_back( { { { 1.0f, 0.0f, 0.0f, 2.0f * WorldSize }, { -1.0f, 0.0f, 0.0f, 2.0f * WorldSize },
+		{ 0.0f, 1.0f, 0.0f, 2.0f * WorldSize }, { 0.0f, -1.0f, 0.0f, 2.0f * WorldSize },
+		{ 0.0f, 0.0f, 1.0f, 2.0f * WorldSize }, { 0.0f, 0.0f, -1.0f, 2.0f * WorldSize } } } );
+	frustums.push_back( { { { 1.0f, 0.0f, 0.0f, -3.0f * WorldSize }, { -1.0f, 0.0f, 0.0f, 4.0f * WorldSize },
+		{ 0.0f, 1.0f, 0.0f, 0.0f }, { 0.0f, -1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, -1.0f, 0.0f } } } );
+	CheckAgainstBruteForce( scene, frustums );
+
+	// Moved entities and changed local bounds are picked up by the next UpdateTransforms.
+	auto view = scene.m_Registry.view<TransformComponent>();
+	const auto& entities = *view.handle();
+	std::uniform_real_distribution<float> position( -WorldSize, WorldSize );
+	for (size_t i = 0; i < entities.size(); i += 7)
+	{
+		view.get<TransformComponent>( entities[i] ).SetPosition( position( random ), position( random ), position( random ) );
+	}
+	auto bounded = scene.m_Registry.view<BoundsComponent>();
+	const auto& withBounds = *bounded.handle();
+	for (size_t i = 0; i < withBounds.size(); i += 5)
+	{
+		scene.m_Registry.patch<BoundsComponent>( withBounds[i], []( BoundsComponent& bounds ) { bounds.Extents = { 20.0f, 1.0f, 20.0f }; } );
+	}
+	scene.UpdateTransforms();
+	CheckAgainstBruteForce( scene, frustums );
+}
+
+CRONO_TEST( VisibilityBlockMasksMatchIndices )
+{
+	std::mt19937 random( 19 );
+	JobSystem jobs( 2 );
+	// Counts that end mid block and span several cull chunks.
+	for (const uint32_t count : { 0u, 1u, 7u, 8u, 513u, 5003u })
+	{
+		Scene scene;
+		scene.SetJobSystem( count > 100 ? &jobs : nullptr );
+		CreateEntities( scene, count, random );
+		scene.UpdateTransforms();
+		std::vector<Math::Frustum> frustums;
+		for (int i = 0; i < 3; ++i)
+		{
+			frustums.push_back( Math::FrustumFromMatrix( RandomView( random, 2000.0f ) ) );
+		}
+		std::vector<VisibilityList> lists( frustums.size() );
+		scene.Cull( frustums.data(), static_cast<uint32_t>(frustums.size()), lists.data() );
+		for (const VisibilityList& list : lists)
+		{
+			CRONO_CHECK( list.BlockMasks.size() == (count + VisibilitySystem::BlockWidth - 1) / VisibilitySystem::BlockWidth );
+			std::vector<uint32_t> fromMasks;
+			for (uint32_t block = 0; block < list.BlockMasks.size(); ++block)
+			{
+				for (uint32_t bit = 0; bit < VisibilitySystem::BlockWidth; ++bit)
+				{
+					if (list.BlockMasks[block] & (1u << bit))
+					{
+						fromMasks.push_back( block * VisibilitySystem::BlockWidth + bit );
+					}
+				}
+			}
+			CRONO_CHECK( fromMasks == list.Indices );
+			CRONO_CHECK( list.Indices.empty() || list.Indices.back() < count );
+		}
+	}
+}
+
+CRONO_BENCHMARK( VisibilityCull )
+{
+	constexpr uint32_t EntityCount = 1000000;
+	constexpr uint32_t ViewCount = 4;
+	std::mt19937 random( 19 );
+	const uint32_t threads = std::max( 1u, std::thread::hardware_concurrency() );
+	std::unique_ptr<JobSystem> jobs = threads > 1 ? std::make_unique<JobSystem>( threads - 1 ) : nullptr;
+	Scene scene;
+	scene.SetJobSystem( jobs.get() );
+	CreateEntities( scene, EntityCount, random );
+	scene.UpdateTransforms();
+
+	std::vector<Math::Frustum> frustums( ViewCount );
+	for (Math::Frustum& frustum : frustums)
+	{
+		frustum = Math::FrustumFromMatrix( RandomView( random, 800.0f ) );
+	}
+	std::vector<VisibilityList> lists( ViewCount );
+	const double oneSeconds = CronoTests::MeasureSeconds( 5, [&]() { scene.Cull( frustums.data(), 1, lists.data() ); } );
+	const double allSeconds = CronoTests::MeasureSeconds( 5, [&]() { scene.Cull( frustums.data(), ViewCount, lists.data() ); } );
+	size_t visible = 0;
+	for (const VisibilityList& list : lists)
+	{
+		visible += list.Indices.size();
+	}
+
+	std::ostringstream oss;
+	oss << threads << " threads, " << EntityCount << " entities: 1 view " << oneSeconds * 1e3 << " ms ("
+		<< EntityCount / oneSeconds / 1e6 << " M entities/s), " << ViewCount << " views " << allSeconds * 1e3 << " ms ("
+		<< EntityCount * ViewCount / allSeconds / 1e6 << " M entity-views/s), " << visible / ViewCount << " visible per view";
+	CronoTests::Report( oss.str() );
+}
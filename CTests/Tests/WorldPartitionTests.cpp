@@ -0,0 +1,384 @@
+/******************************************************************************************
+*	CronoGames Game Engine																  *
+*	Copyright  2024 CronoGames <http://www.cronogames.net>								  *
+*																						  *
+*	This file is part of CronoGames Game Engine.										  *
+*																						  *
+*	CronoGames Game Engine is free software: you can redistribute it and/or modify		  *
+*	it under the terms of the GNU General Public License as published by				  *
+*	the Free Software Foundation, either version 3 of the License, or					  *
+*	(at your option) any later version.													  *
+*																						  *
+*	The CronoGames Game Engine is distributed in the hope that it will be useful,		  *
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of						  *
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the						  *
+*	GNU General Public License for more details.										  *
+*																						  *
+*	You should have received a copy of the GNU General Public License					  *
+*	along with The CronoGames Game Engine.  If not, see <http://www.gnu.org/licenses/>.   *
+******************************************************************************************/
+#include "Test.h"
+#include "Scene/WorldPartition.h"
+#include "Scene/SceneJournal.h"
+#include "Scene/SceneSerializer.h"
+#include "Scene/Entity/Component/HierarchyComponent.h"
+#include "Scene/Entity/Component/TransformComponent.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+using namespace CronoEngine;
+
+namespace
+{
+	constexpr float CellSize = 100.0f;
+	// Cells [MinCell, MaxCell) on both axes.
+	constexpr int32_t MinCell = -5;
+	constexpr int32_t MaxCell = 10;
+
+	/**
+	 * One root in the middle of every cell with two children placed cells away, which must
+	 * still go with their root. Returns the world directory.
+	 */
+	std::string BuildWorld( const std::string& name )
+	{
+		const std::string directory = CronoTests::TemporaryPath( name );
+		std::filesystem::remove_all( directory );
+		Scene scene;
+		entt::registry& registry = scene.m_Registry;
+		for (int32_t z = MinCell; z < MaxCell; ++z)
+		{
+			for (int32_t x = MinCell; x < MaxCell; ++x)
+			{
+				const entt::entity root = registry.create();
+				registry.emplace<TransformComponent>( root, Math::Float3A{ (x + 0.5f) * CellSize, 0.0f, (z + 0.5f) * CellSize },
+					Math::Float3A{ 0.0f, 0.0f, 0.0f }, Math::Float3A{ 1.0f, 1.0f, 1.0f } );
+				for (const float offset : { 3.0f * CellSize, -3.0f * CellSize })
+				{
+					const entt::entity child = registry.create();
+					registry.emplace<TransformComponent>( child, Math::Float3A{ offset, 1.0f, offset },
+						Math::Float3A{ 0.0f, 0.0f, 0.0f }, Math::Float3A{ 1.0f, 1.0f, 1.0f } );
+					CRONO_CHECK( scene.SetParent( child, root ) );
+				}
+			}
+		}
+		WorldPartition::Build( scene, directory, CellSize );
+		return directory;
+	}
+
+	// What WorldPartition measures: from the observer to the nearest point of the cell.
+	float CellDistance( int32_t x, int32_t z, float observerX, float observerZ )
+	{
+		const float dx = std::max( { x * CellSize - observerX, 0.0f, observerX - (x + 1) * CellSize } );
+		const float dz = std::max( { z * CellSize - observerZ, 0.0f, observerZ - (z + 1) * CellSize } );
+		return std::sqrt( dx * dx + dz * dz );
+	}
+
+	uint32_t CountResident( const WorldPartition& world )
+	{
+		uint32_t count = 0;
+		for (int32_t z = MinCell; z < MaxCell; ++z)
+		{
+			for (int32_t x = MinCell; x < MaxCell; ++x)
+			{
+				count += world.IsResident( x, z ) ? 1 : 0;
+			}
+		}
+		return count;
+	}
+
+	// The streamed root of cell x, z in scene, entt::null when it isn't there.
+	entt::entity FindRoot( Scene& scene, int32_t x, int32_t z )
+	{
+		auto transforms = scene.m_Registry.view<TransformComponent>();
+		const auto& entities = *transforms.handle();
+		for (size_t i = 0; i < entities.size(); ++i)
+		{
+			const auto position = transforms.get<TransformComponent>( entities[i] ).GetPosition();
+			if (position.x == (x + 0.5f) * CellSize && position.y == 0.0f && position.z == (z + 0.5f) * CellSize &&
+				!scene.m_Registry.all_of<HierarchyComponent>( entities[i] ))
+			{
+				return entities[i];
+			}
+		}
+		return entt::null;
+	}
+}
+
+CRONO_TEST( WorldPartitionBuildWritesCells )
+{
+	const std::string directory = BuildWorld( "WorldBuild" );
+	std::ifstream manifest( directory + "/world.cells", std::ios::binary );
+	WorldPartition::ManifestHeader header{};
+	manifest.read( reinterpret_cast<char*>(&header), sizeof( header ) );
+	constexpr uint32_t CellCount = (MaxCell - MinCell) * (MaxCell - MinCell);
+	CRONO_CHECK( manifest && header.Magic == WorldPartition::Magic && header.Version == WorldPartition::Version );
+	CRONO_CHECK( header.CellSize == CellSize && header.CellCount == CellCount );
+	std::vector<WorldPartition::ManifestCell> cells( header.CellCount );
+	manifest.read( reinterpret_cast<char*>(cells.data()), static_cast<std::streamsize>(cells.size() * sizeof( WorldPartition::ManifestCell )) );
+	CRONO_CHECK( manifest );
+
+	// One file per root's cell, each holding the root and both children.
+	uint32_t files = 0;
+	for (const auto& entry : std::filesystem::directory_iterator( directory ))
+	{
+		files += entry.path().extension() == ".scene" ? 1 : 0;
+	}
+	CRONO_CHECK( files == CellCount );
+	for (const WorldPartition::ManifestCell& cell : cells)
+	{
+		CRONO_CHECK( cell.X >= MinCell && cell.X < MaxCell && cell.Z >= MinCell && cell.Z < MaxCell );
+		CRONO_CHECK( cell.TransformCount == 3 && cell.HierarchyCount == 2 );
+		const std::string path = directory + "/cell_" + std::to_string( cell.X ) + "_" + std::to_string( cell.Z ) + ".scene";
+		std::unique_ptr<Scene> loaded = SceneSerializer::Load( path );
+		CRONO_CHECK( loaded->m_Registry.view<TransformComponent>().handle()->size() == 3 );
+		const entt::entity root = FindRoot( *loaded, cell.X, cell.Z );
+		CRONO_CHECK( root != entt::null );
+		auto children = loaded->m_Registry.view<HierarchyComponent>();
+		CRONO_CHECK( children.handle()->size() == 2 );
+		for (size_t i = 0; i < children.handle()->size(); ++i)
+		{
+			CRONO_CHECK( children.get<HierarchyComponent>( (*children.handle())[i] ).Parent == root );
+		}
+	}
+	std::filesystem::remove_all( directory );
+}
+
+CRONO_TEST( WorldPartitionStreamsAroundObservers )
+{
+	const std::string directory = BuildWorld( "WorldStreaming" );
+	const std::string path = CronoTests::TemporaryPath( "WorldStreaming.cscn" );
+	Scene scene;
+	SceneJournal journal( path, SceneSerializer::Save( scene, path ), nullptr );
+	WorldPartition::Settings settings;
+	settings.LoadRadius = 150.0f;
+	settings.UnloadRadius = 250.0f;
+	settings.MemoryBudget = 0;
+	settings.MaxLoadsInFlight = 1000;
+	settings.MaxMergesPerUpdate = 1000;
+	// Without a job system loads finish right away, the next Update merges them.
+	WorldPartition world( scene, directory, settings );
+	CRONO_CHECK( world.GetCellSize() == CellSize );
+	const uint32_t observer = world.AddObserver( 50.0f, 50.0f );
+	world.Update();
+	CRONO_CHECK( CountResident( world ) == 0 && world.GetMetrics().CellsInFlight > 0 );
+
+	// Walk east: cells in LoadRadius come in, ones past UnloadRadius go, the ones between stay as they were.
+	std::vector<uint8_t> wasResident( (MaxCell - MinCell) * (MaxCell - MinCell), 0 );
+	uint64_t loaded = 0;
+	uint64_t unloaded = 0;
+	for (float observerX = 50.0f; observerX <= 650.0f; observerX += 75.0f)
+	{
+		world.SetObserver( observer, observerX, 50.0f );
+		world.Update();
+		world.Update();
+		// Freshly merged transforms count as moved, and streamed ones moved later stay out of the journal too.
+		const entt::entity nearest = FindRoot( scene, static_cast<int32_t>(std::floor( observerX / CellSize )), 0 );
+		CRONO_CHECK( nearest != entt::null );
+		scene.m_Registry.get<TransformComponent>( nearest ).SetScale( 2.0f, 2.0f, 2.0f );
+		scene.UpdateTransforms();
+		CRONO_CHECK( scene.GetUnsavedEntities().empty() );
+		scene.m_Registry.get<TransformComponent>( nearest ).SetScale( 1.0f, 1.0f, 1.0f );
+		journal.Append( scene );
+		uint32_t resident = 0;
+		for (int32_t z = MinCell; z < MaxCell; ++z)
+		{
+			for (int32_t x = MinCell; x < MaxCell; ++x)
+			{
+				const float distance = CellDistance( x, z, observerX, 50.0f );
+				uint8_t& was = wasResident[(z - MinCell) * (MaxCell - MinCell) + (x - MinCell)];
+				const bool expected = distance <= settings.LoadRadius || (was != 0 && distance <= settings.UnloadRadius);
+				CRONO_CHECK( world.IsResident( x, z ) == expected );
+				CRONO_CHECK( (FindRoot( scene, x, z ) != entt::null) == expected );
+				loaded += expected && was == 0 ? 1 : 0;
+				unloaded += !expected && was != 0 ? 1 : 0;
+				was = expected ? 1 : 0;
+				resident += expected ? 1 : 0;
+			}
+		}
+		const WorldPartition::Metrics& metrics = world.GetMetrics();
+		CRONO_CHECK( metrics.ResidentCells == resident && metrics.CellsInFlight == 0 );
+		CRONO_CHECK( metrics.LoadedCells == loaded && metrics.UnloadedCells == unloaded && metrics.FailedLoads == 0 );
+		CRONO_CHECK( scene.m_Registry.view<TransformComponent>().handle()->size() == 3 * resident );
+		// Streaming in and out never marks anything unsaved.
+		CRONO_CHECK( scene.GetUnsavedEntities().empty() );
+	}
+	CRONO_CHECK( loaded > 0 && unloaded > 0 );
+
+	// Every Update is timed.
+	const WorldPartition::Metrics& metrics = world.GetMetrics();
+	CRONO_CHECK( metrics.LastStallMilliseconds >= 0.0 && metrics.MaxStallMilliseconds >= metrics.LastStallMilliseconds );
+	CRONO_CHECK( metrics.TotalStallMilliseconds >= metrics.MaxStallMilliseconds && metrics.TotalStallMilliseconds > 0.0 );
+
+	// Tracking is back on for the scene's own edits.
+	const entt::entity own = scene.m_Registry.create();
+	scene.m_Registry.emplace<TransformComponent>( own );
+	CRONO_CHECK( scene.GetUnsavedEntities().size() == 1 && scene.GetUnsavedEntities()[0] == own );
+
+	// Without observers everything goes, the scene's own entity stays.
+	world.RemoveObserver( observer );
+	world.Update();
+	CRONO_CHECK( CountResident( world ) == 0 && world.GetMetrics().ResidentCells == 0 && world.GetMetrics().ResidentBytes == 0 );
+	CRONO_CHECK( scene.m_Registry.view<TransformComponent>().handle()->size() == 1 && scene.m_Registry.valid( own ) );
+
+	// The journal holds the scene's own entity and nothing streamed.
+	journal.Append( scene );
+	SceneSerializer::FileHeader header{};
+	std::unique_ptr<Scene> saved = SceneSerializer::Load( path, &header );
+	SceneJournal( path, header, nullptr ).Replay( *saved );
+	CRONO_CHECK( saved->m_Registry.view<TransformComponent>().handle()->size() == 1 );
+	CRONO_CHECK( saved->m_Registry.valid( own ) && saved->m_Registry.all_of<TransformComponent>( own ) );
+	SceneJournal::Remove( path );
+	std::filesystem::remove( path );
+	std::filesystem::remove_all( directory );
+}
+
+CRONO_TEST( WorldPartitionLoadsNearestFirstWithinBudget )
+{
+	const std::string directory = BuildWorld( "WorldBudget" );
+	Scene scene;
+	WorldPartition::Settings settings;
+	settings.LoadRadius = 150.0f;
+	settings.UnloadRadius = 10000.0f;
+	settings.MemoryBudget = 0;
+	settings.MaxLoadsInFlight = 1;
+	settings.MaxMergesPerUpdate = 1;
+
+	// One load at a time: cells come in one per Update, in order of distance.
+	uint64_t cellBytes = 0;
+	{
+		Scene ordered;
+		WorldPartition world( ordered, directory, settings );
+		world.AddObserver( 260.0f, 370.0f );
+		float last = 0.0f;
+		std::vector<uint8_t> seen( (MaxCell - MinCell) * (MaxCell - MinCell), 0 );
+		for (uint32_t step = 0; step < 30; ++step)
+		{
+			world.Update();
+			CRONO_CHECK( world.GetMetrics().CellsInFlight <= 1 );
+			for (int32_t z = MinCell; z < MaxCell; ++z)
+			{
+				for (int32_t x = MinCell; x < MaxCell; ++x)
+				{
+					uint8_t& was = seen[(z - MinCell) * (MaxCell - MinCell) + (x - MinCell)];
+					if (world.IsResident( x, z ) && was == 0)
+					{
+						const float distance = CellDistance( x, z, 260.0f, 370.0f );
+						CRONO_CHECK( distance >= last && distance <= settings.LoadRadius );
+						last = distance;
+						was = 1;
+					}
+				}
+			}
+			CRONO_CHECK( CountResident( world ) == std::min( step, 21u ) );
+		}
+		cellBytes = world.GetMetrics().ResidentBytes / world.GetMetrics().ResidentCells;
+	}
+
+	// Room for four cells: the four nearest load, the rest wait.
+	settings.MemoryBudget = 4 * cellBytes;
+	settings.MaxLoadsInFlight = 1000;
+	settings.MaxMergesPerUpdate = 1000;
+	WorldPartition world( scene, directory, settings );
+	const uint32_t observer = world.AddObserver( 60.0f, 70.0f );
+	world.Update();
+	world.Update();
+	CRONO_CHECK( world.GetMetrics().BudgetDeferredCells > 0 && world.GetMetrics().ResidentBytes <= settings.MemoryBudget );
+	CRONO_CHECK( CountResident( world ) == 4 );
+	CRONO_CHECK( world.IsResident( 0, 0 ) && world.IsResident( 0, 1 ) && world.IsResident( 1, 0 ) && world.IsResident( 1, 1 ) );
+
+	// Far away, the cells kept only by the hysteresis make room for the new nearest ones.
+	world.SetObserver( observer, 560.0f, 70.0f );
+	world.Update();
+	CRONO_CHECK( world.GetMetrics().UnloadedCells == 4 && world.GetMetrics().ResidentBytes + 4 * cellBytes <= settings.MemoryBudget );
+	world.Update();
+	CRONO_CHECK( CountResident( world ) == 4 && world.GetMetrics().ResidentBytes <= settings.MemoryBudget );
+	CRONO_CHECK( world.IsResident( 5, 0 ) && world.IsResident( 5, 1 ) && world.IsResident( 6, 0 ) && world.IsResident( 6, 1 ) );
+	std::filesystem::remove_all( directory );
+}
+
+CRONO_TEST( WorldPartitionMergeRemapsTakenIds )
+{
+	const std::string directory = BuildWorld( "WorldRemap" );
+	Scene scene;
+	// The scene's own entities hold every id the world uses, so all of the cell's are remapped.
+	std::vector<entt::entity> own;
+	for (int32_t i = 0; i < 3 * (MaxCell - MinCell) * (MaxCell - MinCell); ++i)
+	{
+		own.push_back( scene.m_Registry.create() );
+		scene.m_Registry.emplace<TransformComponent>( own.back(), Math::Float3A{ 0.0f, -1000.0f, 0.0f },
+			Math::Float3A{ 0.0f, 0.0f, 0.0f }, Math::Float3A{ 1.0f, 1.0f, 1.0f } );
+	}
+	WorldPartition::Settings settings;
+	settings.LoadRadius = 10.0f;
+	settings.UnloadRadius = 20.0f;
+	WorldPartition world( scene, directory, settings );
+	const uint32_t observer = world.AddObserver( 50.0f, 50.0f );
+	world.Update();
+	world.Update();
+	CRONO_CHECK( CountResident( world ) == 1 && world.IsResident( 0, 0 ) );
+
+	const entt::entity root = FindRoot( scene, 0, 0 );
+	CRONO_CHECK( root != entt::null && std::find( own.begin(), own.end(), root ) == own.end() );
+	auto children = scene.m_Registry.view<HierarchyComponent>();
+	CRONO_CHECK( children.handle()->size() == 2 );
+	for (size_t i = 0; i < children.handle()->size(); ++i)
+	{
+		const entt::entity child = (*children.handle())[i];
+		CRONO_CHECK( std::find( own.begin(), own.end(), child ) == own.end() );
+		CRONO_CHECK( scene.GetParent( child ) == root );
+	}
+
+	// Unloading takes the remapped entities, not the scene's own under the cell's old ids.
+	world.SetObserver( observer, 5000.0f, 5000.0f );
+	world.Update();
+	CRONO_CHECK( CountResident( world ) == 0 && !scene.m_Registry.valid( root ) );
+	CRONO_CHECK( scene.m_Registry.view<TransformComponent>().handle()->size() == own.size() );
+	for (const entt::entity entity : own)
+	{
+		CRONO_CHECK( scene.m_Registry.valid( entity ) );
+	}
+	std::filesystem::remove_all( directory );
+}
+
+CRONO_BENCHMARK( WorldPartitionStreaming )
+{
+	const std::string directory = BuildWorld( "WorldBenchmark" );
+	const uint32_t threads = std::max( 1u, std::thread::hardware_concurrency() );
+	std::unique_ptr<JobSystem> jobs = threads > 1 ? std::make_unique<JobSystem>( threads - 1 ) : nullptr;
+	Scene scene;
+	scene.SetJobSystem( jobs.get() );
+	WorldPartition::Settings settings;
+	settings.LoadRadius = 300.0f;
+	settings.UnloadRadius = 400.0f;
+	settings.MemoryBudget = 0;
+	WorldPartition world( scene, directory, settings );
+
+	// Walk the diagonal and back, one Update per frame, as a game would.
+	const uint32_t observer = world.AddObserver( MinCell * CellSize, MinCell * CellSize );
+	constexpr uint32_t Frames = 2000;
+	const float span = (MaxCell - MinCell) * CellSize;
+	uint32_t maxInFlight = 0;
+	for (uint32_t frame = 0; frame < Frames; ++frame)
+	{
+		const float t = static_cast<float>(frame % (Frames / 2)) / (Frames / 2);
+		const float along = MinCell * CellSize + span * (frame < Frames / 2 ? t : 1.0f - t);
+		world.SetObserver( observer, along, along );
+		world.Update();
+		maxInFlight = std::max( maxInFlight, world.GetMetrics().CellsInFlight );
+	}
+	const WorldPartition::Metrics& metrics = world.GetMetrics();
+	CRONO_CHECK( metrics.LoadedCells > 0 && metrics.UnloadedCells > 0 && metrics.FailedLoads == 0 );
+
+	std::ostringstream oss;
+	oss << threads << " threads, " << Frames << " frames: " << metrics.LoadedCells << " loads, " << metrics.UnloadedCells
+		<< " unloads, stall " << metrics.TotalStallMilliseconds / Frames << " ms avg " << metrics.MaxStallMilliseconds
+		<< " ms max, " << maxInFlight << " cells in flight at most";
+	CronoTests::Report( oss.str() );
+	std::filesystem::remove_all( directory );
+}